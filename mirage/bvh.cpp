@@ -0,0 +1,328 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+
+#include "check.hpp"
+#include "profiler.hpp"
+
+namespace mirage
+{
+
+namespace detail
+{
+
+struct BvhPrimitive
+{
+    AABB<float> bounds;
+    Vector3<float> centroid;
+    uint32_t index;
+};
+
+struct BvhBin
+{
+    AABB<float> bounds = AABB<float>::Empty();
+    uint32_t count = 0;
+};
+
+// Reorders pPrimitives[pBegin, pEnd) into the two children of a split and
+// returns where the second child starts. Takes the split between centroid
+// bins with the lowest SAH cost, area times triangle count summed over both
+// children: the area is proportional to the chance that a ray through the
+// parent also hits the child. Splits at the median centroid along the longest axis instead if
+// pMedian is set or all centroids coincide.
+static uint32_t PartitionPrimitives(BvhPrimitive* pPrimitives, uint32_t pBegin, uint32_t pEnd,
+    const AABB<float>& pCentroidBounds, bool pMedian)
+{
+    const Vector3<float> lower = pCentroidBounds.lower;
+    const Vector3<float> extent = pCentroidBounds.upper - pCentroidBounds.lower;
+    Vector3<float> scale;
+    for (int axis = 0; axis < 3; ++axis)
+        scale[axis] = extent[axis] > 0.f ? Bvh::BinCount / extent[axis] : 0.f;
+    const auto bin_of = [&](const BvhPrimitive& pPrimitive, int pAxis)
+    {
+        const int bin = static_cast<int>((pPrimitive.centroid[pAxis] - lower[pAxis]) * scale[pAxis]);
+        return std::min(bin, Bvh::BinCount - 1);
+    };
+
+    int best_axis = -1;
+    int best_bin = 0;
+    if (!pMedian)
+    {
+        BvhBin bins[3][Bvh::BinCount];
+        for (uint32_t i = pBegin; i < pEnd; ++i)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                BvhBin& bin = bins[axis][bin_of(pPrimitives[i], axis)];
+                bin.bounds.Extend(pPrimitives[i].bounds);
+                bin.count++;
+            }
+        }
+
+        float best_cost = std::numeric_limits<float>::infinity();
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (extent[axis] <= 0.f)
+                continue;
+
+            // Cost and count of the second child when splitting after bin k.
+            float right_cost[Bvh::BinCount - 1];
+            uint32_t right_count[Bvh::BinCount - 1];
+            AABB<float> right = AABB<float>::Empty();
+            uint32_t count = 0;
+            for (int k = Bvh::BinCount - 1; k > 0; --k)
+            {
+                right.Extend(bins[axis][k].bounds);
+                count += bins[axis][k].count;
+                right_cost[k - 1] = count != 0 ? right.SurfaceArea() * count : 0.f;
+                right_count[k - 1] = count;
+            }
+
+            AABB<float> left = AABB<float>::Empty();
+            count = 0;
+            for (int k = 0; k < Bvh::BinCount - 1; ++k)
+            {
+                left.Extend(bins[axis][k].bounds);
+                count += bins[axis][k].count;
+                if (count == 0 || right_count[k] == 0)
+                    continue;
+                const float cost = left.SurfaceArea() * count + right_cost[k];
+                if (cost < best_cost)
+                {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_bin = k;
+                }
+            }
+        }
+    }
+
+    if (best_axis >= 0)
+    {
+        const BvhPrimitive* middle = std::partition(pPrimitives + pBegin, pPrimitives + pEnd,
+            [&](const BvhPrimitive& p) { return bin_of(p, best_axis) <= best_bin; });
+        return static_cast<uint32_t>(middle - pPrimitives);
+    }
+
+    const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+    const uint32_t middle = pBegin + (pEnd - pBegin) / 2;
+    std::nth_element(pPrimitives + pBegin, pPrimitives + middle, pPrimitives + pEnd,
+        [axis](const BvhPrimitive& a, const BvhPrimitive& b) { return a.centroid[axis] < b.centroid[axis]; });
+    return middle;
+}
+
+// Appends the subtree over pPrimitives[pBegin, pEnd) to pNodes, depth first.
+// The upper pParallelDepth levels build their second subtree on another
+// thread, into a separate vector that is appended once both are done.
+static void BuildBvhNode(std::vector<BvhNode>* pNodes, BvhPrimitive* pPrimitives, uint32_t pBegin, uint32_t pEnd,
+    int pDepth, int pParallelDepth)
+{
+    const std::size_t node = pNodes->size();
+    pNodes->emplace_back();
+
+    AABB<float> bounds = AABB<float>::Empty();
+    AABB<float> centroids = AABB<float>::Empty();
+    for (uint32_t i = pBegin; i < pEnd; ++i)
+    {
+        bounds.Extend(pPrimitives[i].bounds);
+        centroids.Extend(pPrimitives[i].centroid);
+    }
+    (*pNodes)[node].lower = bounds.lower;
+    (*pNodes)[node].upper = bounds.upper;
+
+    const uint32_t count = pEnd - pBegin;
+    if (count <= Bvh::MaxLeafSize)
+    {
+        (*pNodes)[node].offset = pBegin;
+        (*pNodes)[node].count = count;
+        return;
+    }
+
+    // Median splits from here on need at most 30 more levels for 2^32
+    // triangles, which keeps the depth below Bvh::MaxDepth.
+    const bool median = pDepth >= Bvh::MaxDepth - 32;
+    const uint32_t middle = PartitionPrimitives(pPrimitives, pBegin, pEnd, centroids, median);
+
+    uint32_t second;
+    if (pParallelDepth > 0 && count >= Bvh::ParallelThreshold)
+    {
+        std::vector<BvhNode> second_nodes;
+        ParallelFor(2, 1, [&](std::size_t pFirstChild, std::size_t pLastChild)
+        {
+            for (std::size_t child = pFirstChild; child < pLastChild; ++child)
+            {
+                if (child == 0)
+                    BuildBvhNode(pNodes, pPrimitives, pBegin, middle, pDepth + 1, pParallelDepth - 1);
+                else
+                    BuildBvhNode(&second_nodes, pPrimitives, middle, pEnd, pDepth + 1, pParallelDepth - 1);
+            }
+        });
+
+        second = static_cast<uint32_t>(pNodes->size());
+        for (BvhNode n : second_nodes)
+        {
+            if (!n.IsLeaf())
+                n.offset += second;
+            pNodes->push_back(n);
+        }
+    }
+    else
+    {
+        BuildBvhNode(pNodes, pPrimitives, pBegin, middle, pDepth + 1, 0);
+        second = static_cast<uint32_t>(pNodes->size());
+        BuildBvhNode(pNodes, pPrimitives, middle, pEnd, pDepth + 1, 0);
+    }
+    (*pNodes)[node].offset = second;
+    (*pNodes)[node].count = 0;
+}
+
+// Slab test. Returns true if the ray enters the box before pMaxT and leaves
+// it after 0, with the entry distance in pEntry.
+inline bool IntersectBox(const BvhNode& pNode, const Vector3<float>& pOrigin, const Vector3<float>& pInverseDirection,
+    float pMaxT, float* pEntry) noexcept
+{
+    const float tx0 = (pNode.lower.x - pOrigin.x) * pInverseDirection.x;
+    const float tx1 = (pNode.upper.x - pOrigin.x) * pInverseDirection.x;
+    const float ty0 = (pNode.lower.y - pOrigin.y) * pInverseDirection.y;
+    const float ty1 = (pNode.upper.y - pOrigin.y) * pInverseDirection.y;
+    const float tz0 = (pNode.lower.z - pOrigin.z) * pInverseDirection.z;
+    const float tz1 = (pNode.upper.z - pOrigin.z) * pInverseDirection.z;
+    const float entry = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::min(tz0, tz1));
+    const float exit = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::max(tz0, tz1));
+    *pEntry = entry;
+    return entry <= exit && exit > 0.f && entry < pMaxT;
+}
+
+} // namespace detail
+
+void Bvh::Build(Span<const Triangle> pTriangles, Execution pExecution)
+{
+    MIRAGE_PROFILE_ZONE("Bvh::Build");
+    DCHECK_LT(pTriangles.size(), static_cast<std::size_t>(RayHit::NoHit));
+    const uint32_t count = static_cast<uint32_t>(pTriangles.size());
+    const std::size_t grain = pExecution == Execution::PARALLEL ? ParallelThreshold : count + 1;
+
+    std::vector<detail::BvhPrimitive> primitives(count);
+    ParallelFor(count, grain, [&](std::size_t pBegin, std::size_t pEnd)
+    {
+        for (std::size_t i = pBegin; i < pEnd; ++i)
+        {
+            const Triangle& t = pTriangles[i];
+            AABB<float> bounds(t.v0, t.v0);
+            bounds.Extend(t.v1);
+            bounds.Extend(t.v2);
+            primitives[i].bounds = bounds;
+            primitives[i].centroid = bounds.Center();
+            primitives[i].index = static_cast<uint32_t>(i);
+        }
+    });
+
+    mNodes.clear();
+    mTriangles.clear();
+    mTriangleIndices.clear();
+    if (count == 0)
+        return;
+
+    // Two subtrees per level: one more level than needed for a thread each,
+    // as SAH splits are often uneven.
+    int parallel_depth = 0;
+    if (pExecution == Execution::PARALLEL)
+    {
+        while ((1u << parallel_depth) < GetHardwareThreadCount())
+            parallel_depth++;
+        parallel_depth++;
+    }
+
+    // A binary tree with at least one triangle per leaf.
+    mNodes.reserve(2 * static_cast<std::size_t>(count) - 1);
+    detail::BuildBvhNode(&mNodes, primitives.data(), 0, count, 0, parallel_depth);
+
+    mTriangles.resize(count);
+    mTriangleIndices.resize(count);
+    ParallelFor(count, grain, [&](std::size_t pBegin, std::size_t pEnd)
+    {
+        for (std::size_t i = pBegin; i < pEnd; ++i)
+        {
+            mTriangles[i] = pTriangles[primitives[i].index];
+            mTriangleIndices[i] = primitives[i].index;
+        }
+    });
+}
+
+bool Bvh::Intersect(const Ray& pRay, RayHit* pHit) const
+{
+    if (mNodes.empty())
+        return false;
+
+    const Vector3<float> inverse_direction(1.f / pRay.direction.x, 1.f / pRay.direction.y, 1.f / pRay.direction.z);
+    float t = pHit->t;
+    float u = 0.f;
+    float v = 0.f;
+    uint32_t closest = RayHit::NoHit;
+
+    float entry;
+    if (!detail::IntersectBox(mNodes[0], pRay.origin, inverse_direction, t, &entry))
+        return false;
+
+    // At most one entry per level.
+    uint32_t stack[MaxDepth];
+    int stack_size = 0;
+    uint32_t node = 0;
+    for (;;)
+    {
+        const BvhNode& n = mNodes[node];
+        if (n.IsLeaf())
+        {
+            for (uint32_t i = n.offset; i < n.offset + n.count; ++i)
+            {
+                if (IntersectTriangle(pRay, mTriangles[i], t, &t, &u, &v))
+                    closest = i;
+            }
+        }
+        else
+        {
+            // Visit the nearer child first, so that the farther one is more
+            // likely to be skipped once a hit shortens the ray.
+            uint32_t first = node + 1;
+            uint32_t second = n.offset;
+            float first_entry, second_entry;
+            const bool hit_first = detail::IntersectBox(mNodes[first], pRay.origin, inverse_direction, t, &first_entry);
+            const bool hit_second = detail::IntersectBox(mNodes[second], pRay.origin, inverse_direction, t, &second_entry);
+            if (hit_first && hit_second)
+            {
+                if (second_entry < first_entry)
+                    std::swap(first, second);
+                DCHECK_LT(stack_size, static_cast<int>(ARRAYSIZE(stack)));
+                stack[stack_size++] = second;
+                node = first;
+                continue;
+            }
+            if (hit_first || hit_second)
+            {
+                node = hit_first ? first : second;
+                continue;
+            }
+        }
+
+        if (stack_size == 0)
+            break;
+        node = stack[--stack_size];
+    }
+
+    if (closest == RayHit::NoHit)
+        return false;
+    pHit->t = t;
+    pHit->u = u;
+    pHit->v = v;
+    pHit->triangle = closest;
+    return true;
+}
+
+AABB<float> Bvh::GetBounds() const
+{
+    if (mNodes.empty())
+        return AABB<float>::Empty();
+    return AABB<float>(mNodes[0].lower, mNodes[0].upper);
+}
+
+} // namespace mirage
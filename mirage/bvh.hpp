@@ -0,0 +1,132 @@
+#ifndef MIRAGE_BVH_HPP
+#define MIRAGE_BVH_HPP
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "parallel.hpp"
+#include "util.hpp"
+#include "vecmath.hpp"
+
+namespace mirage
+{
+
+struct Triangle
+{
+    Vector3<float> v0, v1, v2;
+};
+
+struct Ray
+{
+    Vector3<float> origin;
+    Vector3<float> direction;
+};
+
+struct RayHit
+{
+    static constexpr uint32_t NoHit = 0xFFFFFFFFu;
+
+    // Distance along the ray in units of its direction. Only hits closer
+    // than this are reported, so set it to limit the search.
+    float t = std::numeric_limits<float>::infinity();
+    // Barycentric coordinates of the hit point, weights of v1 and v2.
+    float u = 0.f;
+    float v = 0.f;
+    // Index into Bvh::GetTriangles(). Bvh::GetTriangleIndex() maps it back
+    // to the order passed to Bvh::Build().
+    uint32_t triangle = NoHit;
+};
+
+// Moller-Trumbore. Returns true and fills pT, pU and pV if the ray hits
+// either side of pTriangle at a distance in (0, pMaxT).
+inline bool IntersectTriangle(const Ray& pRay, const Triangle& pTriangle, float pMaxT, float* pT, float* pU, float* pV) noexcept
+{
+    const Vector3<float> e1 = pTriangle.v1 - pTriangle.v0;
+    const Vector3<float> e2 = pTriangle.v2 - pTriangle.v0;
+    const Vector3<float> p = Cross(pRay.direction, e2);
+    const float det = Dot(e1, p);
+    if (det == 0.f)
+        return false;
+    const float inv_det = 1.f / det;
+
+    const Vector3<float> s = pRay.origin - pTriangle.v0;
+    const float u = Dot(s, p) * inv_det;
+    if (u < 0.f || u > 1.f)
+        return false;
+    const Vector3<float> q = Cross(s, e1);
+    const float v = Dot(pRay.direction, q) * inv_det;
+    if (v < 0.f || u + v > 1.f)
+        return false;
+    const float t = Dot(e2, q) * inv_det;
+    if (!(t > 0.f && t < pMaxT))
+        return false;
+
+    *pT = t;
+    *pU = u;
+    *pV = v;
+    return true;
+}
+
+// 32 bytes, two nodes per cache line. The children of an interior node are
+// stored depth first: the first child directly follows its parent.
+struct alignas(32) BvhNode
+{
+    bool IsLeaf() const noexcept { return count != 0; }
+
+    Vector3<float> lower;
+    // Leaves: index of the first triangle. Interior nodes: index of the
+    // second child.
+    uint32_t offset;
+    Vector3<float> upper;
+    // Number of triangles of a leaf, 0 for interior nodes.
+    uint32_t count;
+};
+
+static_assert(sizeof(BvhNode) == 32, "BvhNode should fill half a cache line");
+
+// Bounding volume hierarchy over a triangle soup, for ray casts whose cost
+// grows with the logarithm of the triangle count. The triangles are copied
+// in leaf order, so each leaf reads one contiguous range.
+class Bvh
+{
+public:
+    static constexpr uint32_t MaxLeafSize = 4;
+    // Bound on the tree depth, and so on the traversal stack.
+    static constexpr int MaxDepth = 64;
+    // Centroid bins per axis of the SAH split search.
+    static constexpr int BinCount = 16;
+    // Subtrees of at least this many triangles are built on their own
+    // thread with Execution::PARALLEL.
+    static constexpr uint32_t ParallelThreshold = 1 << 14;
+
+    Bvh() = default;
+    explicit Bvh(Span<const Triangle> pTriangles, Execution pExecution = Execution::SERIAL) { Build(pTriangles, pExecution); }
+
+    // Replaces the hierarchy. Each node is split where the surface area
+    // heuristic estimates the cheapest traversal, searched among BinCount
+    // centroid bins on each axis. With Execution::PARALLEL the two subtrees
+    // of each of the upper splits are built concurrently.
+    void Build(Span<const Triangle> pTriangles, Execution pExecution = Execution::SERIAL);
+
+    // Closest hit nearer than pHit->t. Returns false and leaves pHit
+    // unchanged on a miss.
+    bool Intersect(const Ray& pRay, RayHit* pHit) const;
+
+    // Bounds of all triangles, empty without triangles.
+    AABB<float> GetBounds() const;
+
+    const std::vector<BvhNode>& GetNodes() const { return mNodes; }
+    // Triangles in leaf order.
+    const std::vector<Triangle>& GetTriangles() const { return mTriangles; }
+    // Index passed to Build() of the triangle at leaf order position pIndex.
+    uint32_t GetTriangleIndex(uint32_t pIndex) const { return mTriangleIndices[pIndex]; }
+
+private:
+    std::vector<BvhNode> mNodes;
+    std::vector<Triangle> mTriangles;
+    std::vector<uint32_t> mTriangleIndices;
+};
+
+} // namespace mirage
+
+#endif
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "bvh.hpp"
+
+// Small triangles scattered through a 20 unit cube, some of them
+// overlapping.
+static std::vector<mirage::Triangle> MakeTriangleSoup(int pCount)
+{
+    using namespace mirage;
+
+    std::vector<Triangle> triangles;
+    for (int i = 0; i < pCount; ++i)
+    {
+        const float t = 0.37f * i;
+        const Vector3<float> c(10.f * std::sin(t), 10.f * std::cos(1.3f * t), 10.f * std::sin(0.7f * t));
+        const Vector3<float> a(std::cos(2.1f * t), std::sin(1.7f * t), 0.5f);
+        const Vector3<float> b(-std::sin(0.9f * t), 0.3f, std::cos(t));
+        triangles.push_back(Triangle{ c, c + a, c + b });
+    }
+    return triangles;
+}
+
+static bool IntersectAll(const std::vector<mirage::Triangle>& pTriangles, const mirage::Ray& pRay, float* pT, uint32_t* pTriangle)
+{
+    bool hit = false;
+    float u, v;
+    for (uint32_t i = 0; i < pTriangles.size(); ++i)
+    {
+        if (mirage::IntersectTriangle(pRay, pTriangles[i], *pT, pT, &u, &v))
+        {
+            *pTriangle = i;
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+static void ExpectValidHierarchy(const mirage::Bvh& pBvh, std::size_t pTriangleCount)
+{
+    using namespace mirage;
+
+    const std::vector<BvhNode>& nodes = pBvh.GetNodes();
+    std::vector<int> referenced(pTriangleCount, 0);
+    std::vector<int> depth(nodes.size(), 0);
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        EXPECT_LT(depth[i], Bvh::MaxDepth);
+        const AABB<float> bounds(nodes[i].lower, nodes[i].upper);
+        if (nodes[i].IsLeaf())
+        {
+            EXPECT_LE(nodes[i].count, Bvh::MaxLeafSize);
+            for (uint32_t k = nodes[i].offset; k < nodes[i].offset + nodes[i].count; ++k)
+            {
+                const Triangle& t = pBvh.GetTriangles()[k];
+                EXPECT_TRUE(bounds.Contains(t.v0) && bounds.Contains(t.v1) && bounds.Contains(t.v2));
+                referenced[pBvh.GetTriangleIndex(k)]++;
+            }
+            continue;
+        }
+        ASSERT_GT(nodes[i].offset, i + 1);
+        ASSERT_LT(nodes[i].offset, nodes.size());
+        for (std::size_t child : { i + 1, static_cast<std::size_t>(nodes[i].offset) })
+        {
+            EXPECT_TRUE(bounds.Contains(nodes[child].lower) && bounds.Contains(nodes[child].upper));
+            depth[child] = depth[i] + 1;
+        }
+    }
+    for (std::size_t i = 0; i < pTriangleCount; ++i)
+        EXPECT_EQ(referenced[i], 1) << i;
+}
+
+TEST(Bvh, NodesBoundTheirTriangles)
+{
+    using namespace mirage;
+
+    const std::vector<Triangle> triangles = MakeTriangleSoup(1001);
+    ExpectValidHierarchy(Bvh(triangles), triangles.size());
+
+    // Coincident centroids leave no SAH split to choose.
+    const std::vector<Triangle> stacked(100, triangles[0]);
+    ExpectValidHierarchy(Bvh(stacked), stacked.size());
+}
+
+TEST(Bvh, ParallelBuildMatchesSerial)
+{
+    using namespace mirage;
+
+    const std::vector<Triangle> triangles = MakeTriangleSoup(4 * Bvh::ParallelThreshold + 3);
+    const Bvh serial(triangles, Execution::SERIAL);
+    const Bvh parallel(triangles, Execution::PARALLEL);
+    ExpectValidHierarchy(parallel, triangles.size());
+
+    ASSERT_EQ(parallel.GetNodes().size(), serial.GetNodes().size());
+    EXPECT_EQ(std::memcmp(parallel.GetNodes().data(), serial.GetNodes().data(), serial.GetNodes().size() * sizeof(BvhNode)), 0);
+    for (uint32_t i = 0; i < triangles.size(); ++i)
+        ASSERT_EQ(parallel.GetTriangleIndex(i), serial.GetTriangleIndex(i));
+}
+
+TEST(Bvh, IntersectMatchesBruteForce)
+{
+    using namespace mirage;
+
+    const std::vector<Triangle> triangles = MakeTriangleSoup(1001);
+    const Bvh bvh(triangles);
+
+    int hits = 0;
+    for (int i = 0; i < 2000; ++i)
+    {
+        const float t = 0.71f * i;
+        Ray ray;
+        ray.origin = Vector3<float>(15.f * std::sin(t), 15.f * std::cos(t), 15.f * std::sin(1.9f * t));
+        ray.direction = Normalize(Vector3<float>(std::sin(2.3f * t), std::cos(1.1f * t), 0.f) - 0.05f * ray.origin);
+
+        float expected_t = std::numeric_limits<float>::infinity();
+        uint32_t expected_triangle = RayHit::NoHit;
+        const bool expected = IntersectAll(triangles, ray, &expected_t, &expected_triangle);
+
+        RayHit hit;
+        ASSERT_EQ(bvh.Intersect(ray, &hit), expected) << i;
+        if (!expected)
+        {
+            EXPECT_EQ(hit.triangle, RayHit::NoHit);
+            continue;
+        }
+        hits++;
+        EXPECT_EQ(hit.t, expected_t) << i;
+        EXPECT_EQ(bvh.GetTriangleIndex(hit.triangle), expected_triangle) << i;
+
+        // A shorter ray stops before the closest hit.
+        RayHit limited;
+        limited.t = 0.5f * expected_t;
+        EXPECT_FALSE(bvh.Intersect(ray, &limited)) << i;
+        EXPECT_EQ(limited.triangle, RayHit::NoHit);
+    }
+    // The rays should exercise both outcomes.
+    EXPECT_GT(hits, 100);
+    EXPECT_LT(hits, 1900);
+}
+
+TEST(Bvh, Empty)
+{
+    using namespace mirage;
+
+    const Bvh bvh{ Span<const Triangle>() };
+    RayHit hit;
+    EXPECT_FALSE(bvh.Intersect(Ray{ Vector3<float>(0.f), Vector3<float>(0.f, 0.f, 1.f) }, &hit));
+    EXPECT_TRUE(bvh.GetBounds().IsEmpty());
+}
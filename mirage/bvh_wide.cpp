@@ -0,0 +1,342 @@
+#include "bvh_wide.hpp"
+
+#include <algorithm>
+
+#include "check.hpp"
+#include "profiler.hpp"
+
+namespace mirage
+{
+
+namespace detail
+{
+
+// Triangles below a node of a binary Bvh, a contiguous range in leaf order.
+struct BvhRange
+{
+    uint32_t first;
+    uint32_t count;
+};
+
+// Children follow their parents in the depth-first layout, so one backward
+// pass sees every child before its parent.
+static std::vector<BvhRange> ComputeBvhRanges(const std::vector<BvhNode>& pNodes)
+{
+    std::vector<BvhRange> ranges(pNodes.size());
+    for (std::size_t i = pNodes.size(); i-- > 0;)
+    {
+        const BvhNode& n = pNodes[i];
+        if (n.IsLeaf())
+            ranges[i] = BvhRange{ n.offset, n.count };
+        else
+            ranges[i] = BvhRange{ ranges[i + 1].first, ranges[i + 1].count + ranges[n.offset].count };
+    }
+    return ranges;
+}
+
+static Triangle8 MakeTriangle8(const std::vector<Triangle>& pTriangles, BvhRange pRange)
+{
+    DCHECK_LE(pRange.count, static_cast<uint32_t>(Float8::Width));
+    Triangle8 block;
+    Vector3<float> v0[Float8::Width], e1[Float8::Width], e2[Float8::Width];
+    for (uint32_t i = 0; i < Float8::Width; ++i)
+    {
+        if (i < pRange.count)
+        {
+            const Triangle& t = pTriangles[pRange.first + i];
+            v0[i] = t.v0;
+            e1[i] = t.v1 - t.v0;
+            e2[i] = t.v2 - t.v0;
+            block.triangle[i] = pRange.first + i;
+        }
+        else
+        {
+            v0[i] = e1[i] = e2[i] = Vector3<float>(0.f);
+            block.triangle[i] = RayHit::NoHit;
+        }
+    }
+    block.v0 = Vector3x8<float>::Load(v0);
+    block.e1 = Vector3x8<float>::Load(e1);
+    block.e2 = Vector3x8<float>::Load(e2);
+    return block;
+}
+
+// Appends the Bvh8Node for the binary subtree pRoot and everything below,
+// depth first, and returns its index.
+static uint32_t CollapseBvhNode(const Bvh& pBvh, const std::vector<BvhRange>& pRanges, uint32_t pRoot,
+    std::vector<Bvh8Node>* pNodes, std::vector<Triangle8>* pLeaves)
+{
+    const std::vector<BvhNode>& nodes = pBvh.GetNodes();
+    uint32_t children[Float8::Width];
+    int count = 0;
+    if (pRanges[pRoot].count <= Float8::Width)
+    {
+        children[count++] = pRoot;
+    }
+    else
+    {
+        children[count++] = pRoot + 1;
+        children[count++] = nodes[pRoot].offset;
+        // Open up the largest subtree until there are eight. Subtrees of
+        // more than eight triangles are interior nodes, as leaves hold at
+        // most Bvh::MaxLeafSize.
+        while (count < Float8::Width)
+        {
+            int largest = -1;
+            float largest_area = -1.f;
+            for (int i = 0; i < count; ++i)
+            {
+                const BvhNode& n = nodes[children[i]];
+                const float area = AABB<float>(n.lower, n.upper).SurfaceArea();
+                if (pRanges[children[i]].count > Float8::Width && area > largest_area)
+                {
+                    largest = i;
+                    largest_area = area;
+                }
+            }
+            if (largest < 0)
+                break;
+            const uint32_t opened = children[largest];
+            children[largest] = opened + 1;
+            children[count++] = nodes[opened].offset;
+        }
+    }
+
+    const uint32_t index = static_cast<uint32_t>(pNodes->size());
+    pNodes->emplace_back();
+    {
+        // A box at infinity is never entered, unlike an inverted one, which
+        // the slab test would treat as the box between its corners.
+        constexpr float inf = std::numeric_limits<float>::infinity();
+        Bvh8Node& node = (*pNodes)[index];
+        for (int i = 0; i < Float8::Width; ++i)
+        {
+            node.lower_x[i] = node.lower_y[i] = node.lower_z[i] = inf;
+            node.upper_x[i] = node.upper_y[i] = node.upper_z[i] = inf;
+            node.child[i] = Bvh8Node::Empty;
+        }
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        const BvhNode& n = nodes[children[i]];
+        uint32_t child;
+        if (pRanges[children[i]].count <= Float8::Width)
+        {
+            child = Bvh8Node::Leaf | static_cast<uint32_t>(pLeaves->size());
+            pLeaves->push_back(MakeTriangle8(pBvh.GetTriangles(), pRanges[children[i]]));
+        }
+        else
+        {
+            child = CollapseBvhNode(pBvh, pRanges, children[i], pNodes, pLeaves);
+        }
+
+        Bvh8Node& node = (*pNodes)[index];
+        node.lower_x[i] = n.lower.x;
+        node.lower_y[i] = n.lower.y;
+        node.lower_z[i] = n.lower.z;
+        node.upper_x[i] = n.upper.x;
+        node.upper_y[i] = n.upper.y;
+        node.upper_z[i] = n.upper.z;
+        node.child[i] = child;
+    }
+    return index;
+}
+
+// Slab test of one ray against eight boxes, or eight rays against one box.
+// Lanes are set where the ray enters the box before pMaxT and leaves it
+// after 0, as in the scalar test of Bvh.
+inline Float8 IntersectBoxes8(const Vector3x8<float>& pLower, const Vector3x8<float>& pUpper,
+    const Vector3x8<float>& pOrigin, const Vector3x8<float>& pInverseDirection, const Float8& pMaxT, Float8* pEntry)
+{
+    const Vector3x8<float> t0 = (pLower - pOrigin) * pInverseDirection;
+    const Vector3x8<float> t1 = (pUpper - pOrigin) * pInverseDirection;
+    const Float8 entry = Max(Max(Min(t0.x, t1.x), Min(t0.y, t1.y)), Min(t0.z, t1.z));
+    const Float8 exit = Min(Min(Max(t0.x, t1.x), Max(t0.y, t1.y)), Max(t0.z, t1.z));
+    *pEntry = entry;
+    return (entry <= exit) & (exit > Float8(0.f)) & (entry < pMaxT);
+}
+
+} // namespace detail
+
+int IntersectPacket(const Bvh& pBvh, const RayPacket8& pRays, RayHit8* pHit)
+{
+    const std::vector<BvhNode>& nodes = pBvh.GetNodes();
+    if (nodes.empty())
+        return 0;
+    const std::vector<Triangle>& triangles = pBvh.GetTriangles();
+
+    const Vector3x8<float> inverse_direction(
+        Float8(1.f) / pRays.direction.x, Float8(1.f) / pRays.direction.y, Float8(1.f) / pRays.direction.z);
+    // Children are visited in the order along the first ray. For coherent
+    // rays that is the near to far order of most of them.
+    const Vector3<float> order_direction = pRays.direction.Get(0);
+
+    Float8 t = pHit->t;
+    Float8 u = pHit->u;
+    Float8 v = pHit->v;
+    int hits = 0;
+
+    uint32_t stack[Bvh::MaxDepth];
+    int stack_size = 0;
+    uint32_t node = 0;
+    for (;;)
+    {
+        const BvhNode& n = nodes[node];
+        Float8 entry;
+        const int active = MoveMask(detail::IntersectBoxes8(Vector3x8<float>(n.lower), Vector3x8<float>(n.upper),
+            pRays.origin, inverse_direction, t, &entry));
+        if (active != 0 && n.IsLeaf())
+        {
+            for (uint32_t k = n.offset; k < n.offset + n.count; ++k)
+            {
+                const Triangle& tri = triangles[k];
+                Float8 hit_t, hit_u, hit_v;
+                const Float8 hit = IntersectTriangles8(pRays.origin, pRays.direction, Vector3x8<float>(tri.v0),
+                    Vector3x8<float>(tri.v1 - tri.v0), Vector3x8<float>(tri.v2 - tri.v0), t, &hit_t, &hit_u, &hit_v);
+                const int mask = MoveMask(hit);
+                if (mask == 0)
+                    continue;
+                t = Select(hit, hit_t, t);
+                u = Select(hit, hit_u, u);
+                v = Select(hit, hit_v, v);
+                for (int j = 0; j < Float8::Width; ++j)
+                {
+                    if (mask & (1 << j))
+                        pHit->triangle[j] = k;
+                }
+                hits |= mask;
+            }
+        }
+        else if (active != 0)
+        {
+            uint32_t first = node + 1;
+            uint32_t second = n.offset;
+            const Vector3<float> first_center = AABB<float>(nodes[first].lower, nodes[first].upper).Center();
+            const Vector3<float> second_center = AABB<float>(nodes[second].lower, nodes[second].upper).Center();
+            if (Dot(second_center - first_center, order_direction) < 0.f)
+                std::swap(first, second);
+            DCHECK_LT(stack_size, Bvh::MaxDepth);
+            stack[stack_size++] = second;
+            node = first;
+            continue;
+        }
+
+        if (stack_size == 0)
+            break;
+        node = stack[--stack_size];
+    }
+
+    pHit->t = t;
+    pHit->u = u;
+    pHit->v = v;
+    return hits;
+}
+
+void Bvh8::Build(const Bvh& pBvh)
+{
+    MIRAGE_PROFILE_ZONE("Bvh8::Build");
+    mNodes.clear();
+    mLeaves.clear();
+    if (pBvh.GetNodes().empty())
+        return;
+
+    const std::vector<detail::BvhRange> ranges = detail::ComputeBvhRanges(pBvh.GetNodes());
+    // Each node opens at least one binary node, each leaf takes at least one
+    // triangle.
+    mNodes.reserve(pBvh.GetNodes().size() / 2 + 1);
+    mLeaves.reserve(pBvh.GetTriangles().size());
+    detail::CollapseBvhNode(pBvh, ranges, 0, &mNodes, &mLeaves);
+    mNodes.shrink_to_fit();
+    mLeaves.shrink_to_fit();
+}
+
+bool Bvh8::Intersect(const Ray& pRay, RayHit* pHit) const
+{
+    if (mNodes.empty())
+        return false;
+
+    const Vector3x8<float> origin(pRay.origin);
+    const Vector3x8<float> direction(pRay.direction);
+    const Vector3x8<float> inverse_direction(
+        Vector3<float>(1.f / pRay.direction.x, 1.f / pRay.direction.y, 1.f / pRay.direction.z));
+    float t = pHit->t;
+    float u = 0.f;
+    float v = 0.f;
+    uint32_t closest = RayHit::NoHit;
+
+    struct Entry
+    {
+        uint32_t child;
+        float distance;
+    };
+    // Up to seven entries wait per level.
+    Entry stack[(Float8::Width - 1) * Bvh::MaxDepth + 1];
+    int stack_size = 0;
+    stack[stack_size++] = Entry{ 0, 0.f };
+    while (stack_size > 0)
+    {
+        const Entry entry = stack[--stack_size];
+        if (entry.distance >= t)
+            continue;
+
+        if (entry.child & Bvh8Node::Leaf)
+        {
+            const Triangle8& leaf = mLeaves[entry.child & ~Bvh8Node::Leaf];
+            Float8 hit_t, hit_u, hit_v;
+            const int mask = MoveMask(IntersectTriangles8(origin, direction, leaf.v0, leaf.e1, leaf.e2, Float8(t),
+                &hit_t, &hit_u, &hit_v));
+            if (mask == 0)
+                continue;
+            alignas(32) float lanes_t[Float8::Width], lanes_u[Float8::Width], lanes_v[Float8::Width];
+            hit_t.Store(lanes_t);
+            hit_u.Store(lanes_u);
+            hit_v.Store(lanes_v);
+            for (int j = 0; j < Float8::Width; ++j)
+            {
+                if ((mask & (1 << j)) && lanes_t[j] < t)
+                {
+                    t = lanes_t[j];
+                    u = lanes_u[j];
+                    v = lanes_v[j];
+                    closest = leaf.triangle[j];
+                }
+            }
+            continue;
+        }
+
+        const Bvh8Node& node = mNodes[entry.child];
+        const Vector3x8<float> lower(Float8::Load(node.lower_x), Float8::Load(node.lower_y), Float8::Load(node.lower_z));
+        const Vector3x8<float> upper(Float8::Load(node.upper_x), Float8::Load(node.upper_y), Float8::Load(node.upper_z));
+        Float8 distance;
+        int mask = MoveMask(detail::IntersectBoxes8(lower, upper, origin, inverse_direction, Float8(t), &distance));
+        if (mask == 0)
+            continue;
+        alignas(32) float distances[Float8::Width];
+        distance.Store(distances);
+
+        // Push far to near, so that the nearest child is visited next.
+        const int first = stack_size;
+        for (int j = 0; j < Float8::Width; ++j)
+        {
+            if (!(mask & (1 << j)))
+                continue;
+            const Entry child{ node.child[j], distances[j] };
+            int k = stack_size++;
+            for (; k > first && stack[k - 1].distance < child.distance; --k)
+                stack[k] = stack[k - 1];
+            stack[k] = child;
+        }
+        DCHECK_LE(stack_size, static_cast<int>(ARRAYSIZE(stack)));
+    }
+
+    if (closest == RayHit::NoHit)
+        return false;
+    pHit->t = t;
+    pHit->u = u;
+    pHit->v = v;
+    pHit->triangle = closest;
+    return true;
+}
+
+} // namespace mirage
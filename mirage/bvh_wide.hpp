@@ -0,0 +1,116 @@
+#ifndef MIRAGE_BVH_WIDE_HPP
+#define MIRAGE_BVH_WIDE_HPP
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "bvh.hpp"
+#include "vecmath_wide.hpp"
+
+namespace mirage
+{
+
+// Eight rays, lane i of each component belonging to ray i.
+struct RayPacket8
+{
+    Vector3x8<float> origin;
+    Vector3x8<float> direction;
+};
+
+// RayHit for each ray of a packet.
+struct RayHit8
+{
+    RayHit8() : t(std::numeric_limits<float>::infinity()), u(0.f), v(0.f)
+    {
+        for (int i = 0; i < Float8::Width; ++i) triangle[i] = RayHit::NoHit;
+    }
+
+    Float8 t;
+    Float8 u;
+    Float8 v;
+    uint32_t triangle[Float8::Width];
+};
+
+// Moller-Trumbore on eight ray-triangle pairs, the same operations as
+// IntersectTriangle() so each lane gets its exact result. Broadcast the ray
+// to test one ray against eight triangles, or the triangle to test eight
+// rays against one triangle. Triangles are given by v0 and the edges
+// v1 - v0 and v2 - v0. Returns the mask of lanes that hit at a distance in
+// (0, pMaxT) and their distance and barycentrics. A zero determinant gives
+// an infinite or NaN u, which fails the range test.
+inline Float8 IntersectTriangles8(const Vector3x8<float>& pOrigin, const Vector3x8<float>& pDirection,
+    const Vector3x8<float>& pV0, const Vector3x8<float>& pE1, const Vector3x8<float>& pE2, const Float8& pMaxT,
+    Float8* pT, Float8* pU, Float8* pV)
+{
+    const Vector3x8<float> p = Cross(pDirection, pE2);
+    const Float8 inv_det = Float8(1.f) / Dot(pE1, p);
+    const Vector3x8<float> s = pOrigin - pV0;
+    const Float8 u = Dot(s, p) * inv_det;
+    const Vector3x8<float> q = Cross(s, pE1);
+    const Float8 v = Dot(pDirection, q) * inv_det;
+    const Float8 t = Dot(pE2, q) * inv_det;
+
+    *pT = t;
+    *pU = u;
+    *pV = v;
+    return (u >= Float8(0.f)) & (u <= Float8(1.f)) & (v >= Float8(0.f)) & (u + v <= Float8(1.f)) &
+        (t > Float8(0.f)) & (t < pMaxT);
+}
+
+// Closest hits of a packet of coherent rays, such as primary rays of
+// neighboring pixels. The rays walk the tree together, so each node is
+// loaded once for all of them, and each triangle is tested against all
+// eight rays at once. Lanes with a hit nearer than pHit->t get it in pHit.
+// Returns the mask of those lanes, bit i for ray i.
+int IntersectPacket(const Bvh& pBvh, const RayPacket8& pRays, RayHit8* pHit);
+
+// Eight triangles in SoA layout. Unused lanes have zero edges and never hit.
+struct Triangle8
+{
+    Vector3x8<float> v0;
+    Vector3x8<float> e1;
+    Vector3x8<float> e2;
+    // Index into Bvh::GetTriangles(), RayHit::NoHit for unused lanes.
+    uint32_t triangle[Float8::Width];
+};
+
+// Up to eight children with their bounds in SoA layout, to test a ray
+// against all of them at once.
+struct alignas(32) Bvh8Node
+{
+    static constexpr uint32_t Leaf = 0x80000000u;
+    static constexpr uint32_t Empty = 0xFFFFFFFFu;
+
+    float lower_x[Float8::Width], lower_y[Float8::Width], lower_z[Float8::Width];
+    float upper_x[Float8::Width], upper_y[Float8::Width], upper_z[Float8::Width];
+    // Index of the child node, Leaf | index of a Triangle8 block, or Empty.
+    uint32_t child[Float8::Width];
+};
+
+// Eight-wide BVH collapsed from a binary one: each node takes the up to
+// eight largest subtrees below, and subtrees of at most eight triangles
+// become one Triangle8 leaf. A single ray then tests eight boxes or eight
+// triangles per step, where the binary tree tests one.
+class Bvh8
+{
+public:
+    Bvh8() = default;
+    explicit Bvh8(const Bvh& pBvh) { Build(pBvh); }
+
+    void Build(const Bvh& pBvh);
+
+    // Same as Bvh::Intersect() on the source tree. Triangle indices refer
+    // to its Bvh::GetTriangles().
+    bool Intersect(const Ray& pRay, RayHit* pHit) const;
+
+    const std::vector<Bvh8Node>& GetNodes() const { return mNodes; }
+    const std::vector<Triangle8>& GetLeaves() const { return mLeaves; }
+
+private:
+    std::vector<Bvh8Node> mNodes;
+    std::vector<Triangle8> mLeaves;
+};
+
+} // namespace mirage
+
+#endif
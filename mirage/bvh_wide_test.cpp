@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "bvh_wide.hpp"
+
+// Small triangles scattered through a 20 unit cube, some of them
+// overlapping.
+static std::vector<mirage::Triangle> MakeTriangleSoup(int pCount)
+{
+    using namespace mirage;
+
+    std::vector<Triangle> triangles;
+    for (int i = 0; i < pCount; ++i)
+    {
+        const float t = 0.37f * i;
+        const Vector3<float> c(10.f * std::sin(t), 10.f * std::cos(1.3f * t), 10.f * std::sin(0.7f * t));
+        const Vector3<float> a(std::cos(2.1f * t), std::sin(1.7f * t), 0.5f);
+        const Vector3<float> b(-std::sin(0.9f * t), 0.3f, std::cos(t));
+        triangles.push_back(Triangle{ c, c + a, c + b });
+    }
+    return triangles;
+}
+
+static mirage::Ray MakeRay(int i)
+{
+    using namespace mirage;
+
+    const float t = 0.71f * i;
+    Ray ray;
+    ray.origin = Vector3<float>(15.f * std::sin(t), 15.f * std::cos(t), 15.f * std::sin(1.9f * t));
+    ray.direction = Normalize(Vector3<float>(std::sin(2.3f * t), std::cos(1.1f * t), 0.f) - 0.05f * ray.origin);
+    return ray;
+}
+
+// The scalar and the 8-wide intersection may be contracted into FMAs
+// differently, e.g. with -mfma. The rounding differences are amplified in
+// the barycentrics of thin triangles, where the determinant is small.
+static void ExpectNearDistance(float a, float b)
+{
+    EXPECT_NEAR(a, b, 1e-5f * (1.f + std::abs(b)));
+}
+
+static void ExpectNearBarycentric(float a, float b)
+{
+    EXPECT_NEAR(a, b, 1e-3f);
+}
+
+TEST(BvhWide, TriangleLanesMatchScalar)
+{
+    using namespace mirage;
+
+    const std::vector<Triangle> triangles = MakeTriangleSoup(800);
+    int hits = 0;
+    for (std::size_t i = 0; i < triangles.size(); i += Float8::Width)
+    {
+        // One ray through the middle of the first triangle, tested against
+        // eight triangles.
+        const Triangle& target = triangles[i];
+        Ray ray = MakeRay(static_cast<int>(i));
+        ray.direction = Normalize((target.v0 + target.v1 + target.v2) * (1.f / 3.f) - ray.origin);
+
+        Vector3<float> v0[8], e1[8], e2[8];
+        for (int j = 0; j < 8; ++j)
+        {
+            v0[j] = triangles[i + j].v0;
+            e1[j] = triangles[i + j].v1 - triangles[i + j].v0;
+            e2[j] = triangles[i + j].v2 - triangles[i + j].v0;
+        }
+        Float8 t, u, v;
+        const int mask = MoveMask(IntersectTriangles8(Vector3x8<float>(ray.origin), Vector3x8<float>(ray.direction),
+            Vector3x8<float>::Load(v0), Vector3x8<float>::Load(e1), Vector3x8<float>::Load(e2), Float8(100.f), &t, &u, &v));
+        for (int j = 0; j < 8; ++j)
+        {
+            float expected_t, expected_u, expected_v;
+            const bool expected = IntersectTriangle(ray, triangles[i + j], 100.f, &expected_t, &expected_u, &expected_v);
+            ASSERT_EQ((mask >> j) & 1, expected ? 1 : 0) << i + j;
+            if (!expected)
+                continue;
+            hits++;
+            ExpectNearDistance(t[j], expected_t);
+            ExpectNearBarycentric(u[j], expected_u);
+            ExpectNearBarycentric(v[j], expected_v);
+        }
+    }
+    EXPECT_GE(hits, 100);
+}
+
+TEST(BvhWide, TraversalsMatchBinaryBvh)
+{
+    using namespace mirage;
+
+    const std::vector<Triangle> triangles = MakeTriangleSoup(1001);
+    const Bvh bvh(triangles);
+    const Bvh8 bvh8(bvh);
+    ASSERT_FALSE(bvh8.GetNodes().empty());
+
+    int hits = 0;
+    for (int i = 0; i < 2000; i += Float8::Width)
+    {
+        RayPacket8 packet;
+        Vector3<float> origins[8], directions[8];
+        for (int j = 0; j < 8; ++j)
+        {
+            origins[j] = MakeRay(i + j).origin;
+            directions[j] = MakeRay(i + j).direction;
+        }
+        packet.origin = Vector3x8<float>::Load(origins);
+        packet.direction = Vector3x8<float>::Load(directions);
+        RayHit8 packet_hit;
+        const int packet_mask = IntersectPacket(bvh, packet, &packet_hit);
+
+        for (int j = 0; j < 8; ++j)
+        {
+            const Ray ray = MakeRay(i + j);
+            RayHit expected;
+            const bool hit = bvh.Intersect(ray, &expected);
+            hits += hit;
+
+            RayHit wide;
+            ASSERT_EQ(bvh8.Intersect(ray, &wide), hit) << i + j;
+            ASSERT_EQ((packet_mask >> j) & 1, hit ? 1 : 0) << i + j;
+            if (!hit)
+                continue;
+            ExpectNearDistance(wide.t, expected.t);
+            ExpectNearDistance(packet_hit.t[j], expected.t);
+            // Rays through a shared edge may report either triangle.
+            if (wide.triangle == expected.triangle)
+            {
+                ExpectNearBarycentric(wide.u, expected.u);
+            }
+            if (packet_hit.triangle[j] == expected.triangle)
+            {
+                ExpectNearBarycentric(packet_hit.u[j], expected.u);
+            }
+        }
+    }
+    EXPECT_GT(hits, 100);
+}
+
+TEST(BvhWide, CollapsesIntoWideNodes)
+{
+    using namespace mirage;
+
+    const std::vector<Triangle> triangles = MakeTriangleSoup(5000);
+    const Bvh bvh(triangles);
+    const Bvh8 bvh8(bvh);
+
+    // Every triangle in exactly one leaf lane, and every leaf lane inside
+    // the bounds its parent stores for it.
+    std::vector<int> referenced(triangles.size(), 0);
+    std::size_t children = 0;
+    for (const Bvh8Node& node : bvh8.GetNodes())
+    {
+        for (int i = 0; i < Float8::Width; ++i)
+        {
+            if (node.child[i] == Bvh8Node::Empty)
+                continue;
+            children++;
+            const AABB<float> bounds(Vector3<float>(node.lower_x[i], node.lower_y[i], node.lower_z[i]),
+                Vector3<float>(node.upper_x[i], node.upper_y[i], node.upper_z[i]));
+            if (!(node.child[i] & Bvh8Node::Leaf))
+                continue;
+            const Triangle8& leaf = bvh8.GetLeaves()[node.child[i] & ~Bvh8Node::Leaf];
+            for (int j = 0; j < Float8::Width; ++j)
+            {
+                if (leaf.triangle[j] == RayHit::NoHit)
+                    continue;
+                referenced[leaf.triangle[j]]++;
+                EXPECT_TRUE(bounds.Contains(leaf.v0.Get(j)));
+            }
+        }
+    }
+    for (std::size_t i = 0; i < triangles.size(); ++i)
+        EXPECT_EQ(referenced[i], 1) << i;
+    // Far fewer nodes than the binary tree.
+    EXPECT_GT(children, 3 * bvh8.GetNodes().size());
+    EXPECT_LT(bvh8.GetNodes().size(), bvh.GetNodes().size() / 8);
+}
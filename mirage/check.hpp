@@ -33,12 +33,12 @@ namespace mirage
     do { \
     } while (false)
 
-#define CHECK_EQ(x, y)  DCHECK_EMPTY
-#define CHECK_NEQ(x, y) DCHECK_EMPTY
-#define CHECK_L(x, y)   DCHECK_EMPTY
-#define CHECK_LE(x, y)  DCHECK_EMPTY
-#define CHECK_G(x, y)   DCHECK_EMPTY
-#define CHECK_GE(x, y)  DCHECK_EMPTY
+#define DCHECK_EQ(x, y)  DCHECK_EMPTY
+#define DCHECK_NE(x, y)  DCHECK_EMPTY
+#define DCHECK_LT(x, y)  DCHECK_EMPTY
+#define DCHECK_LE(x, y)  DCHECK_EMPTY
+#define DCHECK_GT(x, y)  DCHECK_EMPTY
+#define DCHECK_GE(x, y)  DCHECK_EMPTY
 
 #endif
 
@@ -0,0 +1,387 @@
+#include "compact_types.hpp"
+
+#include "check.hpp"
+#include "vecmath_wide.hpp"
+
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#include <immintrin.h>
+#define MIRAGE_COMPACT_F16C
+#endif
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MIRAGE_COMPACT_SSE
+#endif
+
+namespace mirage
+{
+
+namespace detail
+{
+
+#if defined(MIRAGE_COMPACT_SSE)
+
+// Four floats to halves in the low 16 bits of each lane, sign extended. The
+// same steps as FloatToHalfBits(), with the branches turned into masks.
+inline __m128i FloatToHalfBits4(__m128 pF)
+{
+    const __m128 sign_mask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000u)));
+    const __m128 sign = _mm_and_ps(pF, sign_mask);
+    const __m128 a = _mm_xor_ps(pF, sign);
+    const __m128i ai = _mm_castps_si128(a);
+
+    const __m128i is_nan = _mm_castps_si128(_mm_cmpunord_ps(a, a));
+    const __m128i is_regular = _mm_cmpgt_epi32(_mm_set1_epi32(0x47800000), ai);
+    const __m128i is_subnormal = _mm_cmpgt_epi32(_mm_set1_epi32(0x38800000), ai);
+
+    const __m128i nan_payload = _mm_or_si128(_mm_set1_epi32(0x200), _mm_and_si128(_mm_srli_epi32(ai, 13), _mm_set1_epi32(0x3ff)));
+    const __m128i inf_or_nan = _mm_or_si128(_mm_set1_epi32(0x7c00), _mm_and_si128(is_nan, nan_payload));
+
+    const __m128i half = _mm_set1_epi32(0x3f000000);
+    const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(a, _mm_castsi128_ps(half))), half);
+
+    const __m128i odd = _mm_and_si128(_mm_srli_epi32(ai, 13), _mm_set1_epi32(1));
+    const __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(ai, _mm_set1_epi32(static_cast<int>(0xc8000fffu))), odd), 13);
+
+    const __m128i finite = _mm_or_si128(_mm_and_si128(is_subnormal, subnormal), _mm_andnot_si128(is_subnormal, normal));
+    const __m128i joined = _mm_or_si128(_mm_and_si128(is_regular, finite), _mm_andnot_si128(is_regular, inf_or_nan));
+    return _mm_or_si128(joined, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+}
+
+// Four halves in the low 16 bits of each lane to floats. Scaling by 2^112
+// rebiases the exponent and renormalizes subnormals in one multiply.
+inline __m128 HalfBitsToFloat4(__m128i pH)
+{
+    const __m128i magnitude = _mm_and_si128(pH, _mm_set1_epi32(0x7fff));
+    const __m128i sign = _mm_slli_epi32(_mm_xor_si128(pH, magnitude), 16);
+    const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(magnitude, 13)),
+        _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+    const __m128i inf_or_nan = _mm_and_si128(_mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x7bff)), _mm_set1_epi32(255 << 23));
+    return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, inf_or_nan)));
+}
+
+// Clamps to [pLow, 1], maps NaN to 0 and rounds pF * pMax to nearest even,
+// like QuantizeNormalized().
+inline __m128i QuantizeNormalized4(__m128 pF, __m128 pLow, __m128 pMax)
+{
+    const __m128 f = _mm_and_ps(pF, _mm_cmpord_ps(pF, pF));
+    const __m128 c = _mm_min_ps(_mm_max_ps(f, pLow), _mm_set1_ps(1.f));
+    return _mm_cvtps_epi32(_mm_mul_ps(c, pMax));
+}
+
+inline __m128 DequantizeSnorm4(__m128i pI, __m128 pScale)
+{
+    return _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(pI), pScale), _mm_set1_ps(-1.f));
+}
+
+inline __m128 DequantizeUnorm4(__m128i pI, __m128 pScale)
+{
+    return _mm_mul_ps(_mm_cvtepi32_ps(pI), pScale);
+}
+
+#endif
+
+} // namespace detail
+
+void Pack(Span<const float> pIn, Span<Half> pOut)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+
+    std::size_t i = 0;
+#if defined(MIRAGE_COMPACT_F16C)
+    for (; i + 8 <= pIn.size(); i += 8)
+    {
+        const __m128i lo = _mm_cvtps_ph(_mm_loadu_ps(&pIn[i]), _MM_FROUND_TO_NEAREST_INT);
+        const __m128i hi = _mm_cvtps_ph(_mm_loadu_ps(&pIn[i + 4]), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&pOut[i]), _mm_unpacklo_epi64(lo, hi));
+    }
+#elif defined(MIRAGE_COMPACT_SSE)
+    for (; i + 8 <= pIn.size(); i += 8)
+    {
+        const __m128i lo = detail::FloatToHalfBits4(_mm_loadu_ps(&pIn[i]));
+        const __m128i hi = detail::FloatToHalfBits4(_mm_loadu_ps(&pIn[i + 4]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&pOut[i]), _mm_packs_epi32(lo, hi));
+    }
+#endif
+    for (; i < pIn.size(); ++i)
+        pOut[i] = Half(pIn[i]);
+}
+
+void Unpack(Span<const Half> pIn, Span<float> pOut)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+
+    std::size_t i = 0;
+#if defined(MIRAGE_COMPACT_F16C)
+    for (; i + 8 <= pIn.size(); i += 8)
+    {
+        const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pIn[i]));
+        _mm_storeu_ps(&pOut[i], _mm_cvtph_ps(h));
+        _mm_storeu_ps(&pOut[i + 4], _mm_cvtph_ps(_mm_unpackhi_epi64(h, h)));
+    }
+#elif defined(MIRAGE_COMPACT_SSE)
+    for (; i + 8 <= pIn.size(); i += 8)
+    {
+        const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pIn[i]));
+        const __m128i zero = _mm_setzero_si128();
+        _mm_storeu_ps(&pOut[i], detail::HalfBitsToFloat4(_mm_unpacklo_epi16(h, zero)));
+        _mm_storeu_ps(&pOut[i + 4], detail::HalfBitsToFloat4(_mm_unpackhi_epi16(h, zero)));
+    }
+#endif
+    for (; i < pIn.size(); ++i)
+        pOut[i] = pIn[i];
+}
+
+void Pack(Span<const float> pIn, Span<Snorm8> pOut)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+
+    std::size_t i = 0;
+#if defined(MIRAGE_COMPACT_SSE)
+    const __m128 low = _mm_set1_ps(-1.f);
+    const __m128 max = _mm_set1_ps(Snorm8::Max);
+    for (; i + 8 <= pIn.size(); i += 8)
+    {
+        const __m128i lo = detail::QuantizeNormalized4(_mm_loadu_ps(&pIn[i]), low, max);
+        const __m128i hi = detail::QuantizeNormalized4(_mm_loadu_ps(&pIn[i + 4]), low, max);
+        const __m128i words = _mm_packs_epi32(lo, hi);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&pOut[i]), _mm_packs_epi16(words, words));
+    }
+#endif
+    for (; i < pIn.size(); ++i)
+        pOut[i] = Snorm8(pIn[i]);
+}
+
+void Pack(Span<const float> pIn, Span<Snorm16> pOut)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+
+    std::size_t i = 0;
+#if defined(MIRAGE_COMPACT_SSE)
+    const __m128 low = _mm_set1_ps(-1.f);
+    const __m128 max = _mm_set1_ps(Snorm16::Max);
+    for (; i + 8 <= pIn.size(); i += 8)
+    {
+        const __m128i lo = detail::QuantizeNormalized4(_mm_loadu_ps(&pIn[i]), low, max);
+        const __m128i hi = detail::QuantizeNormalized4(_mm_loadu_ps(&pIn[i + 4]), low, max);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&pOut[i]), _mm_packs_epi32(lo, hi));
+    }
+#endif
+    for (; i < pIn.size(); ++i)
+        pOut[i] = Snorm16(pIn[i]);
+}
+
+void Pack(Span<const float> pIn, Span<Unorm8> pOut)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+
+    std::size_t i = 0;
+#if defined(MIRAGE_COMPACT_SSE)
+    const __m128 low = _mm_setzero_ps();
+    const __m128 max = _mm_set1_ps(Unorm8::Max);
+    for (; i + 8 <= pIn.size(); i += 8)
+    {
+        const __m128i lo = detail::QuantizeNormalized4(_mm_loadu_ps(&pIn[i]), low, max);
+        const __m128i hi = detail::QuantizeNormalized4(_mm_loadu_ps(&pIn[i + 4]), low, max);
+        const __m128i words = _mm_packs_epi32(lo, hi);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&pOut[i]), _mm_packus_epi16(words, words));
+    }
+#endif
+    for (; i < pIn.size(); ++i)
+        pOut[i] = Unorm8(pIn[i]);
+}
+
+void Pack(Span<const float> pIn, Span<Unorm16> pOut)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+
+    std::size_t i = 0;
+#if defined(MIRAGE_COMPACT_SSE)
+    const __m128 low = _mm_setzero_ps();
+    const __m128 max = _mm_set1_ps(Unorm16::Max);
+    // SSE2 has no unsigned saturating 32 to 16 bit pack. The values are in
+    // range already, so offset them into the signed range and back.
+    const __m128i bias = _mm_set1_epi32(0x8000);
+    const __m128i flip = _mm_set1_epi16(static_cast<short>(0x8000));
+    for (; i + 8 <= pIn.size(); i += 8)
+    {
+        const __m128i lo = _mm_sub_epi32(detail::QuantizeNormalized4(_mm_loadu_ps(&pIn[i]), low, max), bias);
+        const __m128i hi = _mm_sub_epi32(detail::QuantizeNormalized4(_mm_loadu_ps(&pIn[i + 4]), low, max), bias);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&pOut[i]), _mm_xor_si128(_mm_packs_epi32(lo, hi), flip));
+    }
+#endif
+    for (; i < pIn.size(); ++i)
+        pOut[i] = Unorm16(pIn[i]);
+}
+
+void Unpack(Span<const Snorm8> pIn, Span<float> pOut)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+
+    std::size_t i = 0;
+#if defined(MIRAGE_COMPACT_SSE)
+    const __m128 scale = _mm_set1_ps(1.f / Snorm8::Max);
+    for (; i + 8 <= pIn.size(); i += 8)
+    {
+        const __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&pIn[i]));
+        const __m128i words = _mm_srai_epi16(_mm_unpacklo_epi8(b, b), 8);
+        _mm_storeu_ps(&pOut[i], detail::DequantizeSnorm4(_mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16), scale));
+        _mm_storeu_ps(&pOut[i + 4], detail::DequantizeSnorm4(_mm_srai_epi32(_mm_unpackhi_epi16(words, words), 16), scale));
+    }
+#endif
+    for (; i < pIn.size(); ++i)
+        pOut[i] = pIn[i];
+}
+
+void Unpack(Span<const Snorm16> pIn, Span<float> pOut)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+
+    std::size_t i = 0;
+#if defined(MIRAGE_COMPACT_SSE)
+    const __m128 scale = _mm_set1_ps(1.f / Snorm16::Max);
+    for (; i + 8 <= pIn.size(); i += 8)
+    {
+        const __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pIn[i]));
+        _mm_storeu_ps(&pOut[i], detail::DequantizeSnorm4(_mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16), scale));
+        _mm_storeu_ps(&pOut[i + 4], detail::DequantizeSnorm4(_mm_srai_epi32(_mm_unpackhi_epi16(words, words), 16), scale));
+    }
+#endif
+    for (; i < pIn.size(); ++i)
+        pOut[i] = pIn[i];
+}
+
+void Unpack(Span<const Unorm8> pIn, Span<float> pOut)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+
+    std::size_t i = 0;
+#if defined(MIRAGE_COMPACT_SSE)
+    const __m128 scale = _mm_set1_ps(1.f / Unorm8::Max);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= pIn.size(); i += 8)
+    {
+        const __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&pIn[i]));
+        const __m128i words = _mm_unpacklo_epi8(b, zero);
+        _mm_storeu_ps(&pOut[i], detail::DequantizeUnorm4(_mm_unpacklo_epi16(words, zero), scale));
+        _mm_storeu_ps(&pOut[i + 4], detail::DequantizeUnorm4(_mm_unpackhi_epi16(words, zero), scale));
+    }
+#endif
+    for (; i < pIn.size(); ++i)
+        pOut[i] = pIn[i];
+}
+
+void Unpack(Span<const Unorm16> pIn, Span<float> pOut)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+
+    std::size_t i = 0;
+#if defined(MIRAGE_COMPACT_SSE)
+    const __m128 scale = _mm_set1_ps(1.f / Unorm16::Max);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= pIn.size(); i += 8)
+    {
+        const __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pIn[i]));
+        _mm_storeu_ps(&pOut[i], detail::DequantizeUnorm4(_mm_unpacklo_epi16(words, zero), scale));
+        _mm_storeu_ps(&pOut[i + 4], detail::DequantizeUnorm4(_mm_unpackhi_epi16(words, zero), scale));
+    }
+#endif
+    for (; i < pIn.size(); ++i)
+        pOut[i] = pIn[i];
+}
+
+namespace detail
+{
+
+inline Float8 Abs(const Float8& a)
+{
+    return Max(a, -a);
+}
+
+inline Float8 SignNotZero(const Float8& a)
+{
+    return Select(a >= Float8(0.f), Float8(1.f), Float8(-1.f));
+}
+
+// Eight normals at a time: the projection and fold run on Float8, the
+// quantization on the interleaved u, v pairs through the Snorm array packer.
+template<typename I>
+void PackOctNormals(Span<const Vector3<float>> pIn, Span<OctNormal<I>> pOut)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+    static_assert(sizeof(OctNormal<I>) == 2 * sizeof(I), "OctNormal must be two packed Snorms.");
+
+    std::size_t i = 0;
+    for (; i + Float8::Width <= pIn.size(); i += Float8::Width)
+    {
+        const Vector3x8<float> n = Vector3x8<float>::Load(&pIn[i]);
+        const Float8 inv = Float8(1.f) / (Abs(n.x) + Abs(n.y) + Abs(n.z));
+        const Float8 u = n.x * inv;
+        const Float8 v = n.y * inv;
+        const Float8 lower = n.z < Float8(0.f);
+        const Float8 fu = Select(lower, (Float8(1.f) - Abs(v)) * SignNotZero(u), u);
+        const Float8 fv = Select(lower, (Float8(1.f) - Abs(u)) * SignNotZero(v), v);
+
+        alignas(32) float us[Float8::Width];
+        alignas(32) float vs[Float8::Width];
+        fu.Store(us);
+        fv.Store(vs);
+        float uv[2 * Float8::Width];
+        for (int k = 0; k < Float8::Width; ++k)
+        {
+            uv[2 * k] = us[k];
+            uv[2 * k + 1] = vs[k];
+        }
+        Pack(Span<const float>(uv, 2 * Float8::Width), Span<Snorm<I>>(&pOut[i].x, 2 * Float8::Width));
+    }
+    for (; i < pIn.size(); ++i)
+        pOut[i] = OctNormal<I>(pIn[i]);
+}
+
+template<typename I>
+void UnpackOctNormals(Span<const OctNormal<I>> pIn, Span<Vector3<float>> pOut)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+
+    std::size_t i = 0;
+    for (; i + Float8::Width <= pIn.size(); i += Float8::Width)
+    {
+        float uv[2 * Float8::Width];
+        Unpack(Span<const Snorm<I>>(&pIn[i].x, 2 * Float8::Width), Span<float>(uv, 2 * Float8::Width));
+        const Float8 u(uv[0], uv[2], uv[4], uv[6], uv[8], uv[10], uv[12], uv[14]);
+        const Float8 v(uv[1], uv[3], uv[5], uv[7], uv[9], uv[11], uv[13], uv[15]);
+
+        const Float8 z = Float8(1.f) - Abs(u) - Abs(v);
+        const Float8 t = Max(-z, Float8(0.f));
+        const Vector3x8<float> n(
+            Select(u >= Float8(0.f), u - t, u + t),
+            Select(v >= Float8(0.f), v - t, v + t),
+            z);
+        Normalize(n).Store(&pOut[i]);
+    }
+    for (; i < pIn.size(); ++i)
+        pOut[i] = pIn[i].Decode();
+}
+
+} // namespace detail
+
+void Pack(Span<const Vector3<float>> pIn, Span<OctNormal8> pOut)
+{
+    detail::PackOctNormals(pIn, pOut);
+}
+
+void Pack(Span<const Vector3<float>> pIn, Span<OctNormal16> pOut)
+{
+    detail::PackOctNormals(pIn, pOut);
+}
+
+void Unpack(Span<const OctNormal8> pIn, Span<Vector3<float>> pOut)
+{
+    detail::UnpackOctNormals(pIn, pOut);
+}
+
+void Unpack(Span<const OctNormal16> pIn, Span<Vector3<float>> pOut)
+{
+    detail::UnpackOctNormals(pIn, pOut);
+}
+
+} // namespace mirage
@@ -0,0 +1,269 @@
+#ifndef MIRAGE_COMPACT_TYPES_HPP
+#define MIRAGE_COMPACT_TYPES_HPP
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "util.hpp"
+#include "vecmath.hpp"
+
+namespace mirage
+{
+
+// Storage types for vertex data. Each converts explicitly from float and
+// implicitly to float, and works as the element type of Vector2/3/4:
+//
+//   Vector3<Half> position = ConvertComponents<Half>(p);   // 6 bytes instead of 12
+//   Vector3<float> p2 = ConvertComponents<float>(position);
+//
+// Arithmetic is done on float. Comparisons are bitwise. The Pack() and
+// Unpack() overloads below convert whole arrays with SIMD. An array of
+// Vector3 is an array of 3 * N components, e.g.
+//
+//   Pack(Span<const float>(&p[0].x, 3 * n), Span<Half>(&position[0].x, 3 * n));
+
+namespace detail
+{
+
+inline uint16_t FloatToHalfBits(float f) noexcept
+{
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    const uint32_t sign = (x >> 16) & 0x8000u;
+    x &= 0x7fffffffu;
+
+    uint32_t h;
+    if (x >= 0x47800000u)
+    {
+        // Too large for half, Inf or NaN. NaN keeps its upper payload bits
+        // and becomes quiet.
+        h = x > 0x7f800000u ? 0x7e00u | ((x >> 13) & 0x3ffu) : 0x7c00u;
+    }
+    else if (x < 0x38800000u)
+    {
+        // Subnormal half or zero. Adding 0.5 aligns the half mantissa with the
+        // low float mantissa bits and lets the FPU round to nearest even.
+        float a;
+        std::memcpy(&a, &x, sizeof(a));
+        a += 0.5f;
+        uint32_t bits;
+        std::memcpy(&bits, &a, sizeof(bits));
+        h = bits - 0x3f000000u;
+    }
+    else
+    {
+        // Rebias the exponent and round the mantissa to nearest even. Values
+        // that round past the largest half carry into the Inf encoding.
+        const uint32_t odd = (x >> 13) & 1u;
+        h = (x + 0xc8000fffu + odd) >> 13;
+    }
+    return static_cast<uint16_t>(sign | h);
+}
+
+inline float HalfBitsToFloat(uint16_t h) noexcept
+{
+    const uint32_t shifted_exponent = 0x7c00u << 13;
+    uint32_t x = (h & 0x7fffu) << 13;
+    const uint32_t exponent = x & shifted_exponent;
+    x += (127 - 15) << 23;
+
+    float f;
+    if (exponent == shifted_exponent)
+    {
+        // Inf or NaN.
+        x += (128 - 16) << 23;
+        std::memcpy(&f, &x, sizeof(f));
+    }
+    else if (exponent == 0)
+    {
+        // Zero or subnormal, renormalized by the FPU.
+        x += 1u << 23;
+        std::memcpy(&f, &x, sizeof(f));
+        f -= 6.10351562e-05f;
+    }
+    else
+    {
+        std::memcpy(&f, &x, sizeof(f));
+    }
+
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    bits |= static_cast<uint32_t>(h & 0x8000u) << 16;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// Clamps to [pLow, 1] and maps NaN to 0, then rounds pF * pMax to nearest even.
+template<typename I>
+inline I QuantizeNormalized(float pF, float pLow, float pMax) noexcept
+{
+    const float c = pF != pF ? 0.f : std::min(std::max(pF, pLow), 1.f);
+    return static_cast<I>(std::nearbyint(c * pMax));
+}
+
+} // namespace detail
+
+// IEEE 754 binary16: 11 bits of precision, range +-65504.
+struct Half
+{
+    Half() = default;
+    explicit Half(float f) noexcept : bits(detail::FloatToHalfBits(f)) {}
+
+    static constexpr Half FromBits(uint16_t pBits) noexcept
+    {
+        Half h{};
+        h.bits = pBits;
+        return h;
+    }
+
+    operator float() const noexcept { return detail::HalfBitsToFloat(bits); }
+
+    constexpr bool operator==(const Half& h) const noexcept { return bits == h.bits; }
+    constexpr bool operator!=(const Half& h) const noexcept { return bits != h.bits; }
+
+    uint16_t bits;
+};
+
+// Signed normalized integer: [-1, 1] in steps of 1 / max(I). The most negative
+// integer also decodes to -1, as in D3D and OpenGL.
+template<typename I>
+struct Snorm
+{
+    static_assert(std::is_integral_v<I> && std::is_signed_v<I>, "Snorm needs a signed integer.");
+    static constexpr float Max = static_cast<float>(std::numeric_limits<I>::max());
+
+    Snorm() = default;
+    explicit Snorm(float f) noexcept : bits(detail::QuantizeNormalized<I>(f, -1.f, Max)) {}
+
+    static constexpr Snorm FromBits(I pBits) noexcept
+    {
+        Snorm s{};
+        s.bits = pBits;
+        return s;
+    }
+
+    operator float() const noexcept { return std::max(bits * (1.f / Max), -1.f); }
+
+    constexpr bool operator==(const Snorm& s) const noexcept { return bits == s.bits; }
+    constexpr bool operator!=(const Snorm& s) const noexcept { return bits != s.bits; }
+
+    I bits;
+};
+
+// Unsigned normalized integer: [0, 1] in steps of 1 / max(I).
+template<typename I>
+struct Unorm
+{
+    static_assert(std::is_integral_v<I> && std::is_unsigned_v<I>, "Unorm needs an unsigned integer.");
+    static constexpr float Max = static_cast<float>(std::numeric_limits<I>::max());
+
+    Unorm() = default;
+    explicit Unorm(float f) noexcept : bits(detail::QuantizeNormalized<I>(f, 0.f, Max)) {}
+
+    static constexpr Unorm FromBits(I pBits) noexcept
+    {
+        Unorm u{};
+        u.bits = pBits;
+        return u;
+    }
+
+    operator float() const noexcept { return bits * (1.f / Max); }
+
+    constexpr bool operator==(const Unorm& u) const noexcept { return bits == u.bits; }
+    constexpr bool operator!=(const Unorm& u) const noexcept { return bits != u.bits; }
+
+    I bits;
+};
+
+using Snorm8 = Snorm<int8_t>;
+using Snorm16 = Snorm<int16_t>;
+using Unorm8 = Unorm<uint8_t>;
+using Unorm16 = Unorm<uint16_t>;
+
+// Unit vector in two Snorm components: the octahedron |x| + |y| + |z| = 1
+// unfolded onto the square [-1, 1]^2. OctNormal16 keeps normals within 0.004
+// degrees in 4 bytes, OctNormal8 within 1 degree in 2 bytes.
+template<typename I>
+struct OctNormal
+{
+    OctNormal() = default;
+
+    // pNormal must not be zero. It does not need to be normalized.
+    explicit OctNormal(const Vector3<float>& pNormal) noexcept
+    {
+        const float inv = 1.f / (std::abs(pNormal.x) + std::abs(pNormal.y) + std::abs(pNormal.z));
+        float u = pNormal.x * inv;
+        float v = pNormal.y * inv;
+        if (pNormal.z < 0.f)
+        {
+            // Fold the lower half over the diagonals.
+            const float fu = (1.f - std::abs(v)) * (u >= 0.f ? 1.f : -1.f);
+            const float fv = (1.f - std::abs(u)) * (v >= 0.f ? 1.f : -1.f);
+            u = fu;
+            v = fv;
+        }
+        x = Snorm<I>(u);
+        y = Snorm<I>(v);
+    }
+
+    // The unit vector, renormalized after quantization.
+    Vector3<float> Decode() const noexcept
+    {
+        const float u = x;
+        const float v = y;
+        const float z = 1.f - std::abs(u) - std::abs(v);
+        const float t = std::max(-z, 0.f);
+        return Normalize(Vector3<float>(u >= 0.f ? u - t : u + t, v >= 0.f ? v - t : v + t, z));
+    }
+
+    constexpr bool operator==(const OctNormal& o) const noexcept { return x == o.x && y == o.y; }
+    constexpr bool operator!=(const OctNormal& o) const noexcept { return !(*this == o); }
+
+    Snorm<I> x, y;
+};
+
+using OctNormal8 = OctNormal<int8_t>;
+using OctNormal16 = OctNormal<int16_t>;
+
+template<typename To, typename From>
+Vector2<To> ConvertComponents(const Vector2<From>& v) noexcept
+{
+    return Vector2<To>(To(v.x), To(v.y));
+}
+
+template<typename To, typename From>
+Vector3<To> ConvertComponents(const Vector3<From>& v) noexcept
+{
+    return Vector3<To>(To(v.x), To(v.y), To(v.z));
+}
+
+template<typename To, typename From>
+Vector4<To> ConvertComponents(const Vector4<From>& v) noexcept
+{
+    return Vector4<To>(To(v.x), To(v.y), To(v.z), To(v.w));
+}
+
+// Array conversions. Each element converts exactly like the scalar
+// constructor and conversion operator. Outputs must have the size of the inputs.
+void Pack(Span<const float> pIn, Span<Half> pOut);
+void Pack(Span<const float> pIn, Span<Snorm8> pOut);
+void Pack(Span<const float> pIn, Span<Snorm16> pOut);
+void Pack(Span<const float> pIn, Span<Unorm8> pOut);
+void Pack(Span<const float> pIn, Span<Unorm16> pOut);
+void Pack(Span<const Vector3<float>> pIn, Span<OctNormal8> pOut);
+void Pack(Span<const Vector3<float>> pIn, Span<OctNormal16> pOut);
+
+void Unpack(Span<const Half> pIn, Span<float> pOut);
+void Unpack(Span<const Snorm8> pIn, Span<float> pOut);
+void Unpack(Span<const Snorm16> pIn, Span<float> pOut);
+void Unpack(Span<const Unorm8> pIn, Span<float> pOut);
+void Unpack(Span<const Unorm16> pIn, Span<float> pOut);
+void Unpack(Span<const OctNormal8> pIn, Span<Vector3<float>> pOut);
+void Unpack(Span<const OctNormal16> pIn, Span<Vector3<float>> pOut);
+
+} // namespace mirage
+
+#endif
@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "compact_types.hpp"
+
+static_assert(std::is_trivially_copyable_v<mirage::Half>);
+static_assert(std::is_trivially_copyable_v<mirage::Vector3<mirage::Half>>);
+static_assert(std::is_trivially_copyable_v<mirage::Vector4<mirage::Snorm16>>);
+static_assert(sizeof(mirage::Vector3<mirage::Half>) == 6);
+static_assert(sizeof(mirage::Vector4<mirage::Unorm8>) == 4);
+static_assert(sizeof(mirage::OctNormal16) == 4);
+static_assert(sizeof(mirage::OctNormal8) == 2);
+
+static uint32_t FloatBits(float f)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+static float BitsFloat(uint32_t bits)
+{
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// Floats around every interesting half boundary, plus the specials.
+static std::vector<float> MakeHalfInputs()
+{
+    std::vector<float> in;
+    for (uint32_t h = 0; h < 0x10000; ++h)
+    {
+        const uint32_t f = FloatBits(mirage::Half::FromBits(static_cast<uint16_t>(h)));
+        // The value itself, halfway to the next half, and a bit either side.
+        in.push_back(BitsFloat(f));
+        in.push_back(BitsFloat(f + 0x1000));
+        in.push_back(BitsFloat(f + 0x0fff));
+        in.push_back(BitsFloat(f + 0x1001));
+    }
+    const float inf = std::numeric_limits<float>::infinity();
+    for (float f : { 0.f, -0.f, 1e-10f, -1e-10f, 65504.f, 65519.f, 65520.f, 70000.f, 1e30f, inf, -inf })
+        in.push_back(f);
+    return in;
+}
+
+TEST(Half, ConvertsExactly)
+{
+    using namespace mirage;
+
+    EXPECT_EQ(Half(1.f).bits, 0x3c00);
+    EXPECT_EQ(Half(-2.f).bits, 0xc000);
+    EXPECT_EQ(Half(65504.f).bits, 0x7bff);
+    EXPECT_EQ(Half(65520.f).bits, 0x7c00);
+    EXPECT_EQ(Half(5.96046448e-08f).bits, 0x0001);
+    EXPECT_EQ(Half(2.98023224e-08f).bits, 0x0000);  // Halfway to the smallest subnormal, ties to even.
+    EXPECT_EQ(Half(1.f + 1.f / 2048).bits, 0x3c00); // Halfway, ties to even.
+    EXPECT_EQ(Half(1.f + 3.f / 2048).bits, 0x3c02);
+    EXPECT_TRUE(std::isnan(static_cast<float>(Half(std::numeric_limits<float>::quiet_NaN()))));
+
+    // Every half round-trips through float.
+    for (uint32_t h = 0; h < 0x10000; ++h)
+    {
+        const Half half = Half::FromBits(static_cast<uint16_t>(h));
+        const float f = half;
+        if (std::isnan(f))
+            continue;
+        EXPECT_EQ(Half(f).bits, h);
+    }
+
+    // Nearest-even rounding, checked against double arithmetic.
+    for (float f : MakeHalfInputs())
+    {
+        if (std::isnan(f) || std::abs(f) >= 65520.f)
+            continue;
+        const Half h(f);
+        const double below = static_cast<float>(Half::FromBits(h.bits));
+        const double above = static_cast<float>(Half::FromBits(static_cast<uint16_t>(h.bits + 1)));
+        const double below_error = std::abs(static_cast<double>(f) - below);
+        ASSERT_LE(below_error, std::abs(static_cast<double>(f) - above)) << f;
+    }
+}
+
+TEST(Half, ArraysMatchScalar)
+{
+    using namespace mirage;
+
+    const std::vector<float> in = MakeHalfInputs();
+    std::vector<Half> packed(in.size());
+    Pack(in, packed);
+    for (std::size_t i = 0; i < in.size(); ++i)
+    {
+        if (std::isnan(in[i]))
+            EXPECT_TRUE(std::isnan(static_cast<float>(packed[i])));
+        else
+            ASSERT_EQ(packed[i].bits, Half(in[i]).bits) << in[i];
+    }
+
+    std::vector<Half> all(0x10000 + 3);
+    for (std::size_t i = 0; i < all.size(); ++i)
+        all[i] = Half::FromBits(static_cast<uint16_t>(i));
+    std::vector<float> unpacked(all.size());
+    Unpack(all, unpacked);
+    for (std::size_t i = 0; i < all.size(); ++i)
+    {
+        const float f = all[i];
+        if (std::isnan(f))
+            EXPECT_TRUE(std::isnan(unpacked[i]));
+        else
+            ASSERT_EQ(FloatBits(unpacked[i]), FloatBits(f)) << i;
+    }
+}
+
+template<typename T>
+static void ExpectArraysMatchScalar()
+{
+    using namespace mirage;
+
+    std::vector<float> in;
+    for (int i = -1100; i <= 1100; ++i)
+        in.push_back(i * 0.001f);
+    in.push_back(std::numeric_limits<float>::quiet_NaN());
+    in.push_back(std::numeric_limits<float>::infinity());
+    in.push_back(-std::numeric_limits<float>::infinity());
+
+    std::vector<T> packed(in.size());
+    Pack(in, packed);
+    for (std::size_t i = 0; i < in.size(); ++i)
+        ASSERT_EQ(packed[i], T(in[i])) << in[i];
+
+    // Every encoding, including the most negative Snorm.
+    using I = decltype(T().bits);
+    std::vector<T> all;
+    for (int i = std::numeric_limits<I>::min(); i <= std::numeric_limits<I>::max(); ++i)
+    {
+        T t;
+        t.bits = static_cast<I>(i);
+        all.push_back(t);
+    }
+    std::vector<float> unpacked(all.size());
+    Unpack(all, unpacked);
+    for (std::size_t i = 0; i < all.size(); ++i)
+    {
+        ASSERT_EQ(unpacked[i], static_cast<float>(all[i]));
+        ASSERT_EQ(T(unpacked[i]), all[i].bits == std::numeric_limits<I>::min() ? T(-1.f) : all[i]);
+    }
+}
+
+TEST(Normalized, ConvertsExactly)
+{
+    using namespace mirage;
+
+    EXPECT_EQ(Snorm16(1.f).bits, 32767);
+    EXPECT_EQ(Snorm16(-1.f).bits, -32767);
+    EXPECT_EQ(Snorm16(2.f).bits, 32767);
+    EXPECT_EQ(Snorm16(std::numeric_limits<float>::quiet_NaN()).bits, 0);
+    EXPECT_EQ(static_cast<float>(Snorm8::FromBits(-128)), -1.f);
+    EXPECT_EQ(Snorm8(0.5f).bits, 64);
+    EXPECT_EQ(Unorm8(0.5f).bits, 128);
+    EXPECT_EQ(Unorm8(-0.5f).bits, 0);
+    EXPECT_EQ(Unorm16(1.f).bits, 65535);
+    EXPECT_EQ(static_cast<float>(Unorm8::FromBits(255)), 1.f);
+}
+
+TEST(Normalized, ArraysMatchScalar)
+{
+    ExpectArraysMatchScalar<mirage::Snorm8>();
+    ExpectArraysMatchScalar<mirage::Snorm16>();
+    ExpectArraysMatchScalar<mirage::Unorm8>();
+    ExpectArraysMatchScalar<mirage::Unorm16>();
+}
+
+TEST(Normalized, VectorElements)
+{
+    using namespace mirage;
+
+    const Vector3<float> p(0.25f, -0.5f, 1.f);
+    const Vector3<Half> h = ConvertComponents<Half>(p);
+    EXPECT_EQ(ConvertComponents<float>(h), p);
+
+    const Vector4<Unorm8> color = ConvertComponents<Unorm8>(Vector4<float>(1.f, 0.f, 0.5f, 1.f));
+    EXPECT_EQ(color, Vector4<Unorm8>(Unorm8::FromBits(255), Unorm8::FromBits(0), Unorm8::FromBits(128), Unorm8::FromBits(255)));
+
+    // An array of vectors packs as its components.
+    const std::vector<Vector3<float>> positions(9, p);
+    std::vector<Vector3<Half>> packed(positions.size());
+    Pack(Span<const float>(&positions[0].x, 3 * positions.size()), Span<Half>(&packed[0].x, 3 * packed.size()));
+    for (const Vector3<Half>& v : packed)
+        EXPECT_EQ(v, h);
+}
+
+static std::vector<mirage::Vector3<float>> MakeNormals(std::size_t n)
+{
+    std::vector<mirage::Vector3<float>> normals(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        // A spiral over the whole sphere, then the axes and diagonals.
+        const float z = 1.f - 2.f * (i + 0.5f) / n;
+        const float r = std::sqrt(1.f - z * z);
+        const float phi = 2.39996323f * i;
+        normals[i] = mirage::Vector3<float>(r * std::cos(phi), r * std::sin(phi), z);
+    }
+    const mirage::Vector3<float> special[] =
+    {
+        { 1.f, 0.f, 0.f }, { -1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, -1.f, 0.f }, { 0.f, 0.f, 1.f }, { 0.f, 0.f, -1.f },
+        { 0.57735f, -0.57735f, -0.57735f }, { -0.57735f, 0.57735f, -0.57735f }
+    };
+    for (std::size_t i = 0; i < sizeof(special) / sizeof(special[0]) && i < n; ++i)
+        normals[i] = special[i];
+    return normals;
+}
+
+template<typename O>
+static void ExpectOctNormals(float pMaxDegrees)
+{
+    using namespace mirage;
+
+    const std::vector<Vector3<float>> normals = MakeNormals(2003);
+    std::vector<O> packed(normals.size());
+    Pack(normals, packed);
+    std::vector<Vector3<float>> unpacked(normals.size());
+    Unpack(packed, unpacked);
+
+    for (std::size_t i = 0; i < normals.size(); ++i)
+    {
+        ASSERT_EQ(packed[i], O(normals[i])) << i;
+        const Vector3<float> decoded = packed[i].Decode();
+        EXPECT_NEAR(unpacked[i].x, decoded.x, 1e-6f);
+        EXPECT_NEAR(unpacked[i].y, decoded.y, 1e-6f);
+        EXPECT_NEAR(unpacked[i].z, decoded.z, 1e-6f);
+        EXPECT_NEAR(Length(decoded), 1.f, 1e-6f);
+        const float degrees = std::atan2(Length(Cross(decoded, normals[i])), Dot(decoded, normals[i])) * 180.f / 3.14159265f;
+        EXPECT_LE(degrees, pMaxDegrees) << i;
+    }
+}
+
+TEST(OctNormal, RoundTrips)
+{
+    ExpectOctNormals<mirage::OctNormal16>(0.004f);
+    ExpectOctNormals<mirage::OctNormal8>(1.f);
+}
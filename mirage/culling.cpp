@@ -0,0 +1,131 @@
+#include "culling.hpp"
+
+#include "check.hpp"
+#include "vecmath_wide.hpp"
+
+namespace mirage
+{
+
+namespace detail
+{
+
+// Plane coefficients broadcast for Float8.
+struct FrustumPlanes8
+{
+    FrustumPlanes8(const Frustum<float>& pFrustum)
+    {
+        for (int i = 0; i < static_cast<int>(FrustumPlane::COUNT); ++i)
+        {
+            const Plane<float>& p = pFrustum.planes[i];
+            nx[i] = Float8(p.normal.x);
+            ny[i] = Float8(p.normal.y);
+            nz[i] = Float8(p.normal.z);
+            d[i] = Float8(p.d);
+            abs_nx[i] = Float8(Abs(p.normal.x));
+            abs_ny[i] = Float8(Abs(p.normal.y));
+            abs_nz[i] = Float8(Abs(p.normal.z));
+        }
+    }
+
+    Float8 nx[6], ny[6], nz[6], d[6];
+    Float8 abs_nx[6], abs_ny[6], abs_nz[6];
+};
+
+// Appends pBase + j for every lane j set in pMask. Writes one index per lane
+// unconditionally and advances only over the visible ones, so there is no
+// branch per object. The writes stay below pBase + 8, within the output.
+inline std::size_t AppendVisible(int pMask, uint32_t pBase, uint32_t* pVisible, std::size_t pCount)
+{
+    for (int j = 0; j < Float8::Width; ++j)
+    {
+        pVisible[pCount] = pBase + j;
+        pCount += (pMask >> j) & 1;
+    }
+    return pCount;
+}
+
+} // namespace detail
+
+std::size_t CullBoxes(const Frustum<float>& pFrustum,
+    Span<const float> pCenterX, Span<const float> pCenterY, Span<const float> pCenterZ,
+    Span<const float> pExtentX, Span<const float> pExtentY, Span<const float> pExtentZ,
+    Span<uint32_t> pVisible)
+{
+    const std::size_t n = pCenterX.size();
+    DCHECK_EQ(pCenterY.size(), n);
+    DCHECK_EQ(pCenterZ.size(), n);
+    DCHECK_EQ(pExtentX.size(), n);
+    DCHECK_EQ(pExtentY.size(), n);
+    DCHECK_EQ(pExtentZ.size(), n);
+    DCHECK_GE(pVisible.size(), n);
+
+    const detail::FrustumPlanes8 planes(pFrustum);
+    std::size_t count = 0;
+    std::size_t i = 0;
+    for (; i + Float8::Width <= n; i += Float8::Width)
+    {
+        const Float8 cx = Float8::Load(&pCenterX[i]);
+        const Float8 cy = Float8::Load(&pCenterY[i]);
+        const Float8 cz = Float8::Load(&pCenterZ[i]);
+        const Float8 ex = Float8::Load(&pExtentX[i]);
+        const Float8 ey = Float8::Load(&pExtentY[i]);
+        const Float8 ez = Float8::Load(&pExtentZ[i]);
+
+        Float8 visible;
+        for (int p = 0; p < static_cast<int>(FrustumPlane::COUNT); ++p)
+        {
+            const Float8 distance = planes.nx[p] * cx + planes.ny[p] * cy + planes.nz[p] * cz + planes.d[p];
+            const Float8 radius = planes.abs_nx[p] * ex + planes.abs_ny[p] * ey + planes.abs_nz[p] * ez;
+            const Float8 inside = distance + radius >= Float8(0.f);
+            visible = p == 0 ? inside : visible & inside;
+        }
+        count = detail::AppendVisible(MoveMask(visible), static_cast<uint32_t>(i), pVisible.data(), count);
+    }
+    for (; i < n; ++i)
+    {
+        const Vector3<float> c(pCenterX[i], pCenterY[i], pCenterZ[i]);
+        const Vector3<float> e(pExtentX[i], pExtentY[i], pExtentZ[i]);
+        if (pFrustum.IsBoxVisible(c, e))
+            pVisible[count++] = static_cast<uint32_t>(i);
+    }
+    return count;
+}
+
+std::size_t CullSpheres(const Frustum<float>& pFrustum,
+    Span<const float> pCenterX, Span<const float> pCenterY, Span<const float> pCenterZ, Span<const float> pRadius,
+    Span<uint32_t> pVisible)
+{
+    const std::size_t n = pCenterX.size();
+    DCHECK_EQ(pCenterY.size(), n);
+    DCHECK_EQ(pCenterZ.size(), n);
+    DCHECK_EQ(pRadius.size(), n);
+    DCHECK_GE(pVisible.size(), n);
+
+    const detail::FrustumPlanes8 planes(pFrustum);
+    std::size_t count = 0;
+    std::size_t i = 0;
+    for (; i + Float8::Width <= n; i += Float8::Width)
+    {
+        const Float8 cx = Float8::Load(&pCenterX[i]);
+        const Float8 cy = Float8::Load(&pCenterY[i]);
+        const Float8 cz = Float8::Load(&pCenterZ[i]);
+        const Float8 radius = Float8::Load(&pRadius[i]);
+
+        Float8 visible;
+        for (int p = 0; p < static_cast<int>(FrustumPlane::COUNT); ++p)
+        {
+            const Float8 distance = planes.nx[p] * cx + planes.ny[p] * cy + planes.nz[p] * cz + planes.d[p];
+            const Float8 inside = distance + radius >= Float8(0.f);
+            visible = p == 0 ? inside : visible & inside;
+        }
+        count = detail::AppendVisible(MoveMask(visible), static_cast<uint32_t>(i), pVisible.data(), count);
+    }
+    for (; i < n; ++i)
+    {
+        if (pFrustum.IsSphereVisible(Vector3<float>(pCenterX[i], pCenterY[i], pCenterZ[i]), pRadius[i]))
+            pVisible[count++] = static_cast<uint32_t>(i);
+    }
+    return count;
+}
+
+} // namespace mirage
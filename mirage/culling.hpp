@@ -0,0 +1,32 @@
+#ifndef MIRAGE_CULLING_HPP
+#define MIRAGE_CULLING_HPP
+#include <cstddef>
+#include <cstdint>
+
+#include "util.hpp"
+#include "vecmath.hpp"
+
+namespace mirage
+{
+
+// Frustum culling of object batches, eight objects at a time with Float8.
+// Bounds come in SoA layout, one array per component. The indices of the
+// objects that pass go to pVisible in increasing order, and the count is
+// returned. pVisible must hold as many indices as there are objects. Each
+// object gets exactly the result of Frustum::IsBoxVisible() or
+// Frustum::IsSphereVisible().
+
+// Boxes given by their centers and half extents, e.g. AABB::Center() and
+// AABB::HalfExtents().
+std::size_t CullBoxes(const Frustum<float>& pFrustum,
+    Span<const float> pCenterX, Span<const float> pCenterY, Span<const float> pCenterZ,
+    Span<const float> pExtentX, Span<const float> pExtentY, Span<const float> pExtentZ,
+    Span<uint32_t> pVisible);
+
+std::size_t CullSpheres(const Frustum<float>& pFrustum,
+    Span<const float> pCenterX, Span<const float> pCenterY, Span<const float> pCenterZ, Span<const float> pRadius,
+    Span<uint32_t> pVisible);
+
+} // namespace mirage
+
+#endif
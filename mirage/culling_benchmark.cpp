@@ -0,0 +1,86 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+#include "tmp_runtests_macro.hpp"
+
+#ifdef MIRAGE_RUN_BENCHMARKS
+
+#include "culling.hpp"
+
+// 100k boxes around a camera at the origin looking down -z, about a third
+// of them visible.
+struct TestScene
+{
+    TestScene()
+        : cx(Count), cy(Count), cz(Count), ex(Count), ey(Count), ez(Count), visible(Count)
+    {
+        const mirage::Matrix44<float> projection(1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f,
+            0.f, 0.f, -101.f / 99.f, -200.f / 99.f, 0.f, 0.f, -1.f, 0.f);
+        frustum = mirage::ExtractFrustum(projection);
+        for (std::size_t i = 0; i < Count; ++i)
+        {
+            const float t = 0.37f * i;
+            cx[i] = 100.f * std::sin(t);
+            cy[i] = 100.f * std::cos(1.3f * t);
+            cz[i] = 100.f * std::sin(0.7f * t);
+            ex[i] = ey[i] = ez[i] = 1.f;
+        }
+    }
+
+    static constexpr std::size_t Count = 100000;
+
+    mirage::Frustum<float> frustum;
+    std::vector<float> cx, cy, cz, ex, ey, ez;
+    std::vector<uint32_t> visible;
+};
+
+static void BM_CullBoxesLoop(benchmark::State& state)
+{
+    using namespace mirage;
+    TestScene scene;
+    for (auto _ : state)
+    {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < TestScene::Count; ++i)
+        {
+            const Vector3<float> c(scene.cx[i], scene.cy[i], scene.cz[i]);
+            const Vector3<float> e(scene.ex[i], scene.ey[i], scene.ez[i]);
+            if (scene.frustum.IsBoxVisible(c, e))
+                scene.visible[count++] = static_cast<uint32_t>(i);
+        }
+        benchmark::DoNotOptimize(count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * TestScene::Count);
+}
+BENCHMARK(BM_CullBoxesLoop);
+
+static void BM_CullBoxes(benchmark::State& state)
+{
+    using namespace mirage;
+    TestScene scene;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(CullBoxes(scene.frustum, scene.cx, scene.cy, scene.cz, scene.ex, scene.ey, scene.ez, scene.visible));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * TestScene::Count);
+}
+BENCHMARK(BM_CullBoxes);
+
+static void BM_CullSpheres(benchmark::State& state)
+{
+    using namespace mirage;
+    TestScene scene;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(CullSpheres(scene.frustum, scene.cx, scene.cy, scene.cz, scene.ex, scene.visible));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * TestScene::Count);
+}
+BENCHMARK(BM_CullSpheres);
+
+#endif
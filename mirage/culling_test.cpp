@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "culling.hpp"
+
+// OpenGL-style perspective projection looking down -z: 90 degree vertical
+// field of view, aspect 2, near 1 and far 100, then moved to pEyeX.
+static mirage::Matrix44<float> MakeViewProjection(mirage::ClipDepth pDepth, float pEyeX)
+{
+    const float n = 1.f, f = 100.f;
+    const float a = pDepth == mirage::ClipDepth::ZERO_TO_ONE ? f / (n - f) : (f + n) / (n - f);
+    const float b = pDepth == mirage::ClipDepth::ZERO_TO_ONE ? n * f / (n - f) : 2.f * f * n / (n - f);
+    const mirage::Matrix44<float> projection(0.5f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, a, b, 0.f, 0.f, -1.f, 0.f);
+    mirage::Matrix44<float> view(1.f);
+    view.d[3] = -pEyeX;
+    return projection * view;
+}
+
+TEST(Frustum, ExtractsPlanes)
+{
+    using namespace mirage;
+
+    for (ClipDepth depth : { ClipDepth::MINUS_ONE_TO_ONE, ClipDepth::ZERO_TO_ONE })
+    {
+        const Frustum<float> f = ExtractFrustum(MakeViewProjection(depth, 5.f), depth);
+        EXPECT_NEAR(f[FrustumPlane::ZNEAR].Distance(Vector3<float>(5.f, 0.f, -1.f)), 0.f, 1e-4f);
+        EXPECT_NEAR(f[FrustumPlane::ZFAR].Distance(Vector3<float>(5.f, 0.f, -100.f)), 0.f, 1e-2f);
+        EXPECT_NEAR(f[FrustumPlane::ZNEAR].Distance(Vector3<float>(5.f, 0.f, -3.f)), 2.f, 1e-4f);
+        // At distance 10 the frustum spans x in [-20, 20] and y in [-10, 10].
+        EXPECT_NEAR(f[FrustumPlane::LEFT].Distance(Vector3<float>(-15.f, 0.f, -10.f)), 0.f, 1e-4f);
+        EXPECT_NEAR(f[FrustumPlane::RIGHT].Distance(Vector3<float>(25.f, 0.f, -10.f)), 0.f, 1e-4f);
+        EXPECT_NEAR(f[FrustumPlane::BOTTOM].Distance(Vector3<float>(5.f, -10.f, -10.f)), 0.f, 1e-4f);
+        EXPECT_NEAR(f[FrustumPlane::TOP].Distance(Vector3<float>(5.f, 10.f, -10.f)), 0.f, 1e-4f);
+        EXPECT_NEAR(Length(f[FrustumPlane::TOP].normal), 1.f, 1e-6f);
+
+        EXPECT_TRUE(f.IsSphereVisible(Vector3<float>(5.f, 0.f, -50.f), 1.f));
+        EXPECT_TRUE(f.IsSphereVisible(Vector3<float>(5.f, 0.f, 0.f), 1.5f));
+        EXPECT_FALSE(f.IsSphereVisible(Vector3<float>(5.f, 0.f, 1.f), 1.5f));
+        EXPECT_FALSE(f.IsSphereVisible(Vector3<float>(5.f, 0.f, -102.f), 1.f));
+        EXPECT_TRUE(f.IsVisible(AABB<float>(Vector3<float>(24.f, 9.f, -10.f), Vector3<float>(26.f, 11.f, -9.f))));
+        EXPECT_FALSE(f.IsVisible(AABB<float>(Vector3<float>(26.f, -1.f, -10.f), Vector3<float>(28.f, 1.f, -9.f))));
+    }
+}
+
+TEST(Culling, BatchesMatchScalar)
+{
+    using namespace mirage;
+
+    const Frustum<float> f = ExtractFrustum(MakeViewProjection(ClipDepth::MINUS_ONE_TO_ONE, 0.f));
+
+    // Not a multiple of the packet width, so the scalar tail runs too.
+    const std::size_t n = 10005;
+    std::vector<float> cx(n), cy(n), cz(n), ex(n), ey(n), ez(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const float t = 0.37f * i;
+        cx[i] = 60.f * std::sin(t);
+        cy[i] = 40.f * std::cos(1.3f * t);
+        cz[i] = -55.f + 60.f * std::sin(0.7f * t);
+        ex[i] = 0.5f + 3.f * std::abs(std::sin(2.1f * t));
+        ey[i] = 0.5f + 2.f * std::abs(std::cos(1.7f * t));
+        ez[i] = 0.5f + std::abs(std::sin(0.3f * t));
+    }
+
+    std::vector<uint32_t> boxes(n), spheres(n);
+    const std::size_t box_count = CullBoxes(f, cx, cy, cz, ex, ey, ez, boxes);
+    const std::size_t sphere_count = CullSpheres(f, cx, cy, cz, ex, spheres);
+
+    std::vector<uint32_t> expected_boxes, expected_spheres;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const Vector3<float> c(cx[i], cy[i], cz[i]);
+        if (f.IsBoxVisible(c, Vector3<float>(ex[i], ey[i], ez[i])))
+            expected_boxes.push_back(static_cast<uint32_t>(i));
+        if (f.IsSphereVisible(c, ex[i]))
+            expected_spheres.push_back(static_cast<uint32_t>(i));
+    }
+
+    // Some of each, so both outcomes are covered.
+    EXPECT_GT(expected_boxes.size(), n / 10);
+    EXPECT_LT(expected_boxes.size(), n - n / 10);
+    ASSERT_EQ(box_count, expected_boxes.size());
+    ASSERT_EQ(sphere_count, expected_spheres.size());
+    for (std::size_t i = 0; i < box_count; ++i)
+        EXPECT_EQ(boxes[i], expected_boxes[i]);
+    for (std::size_t i = 0; i < sphere_count; ++i)
+        EXPECT_EQ(spheres[i], expected_spheres[i]);
+}
@@ -0,0 +1,156 @@
+#include "frame_capture.hpp"
+
+#include <cstring>
+
+#include "check.hpp"
+#include "profiler.hpp"
+
+namespace mirage
+{
+
+FrameCapture::FrameCapture(const FrameCaptureSettings& pSettings, unsigned pDimensionX, unsigned pDimensionY)
+    : mSettings(pSettings)
+    , mWriteIndex(0)
+    , mReadIndex(0)
+    , mPendingSlots(0)
+    , mConsumedFrames(0)
+    , mCapturedFrames(0)
+    , mStop(false)
+{
+    if (mSettings.interval == 0)
+        mSettings.interval = 1;
+    if (mSettings.ring_size == 0)
+        mSettings.ring_size = 1;
+    if (mSettings.encoder_threads == 0)
+        mSettings.encoder_threads = 1;
+
+    // Allocate every slot up front so capturing never allocates on the render thread.
+    mRing.resize(mSettings.ring_size);
+    for (Slot& slot : mRing)
+    {
+        slot.pixels.resize(static_cast<std::size_t>(pDimensionX) * pDimensionY);
+        slot.dimension_x = pDimensionX;
+        slot.dimension_y = pDimensionY;
+        slot.frame_index = 0;
+        slot.state = SlotState::FREE;
+    }
+
+    for (unsigned i = 0; i < mSettings.encoder_threads; ++i)
+    {
+        mEncoders.emplace_back(&FrameCapture::EncoderLoop, this);
+    }
+}
+
+FrameCapture::~FrameCapture()
+{
+    Flush();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mSlotFilled.notify_all();
+    for (std::thread& encoder : mEncoders)
+    {
+        encoder.join();
+    }
+}
+
+void FrameCapture::Consume(const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY)
+{
+    const uint64_t frame_index = mConsumedFrames++;
+    if (frame_index % mSettings.interval != 0)
+        return;
+
+    Slot* slot;
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        slot = &mRing[mWriteIndex];
+        // Backpressure: wait for the encoders to release the slot.
+        mSlotFreed.wait(lock, [slot]() { return slot->state == SlotState::FREE; });
+        mWriteIndex = (mWriteIndex + 1) % mRing.size();
+    }
+
+    // The slot is owned by the render thread until it is marked as filled.
+    const std::size_t pixel_count = static_cast<std::size_t>(pDimensionX) * pDimensionY;
+    if (slot->pixels.size() != pixel_count)
+        slot->pixels.resize(pixel_count);
+    std::memcpy(slot->pixels.data(), pColorBuffer, pixel_count * sizeof(Vector4<uint8_t>));
+    slot->dimension_x = pDimensionX;
+    slot->dimension_y = pDimensionY;
+    slot->frame_index = frame_index;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        slot->state = SlotState::FILLED;
+        mPendingSlots++;
+        mCapturedFrames++;
+    }
+    mSlotFilled.notify_one();
+}
+
+void FrameCapture::Flush()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mSlotFreed.wait(lock, [this]() { return mPendingSlots == 0; });
+}
+
+std::string FrameCapture::GetFramePath(uint64_t pFrameIndex) const
+{
+    std::string index = std::to_string(pFrameIndex);
+    if (index.size() < 6)
+        index.insert(0, 6 - index.size(), '0');
+
+    const char* extension = ".pam";
+    switch (mSettings.format) {
+    case ImageFormat::PPM: extension = ".ppm"; break;
+    case ImageFormat::PAM: extension = ".pam"; break;
+    case ImageFormat::QOI: extension = ".qoi"; break;
+    case ImageFormat::PNG: extension = ".png"; break;
+    }
+    return mSettings.path_prefix + index + extension;
+}
+
+void FrameCapture::EncoderLoop()
+{
+    if (Profiler::IsEnabled())
+        Profiler::SetThreadName("FrameCapture encoder");
+    std::vector<uint8_t> bytes;
+    while (true)
+    {
+        Slot* slot;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mSlotFilled.wait(lock, [this]() {
+                return mStop || mRing[mReadIndex].state == SlotState::FILLED;
+            });
+            if (mRing[mReadIndex].state != SlotState::FILLED)
+                return;
+            slot = &mRing[mReadIndex];
+            slot->state = SlotState::ENCODING;
+            mReadIndex = (mReadIndex + 1) % mRing.size();
+        }
+        // Another frame may be waiting behind this one.
+        mSlotFilled.notify_one();
+
+        {
+            MIRAGE_PROFILE_ZONE("FrameCapture::Encode");
+            bytes.clear();
+            EncodeImage(mSettings.format, slot->pixels.data(), slot->dimension_x, slot->dimension_y, &bytes);
+            const std::string path = GetFramePath(slot->frame_index);
+            const bool written = mSettings.write_file
+                ? mSettings.write_file(path, bytes)
+                : WriteBytesToFile(path, bytes.data(), bytes.size());
+            if (!written)
+                printf("Error. Could not write captured frame to %s\n", path.c_str());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            slot->state = SlotState::FREE;
+            mPendingSlots--;
+        }
+        mSlotFreed.notify_all();
+    }
+}
+
+} // namespace mirage
@@ -0,0 +1,98 @@
+#ifndef MIRAGE_FRAME_CAPTURE_HPP
+#define MIRAGE_FRAME_CAPTURE_HPP
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_sink.hpp"
+#include "image_io.hpp"
+
+namespace mirage
+{
+
+struct FrameCaptureSettings
+{
+    FrameCaptureSettings()
+        : path_prefix("frame_")
+        , format(ImageFormat::QOI)
+        , interval(1)
+        , ring_size(8)
+        , encoder_threads(2)
+    {}
+
+    // Frames are written to <path_prefix><frame index>.<extension>.
+    std::string path_prefix;
+    ImageFormat format;
+    // Every interval-th consumed frame is captured.
+    unsigned interval;
+    // Number of preallocated frames that may wait for encoding.
+    unsigned ring_size;
+    unsigned encoder_threads;
+    // Stores an encoded frame, called on the encoder threads. Defaults to
+    // WriteBytesToFile when empty.
+    std::function<bool(const std::string& pPath, const std::vector<uint8_t>& pBytes)> write_file;
+};
+
+// Records a frame sequence to disk without stalling the render loop. Captured
+// frames are copied into a preallocated ring and compressed by a pool of
+// encoder threads. When every slot of the ring is waiting to be encoded,
+// Consume() blocks until one is free again.
+class FrameCapture : public FrameSink
+{
+public:
+
+    FrameCapture(const FrameCaptureSettings& pSettings, unsigned pDimensionX, unsigned pDimensionY);
+    // Encodes all captured frames before returning.
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    void Consume(const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY) override;
+
+    // Blocks until every captured frame has been written.
+    void Flush();
+
+    uint64_t GetCapturedFrameCount() const { return mCapturedFrames; }
+
+private:
+
+    enum class SlotState
+    {
+        FREE = 0, FILLED, ENCODING
+    };
+
+    struct Slot
+    {
+        std::vector<Vector4<uint8_t>> pixels;
+        unsigned dimension_x;
+        unsigned dimension_y;
+        uint64_t frame_index;
+        SlotState state;
+    };
+
+    void EncoderLoop();
+    std::string GetFramePath(uint64_t pFrameIndex) const;
+
+    FrameCaptureSettings mSettings;
+    std::vector<Slot> mRing;
+    std::vector<std::thread> mEncoders;
+    std::mutex mMutex;
+    std::condition_variable mSlotFilled;
+    std::condition_variable mSlotFreed;
+    // Next slot the render thread writes to and next slot to be encoded.
+    unsigned mWriteIndex;
+    unsigned mReadIndex;
+    unsigned mPendingSlots;
+    uint64_t mConsumedFrames;
+    uint64_t mCapturedFrames;
+    bool mStop;
+};
+
+} // namespace mirage
+
+#endif
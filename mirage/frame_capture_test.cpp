@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_capture.hpp"
+
+// Keeps the files FrameCapture writes in memory.
+struct CapturedFrames
+{
+    std::mutex mutex;
+    std::map<std::string, std::vector<uint8_t>> files;
+
+    bool Write(const std::string& pPath, const std::vector<uint8_t>& pBytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        files[pPath] = pBytes;
+        return true;
+    }
+};
+
+TEST(FrameCapture, RingWrapsAround)
+{
+    using namespace mirage;
+
+    CapturedFrames captured;
+    FrameCaptureSettings settings;
+    settings.path_prefix = "f";
+    settings.format = ImageFormat::PAM;
+    settings.interval = 2;
+    settings.ring_size = 3;
+    settings.encoder_threads = 2;
+    settings.write_file = [&](const std::string& pPath, const std::vector<uint8_t>& pBytes)
+    {
+        return captured.Write(pPath, pBytes);
+    };
+
+    const unsigned res = 4;
+    std::vector<Vector4<uint8_t>> frame(res * res, Vector4<uint8_t>(0, 0, 0, 255));
+    {
+        FrameCapture capture(settings, res, res);
+        // Every other one of 20 frames is captured, 10 frames through a ring
+        // of 3 slots.
+        for (unsigned i = 0; i < 20; ++i)
+        {
+            frame[0].x = uint8_t(i);
+            capture.Consume(frame.data(), res, res);
+        }
+        capture.Flush();
+        EXPECT_EQ(capture.GetCapturedFrameCount(), 10u);
+    }
+
+    ASSERT_EQ(captured.files.size(), 10u);
+    for (unsigned i = 0; i < 20; i += 2)
+    {
+        const std::string path = "f" + std::string(i < 10 ? "00000" : "0000") + std::to_string(i) + ".pam";
+        ASSERT_EQ(captured.files.count(path), 1u) << path;
+        // The pixels end the file, red of the first one comes first.
+        const std::vector<uint8_t>& bytes = captured.files[path];
+        EXPECT_EQ(bytes[bytes.size() - res * res * 4], i) << path;
+    }
+}
+
+TEST(FrameCapture, ConsumeBlocksWhileRingIsFull)
+{
+    using namespace mirage;
+
+    // The single encoder blocks in write_file until the test releases it.
+    std::mutex mutex;
+    std::condition_variable changed;
+    unsigned writes_started = 0;
+    bool released = false;
+
+    FrameCaptureSettings settings;
+    settings.ring_size = 2;
+    settings.encoder_threads = 1;
+    settings.write_file = [&](const std::string&, const std::vector<uint8_t>&)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        writes_started++;
+        changed.notify_all();
+        changed.wait(lock, [&] { return released; });
+        return true;
+    };
+
+    const unsigned res = 4;
+    std::vector<Vector4<uint8_t>> frame(res * res, Vector4<uint8_t>(0, 0, 0, 255));
+    FrameCapture capture(settings, res, res);
+
+    // Frame 0 is being encoded, frame 1 waits in the second slot.
+    capture.Consume(frame.data(), res, res);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return writes_started == 1; });
+    }
+    capture.Consume(frame.data(), res, res);
+    EXPECT_EQ(capture.GetCapturedFrameCount(), 2u);
+
+    // Frame 2 needs the slot of frame 0.
+    std::atomic<bool> consumed{ false };
+    std::thread render_thread([&]
+    {
+        capture.Consume(frame.data(), res, res);
+        consumed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(consumed);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+    }
+    changed.notify_all();
+    render_thread.join();
+    EXPECT_TRUE(consumed);
+    capture.Flush();
+    EXPECT_EQ(capture.GetCapturedFrameCount(), 3u);
+    EXPECT_EQ(writes_started, 3u);
+}
@@ -0,0 +1,25 @@
+#ifndef MIRAGE_FRAME_SINK_HPP
+#define MIRAGE_FRAME_SINK_HPP
+#include "vecmath.hpp"
+
+namespace mirage
+{
+
+// Consumer of presented frames, e.g. for writing them to disk or handing them
+// to another process. The buffer is only valid for the duration of the call.
+class FrameSink
+{
+public:
+
+    virtual ~FrameSink() {}
+
+    virtual void Consume(const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY) = 0;
+
+    // False once the sink stopped taking frames, e.g. because the process
+    // reading them exited.
+    virtual bool IsOpen() const { return true; }
+};
+
+} // namespace mirage
+
+#endif
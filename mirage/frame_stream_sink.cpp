@@ -0,0 +1,193 @@
+#include "frame_stream_sink.hpp"
+
+#include <cstring>
+
+#include "check.hpp"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace mirage
+{
+
+FrameStreamSink::FrameStreamSink(const char* pPath, bool pWriteHeaders)
+    : mFileDescriptor(-1)
+    , mOwnsFileDescriptor(false)
+    , mWriteHeaders(pWriteHeaders)
+    , mFrameIndex(0)
+{
+    if (std::strcmp(pPath, "-") == 0)
+    {
+        mFileDescriptor = 1;
+    }
+    else
+    {
+#ifdef _WIN32
+        _sopen_s(&mFileDescriptor, pPath, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE);
+#else
+        // Opening a FIFO blocks until the reader is connected.
+        mFileDescriptor = open(pPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+        mOwnsFileDescriptor = mFileDescriptor >= 0;
+    }
+
+    if (mFileDescriptor < 0)
+        fprintf(stderr, "Error. Could not open frame stream %s\n", pPath);
+    Initialize();
+}
+
+FrameStreamSink::FrameStreamSink(int pFileDescriptor, bool pWriteHeaders)
+    : mFileDescriptor(pFileDescriptor)
+    , mOwnsFileDescriptor(false)
+    , mWriteHeaders(pWriteHeaders)
+    , mFrameIndex(0)
+{
+    Initialize();
+}
+
+FrameStreamSink::~FrameStreamSink()
+{
+    if (mOwnsFileDescriptor)
+    {
+#ifdef _WIN32
+        _close(mFileDescriptor);
+#else
+        close(mFileDescriptor);
+#endif
+    }
+}
+
+void FrameStreamSink::Initialize()
+{
+    if (mFileDescriptor < 0)
+        return;
+
+#ifdef _WIN32
+    // Text mode would translate every 0x0a byte of the frame.
+    _setmode(mFileDescriptor, _O_BINARY);
+#else
+    // A reader that exits would otherwise kill the process on the next
+    // write. With SIGPIPE ignored the write fails with EPIPE instead and
+    // the sink closes.
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+#ifdef __linux__
+    // Fewer, larger transfers per frame. Fails silently above the system limit.
+    struct stat info;
+    if (fstat(mFileDescriptor, &info) == 0 && S_ISFIFO(info.st_mode))
+        fcntl(mFileDescriptor, F_SETPIPE_SZ, 1 << 20);
+#endif
+}
+
+void FrameStreamSink::Consume(const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY)
+{
+    if (mFileDescriptor < 0)
+        return;
+
+    const auto now = std::chrono::steady_clock::now();
+    if (mFrameIndex == 0)
+        mStartTime = now;
+
+    FrameStreamHeader header;
+    std::memcpy(header.magic, "MRGF", 4);
+    header.header_size = sizeof(FrameStreamHeader);
+    header.width = pDimensionX;
+    header.height = pDimensionY;
+    header.frame_index = mFrameIndex;
+    header.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - mStartTime).count();
+
+    const uint8_t* pixels = reinterpret_cast<const uint8_t*>(pColorBuffer);
+    const std::size_t size = static_cast<std::size_t>(pDimensionX) * pDimensionY * sizeof(Vector4<uint8_t>);
+    const FrameStreamHeader* header_ptr = mWriteHeaders ? &header : nullptr;
+
+    if (!WriteFrame(header_ptr, pixels, size))
+    {
+        fprintf(stderr, "Error. Frame stream closed after %llu frames\n", static_cast<unsigned long long>(mFrameIndex));
+        if (mOwnsFileDescriptor)
+        {
+#ifdef _WIN32
+            _close(mFileDescriptor);
+#else
+            close(mFileDescriptor);
+#endif
+        }
+        mFileDescriptor = -1;
+        return;
+    }
+
+    mFrameIndex++;
+}
+
+bool FrameStreamSink::WriteFrame(const FrameStreamHeader* pHeader, const uint8_t* pPixels, std::size_t pSize)
+{
+#ifdef _WIN32
+    if (pHeader && _write(mFileDescriptor, pHeader, sizeof(FrameStreamHeader)) != sizeof(FrameStreamHeader))
+        return false;
+
+    // _write takes an unsigned int count.
+    constexpr std::size_t MaxChunk = 1u << 30;
+    while (pSize > 0)
+    {
+        const unsigned chunk = static_cast<unsigned>(pSize < MaxChunk ? pSize : MaxChunk);
+        const int n = _write(mFileDescriptor, pPixels, chunk);
+        if (n <= 0)
+            return false;
+        pPixels += n;
+        pSize -= n;
+    }
+    return true;
+#else
+    // Header and frame go out in one gathered write. Partial writes advance
+    // through the iovecs until everything is written.
+    struct iovec iov[2];
+    int iov_count = 0;
+    if (pHeader)
+    {
+        iov[iov_count].iov_base = const_cast<FrameStreamHeader*>(pHeader);
+        iov[iov_count].iov_len = sizeof(FrameStreamHeader);
+        iov_count++;
+    }
+    iov[iov_count].iov_base = const_cast<uint8_t*>(pPixels);
+    iov[iov_count].iov_len = pSize;
+    iov_count++;
+
+    struct iovec* current = iov;
+    while (iov_count > 0)
+    {
+        const ssize_t n = writev(mFileDescriptor, current, iov_count);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            // EPIPE when the reader went away.
+            return false;
+        }
+
+        std::size_t remaining = static_cast<std::size_t>(n);
+        while (iov_count > 0 && remaining >= current->iov_len)
+        {
+            remaining -= current->iov_len;
+            current++;
+            iov_count--;
+        }
+        if (iov_count > 0)
+        {
+            current->iov_base = static_cast<uint8_t*>(current->iov_base) + remaining;
+            current->iov_len -= remaining;
+        }
+    }
+    return true;
+#endif
+}
+
+} // namespace mirage
@@ -0,0 +1,69 @@
+#ifndef MIRAGE_FRAME_STREAM_SINK_HPP
+#define MIRAGE_FRAME_STREAM_SINK_HPP
+#include <chrono>
+#include <cstdint>
+
+#include "frame_sink.hpp"
+
+namespace mirage
+{
+
+// Precedes every frame unless the sink was created without headers.
+// All fields are little-endian.
+struct FrameStreamHeader
+{
+    char magic[4];          // "MRGF"
+    uint32_t header_size;   // sizeof(FrameStreamHeader)
+    uint32_t width;
+    uint32_t height;
+    uint64_t frame_index;
+    uint64_t timestamp_ns;  // steady clock, relative to the first frame
+};
+
+static_assert(sizeof(FrameStreamHeader) == 32, "FrameStreamHeader must not contain padding");
+
+// Streams raw RGBA8 frames to a file descriptor (stdout, a FIFO or a file),
+// e.g. for piping into ffmpeg:
+//
+//   mirage --headless --frames 0 --stream - --stream-raw |
+//       ffmpeg -f rawvideo -pixel_format rgba -video_size 1024x1024 -i - out.mp4
+//
+// Headers have to be disabled for ffmpeg's rawvideo demuxer.
+//
+// Every frame is one gathered write of header and pixels. Writes block
+// while the reader is behind, which throttles the renderer to the reader's
+// pace. When the reader goes away the sink closes itself; SIGPIPE is ignored
+// process-wide for that.
+class FrameStreamSink : public FrameSink
+{
+public:
+
+    // Opens pPath for writing. "-" selects stdout.
+    FrameStreamSink(const char* pPath, bool pWriteHeaders = true);
+    // Uses an already open descriptor, which is not closed by the sink.
+    FrameStreamSink(int pFileDescriptor, bool pWriteHeaders = true);
+    ~FrameStreamSink();
+
+    FrameStreamSink(const FrameStreamSink&) = delete;
+    FrameStreamSink& operator=(const FrameStreamSink&) = delete;
+
+    void Consume(const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY) override;
+
+    bool IsOpen() const override { return mFileDescriptor >= 0; }
+    uint64_t GetFrameCount() const { return mFrameIndex; }
+
+private:
+
+    void Initialize();
+    bool WriteFrame(const FrameStreamHeader* pHeader, const uint8_t* pPixels, std::size_t pSize);
+
+    int mFileDescriptor;
+    bool mOwnsFileDescriptor;
+    bool mWriteHeaders;
+    uint64_t mFrameIndex;
+    std::chrono::steady_clock::time_point mStartTime;
+};
+
+} // namespace mirage
+
+#endif
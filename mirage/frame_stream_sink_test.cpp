@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "frame_stream_sink.hpp"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+static bool OpenPipe(int pFileDescriptors[2])
+{
+#ifdef _WIN32
+    return _pipe(pFileDescriptors, 1 << 16, _O_BINARY) == 0;
+#else
+    return pipe(pFileDescriptors) == 0;
+#endif
+}
+
+static void ClosePipeEnd(int pFileDescriptor)
+{
+#ifdef _WIN32
+    _close(pFileDescriptor);
+#else
+    close(pFileDescriptor);
+#endif
+}
+
+static bool ReadExactly(int pFileDescriptor, void* pData, std::size_t pSize)
+{
+    uint8_t* data = static_cast<uint8_t*>(pData);
+    while (pSize > 0)
+    {
+#ifdef _WIN32
+        const int n = _read(pFileDescriptor, data, static_cast<unsigned>(pSize));
+#else
+        const ssize_t n = read(pFileDescriptor, data, pSize);
+#endif
+        if (n <= 0)
+            return false;
+        data += n;
+        pSize -= n;
+    }
+    return true;
+}
+
+TEST(FrameStreamSink, WritesHeaderAndPixels)
+{
+    using namespace mirage;
+
+    int fds[2];
+    ASSERT_TRUE(OpenPipe(fds));
+
+    // Two small frames fit into the pipe without a concurrent reader.
+    const unsigned res_x = 8, res_y = 4;
+    std::vector<Vector4<uint8_t>> frame(res_x * res_y);
+    for (std::size_t i = 0; i < frame.size(); ++i)
+        frame[i] = Vector4<uint8_t>(uint8_t(i), uint8_t(i * 3), 7, 255);
+    {
+        FrameStreamSink sink(fds[1]);
+        sink.Consume(frame.data(), res_x, res_y);
+        frame[0].x = 200;
+        sink.Consume(frame.data(), res_x, res_y);
+        EXPECT_TRUE(sink.IsOpen());
+        EXPECT_EQ(sink.GetFrameCount(), 2u);
+    }
+    ClosePipeEnd(fds[1]);
+
+    for (uint64_t index = 0; index < 2; ++index)
+    {
+        FrameStreamHeader header;
+        ASSERT_TRUE(ReadExactly(fds[0], &header, sizeof(header)));
+        EXPECT_EQ(std::memcmp(header.magic, "MRGF", 4), 0);
+        EXPECT_EQ(header.header_size, sizeof(FrameStreamHeader));
+        EXPECT_EQ(header.width, res_x);
+        EXPECT_EQ(header.height, res_y);
+        EXPECT_EQ(header.frame_index, index);
+        if (index == 0)
+        {
+            EXPECT_EQ(header.timestamp_ns, 0u);
+        }
+
+        std::vector<Vector4<uint8_t>> pixels(res_x * res_y);
+        ASSERT_TRUE(ReadExactly(fds[0], pixels.data(), pixels.size() * sizeof(Vector4<uint8_t>)));
+        EXPECT_EQ(pixels[0].x, index == 0 ? 0 : 200);
+        EXPECT_EQ(pixels[5], Vector4<uint8_t>(5, 15, 7, 255));
+    }
+    uint8_t extra;
+    EXPECT_FALSE(ReadExactly(fds[0], &extra, 1));
+    ClosePipeEnd(fds[0]);
+}
+
+TEST(FrameStreamSink, ClosesWhenReaderGoesAway)
+{
+    using namespace mirage;
+
+    int fds[2];
+    ASSERT_TRUE(OpenPipe(fds));
+
+    const unsigned res = 16;
+    std::vector<Vector4<uint8_t>> frame(res * res, Vector4<uint8_t>(1, 2, 3, 4));
+    FrameStreamSink sink(fds[1], false);
+    sink.Consume(frame.data(), res, res);
+    EXPECT_EQ(sink.GetFrameCount(), 1u);
+
+    // Writing to a pipe without a reader must fail instead of raising SIGPIPE.
+    ClosePipeEnd(fds[0]);
+    sink.Consume(frame.data(), res, res);
+    EXPECT_FALSE(sink.IsOpen());
+    EXPECT_EQ(sink.GetFrameCount(), 1u);
+
+    // Closed sinks ignore further frames.
+    sink.Consume(frame.data(), res, res);
+    EXPECT_EQ(sink.GetFrameCount(), 1u);
+    ClosePipeEnd(fds[1]);
+}
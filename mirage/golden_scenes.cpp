@@ -0,0 +1,140 @@
+#include "golden_scenes.hpp"
+
+#include "image_io.hpp"
+#include "point.hpp"
+#include "triangle_p0.hpp"
+
+namespace mirage
+{
+
+static void RenderReferenceTriangle(Vector4<uint8_t>* pColorBuffer, unsigned pResolutionX, unsigned pResolutionY)
+{
+    // Same triangle as the interactive demo in main.cpp.
+    FormTriangle(pColorBuffer, pResolutionX, pResolutionY,
+        Point2<float>(-1.f, 0.f), Point2<float>(0.5f, 0.f), Point2<float>(0.f, 0.25f),
+        Vector3<uint8_t>(255, 0, 0), Vector3<uint8_t>(0, 255, 0), Vector3<uint8_t>(255, 255, 255)
+    );
+}
+
+static void RenderSteepTriangle(Vector4<uint8_t>* pColorBuffer, unsigned pResolutionX, unsigned pResolutionY)
+{
+    FormTriangle(pColorBuffer, pResolutionX, pResolutionY,
+        Point2<float>(-0.1f, -0.9f), Point2<float>(0.05f, 0.9f), Point2<float>(0.1f, -0.8f),
+        Vector3<uint8_t>(0, 0, 255), Vector3<uint8_t>(255, 0, 255), Vector3<uint8_t>(0, 255, 255)
+    );
+}
+
+static void RenderTriangleFan(Vector4<uint8_t>* pColorBuffer, unsigned pResolutionX, unsigned pResolutionY)
+{
+    constexpr int Segments = 12;
+    constexpr float Pi = 3.14159265f;
+    const Point2<float> center(0.f, 0.f);
+    for (int i = 0; i < Segments; ++i)
+    {
+        const float a0 = 2.f * Pi * i / Segments;
+        const float a1 = 2.f * Pi * (i + 1) / Segments;
+        const uint8_t shade = static_cast<uint8_t>(40 + 200 * i / Segments);
+        FormTriangle(pColorBuffer, pResolutionX, pResolutionY,
+            center,
+            Point2<float>(0.8f * std::cos(a0), 0.8f * std::sin(a0)),
+            Point2<float>(0.8f * std::cos(a1), 0.8f * std::sin(a1)),
+            Vector3<uint8_t>(255, 255, 255), Vector3<uint8_t>(shade, 0, 255 - shade), Vector3<uint8_t>(0, shade, 0)
+        );
+    }
+}
+
+static void RenderSmallTriangles(Vector4<uint8_t>* pColorBuffer, unsigned pResolutionX, unsigned pResolutionY)
+{
+    for (int y = 0; y < 8; ++y)
+    {
+        for (int x = 0; x < 8; ++x)
+        {
+            const float ox = -0.9f + x * 0.22f;
+            const float oy = -0.9f + y * 0.22f;
+            FormTriangle(pColorBuffer, pResolutionX, pResolutionY,
+                Point2<float>(ox, oy), Point2<float>(ox + 0.05f, oy), Point2<float>(ox + 0.02f, oy + 0.06f),
+                Vector3<uint8_t>(255, 32 * x, 0), Vector3<uint8_t>(0, 255, 32 * y), Vector3<uint8_t>(32 * y, 0, 255)
+            );
+        }
+    }
+}
+
+const std::vector<GoldenScene>& GetGoldenScenes()
+{
+    static const std::vector<GoldenScene> scenes =
+    {
+        { "reference_triangle", 256, 256, RenderReferenceTriangle },
+        { "steep_triangle",     256, 256, RenderSteepTriangle },
+        { "triangle_fan",       256, 256, RenderTriangleFan },
+        { "small_triangles",    256, 256, RenderSmallTriangles },
+    };
+    return scenes;
+}
+
+std::string GetGoldenDirectory()
+{
+#ifdef MIRAGE_GOLDEN_DIR
+    return MIRAGE_GOLDEN_DIR;
+#else
+    // __FILE__ is absolute in the Visual Studio build.
+    std::string directory = __FILE__;
+    const std::size_t separator = directory.find_last_of("/\\");
+    directory.resize(separator == std::string::npos ? 0 : separator + 1);
+    return directory + "golden/";
+#endif
+}
+
+GoldenResult CheckGoldenScene(
+    const GoldenScene& pScene, const std::string& pDirectory, const std::string& pOutputDirectory,
+    uint8_t pTolerance, bool pUpdateReference)
+{
+    GoldenResult result;
+    result.passed = false;
+    result.reference_found = false;
+    result.diff = ImageDiff{ 0, 0.0, 0 };
+
+    const std::size_t n = static_cast<std::size_t>(pScene.width) * pScene.height;
+    std::vector<Vector4<uint8_t>> rendered(n, Vector4<uint8_t>(0, 0, 0, 0));
+    pScene.render(rendered.data(), pScene.width, pScene.height);
+
+    const std::string base = pDirectory + pScene.name;
+    if (pUpdateReference)
+    {
+        result.passed = WriteImage(base + ".qoi", rendered.data(), pScene.width, pScene.height);
+        result.reference_found = true;
+        result.message = result.passed ? "Reference updated." : "Could not write " + base + ".qoi";
+        return result;
+    }
+
+    const std::string output_base = pOutputDirectory + pScene.name;
+    std::vector<Vector4<uint8_t>> reference;
+    unsigned width = 0, height = 0;
+    if (!ReadImage(base + ".qoi", &reference, &width, &height))
+    {
+        WriteImage(output_base + ".actual.qoi", rendered.data(), pScene.width, pScene.height);
+        result.message = "Missing reference " + base + ".qoi, rendered image written to " + output_base + ".actual.qoi";
+        return result;
+    }
+    result.reference_found = true;
+
+    if (width != pScene.width || height != pScene.height)
+    {
+        result.message = "Reference " + base + ".qoi has a different resolution.";
+        return result;
+    }
+
+    result.diff = CompareImages(rendered.data(), reference.data(), n, pTolerance);
+    result.passed = result.diff.differing_pixels == 0;
+    if (!result.passed)
+    {
+        WriteImage(output_base + ".actual.qoi", rendered.data(), pScene.width, pScene.height);
+        WriteDiffHeatmap(output_base + ".diff.qoi", rendered.data(), reference.data(), pScene.width, pScene.height);
+        result.message =
+            std::to_string(result.diff.differing_pixels) + " pixels differ (max error " +
+            std::to_string(result.diff.max_error) + ", rmse " + std::to_string(result.diff.rmse) +
+            "), see " + output_base + ".diff.qoi";
+    }
+    return result;
+}
+
+} // namespace mirage
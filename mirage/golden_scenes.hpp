@@ -0,0 +1,50 @@
+#ifndef MIRAGE_GOLDEN_SCENES_HPP
+#define MIRAGE_GOLDEN_SCENES_HPP
+#include <string>
+#include <vector>
+
+#include "image_diff.hpp"
+#include "vecmath.hpp"
+
+namespace mirage
+{
+
+// A named scene for golden-image regression tests. Render() draws into a
+// cleared color buffer of width x height pixels.
+struct GoldenScene
+{
+    const char* name;
+    unsigned width;
+    unsigned height;
+    void (*render)(Vector4<uint8_t>* pColorBuffer, unsigned pResolutionX, unsigned pResolutionY);
+};
+
+const std::vector<GoldenScene>& GetGoldenScenes();
+
+// Directory of the stored reference images: MIRAGE_GOLDEN_DIR if defined,
+// otherwise golden/ next to the sources, so the tests do not depend on the
+// working directory.
+std::string GetGoldenDirectory();
+
+struct GoldenResult
+{
+    bool passed;
+    // False if there was no reference image to compare against.
+    bool reference_found;
+    ImageDiff diff;
+    std::string message;
+};
+
+// Renders pScene and compares it against <pDirectory><name>.qoi. On failure
+// the rendered image and a diff heatmap are written to pOutputDirectory as
+// <name>.actual.qoi and <name>.diff.qoi, which keeps them out of the
+// checked-in references. With pUpdateReference set, the rendered image
+// replaces the reference instead.
+GoldenResult CheckGoldenScene(
+    const GoldenScene& pScene, const std::string& pDirectory, const std::string& pOutputDirectory,
+    uint8_t pTolerance = 0, bool pUpdateReference = false
+);
+
+} // namespace mirage
+
+#endif
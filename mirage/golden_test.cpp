@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+#include "golden_scenes.hpp"
+#include "image_diff.hpp"
+
+#pragma warning ( push )
+#pragma warning ( disable : 4996 )
+
+// Set MIRAGE_UPDATE_GOLDEN to accept the current output as the new reference.
+static bool ShouldUpdateGoldenImages()
+{
+    return std::getenv("MIRAGE_UPDATE_GOLDEN") != nullptr;
+}
+
+#pragma warning ( pop )
+
+class GoldenSceneTest : public testing::TestWithParam<mirage::GoldenScene>
+{
+};
+
+TEST_P(GoldenSceneTest, MatchesReference)
+{
+    using namespace mirage;
+
+    // Edge pixels may be off by one when the compiler contracts the edge
+    // functions into FMAs, e.g. with -mfma.
+    GoldenResult result = CheckGoldenScene(
+        GetParam(), GetGoldenDirectory(), testing::TempDir(), 1, ShouldUpdateGoldenImages());
+    EXPECT_EQ(result.reference_found, true) << result.message;
+    EXPECT_EQ(result.passed, true) << result.message;
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Golden, GoldenSceneTest, testing::ValuesIn(mirage::GetGoldenScenes()),
+    [](const testing::TestParamInfo<mirage::GoldenScene>& info) { return std::string(info.param.name); }
+);
+
+TEST(ImageDiff, Statistics)
+{
+    using namespace mirage;
+
+    // Odd size to cover the scalar tail after the vectorized loop.
+    constexpr std::size_t N = 1027;
+    std::vector<Vector4<uint8_t>> a(N, Vector4<uint8_t>(10, 20, 30, 255));
+    std::vector<Vector4<uint8_t>> b(a);
+
+    ImageDiff same = CompareImages(a.data(), b.data(), N);
+    EXPECT_EQ(same.max_error, 0);
+    EXPECT_EQ(same.differing_pixels, 0);
+    EXPECT_EQ(same.rmse, 0.0);
+
+    b[0].x = 13;       // error 3
+    b[517].w = 245;    // error 10
+    b[1026].y = 0;     // error 20, in the scalar tail
+    b[800].z = 31;     // error 1
+
+    ImageDiff diff = CompareImages(a.data(), b.data(), N);
+    EXPECT_EQ(diff.max_error, 20);
+    EXPECT_EQ(diff.differing_pixels, 4);
+    const double expected_rmse = std::sqrt((9.0 + 100.0 + 400.0 + 1.0) / (N * 4.0));
+    EXPECT_EQ(IsEqual(diff.rmse, expected_rmse), true);
+
+    ImageDiff tolerant = CompareImages(a.data(), b.data(), N, 3);
+    EXPECT_EQ(tolerant.max_error, 20);
+    EXPECT_EQ(tolerant.differing_pixels, 2);
+}
@@ -0,0 +1,239 @@
+#include "hardware_counters.hpp"
+
+#include <cstdio>
+
+#include "check.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace mirage
+{
+
+namespace detail
+{
+
+#ifdef __linux__
+
+struct HardwareCounterConfig
+{
+    uint32_t type;
+    uint64_t config;
+};
+
+static HardwareCounterConfig GetHardwareCounterConfig(HardwareCounter pCounter)
+{
+    switch (pCounter)
+    {
+    case HardwareCounter::CYCLES:
+        return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES };
+    case HardwareCounter::INSTRUCTIONS:
+        return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS };
+    case HardwareCounter::L1D_READ_MISSES:
+        return { PERF_TYPE_HW_CACHE,
+            PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) };
+    case HardwareCounter::LLC_MISSES:
+        return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES };
+    case HardwareCounter::BRANCH_MISSES:
+        return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES };
+    default:
+        assert(false, "Error. Unknown hardware counter.");
+        return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES };
+    }
+}
+
+static int OpenHardwareCounter(HardwareCounter pCounter, int pGroupFileDescriptor)
+{
+    const HardwareCounterConfig config = GetHardwareCounterConfig(pCounter);
+
+    perf_event_attr attr = {};
+    attr.size = sizeof(attr);
+    attr.type = config.type;
+    attr.config = config.config;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // User space only, which perf_event_paranoid 2 still allows.
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    // Calling thread, any CPU.
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, pGroupFileDescriptor, 0));
+}
+
+#endif
+
+} // namespace detail
+
+const char* HardwareCounterName(HardwareCounter pCounter)
+{
+    switch (pCounter)
+    {
+    case HardwareCounter::CYCLES: return "cycles";
+    case HardwareCounter::INSTRUCTIONS: return "instructions";
+    case HardwareCounter::L1D_READ_MISSES: return "l1d-read-misses";
+    case HardwareCounter::LLC_MISSES: return "llc-misses";
+    case HardwareCounter::BRANCH_MISSES: return "branch-misses";
+    default: return "unknown";
+    }
+}
+
+const char* PipelineStageName(PipelineStage pStage)
+{
+    switch (pStage)
+    {
+    case PipelineStage::RASTERIZE: return "rasterize";
+    case PipelineStage::TRACE: return "trace";
+    case PipelineStage::UPLOAD: return "upload";
+    default: return "unknown";
+    }
+}
+
+HardwareCounterValues::HardwareCounterValues()
+    : values{}
+{}
+
+HardwareCounters::HardwareCounters()
+    : mGroupFileDescriptor(-1)
+    , mAvailableMask(0)
+    , mActiveStage(PipelineStage::COUNT)
+    , mStageBeginValid(false)
+{
+    for (int i = 0; i < static_cast<int>(HardwareCounter::COUNT); ++i)
+    {
+        mFileDescriptors[i] = -1;
+#ifdef __linux__
+        // All counters form one group, so they are scheduled together and
+        // read with a single call. The first counter that opens leads.
+        const int fd = detail::OpenHardwareCounter(static_cast<HardwareCounter>(i), mGroupFileDescriptor);
+        if (fd < 0)
+            continue;
+        if (mGroupFileDescriptor < 0)
+            mGroupFileDescriptor = fd;
+        mFileDescriptors[i] = fd;
+        mAvailableMask |= 1u << i;
+#endif
+    }
+}
+
+HardwareCounters::~HardwareCounters()
+{
+#ifdef __linux__
+    // Members before the leader.
+    for (int i = static_cast<int>(HardwareCounter::COUNT) - 1; i >= 0; --i)
+    {
+        if (mFileDescriptors[i] >= 0)
+            close(mFileDescriptors[i]);
+    }
+#endif
+}
+
+bool HardwareCounters::Read(HardwareCounterValues* pValues) const
+{
+#ifdef __linux__
+    if (mGroupFileDescriptor < 0)
+        return false;
+
+    // PERF_FORMAT_GROUP layout: nr, time_enabled, time_running, values[nr].
+    uint64_t data[3 + static_cast<int>(HardwareCounter::COUNT)];
+    const ssize_t n = read(mGroupFileDescriptor, data, sizeof(data));
+    if (n < static_cast<ssize_t>(3 * sizeof(uint64_t)))
+        return false;
+
+    const uint64_t count = data[0];
+    const uint64_t enabled = data[1];
+    const uint64_t running = data[2];
+    // The kernel multiplexes groups when the PMU is oversubscribed.
+    const double scale = running > 0 ? static_cast<double>(enabled) / running : 0.0;
+
+    uint64_t index = 0;
+    for (int i = 0; i < static_cast<int>(HardwareCounter::COUNT); ++i)
+    {
+        if (mFileDescriptors[i] < 0 || index >= count)
+        {
+            pValues->values[i] = 0;
+            continue;
+        }
+        pValues->values[i] = static_cast<uint64_t>(data[3 + index] * scale);
+        index++;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void HardwareCounters::BeginStage(PipelineStage pStage)
+{
+    DCHECK(mActiveStage == PipelineStage::COUNT);
+    DCHECK(pStage != PipelineStage::COUNT);
+    mActiveStage = pStage;
+    mStageBeginValid = Read(&mStageBegin);
+}
+
+void HardwareCounters::EndStage(PipelineStage pStage)
+{
+    DCHECK(mActiveStage == pStage);
+    mActiveStage = PipelineStage::COUNT;
+
+    HardwareCounterValues end;
+    if (!mStageBeginValid || !Read(&end))
+        return;
+
+    HardwareCounterValues& frame = mCurrentFrame[static_cast<int>(pStage)];
+    for (int i = 0; i < static_cast<int>(HardwareCounter::COUNT); ++i)
+    {
+        if (end.values[i] > mStageBegin.values[i])
+            frame.values[i] += end.values[i] - mStageBegin.values[i];
+    }
+}
+
+void HardwareCounters::EndFrame()
+{
+    for (int i = 0; i < static_cast<int>(PipelineStage::COUNT); ++i)
+    {
+        mLastFrame[i] = mCurrentFrame[i];
+        mCurrentFrame[i] = HardwareCounterValues();
+    }
+}
+
+const HardwareCounterValues& HardwareCounters::GetStage(PipelineStage pStage) const
+{
+    return mLastFrame[static_cast<int>(pStage)];
+}
+
+std::string HardwareCounters::Report(uint64_t pPixels) const
+{
+    if (!IsAvailable())
+        return "Hardware counters are not available.\n";
+
+    std::string report;
+    char buf[128];
+    for (int s = 0; s < static_cast<int>(PipelineStage::COUNT); ++s)
+    {
+        bool empty = true;
+        for (int i = 0; i < static_cast<int>(HardwareCounter::COUNT); ++i)
+            empty = empty && mLastFrame[s].values[i] == 0;
+        if (empty)
+            continue;
+
+        report += PipelineStageName(static_cast<PipelineStage>(s));
+        report += ':';
+        for (int i = 0; i < static_cast<int>(HardwareCounter::COUNT); ++i)
+        {
+            if (!IsAvailable(static_cast<HardwareCounter>(i)))
+                continue;
+            const uint64_t value = mLastFrame[s].values[i];
+            snprintf(buf, sizeof(buf), " %s=%llu (%.3f/px)",
+                HardwareCounterName(static_cast<HardwareCounter>(i)), static_cast<unsigned long long>(value),
+                pPixels > 0 ? static_cast<double>(value) / pPixels : 0.0);
+            report += buf;
+        }
+        report += '\n';
+    }
+    return report;
+}
+
+} // namespace mirage
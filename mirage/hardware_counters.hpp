@@ -0,0 +1,130 @@
+#ifndef MIRAGE_HARDWARE_COUNTERS_HPP
+#define MIRAGE_HARDWARE_COUNTERS_HPP
+#include <cstdint>
+#include <string>
+
+namespace mirage
+{
+
+enum class HardwareCounter
+{
+    CYCLES = 0,
+    INSTRUCTIONS,
+    L1D_READ_MISSES,
+    LLC_MISSES,
+    BRANCH_MISSES,
+    COUNT
+};
+
+enum class PipelineStage
+{
+    RASTERIZE = 0,
+    TRACE,
+    UPLOAD,
+    COUNT
+};
+
+const char* HardwareCounterName(HardwareCounter pCounter);
+const char* PipelineStageName(PipelineStage pStage);
+
+struct HardwareCounterValues
+{
+    HardwareCounterValues();
+
+    uint64_t values[static_cast<int>(HardwareCounter::COUNT)];
+
+    uint64_t Get(HardwareCounter pCounter) const { return values[static_cast<int>(pCounter)]; }
+};
+
+// Samples CPU performance counters of the calling thread around pipeline
+// stages, using perf_event_open on Linux. Counters the CPU or the kernel does
+// not provide (e.g. in virtual machines, or with perf_event_paranoid > 2) are
+// reported as unavailable. On other platforms no counter is available.
+// Work a stage hands to other threads, e.g. through ParallelFor(), is not
+// counted, so measured stages should run serially.
+//
+//   counters.BeginStage(PipelineStage::RASTERIZE);
+//   FormTriangle(...);
+//   counters.EndStage(PipelineStage::RASTERIZE);
+//   counters.EndFrame();
+//   printf("%s", counters.Report(pixels).c_str());
+class HardwareCounters
+{
+public:
+
+    HardwareCounters();
+    ~HardwareCounters();
+
+    HardwareCounters(const HardwareCounters&) = delete;
+    HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+    bool IsAvailable() const { return mAvailableMask != 0; }
+    bool IsAvailable(HardwareCounter pCounter) const { return (mAvailableMask >> static_cast<int>(pCounter)) & 1; }
+
+    // A stage may be entered several times per frame, the deltas add up.
+    // Stages must not overlap, and EndStage() takes the stage of the
+    // matching BeginStage().
+    void BeginStage(PipelineStage pStage);
+    void EndStage(PipelineStage pStage);
+
+    // Publishes the deltas accumulated since the previous EndFrame().
+    void EndFrame();
+
+    // Counter deltas of a stage in the last completed frame.
+    const HardwareCounterValues& GetStage(PipelineStage pStage) const;
+
+    // One line per stage with the counters of the last frame, in total and
+    // per pixel. Stages without counts, e.g. not entered, are left out.
+    std::string Report(uint64_t pPixels) const;
+
+private:
+
+    // Current counter values, scaled for multiplexing.
+    bool Read(HardwareCounterValues* pValues) const;
+
+    // Descriptors in group order, -1 for unavailable counters.
+    int mFileDescriptors[static_cast<int>(HardwareCounter::COUNT)];
+    int mGroupFileDescriptor;
+    uint32_t mAvailableMask;
+
+    // PipelineStage::COUNT outside of a stage.
+    PipelineStage mActiveStage;
+    // False if the counters could not be read when the stage began, the
+    // stage then adds nothing.
+    bool mStageBeginValid;
+    HardwareCounterValues mStageBegin;
+    HardwareCounterValues mCurrentFrame[static_cast<int>(PipelineStage::COUNT)];
+    HardwareCounterValues mLastFrame[static_cast<int>(PipelineStage::COUNT)];
+};
+
+// Measures the enclosing scope as the given stage.
+class HardwareCounterScope
+{
+public:
+
+    HardwareCounterScope(HardwareCounters* pCounters, PipelineStage pStage)
+        : mCounters(pCounters)
+        , mStage(pStage)
+    {
+        if (mCounters)
+            mCounters->BeginStage(mStage);
+    }
+
+    ~HardwareCounterScope()
+    {
+        if (mCounters)
+            mCounters->EndStage(mStage);
+    }
+
+    HardwareCounterScope(const HardwareCounterScope&) = delete;
+    HardwareCounterScope& operator=(const HardwareCounterScope&) = delete;
+
+private:
+
+    HardwareCounters* mCounters;
+    PipelineStage mStage;
+};
+
+} // namespace mirage
+
+#endif
@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "hardware_counters.hpp"
+
+TEST(HardwareCounters, StageDeltas)
+{
+    using namespace mirage;
+
+    HardwareCounters counters;
+    if (!counters.IsAvailable())
+        GTEST_SKIP() << "perf_event counters are not available.";
+
+    std::vector<int> data(1 << 16, 1);
+    volatile int sum = 0;
+    {
+        HardwareCounterScope scope(&counters, PipelineStage::RASTERIZE);
+        for (int v : data)
+            sum = sum + v;
+    }
+    counters.EndFrame();
+
+    if (counters.IsAvailable(HardwareCounter::INSTRUCTIONS))
+    {
+        EXPECT_GT(counters.GetStage(PipelineStage::RASTERIZE).Get(HardwareCounter::INSTRUCTIONS), 1u << 16);
+    }
+    for (int i = 0; i < static_cast<int>(HardwareCounter::COUNT); ++i)
+    {
+        EXPECT_EQ(counters.GetStage(PipelineStage::UPLOAD).values[i], 0u);
+    }
+    // Stages that were not entered are not reported.
+    const std::string report = counters.Report(1);
+    EXPECT_NE(report.find("rasterize:"), std::string::npos);
+    EXPECT_EQ(report.find("upload:"), std::string::npos);
+
+    // A frame without stages reports nothing.
+    counters.EndFrame();
+    EXPECT_EQ(counters.GetStage(PipelineStage::RASTERIZE).Get(HardwareCounter::INSTRUCTIONS), 0u);
+}
@@ -0,0 +1,37 @@
+#include "headless_presenter.hpp"
+
+#include <cstring>
+
+#include "profiler.hpp"
+
+namespace mirage
+{
+
+HeadlessPresenter::HeadlessPresenter(unsigned pResX, unsigned pResY, unsigned pFrameLimit)
+    : mResolution(pResX, pResY)
+    , mFrameLimit(pFrameLimit)
+    , mFrameCount(0)
+    , mShouldClose(false)
+{
+    mFrame.resize(pResX * pResY, Vector4<uint8_t>(0, 0, 0, 0));
+}
+
+void HeadlessPresenter::Update(const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY)
+{
+    MIRAGE_PROFILE_ZONE("HeadlessPresenter::Update");
+    mResolution = Point2<unsigned>(pDimensionX, pDimensionY);
+    mFrame.resize(pDimensionX * pDimensionY);
+    std::memcpy(mFrame.data(), pColorBuffer, sizeof(Vector4<uint8_t>) * mFrame.size());
+}
+
+void HeadlessPresenter::Render()
+{
+    MIRAGE_PROFILE_ZONE("HeadlessPresenter::Render");
+    mFrameCount++;
+    if (mFrameLimit != 0 && mFrameCount >= mFrameLimit)
+    {
+        mShouldClose = true;
+    }
+}
+
+} // namespace mirage
@@ -0,0 +1,44 @@
+#ifndef MIRAGE_HEADLESS_PRESENTER_HPP
+#define MIRAGE_HEADLESS_PRESENTER_HPP
+#include <vector>
+
+#include "point.hpp"
+#include "presenter.hpp"
+
+namespace mirage
+{
+
+// Presenter for machines without a display. Frames are copied into memory on
+// Update and only counted on Render; FrameSinks consume them from the caller's
+// color buffer like with any other presenter. There is no vsync or buffer
+// swap, so the render loop runs as fast as the rasterizer allows.
+class HeadlessPresenter : public Presenter
+{
+public:
+
+    // ShouldWindowClose() reports true after pFrameLimit calls to Render().
+    // A limit of 0 keeps the presenter open until Close() is called.
+    HeadlessPresenter(unsigned pResX, unsigned pResY, unsigned pFrameLimit = 1);
+
+    void Update(const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY) override;
+    void Render() override;
+    bool ShouldWindowClose() const override { return mShouldClose; }
+
+    void Close() { mShouldClose = true; }
+
+    const Vector4<uint8_t>* GetFrame() const { return mFrame.data(); }
+    Point2<unsigned> GetResolution() const { return mResolution; }
+    unsigned GetFrameCount() const { return mFrameCount; }
+
+private:
+
+    std::vector<Vector4<uint8_t>> mFrame;
+    Point2<unsigned> mResolution;
+    unsigned mFrameLimit;
+    unsigned mFrameCount;
+    bool mShouldClose;
+};
+
+} // namespace mirage
+
+#endif
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "headless_presenter.hpp"
+
+TEST(HeadlessPresenter, ClosesAfterFrameLimit)
+{
+    using namespace mirage;
+
+    HeadlessPresenter presenter(4, 2, 3);
+    for (unsigned frame = 0; frame < 3; ++frame)
+    {
+        EXPECT_FALSE(presenter.ShouldWindowClose());
+        presenter.Render();
+    }
+    EXPECT_TRUE(presenter.ShouldWindowClose());
+    EXPECT_EQ(presenter.GetFrameCount(), 3u);
+}
+
+TEST(HeadlessPresenter, StaysOpenUntilClosed)
+{
+    using namespace mirage;
+
+    HeadlessPresenter presenter(4, 2, 0);
+    for (unsigned frame = 0; frame < 100; ++frame)
+        presenter.Render();
+    EXPECT_FALSE(presenter.ShouldWindowClose());
+    presenter.Close();
+    EXPECT_TRUE(presenter.ShouldWindowClose());
+    EXPECT_EQ(presenter.GetFrameCount(), 100u);
+}
+
+TEST(HeadlessPresenter, UpdateCopiesFrame)
+{
+    using namespace mirage;
+
+    HeadlessPresenter presenter(4, 2);
+    std::vector<Vector4<uint8_t>> frame(3 * 5);
+    for (std::size_t i = 0; i < frame.size(); ++i)
+        frame[i] = Vector4<uint8_t>(uint8_t(i), 1, 2, 3);
+    presenter.Update(frame.data(), 3, 5);
+    frame[0].x = 99;
+
+    EXPECT_EQ(presenter.GetResolution().x(), 3u);
+    EXPECT_EQ(presenter.GetResolution().y(), 5u);
+    EXPECT_EQ(presenter.GetFrame()[0], Vector4<uint8_t>(0, 1, 2, 3));
+    EXPECT_EQ(presenter.GetFrame()[14], Vector4<uint8_t>(14, 1, 2, 3));
+}
@@ -0,0 +1,125 @@
+#include "image_diff.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "image_io.hpp"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define MIRAGE_IMAGE_DIFF_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace mirage
+{
+
+static void CompareImagesScalar(
+    const uint8_t* pA, const uint8_t* pB, std::size_t pCount, uint8_t pTolerance,
+    uint8_t* pMaxError, uint64_t* pSquaredSum, uint64_t* pDifferingPixels)
+{
+    for (std::size_t i = 0; i < pCount; ++i)
+    {
+        bool differs = false;
+        for (int c = 0; c < 4; ++c)
+        {
+            const int d = std::abs(static_cast<int>(pA[i * 4 + c]) - pB[i * 4 + c]);
+            *pMaxError = std::max<uint8_t>(*pMaxError, static_cast<uint8_t>(d));
+            *pSquaredSum += d * d;
+            differs |= d > pTolerance;
+        }
+        *pDifferingPixels += differs;
+    }
+}
+
+ImageDiff CompareImages(
+    const Vector4<uint8_t>* pImageA, const Vector4<uint8_t>* pImageB,
+    std::size_t pCount, uint8_t pTolerance)
+{
+    const uint8_t* a = reinterpret_cast<const uint8_t*>(pImageA);
+    const uint8_t* b = reinterpret_cast<const uint8_t*>(pImageB);
+
+    uint8_t max_error = 0;
+    uint64_t squared_sum = 0;
+    uint64_t differing_pixels = 0;
+    std::size_t i = 0;
+
+#ifdef MIRAGE_IMAGE_DIFF_SSE2
+    // Four pixels per iteration. Squared differences are summed in 32-bit
+    // lanes and flushed to 64 bits before they can overflow.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i tolerance = _mm_set1_epi8(static_cast<char>(pTolerance));
+    __m128i max_vec = zero;
+    constexpr std::size_t FlushInterval = 4096;
+
+    while (i + 4 <= pCount)
+    {
+        __m128i sum_vec = zero;
+        const std::size_t block_end = std::min(pCount & ~std::size_t(3), i + FlushInterval * 4);
+        for (; i < block_end; i += 4)
+        {
+            const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i * 4));
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i * 4));
+            const __m128i diff = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+            max_vec = _mm_max_epu8(max_vec, diff);
+
+            const __m128i lo = _mm_unpacklo_epi8(diff, zero);
+            const __m128i hi = _mm_unpackhi_epi8(diff, zero);
+            sum_vec = _mm_add_epi32(sum_vec, _mm_madd_epi16(lo, lo));
+            sum_vec = _mm_add_epi32(sum_vec, _mm_madd_epi16(hi, hi));
+
+            // A pixel is equal within tolerance if all four channel bytes
+            // saturate to zero after subtracting the tolerance.
+            const __m128i above = _mm_subs_epu8(diff, tolerance);
+            const int equal_mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(above, zero)));
+            differing_pixels += 4 - ((equal_mask & 1) + ((equal_mask >> 1) & 1) + ((equal_mask >> 2) & 1) + ((equal_mask >> 3) & 1));
+        }
+
+        alignas(16) uint32_t sums[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(sums), sum_vec);
+        squared_sum += static_cast<uint64_t>(sums[0]) + sums[1] + sums[2] + sums[3];
+    }
+
+    alignas(16) uint8_t maxima[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(maxima), max_vec);
+    for (int k = 0; k < 16; ++k)
+        max_error = std::max(max_error, maxima[k]);
+#endif
+
+    CompareImagesScalar(a + i * 4, b + i * 4, pCount - i, pTolerance, &max_error, &squared_sum, &differing_pixels);
+
+    ImageDiff result;
+    result.max_error = max_error;
+    result.rmse = pCount ? std::sqrt(static_cast<double>(squared_sum) / (pCount * 4.0)) : 0.0;
+    result.differing_pixels = differing_pixels;
+    return result;
+}
+
+bool WriteDiffHeatmap(
+    const std::string& pPath, const Vector4<uint8_t>* pImageA, const Vector4<uint8_t>* pImageB,
+    unsigned pDimensionX, unsigned pDimensionY)
+{
+    const std::size_t n = static_cast<std::size_t>(pDimensionX) * pDimensionY;
+    std::vector<Vector4<uint8_t>> heatmap(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        int d = 0;
+        d = std::max(d, std::abs(pImageA[i].x - pImageB[i].x));
+        d = std::max(d, std::abs(pImageA[i].y - pImageB[i].y));
+        d = std::max(d, std::abs(pImageA[i].z - pImageB[i].z));
+        d = std::max(d, std::abs(pImageA[i].w - pImageB[i].w));
+
+        // Any difference is at least clearly red, so single pixels stand out.
+        const float t = d == 0 ? 0.f : 0.25f + 0.75f * (d / 255.f);
+        heatmap[i] = Vector4<uint8_t>(
+            static_cast<uint8_t>(255.f * std::min(1.f, t * 3.f)),
+            static_cast<uint8_t>(255.f * std::min(1.f, std::max(0.f, t * 3.f - 1.f))),
+            static_cast<uint8_t>(255.f * std::min(1.f, std::max(0.f, t * 3.f - 2.f))),
+            255
+        );
+    }
+    return WriteImage(pPath, heatmap.data(), pDimensionX, pDimensionY);
+}
+
+} // namespace mirage
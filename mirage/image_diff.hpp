@@ -0,0 +1,36 @@
+#ifndef MIRAGE_IMAGE_DIFF_HPP
+#define MIRAGE_IMAGE_DIFF_HPP
+#include <cstdint>
+#include <string>
+
+#include "vecmath.hpp"
+
+namespace mirage
+{
+
+struct ImageDiff
+{
+    // Largest absolute difference of any channel.
+    uint8_t max_error;
+    // Root mean square error over all channels.
+    double rmse;
+    // Pixels with a channel difference above the tolerance.
+    uint64_t differing_pixels;
+};
+
+// Per-pixel comparison of two RGBA8 images with pCount pixels each.
+ImageDiff CompareImages(
+    const Vector4<uint8_t>* pImageA, const Vector4<uint8_t>* pImageB,
+    std::size_t pCount, uint8_t pTolerance = 0
+);
+
+// Writes an image of the largest channel difference per pixel. Identical
+// pixels are black, larger errors go from red over yellow to white.
+bool WriteDiffHeatmap(
+    const std::string& pPath, const Vector4<uint8_t>* pImageA, const Vector4<uint8_t>* pImageB,
+    unsigned pDimensionX, unsigned pDimensionY
+);
+
+} // namespace mirage
+
+#endif
@@ -0,0 +1,666 @@
+#include "image_io.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "check.hpp"
+
+namespace mirage
+{
+
+static bool HasExtension(const std::string& pPath, const char* pExtension)
+{
+    const std::size_t length = std::strlen(pExtension);
+    if (pPath.size() < length)
+        return false;
+
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        char c = pPath[pPath.size() - length + i];
+        if (c >= 'A' && c <= 'Z')
+            c = c - 'A' + 'a';
+        if (c != pExtension[i])
+            return false;
+    }
+    return true;
+}
+
+ImageFormat ImageFormatFromPath(const std::string& pPath)
+{
+    if (HasExtension(pPath, ".ppm")) return ImageFormat::PPM;
+    if (HasExtension(pPath, ".qoi")) return ImageFormat::QOI;
+    if (HasExtension(pPath, ".png")) return ImageFormat::PNG;
+    return ImageFormat::PAM;
+}
+
+static void AppendString(std::vector<uint8_t>* pOut, const std::string& pString)
+{
+    pOut->insert(pOut->end(), pString.begin(), pString.end());
+}
+
+static void AppendU32BigEndian(std::vector<uint8_t>* pOut, uint32_t v)
+{
+    pOut->push_back(static_cast<uint8_t>(v >> 24));
+    pOut->push_back(static_cast<uint8_t>(v >> 16));
+    pOut->push_back(static_cast<uint8_t>(v >> 8));
+    pOut->push_back(static_cast<uint8_t>(v));
+}
+
+static void EncodePPM(
+    const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY,
+    std::vector<uint8_t>* pOut)
+{
+    const std::size_t n = static_cast<std::size_t>(pDimensionX) * pDimensionY;
+    AppendString(pOut, "P6\n" + std::to_string(pDimensionX) + ' ' + std::to_string(pDimensionY) + "\n255\n");
+
+    std::size_t offset = pOut->size();
+    pOut->resize(offset + n * 3);
+    uint8_t* dst = pOut->data() + offset;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        dst[0] = pColorBuffer[i].x;
+        dst[1] = pColorBuffer[i].y;
+        dst[2] = pColorBuffer[i].z;
+        dst += 3;
+    }
+}
+
+static void EncodePAM(
+    const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY,
+    std::vector<uint8_t>* pOut)
+{
+    const std::size_t n = static_cast<std::size_t>(pDimensionX) * pDimensionY;
+    AppendString(pOut,
+        "P7\nWIDTH " + std::to_string(pDimensionX) +
+        "\nHEIGHT " + std::to_string(pDimensionY) +
+        "\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n");
+
+    // The color buffer already is tightly packed RGBA.
+    std::size_t offset = pOut->size();
+    pOut->resize(offset + n * 4);
+    std::memcpy(pOut->data() + offset, pColorBuffer, n * 4);
+}
+
+// Reference: https://qoiformat.org/qoi-specification.pdf
+static void EncodeQOI(
+    const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY,
+    std::vector<uint8_t>* pOut)
+{
+    constexpr uint8_t OpIndex = 0x00;
+    constexpr uint8_t OpDiff  = 0x40;
+    constexpr uint8_t OpLuma  = 0x80;
+    constexpr uint8_t OpRun   = 0xc0;
+    constexpr uint8_t OpRGB   = 0xfe;
+    constexpr uint8_t OpRGBA  = 0xff;
+
+    const std::size_t n = static_cast<std::size_t>(pDimensionX) * pDimensionY;
+    // Worst case is one OpRGBA per pixel.
+    pOut->reserve(pOut->size() + 14 + n * 5 + 8);
+
+    AppendString(pOut, "qoif");
+    AppendU32BigEndian(pOut, pDimensionX);
+    AppendU32BigEndian(pOut, pDimensionY);
+    pOut->push_back(4); // channels
+    pOut->push_back(0); // sRGB with linear alpha
+
+    Vector4<uint8_t> index[64];
+    for (int i = 0; i < 64; ++i)
+        index[i] = Vector4<uint8_t>(0, 0, 0, 0);
+    Vector4<uint8_t> prev(0, 0, 0, 255);
+    int run = 0;
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const Vector4<uint8_t> px = pColorBuffer[i];
+        if (std::memcmp(&px, &prev, sizeof(px)) == 0)
+        {
+            run++;
+            if (run == 62 || i == n - 1)
+            {
+                pOut->push_back(OpRun | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+
+        if (run > 0)
+        {
+            pOut->push_back(OpRun | (run - 1));
+            run = 0;
+        }
+
+        const int h = (px.x * 3 + px.y * 5 + px.z * 7 + px.w * 11) % 64;
+        if (std::memcmp(&index[h], &px, sizeof(px)) == 0)
+        {
+            pOut->push_back(OpIndex | h);
+        }
+        else
+        {
+            index[h] = px;
+            if (px.w == prev.w)
+            {
+                const int8_t vr = static_cast<int8_t>(px.x - prev.x);
+                const int8_t vg = static_cast<int8_t>(px.y - prev.y);
+                const int8_t vb = static_cast<int8_t>(px.z - prev.z);
+                const int8_t vg_r = vr - vg;
+                const int8_t vg_b = vb - vg;
+
+                if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+                {
+                    pOut->push_back(OpDiff | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+                }
+                else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8)
+                {
+                    pOut->push_back(OpLuma | (vg + 32));
+                    pOut->push_back((vg_r + 8) << 4 | (vg_b + 8));
+                }
+                else
+                {
+                    pOut->push_back(OpRGB);
+                    pOut->push_back(px.x);
+                    pOut->push_back(px.y);
+                    pOut->push_back(px.z);
+                }
+            }
+            else
+            {
+                pOut->push_back(OpRGBA);
+                pOut->push_back(px.x);
+                pOut->push_back(px.y);
+                pOut->push_back(px.z);
+                pOut->push_back(px.w);
+            }
+        }
+        prev = px;
+    }
+
+    const uint8_t padding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+    pOut->insert(pOut->end(), padding, padding + 8);
+}
+
+static uint32_t Crc32(const uint8_t* pData, std::size_t pSize, uint32_t pCrc = 0)
+{
+    // Initialized once, thread-safe since several encoders may run at once.
+    static const std::array<uint32_t, 256> table = []()
+    {
+        std::array<uint32_t, 256> t;
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    uint32_t c = pCrc ^ 0xffffffffu;
+    for (std::size_t i = 0; i < pSize; ++i)
+        c = table[(c ^ pData[i]) & 0xff] ^ (c >> 8);
+    return c ^ 0xffffffffu;
+}
+
+static void AppendPNGChunk(std::vector<uint8_t>* pOut, const char* pType, const uint8_t* pData, std::size_t pSize)
+{
+    AppendU32BigEndian(pOut, static_cast<uint32_t>(pSize));
+    const std::size_t type_offset = pOut->size();
+    pOut->insert(pOut->end(), pType, pType + 4);
+    pOut->insert(pOut->end(), pData, pData + pSize);
+    AppendU32BigEndian(pOut, Crc32(pOut->data() + type_offset, pSize + 4));
+}
+
+// Writes a PNG whose IDAT stream consists of stored (uncompressed) deflate
+// blocks. Files are large but encoding is little more than a memcpy.
+static void EncodePNG(
+    const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY,
+    std::vector<uint8_t>* pOut)
+{
+    const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    pOut->insert(pOut->end(), signature, signature + 8);
+
+    std::vector<uint8_t> ihdr;
+    AppendU32BigEndian(&ihdr, pDimensionX);
+    AppendU32BigEndian(&ihdr, pDimensionY);
+    ihdr.push_back(8); // bit depth
+    ihdr.push_back(6); // RGBA
+    ihdr.push_back(0); // deflate
+    ihdr.push_back(0); // adaptive filtering
+    ihdr.push_back(0); // no interlace
+    AppendPNGChunk(pOut, "IHDR", ihdr.data(), ihdr.size());
+
+    // Every scanline starts with filter type 0.
+    const std::size_t row_size = static_cast<std::size_t>(pDimensionX) * 4 + 1;
+    std::vector<uint8_t> raw(row_size * pDimensionY);
+    for (unsigned y = 0; y < pDimensionY; ++y)
+    {
+        raw[y * row_size] = 0;
+        std::memcpy(&raw[y * row_size + 1], pColorBuffer + static_cast<std::size_t>(y) * pDimensionX, pDimensionX * 4);
+    }
+
+    constexpr std::size_t MaxBlockSize = 65535;
+    const std::size_t block_count = std::max<std::size_t>(1, (raw.size() + MaxBlockSize - 1) / MaxBlockSize);
+    std::vector<uint8_t> zlib;
+    zlib.reserve(2 + raw.size() + block_count * 5 + 4);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+
+    uint32_t adler_a = 1, adler_b = 0;
+    std::size_t offset = 0;
+    for (std::size_t block = 0; block < block_count; ++block)
+    {
+        const std::size_t size = std::min(MaxBlockSize, raw.size() - offset);
+        zlib.push_back(block == block_count - 1 ? 1 : 0);
+        zlib.push_back(static_cast<uint8_t>(size));
+        zlib.push_back(static_cast<uint8_t>(size >> 8));
+        zlib.push_back(static_cast<uint8_t>(~size));
+        zlib.push_back(static_cast<uint8_t>(~size >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+
+        for (std::size_t i = offset; i < offset + size; ++i)
+        {
+            adler_a = (adler_a + raw[i]) % 65521;
+            adler_b = (adler_b + adler_a) % 65521;
+        }
+        offset += size;
+    }
+    AppendU32BigEndian(&zlib, (adler_b << 16) | adler_a);
+
+    AppendPNGChunk(pOut, "IDAT", zlib.data(), zlib.size());
+    AppendPNGChunk(pOut, "IEND", nullptr, 0);
+}
+
+void EncodeImage(
+    ImageFormat pFormat, const Vector4<uint8_t>* pColorBuffer,
+    unsigned pDimensionX, unsigned pDimensionY, std::vector<uint8_t>* pOut)
+{
+    switch (pFormat) {
+    case ImageFormat::PPM:
+        EncodePPM(pColorBuffer, pDimensionX, pDimensionY, pOut);
+        break;
+    case ImageFormat::PAM:
+        EncodePAM(pColorBuffer, pDimensionX, pDimensionY, pOut);
+        break;
+    case ImageFormat::QOI:
+        EncodeQOI(pColorBuffer, pDimensionX, pDimensionY, pOut);
+        break;
+    case ImageFormat::PNG:
+        EncodePNG(pColorBuffer, pDimensionX, pDimensionY, pOut);
+        break;
+    default:
+        assert(false, "Error. Unhandled image format!");
+        break;
+    }
+}
+
+bool WriteBytesToFile(const std::string& pPath, const uint8_t* pBytes, std::size_t pSize)
+{
+    std::ofstream outs(pPath, std::ios::binary | std::ios::trunc);
+    if (!outs)
+        return false;
+    outs.write(reinterpret_cast<const char*>(pBytes), pSize);
+    return static_cast<bool>(outs);
+}
+
+bool WriteImage(
+    const std::string& pPath, const Vector4<uint8_t>* pColorBuffer,
+    unsigned pDimensionX, unsigned pDimensionY)
+{
+    std::vector<uint8_t> bytes;
+    EncodeImage(ImageFormatFromPath(pPath), pColorBuffer, pDimensionX, pDimensionY, &bytes);
+    return WriteBytesToFile(pPath, bytes.data(), bytes.size());
+}
+
+static bool ReadFile(const std::string& pPath, std::vector<uint8_t>* pBytes)
+{
+    std::ifstream ins(pPath, std::ios::binary | std::ios::ate);
+    if (!ins)
+        return false;
+    const std::streamsize size = ins.tellg();
+    ins.seekg(0);
+    pBytes->resize(static_cast<std::size_t>(size));
+    return static_cast<bool>(ins.read(reinterpret_cast<char*>(pBytes->data()), size));
+}
+
+// Minimal tokenizer for the whitespace separated PNM headers.
+struct HeaderReader
+{
+    const uint8_t* p;
+    const uint8_t* end;
+
+    std::string NextToken()
+    {
+        while (p < end)
+        {
+            if (*p == '#')
+            {
+                while (p < end && *p != '\n') ++p;
+            }
+            else if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+            {
+                ++p;
+            }
+            else
+            {
+                break;
+            }
+        }
+        const uint8_t* begin = p;
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+            ++p;
+        return std::string(begin, p);
+    }
+
+    unsigned NextUnsigned()
+    {
+        const std::string token = NextToken();
+        return token.empty() ? 0 : static_cast<unsigned>(std::strtoul(token.c_str(), nullptr, 10));
+    }
+};
+
+static bool DecodePNM(
+    const std::vector<uint8_t>& pBytes, std::vector<Vector4<uint8_t>>* pPixels,
+    unsigned* pDimensionX, unsigned* pDimensionY)
+{
+    HeaderReader reader{ pBytes.data(), pBytes.data() + pBytes.size() };
+    const std::string magic = reader.NextToken();
+    unsigned width = 0, height = 0, depth = 0, maxval = 0;
+
+    if (magic == "P6")
+    {
+        width = reader.NextUnsigned();
+        height = reader.NextUnsigned();
+        maxval = reader.NextUnsigned();
+        depth = 3;
+    }
+    else if (magic == "P7")
+    {
+        while (true)
+        {
+            const std::string key = reader.NextToken();
+            if (key.empty())
+                return false;
+            if (key == "ENDHDR")
+                break;
+            if (key == "WIDTH") width = reader.NextUnsigned();
+            else if (key == "HEIGHT") height = reader.NextUnsigned();
+            else if (key == "DEPTH") depth = reader.NextUnsigned();
+            else if (key == "MAXVAL") maxval = reader.NextUnsigned();
+            else reader.NextToken();
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    // Exactly one whitespace character separates the header from the data.
+    reader.p++;
+    const std::size_t n = static_cast<std::size_t>(width) * height;
+    if (maxval != 255 || (depth != 3 && depth != 4) || reader.p + n * depth > reader.end)
+        return false;
+
+    pPixels->resize(n);
+    const uint8_t* src = reader.p;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        (*pPixels)[i] = Vector4<uint8_t>(src[0], src[1], src[2], depth == 4 ? src[3] : 255);
+        src += depth;
+    }
+    *pDimensionX = width;
+    *pDimensionY = height;
+    return true;
+}
+
+static bool DecodeQOI(
+    const std::vector<uint8_t>& pBytes, std::vector<Vector4<uint8_t>>* pPixels,
+    unsigned* pDimensionX, unsigned* pDimensionY)
+{
+    if (pBytes.size() < 14 + 8 || std::memcmp(pBytes.data(), "qoif", 4) != 0)
+        return false;
+
+    const uint8_t* b = pBytes.data();
+    const unsigned width = b[4] << 24 | b[5] << 16 | b[6] << 8 | b[7];
+    const unsigned height = b[8] << 24 | b[9] << 16 | b[10] << 8 | b[11];
+    const std::size_t n = static_cast<std::size_t>(width) * height;
+    const std::size_t end = pBytes.size() - 8;
+    // A run op covers at most 62 pixels, so a corrupt header cannot make
+    // the buffer below much larger than the file.
+    if (n > (end - 14) * 62)
+        return false;
+
+    Vector4<uint8_t> index[64];
+    for (int i = 0; i < 64; ++i)
+        index[i] = Vector4<uint8_t>(0, 0, 0, 0);
+    Vector4<uint8_t> px(0, 0, 0, 255);
+
+    pPixels->resize(n);
+    std::size_t p = 14;
+    int run = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (run > 0)
+        {
+            run--;
+        }
+        else
+        {
+            // The ops ran out before the last pixel.
+            if (p >= end)
+                return false;
+            const uint8_t op = b[p++];
+            if (op == 0xfe)
+            {
+                px.x = b[p]; px.y = b[p + 1]; px.z = b[p + 2];
+                p += 3;
+            }
+            else if (op == 0xff)
+            {
+                px = Vector4<uint8_t>(b[p], b[p + 1], b[p + 2], b[p + 3]);
+                p += 4;
+            }
+            else if ((op & 0xc0) == 0x00)
+            {
+                px = index[op];
+            }
+            else if ((op & 0xc0) == 0x40)
+            {
+                px.x += ((op >> 4) & 0x03) - 2;
+                px.y += ((op >> 2) & 0x03) - 2;
+                px.z += (op & 0x03) - 2;
+            }
+            else if ((op & 0xc0) == 0x80)
+            {
+                const uint8_t b2 = b[p++];
+                const int vg = (op & 0x3f) - 32;
+                px.x += vg - 8 + ((b2 >> 4) & 0x0f);
+                px.y += vg;
+                px.z += vg - 8 + (b2 & 0x0f);
+            }
+            else
+            {
+                run = op & 0x3f;
+            }
+            index[(px.x * 3 + px.y * 5 + px.z * 7 + px.w * 11) % 64] = px;
+        }
+        (*pPixels)[i] = px;
+    }
+    if (p > end)
+        return false;
+
+    *pDimensionX = width;
+    *pDimensionY = height;
+    return true;
+}
+
+static uint32_t ReadU32BigEndian(const uint8_t* p)
+{
+    return static_cast<uint32_t>(p[0]) << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+// Decodes the PNGs written by EncodePNG: 8-bit RGBA, stored deflate blocks
+// and filter type 0 on every scanline. Anything else is rejected.
+static bool DecodePNG(
+    const std::vector<uint8_t>& pBytes, std::vector<Vector4<uint8_t>>* pPixels,
+    unsigned* pDimensionX, unsigned* pDimensionY)
+{
+    const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    if (pBytes.size() < 8 || std::memcmp(pBytes.data(), signature, 8) != 0)
+        return false;
+
+    unsigned width = 0, height = 0;
+    std::vector<uint8_t> zlib;
+    std::size_t p = 8;
+    while (p + 12 <= pBytes.size())
+    {
+        const uint32_t length = ReadU32BigEndian(&pBytes[p]);
+        const uint8_t* type = &pBytes[p + 4];
+        const uint8_t* data = &pBytes[p + 8];
+        if (length > pBytes.size() - p - 12)
+            return false;
+        if (std::memcmp(type, "IHDR", 4) == 0)
+        {
+            // 8-bit RGBA, deflate, no interlace.
+            if (length != 13 || data[8] != 8 || data[9] != 6 || data[10] != 0 || data[12] != 0)
+                return false;
+            width = ReadU32BigEndian(data);
+            height = ReadU32BigEndian(data + 4);
+        }
+        else if (std::memcmp(type, "IDAT", 4) == 0)
+        {
+            zlib.insert(zlib.end(), data, data + length);
+        }
+        else if (std::memcmp(type, "IEND", 4) == 0)
+        {
+            break;
+        }
+        p += 12 + length;
+    }
+
+    const std::size_t row_size = static_cast<std::size_t>(width) * 4 + 1;
+    std::vector<uint8_t> raw;
+    raw.reserve(row_size * height);
+    std::size_t z = 2;
+    bool final_block = zlib.size() < 2;
+    while (!final_block)
+    {
+        // Only stored blocks: 3 header bits, padded to a byte, then LEN and NLEN.
+        if (z + 5 > zlib.size() || (zlib[z] & 0x06) != 0)
+            return false;
+        final_block = zlib[z] & 1;
+        const std::size_t size = zlib[z + 1] | zlib[z + 2] << 8;
+        z += 5;
+        if (size > zlib.size() - z)
+            return false;
+        raw.insert(raw.end(), zlib.begin() + z, zlib.begin() + z + size);
+        z += size;
+    }
+    if (width == 0 || height == 0 || raw.size() != row_size * height)
+        return false;
+
+    pPixels->resize(static_cast<std::size_t>(width) * height);
+    for (unsigned y = 0; y < height; ++y)
+    {
+        const uint8_t* row = &raw[y * row_size];
+        if (row[0] != 0)
+            return false;
+        std::memcpy(&(*pPixels)[static_cast<std::size_t>(y) * width], row + 1, width * 4);
+    }
+    *pDimensionX = width;
+    *pDimensionY = height;
+    return true;
+}
+
+bool ReadImage(
+    const std::string& pPath, std::vector<Vector4<uint8_t>>* pPixels,
+    unsigned* pDimensionX, unsigned* pDimensionY)
+{
+    std::vector<uint8_t> bytes;
+    if (!ReadFile(pPath, &bytes))
+        return false;
+
+    if (bytes.size() >= 4 && std::memcmp(bytes.data(), "qoif", 4) == 0)
+        return DecodeQOI(bytes, pPixels, pDimensionX, pDimensionY);
+    if (bytes.size() >= 4 && std::memcmp(bytes.data() + 1, "PNG", 3) == 0)
+        return DecodePNG(bytes, pPixels, pDimensionX, pDimensionY);
+    return DecodePNM(bytes, pPixels, pDimensionX, pDimensionY);
+}
+
+AsyncImageWriter::AsyncImageWriter(std::size_t pMaxQueuedImages)
+    : mMaxQueuedImages(std::max<std::size_t>(pMaxQueuedImages, 1))
+    , mBusy(false)
+    , mStop(false)
+{
+}
+
+AsyncImageWriter::~AsyncImageWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mJobAvailable.notify_one();
+    if (mThread.joinable())
+        mThread.join();
+}
+
+void AsyncImageWriter::Write(
+    const std::string& pPath, const Vector4<uint8_t>* pColorBuffer,
+    unsigned pDimensionX, unsigned pDimensionY)
+{
+    Job job;
+    job.path = pPath;
+    job.pixels.assign(pColorBuffer, pColorBuffer + static_cast<std::size_t>(pDimensionX) * pDimensionY);
+    job.dimension_x = pDimensionX;
+    job.dimension_y = pDimensionY;
+
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        // The thread is only started once something is written.
+        if (!mThread.joinable())
+            mThread = std::thread(&AsyncImageWriter::Run, this);
+        mJobTaken.wait(lock, [this]() { return mJobs.size() < mMaxQueuedImages; });
+        mJobs.push_back(std::move(job));
+    }
+    mJobAvailable.notify_one();
+}
+
+void AsyncImageWriter::Flush()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIdle.wait(lock, [this]() { return mJobs.empty() && !mBusy; });
+}
+
+void AsyncImageWriter::Run()
+{
+    std::vector<uint8_t> bytes;
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mJobAvailable.wait(lock, [this]() { return mStop || !mJobs.empty(); });
+            if (mJobs.empty())
+                return;
+            job = std::move(mJobs.front());
+            mJobs.pop_front();
+            mBusy = true;
+        }
+        mJobTaken.notify_all();
+
+        bytes.clear();
+        EncodeImage(ImageFormatFromPath(job.path), job.pixels.data(), job.dimension_x, job.dimension_y, &bytes);
+        if (!WriteBytesToFile(job.path, bytes.data(), bytes.size()))
+            printf("Error. Could not write image to %s\n", job.path.c_str());
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mBusy = false;
+        }
+        mIdle.notify_all();
+    }
+}
+
+} // namespace mirage
@@ -0,0 +1,100 @@
+#ifndef MIRAGE_IMAGE_IO_HPP
+#define MIRAGE_IMAGE_IO_HPP
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "vecmath.hpp"
+
+namespace mirage
+{
+
+enum class ImageFormat
+{
+    PPM = 0,    // Binary P6, alpha is dropped.
+    PAM,        // Binary P7 with RGB_ALPHA tuples.
+    QOI,
+    PNG         // Uncompressed (stored deflate blocks).
+};
+
+// Picks the format from the file extension. Unknown extensions map to PAM.
+ImageFormat ImageFormatFromPath(const std::string& pPath);
+
+// Serializes the color buffer into pOut. Row 0 of the buffer is written first.
+void EncodeImage(
+    ImageFormat pFormat, const Vector4<uint8_t>* pColorBuffer,
+    unsigned pDimensionX, unsigned pDimensionY, std::vector<uint8_t>* pOut
+);
+
+// Writes pSize bytes with a single write call. Returns false on failure.
+bool WriteBytesToFile(const std::string& pPath, const uint8_t* pBytes, std::size_t pSize);
+
+// Encodes the color buffer in the format implied by pPath and writes it
+// synchronously. Returns false if the file could not be written.
+bool WriteImage(
+    const std::string& pPath, const Vector4<uint8_t>* pColorBuffer,
+    unsigned pDimensionX, unsigned pDimensionY
+);
+
+// Reads binary PPM (P6), PAM (P7 with RGB or RGB_ALPHA tuples) and QOI
+// images, and PNGs as written by EncodeImage (stored deflate blocks, no
+// filtering). PPM pixels get an alpha of 255. Returns false on malformed or
+// unsupported input.
+bool ReadImage(
+    const std::string& pPath, std::vector<Vector4<uint8_t>>* pPixels,
+    unsigned* pDimensionX, unsigned* pDimensionY
+);
+
+// Encodes and writes images on a background thread. Write() copies the color
+// buffer and returns immediately, so the caller may reuse the buffer for the
+// next frame right away. At most pMaxQueuedImages copies wait for the disk;
+// beyond that Write() blocks until the oldest one is being written, so a slow
+// disk throttles the caller instead of growing the queue without bound.
+class AsyncImageWriter
+{
+public:
+
+    explicit AsyncImageWriter(std::size_t pMaxQueuedImages = 4);
+    // Writes all pending images before returning.
+    ~AsyncImageWriter();
+
+    AsyncImageWriter(const AsyncImageWriter&) = delete;
+    AsyncImageWriter& operator=(const AsyncImageWriter&) = delete;
+
+    void Write(
+        const std::string& pPath, const Vector4<uint8_t>* pColorBuffer,
+        unsigned pDimensionX, unsigned pDimensionY
+    );
+
+    // Blocks until every queued image has been written.
+    void Flush();
+
+private:
+
+    struct Job
+    {
+        std::string path;
+        std::vector<Vector4<uint8_t>> pixels;
+        unsigned dimension_x;
+        unsigned dimension_y;
+    };
+
+    void Run();
+
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mJobAvailable;
+    std::condition_variable mIdle;
+    std::condition_variable mJobTaken;
+    std::deque<Job> mJobs;
+    std::size_t mMaxQueuedImages;
+    bool mBusy;
+    bool mStop;
+};
+
+} // namespace mirage
+
+#endif
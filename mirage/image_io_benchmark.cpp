@@ -0,0 +1,65 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <vector>
+
+#include "tmp_runtests_macro.hpp"
+
+#ifdef MIRAGE_RUN_BENCHMARKS
+
+#include "image_io.hpp"
+
+static std::vector<mirage::Vector4<uint8_t>> MakeTestFrame(unsigned pResX, unsigned pResY)
+{
+    std::vector<mirage::Vector4<uint8_t>> frame(pResX * pResY);
+    for (unsigned y = 0; y < pResY; ++y)
+    {
+        for (unsigned x = 0; x < pResX; ++x)
+        {
+            frame[y * pResX + x] = mirage::Vector4<uint8_t>(x & 0xff, y & 0xff, (x ^ y) & 0xff, 255);
+        }
+    }
+    return frame;
+}
+
+// The synchronous encode and write that TextureRenderer::WriteToFile runs on
+// its background thread. Argument: ImageFormat.
+static void BM_WriteImage(benchmark::State& state)
+{
+    using namespace mirage;
+    constexpr unsigned Res = 1024;
+    const std::vector<Vector4<uint8_t>> frame = MakeTestFrame(Res, Res);
+    const char* paths[] = { "bench_frame.ppm", "bench_frame.pam", "bench_frame.qoi", "bench_frame.png" };
+    const char* path = paths[state.range(0)];
+
+    for (auto _ : state)
+    {
+        WriteImage(path, frame.data(), Res, Res);
+    }
+    std::remove(path);
+
+    state.SetBytesProcessed(state.iterations() * Res * Res * sizeof(Vector4<uint8_t>));
+}
+BENCHMARK(BM_WriteImage)->DenseRange(0, 3)->Unit(benchmark::kMillisecond);
+
+// Time the render loop spends in TextureRenderer::WriteToFile: copying the
+// frame and queueing it for the writer thread.
+static void BM_AsyncImageWriterSubmit(benchmark::State& state)
+{
+    using namespace mirage;
+    constexpr unsigned Res = 1024;
+    const std::vector<Vector4<uint8_t>> frame = MakeTestFrame(Res, Res);
+    AsyncImageWriter writer;
+
+    for (auto _ : state)
+    {
+        writer.Write("bench_async.pam", frame.data(), Res, Res);
+        state.PauseTiming();
+        writer.Flush();
+        state.ResumeTiming();
+    }
+    std::remove("bench_async.pam");
+}
+BENCHMARK(BM_AsyncImageWriterSubmit)->Unit(benchmark::kMicrosecond);
+
+#endif
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "image_io.hpp"
+
+static std::vector<mirage::Vector4<uint8_t>> MakeTestImage(unsigned pDimensionX, unsigned pDimensionY)
+{
+    using namespace mirage;
+    std::vector<Vector4<uint8_t>> pixels(pDimensionX * pDimensionY);
+    for (unsigned y = 0; y < pDimensionY; ++y)
+    {
+        for (unsigned x = 0; x < pDimensionX; ++x)
+        {
+            // Runs, small differences and arbitrary colors, so every QOI op
+            // is exercised.
+            const unsigned i = y * pDimensionX + x;
+            if (x < 4)
+                pixels[i] = Vector4<uint8_t>(10, 20, 30, 255);
+            else if (x < 8)
+                pixels[i] = Vector4<uint8_t>(uint8_t(10 + x), uint8_t(20 + x), 30, 255);
+            else
+                pixels[i] = Vector4<uint8_t>(uint8_t(i * 37), uint8_t(i * 101), uint8_t(y * 7), uint8_t(255 - x));
+        }
+    }
+    return pixels;
+}
+
+static std::string TempPath(const char* pName)
+{
+    return testing::TempDir() + pName;
+}
+
+TEST(ImageIO, RoundTripsEveryFormat)
+{
+    using namespace mirage;
+
+    // 300 * 120 * 4 bytes of PNG data span several stored deflate blocks.
+    const unsigned res_x = 300, res_y = 120;
+    const std::vector<Vector4<uint8_t>> image = MakeTestImage(res_x, res_y);
+    for (const char* name : { "mirage_round_trip.ppm", "mirage_round_trip.pam", "mirage_round_trip.qoi", "mirage_round_trip.png" })
+    {
+        const std::string path = TempPath(name);
+        ASSERT_TRUE(WriteImage(path, image.data(), res_x, res_y)) << name;
+
+        std::vector<Vector4<uint8_t>> read;
+        unsigned read_x = 0, read_y = 0;
+        ASSERT_TRUE(ReadImage(path, &read, &read_x, &read_y)) << name;
+        EXPECT_EQ(read_x, res_x) << name;
+        EXPECT_EQ(read_y, res_y) << name;
+        ASSERT_EQ(read.size(), image.size()) << name;
+
+        // PPM has no alpha channel.
+        const bool has_alpha = ImageFormatFromPath(path) != ImageFormat::PPM;
+        for (std::size_t i = 0; i < image.size(); ++i)
+        {
+            const Vector4<uint8_t> expected(image[i].x, image[i].y, image[i].z, has_alpha ? image[i].w : 255);
+            ASSERT_EQ(read[i], expected) << name << " pixel " << i;
+        }
+        std::remove(path.c_str());
+    }
+}
+
+TEST(ImageIO, RejectsMalformedFiles)
+{
+    using namespace mirage;
+
+    const std::vector<Vector4<uint8_t>> image = MakeTestImage(16, 16);
+    std::vector<uint8_t> bytes;
+    EncodeImage(ImageFormat::PNG, image.data(), 16, 16, &bytes);
+    bytes.resize(bytes.size() / 2);
+    const std::string path = TempPath("mirage_truncated.png");
+    ASSERT_TRUE(WriteBytesToFile(path, bytes.data(), bytes.size()));
+
+    std::vector<Vector4<uint8_t>> read;
+    unsigned read_x = 0, read_y = 0;
+    EXPECT_FALSE(ReadImage(path, &read, &read_x, &read_y));
+    EXPECT_FALSE(ReadImage(TempPath("mirage_does_not_exist.qoi"), &read, &read_x, &read_y));
+    std::remove(path.c_str());
+}
+
+TEST(ImageIO, RejectsTruncatedQOI)
+{
+    using namespace mirage;
+
+    const std::vector<Vector4<uint8_t>> image = MakeTestImage(64, 64);
+    std::vector<uint8_t> bytes;
+    EncodeImage(ImageFormat::QOI, image.data(), 64, 64, &bytes);
+    const std::string path = TempPath("mirage_truncated.qoi");
+    std::vector<Vector4<uint8_t>> read;
+    unsigned read_x = 0, read_y = 0;
+
+    // Half of the ops, followed by the end marker.
+    std::vector<uint8_t> truncated(bytes.begin(), bytes.begin() + bytes.size() / 2);
+    truncated.insert(truncated.end(), bytes.end() - 8, bytes.end());
+    ASSERT_TRUE(WriteBytesToFile(path, truncated.data(), truncated.size()));
+    EXPECT_FALSE(ReadImage(path, &read, &read_x, &read_y));
+
+    // A header claiming far more pixels than the ops can hold.
+    std::vector<uint8_t> huge = bytes;
+    for (int i = 4; i < 12; ++i)
+        huge[i] = 0xff;
+    ASSERT_TRUE(WriteBytesToFile(path, huge.data(), huge.size()));
+    EXPECT_FALSE(ReadImage(path, &read, &read_x, &read_y));
+
+    ASSERT_TRUE(WriteBytesToFile(path, bytes.data(), bytes.size()));
+    EXPECT_TRUE(ReadImage(path, &read, &read_x, &read_y));
+    std::remove(path.c_str());
+}
+
+TEST(ImageIO, AsyncWriterWritesEveryImage)
+{
+    using namespace mirage;
+
+    const unsigned res = 32;
+    std::vector<std::string> paths;
+    {
+        // A queue of one makes Write() wait for the writer thread.
+        AsyncImageWriter writer(1);
+        std::vector<Vector4<uint8_t>> image = MakeTestImage(res, res);
+        for (int i = 0; i < 6; ++i)
+        {
+            paths.push_back(TempPath(("mirage_async_" + std::to_string(i) + ".qoi").c_str()));
+            image[0].x = uint8_t(i);
+            writer.Write(paths.back(), image.data(), res, res);
+            // The writer works on its own copy.
+            image[0].x = 255;
+        }
+        writer.Flush();
+
+        std::vector<Vector4<uint8_t>> read;
+        unsigned read_x = 0, read_y = 0;
+        ASSERT_TRUE(ReadImage(paths[3], &read, &read_x, &read_y));
+        EXPECT_EQ(read_x, res);
+        EXPECT_EQ(read[0].x, 3);
+        EXPECT_EQ(read[1], image[1]);
+    }
+    for (const std::string& path : paths)
+    {
+        std::vector<Vector4<uint8_t>> read;
+        unsigned read_x = 0, read_y = 0;
+        EXPECT_TRUE(ReadImage(path, &read, &read_x, &read_y)) << path;
+        std::remove(path.c_str());
+    }
+}
@@ -1,12 +1,26 @@
-#ifndef MIRAGE_RUN_TESTS
+#include "tmp_runtests_macro.hpp"
+
+#if !defined(MIRAGE_RUN_TESTS) && !defined(MIRAGE_RUN_BENCHMARKS)
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include "tmp_runtests_macro.hpp"
+#include <memory>
 #include "stringprintf.hpp"
 #include "vecmath.hpp"
 
 #include <shaderdirect.hpp>
+#include "frame_capture.hpp"
+#include "frame_stream_sink.hpp"
+#include "hardware_counters.hpp"
+#include "headless_presenter.hpp"
+#include "profiler.hpp"
+#include "progressive_renderer.hpp"
+#include "raster_stats.hpp"
+#include "ray_tracer.hpp"
+#include "shared_frame_ring.hpp"
 #include "texture_renderer.hpp"
 #include "triangle_p0.hpp"
 
@@ -56,13 +70,116 @@ void opengl_reference()
     glDeleteBuffers(1, &vbo);
 }
 
-int main()
+// Displays the frames another mirage process publishes with --publish.
+// Only the latest frame is shown, so a slow display never stalls rendering.
+int RunViewer(const char* pRingName)
+{
+    mirage::SharedFrameRingReader reader(pRingName);
+    if (!reader.IsOpen())
+    {
+        printf("Error. Could not open shared frame ring %s\n", pRingName);
+        return 1;
+    }
+
+    mirage::TextureRenderer renderer(mirage::WindowMode::WINDOWED, reader.GetMaxDimensionX(), reader.GetMaxDimensionY());
+    uint64_t shown_frames = 0;
+    while (!renderer.ShouldWindowClose())
+    {
+        // The texture upload reads straight from shared memory. If the slot
+        // was overwritten meanwhile, the next iteration uploads again.
+        mirage::SharedFrameRingReader::Frame frame;
+        if (reader.AcquireLatest(&frame) && frame.frame_index + 1 != shown_frames)
+        {
+            renderer.Update(frame.pixels, frame.width, frame.height);
+            if (reader.IsStillValid(frame))
+                shown_frames = frame.frame_index + 1;
+        }
+        renderer.Render();
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
 {
     //opengl_reference();
     //return 0;
 
+    // --headless renders without a display, e.g. on render servers.
+    // --frames N closes the headless presenter after N frames, --frames 0 once all of
+    // the sinks below have closed, e.g. when the process reading --stream exits
+    // (right after the first frame without sinks).
+    // --capture PREFIX records every Nth frame (--capture-interval N).
+    // --stream PATH writes raw RGBA frames to PATH ("-" for stdout),
+    // --stream-raw omits the per-frame headers.
+    // --publish NAME shares frames with a viewer process, started with --viewer NAME.
+    // --profile PATH writes a Chrome trace of the run to PATH on exit.
+    // --raster-stats prints the rasterizer counters every frame, --overdraw shows an overdraw heatmap.
+    // --hw-counters prints CPU performance counters per pipeline stage every frame,
+    // and renders on a single thread so that the counters see all of the work.
+    // --raytrace renders a BVH-traced scene of about a million triangles instead,
+    // --progressive refines it with ambient occlusion over the following frames.
+    bool headless = false;
+    unsigned frame_limit = 1;
+    const char* capture_prefix = nullptr;
+    unsigned capture_interval = 1;
+    const char* stream_path = nullptr;
+    bool stream_headers = true;
+    const char* publish_name = nullptr;
+    const char* profile_path = nullptr;
+    bool print_raster_stats = false;
+    bool show_overdraw = false;
+    bool print_hw_counters = false;
+    bool ray_trace = false;
+    bool progressive = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frame_limit = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+            capture_prefix = argv[++i];
+        else if (std::strcmp(argv[i], "--capture-interval") == 0 && i + 1 < argc)
+            capture_interval = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--stream") == 0 && i + 1 < argc)
+            stream_path = argv[++i];
+        else if (std::strcmp(argv[i], "--stream-raw") == 0)
+            stream_headers = false;
+        else if (std::strcmp(argv[i], "--publish") == 0 && i + 1 < argc)
+            publish_name = argv[++i];
+        else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+            profile_path = argv[++i];
+        else if (std::strcmp(argv[i], "--raster-stats") == 0)
+            print_raster_stats = true;
+        else if (std::strcmp(argv[i], "--overdraw") == 0)
+            show_overdraw = true;
+        else if (std::strcmp(argv[i], "--hw-counters") == 0)
+            print_hw_counters = true;
+        else if (std::strcmp(argv[i], "--raytrace") == 0)
+            ray_trace = true;
+        else if (std::strcmp(argv[i], "--progressive") == 0)
+            ray_trace = progressive = true;
+        else if (std::strcmp(argv[i], "--viewer") == 0 && i + 1 < argc)
+            return RunViewer(argv[i + 1]);
+    }
+
+    if (profile_path)
+    {
+        mirage::Profiler::SetEnabled(true);
+        mirage::Profiler::SetThreadName("Main");
+    }
+
     mirage::Point2<unsigned> res(1024, 1024);
-    mirage::TextureRenderer renderer(mirage::WindowMode::WINDOWED, res.x(), res.y());
+    std::unique_ptr<mirage::Presenter> renderer;
+    mirage::HeadlessPresenter* headless_presenter = nullptr;
+    if (headless)
+    {
+        auto presenter = std::make_unique<mirage::HeadlessPresenter>(res.x(), res.y(), frame_limit);
+        headless_presenter = presenter.get();
+        renderer = std::move(presenter);
+    }
+    else
+        renderer = std::make_unique<mirage::TextureRenderer>(mirage::WindowMode::WINDOWED, res.x(), res.y());
 
     std::vector<mirage::Vector4<uint8_t>> color_buffer;
     color_buffer.resize(res.x() * res.y());
@@ -80,16 +197,130 @@ int main()
         {255, 0, 0}, {0, 255, 0}, {255, 255, 255}
     };
     
-    FormTriangle(color_buffer.data(), res.x(), res.y(), 
-        vertices[0], vertices[1], vertices[2], 
-        colors[0], colors[1], colors[2]
-    );
+    std::unique_ptr<mirage::HardwareCounters> hw_counters;
+    if (print_hw_counters)
+        hw_counters = std::make_unique<mirage::HardwareCounters>();
 
-    renderer.Update(color_buffer.data(), res.x(), res.y());
+    if (show_overdraw)
+        mirage::SetRasterDebugMode(mirage::RasterDebugMode::OVERDRAW);
 
-    while (!renderer.ShouldWinodwClose())
+    // The hardware counters only see the calling thread, so the measured
+    // stages run on it alone.
+    const mirage::Execution execution = hw_counters ? mirage::Execution::SERIAL : mirage::Execution::PARALLEL;
+
+    mirage::Bvh bvh;
+    mirage::Matrix44<float> view_projection;
+    std::unique_ptr<mirage::ProgressiveRenderer> progressive_renderer;
+    if (ray_trace)
     {
-        renderer.Render();
+        // An 8x8 grid of spheres in front of the camera.
+        std::vector<mirage::Triangle> triangles;
+        for (int y = 0; y < 8; ++y)
+        {
+            for (int x = 0; x < 8; ++x)
+                mirage::AppendSphereMesh(&triangles, mirage::Vector3<float>(x - 3.5f, y - 3.5f, 0.f), 0.45f, 90);
+        }
+        bvh.Build(triangles, mirage::Execution::PARALLEL);
+        view_projection =
+            mirage::PerspectiveMatrix(1.5707964f, static_cast<float>(res.x()) / res.y(), 0.5f, 100.f) *
+            mirage::LookAtMatrix(mirage::Vector3<float>(0.f, 0.f, 5.f), mirage::Vector3<float>(0.f), mirage::Vector3<float>(0.f, 1.f, 0.f));
+
+        mirage::HardwareCounterScope scope(hw_counters.get(), mirage::PipelineStage::TRACE);
+        if (progressive)
+        {
+            progressive_renderer = std::make_unique<mirage::ProgressiveRenderer>(
+                res.x(), res.y(), mirage::ProgressiveSettings(), execution);
+            progressive_renderer->RenderFrame(bvh, view_projection);
+            progressive_renderer->Resolve(color_buffer.data());
+        }
+        else
+        {
+            mirage::RayTrace(bvh, view_projection, color_buffer.data(), res.x(), res.y(), execution);
+        }
+    }
+    else
+    {
+        mirage::HardwareCounterScope scope(hw_counters.get(), mirage::PipelineStage::RASTERIZE);
+        FormTriangle(color_buffer.data(), res.x(), res.y(), 
+            vertices[0], vertices[1], vertices[2], 
+            colors[0], colors[1], colors[2]
+        );
+    }
+
+    if (show_overdraw)
+        mirage::ResolveOverdrawHeatmap(color_buffer.data(), res.x(), res.y());
+
+    {
+        mirage::HardwareCounterScope scope(hw_counters.get(), mirage::PipelineStage::UPLOAD);
+        renderer->Update(color_buffer.data(), res.x(), res.y());
+    }
+
+    std::vector<std::unique_ptr<mirage::FrameSink>> sinks;
+    if (capture_prefix)
+    {
+        mirage::FrameCaptureSettings settings;
+        settings.path_prefix = capture_prefix;
+        settings.interval = capture_interval;
+        sinks.push_back(std::make_unique<mirage::FrameCapture>(settings, res.x(), res.y()));
+    }
+    if (stream_path)
+    {
+        sinks.push_back(std::make_unique<mirage::FrameStreamSink>(stream_path, stream_headers));
+    }
+    if (publish_name)
+    {
+        sinks.push_back(std::make_unique<mirage::SharedFrameRingPublisher>(publish_name, res.x(), res.y()));
+    }
+
+    while (!renderer->ShouldWindowClose())
+    {
+        MIRAGE_PROFILE_ZONE("Frame");
+        if (progressive_renderer)
+        {
+            bool refined;
+            {
+                mirage::HardwareCounterScope scope(hw_counters.get(), mirage::PipelineStage::TRACE);
+                refined = progressive_renderer->RenderFrame(bvh, view_projection) != 0;
+                if (refined)
+                    progressive_renderer->Resolve(color_buffer.data());
+            }
+            if (refined)
+            {
+                mirage::HardwareCounterScope scope(hw_counters.get(), mirage::PipelineStage::UPLOAD);
+                renderer->Update(color_buffer.data(), res.x(), res.y());
+            }
+        }
+        renderer->Render();
+        for (auto& sink : sinks)
+        {
+            MIRAGE_PROFILE_ZONE("FrameSink::Consume");
+            sink->Consume(color_buffer.data(), res.x(), res.y());
+        }
+        sinks.erase(std::remove_if(sinks.begin(), sinks.end(),
+            [](const std::unique_ptr<mirage::FrameSink>& pSink) { return !pSink->IsOpen(); }), sinks.end());
+
+        // Without a frame limit, a headless run only exists to feed its
+        // sinks, e.g. --stream into ffmpeg. Stop once their readers are gone,
+        // or after the first frame if there were none.
+        if (headless_presenter && frame_limit == 0 && sinks.empty())
+            headless_presenter->Close();
+
+        // The first frame also includes the rendering before the loop.
+        const mirage::RasterStats raster_stats = mirage::CollectRasterStats();
+        if (print_raster_stats)
+            printf("%s\n", raster_stats.ToString().c_str());
+        if (hw_counters)
+        {
+            hw_counters->EndFrame();
+            printf("%s", hw_counters->Report(res.x() * res.y()).c_str());
+        }
+    }
+
+    if (profile_path)
+    {
+        sinks.clear();
+        mirage::Profiler::SetEnabled(false);
+        mirage::Profiler::WriteChromeTrace(profile_path);
     }
 }
 
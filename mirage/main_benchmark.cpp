@@ -0,0 +1,40 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <vector>
+
+#include "tmp_runtests_macro.hpp"
+
+#ifdef MIRAGE_RUN_BENCHMARKS
+
+// Results are written as JSON to mirage_benchmarks.json so that runs can be
+// compared, e.g. with tools/compare.py from Google Benchmark. Passing
+// --benchmark_out overrides the file.
+int main(int argc, char** argv)
+{
+    std::vector<char*> args(argv, argv + argc);
+    bool has_out = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strncmp(argv[i], "--benchmark_out=", 16) == 0)
+            has_out = true;
+    }
+
+    char out_flag[] = "--benchmark_out=mirage_benchmarks.json";
+    char format_flag[] = "--benchmark_out_format=json";
+    if (!has_out)
+    {
+        args.push_back(out_flag);
+        args.push_back(format_flag);
+    }
+
+    int arg_count = static_cast<int>(args.size());
+    benchmark::Initialize(&arg_count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(arg_count, args.data()))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
+
+#endif
@@ -0,0 +1,169 @@
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace mirage
+{
+
+unsigned GetHardwareThreadCount()
+{
+    // hardware_concurrency() may report 0 when it cannot tell.
+    static const unsigned count = std::max(1u, std::thread::hardware_concurrency());
+    return count;
+}
+
+void ParallelFor(std::size_t pCount, std::size_t pGrain, const std::function<void(std::size_t, std::size_t)>& pBody)
+{
+    if (pCount == 0)
+        return;
+
+    const std::size_t grain = std::max<std::size_t>(pGrain, 1);
+    const std::size_t ranges = std::min<std::size_t>(GetHardwareThreadCount(), (pCount + grain - 1) / grain);
+    if (ranges <= 1)
+    {
+        pBody(0, pCount);
+        return;
+    }
+
+    // Equal ranges, the first pCount % ranges of them one element longer.
+    const std::size_t base = pCount / ranges;
+    const std::size_t extra = pCount % ranges;
+    auto RangeBegin = [&](std::size_t i) { return i * base + std::min(i, extra); };
+
+    std::vector<std::thread> workers;
+    workers.reserve(ranges - 1);
+    for (std::size_t i = 1; i < ranges; ++i)
+    {
+        workers.emplace_back(std::cref(pBody), RangeBegin(i), RangeBegin(i + 1));
+    }
+    pBody(0, RangeBegin(1));
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+struct WorkStealingPool::Queue
+{
+    std::mutex mutex;
+    std::deque<std::size_t> items;
+};
+
+WorkStealingPool::WorkStealingPool(unsigned pThreadCount)
+{
+    const unsigned count = std::max(pThreadCount, 1u);
+    for (unsigned i = 0; i < count; ++i)
+        mQueues.push_back(std::make_unique<Queue>());
+    // Queue 0 belongs to the thread calling Run().
+    for (unsigned i = 1; i < count; ++i)
+        mThreads.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mWake.notify_all();
+    for (std::thread& thread : mThreads)
+        thread.join();
+}
+
+void WorkStealingPool::Run(std::size_t pCount, const std::function<void(std::size_t)>& pBody)
+{
+    if (pCount == 0)
+        return;
+    if (mThreads.empty())
+    {
+        for (std::size_t i = 0; i < pCount; ++i)
+            pBody(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mBody = &pBody;
+        mPending = pCount;
+        const std::size_t queues = mQueues.size();
+        for (std::size_t q = 0; q < queues; ++q)
+        {
+            std::lock_guard<std::mutex> queue_lock(mQueues[q]->mutex);
+            for (std::size_t i = q; i < pCount; i += queues)
+                mQueues[q]->items.push_back(i);
+        }
+        mBatch++;
+    }
+    mWake.notify_all();
+
+    RunItems(0);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDone.wait(lock, [this] { return mPending == 0; });
+    mBody = nullptr;
+}
+
+void WorkStealingPool::WorkerLoop(unsigned pIndex)
+{
+    uint64_t batch = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [&] { return mStop || mBatch != batch; });
+            if (mStop)
+                return;
+            batch = mBatch;
+        }
+        RunItems(pIndex);
+    }
+}
+
+void WorkStealingPool::RunItems(unsigned pIndex)
+{
+    std::size_t item;
+    while (Pop(pIndex, &item))
+    {
+        (*mBody)(item);
+        if (--mPending == 0)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mDone.notify_all();
+        }
+    }
+}
+
+bool WorkStealingPool::Pop(unsigned pIndex, std::size_t* pItem)
+{
+    {
+        Queue& own = *mQueues[pIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.items.empty())
+        {
+            *pItem = own.items.front();
+            own.items.pop_front();
+            return true;
+        }
+    }
+    // Steal the item its owner would run last.
+    const std::size_t queues = mQueues.size();
+    for (std::size_t k = 1; k < queues; ++k)
+    {
+        Queue& victim = *mQueues[(pIndex + k) % queues];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.items.empty())
+        {
+            *pItem = victim.items.back();
+            victim.items.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace mirage
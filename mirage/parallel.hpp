@@ -0,0 +1,76 @@
+#ifndef MIRAGE_PARALLEL_HPP
+#define MIRAGE_PARALLEL_HPP
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mirage
+{
+
+enum class Execution
+{
+    SERIAL = 0,
+    // Splits large inputs across the hardware threads. Small inputs still run
+    // on the calling thread, where spawning threads would cost more than the work.
+    PARALLEL
+};
+
+// Number of threads the hardware runs concurrently, at least 1.
+unsigned GetHardwareThreadCount();
+
+// Splits [0, pCount) into contiguous ranges of at least pGrain elements and
+// calls pBody(begin, end) for each, on up to GetHardwareThreadCount() threads.
+// The calling thread takes the first range. Returns once every range is done.
+void ParallelFor(std::size_t pCount, std::size_t pGrain, const std::function<void(std::size_t, std::size_t)>& pBody);
+
+// Persistent threads for batches of uneven work items, such as image tiles.
+// Run() deals the items round-robin to one queue per thread, in the order
+// given. Each thread takes items from the front of its own queue and, once
+// that is empty, steals from the back of the others. Items given first
+// start first, and no thread idles while another has items waiting.
+class WorkStealingPool
+{
+public:
+    // pThreadCount includes the thread calling Run(). With 1, Run() calls
+    // every item on the calling thread.
+    explicit WorkStealingPool(unsigned pThreadCount = GetHardwareThreadCount());
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned GetThreadCount() const { return static_cast<unsigned>(mQueues.size()); }
+
+    // Calls pBody(i) for every i in [0, pCount) and returns once all calls
+    // are done. Not reentrant: pBody must not call Run().
+    void Run(std::size_t pCount, const std::function<void(std::size_t)>& pBody);
+
+private:
+    struct Queue;
+
+    void WorkerLoop(unsigned pIndex);
+    // Runs items until no queue has any left.
+    void RunItems(unsigned pIndex);
+    bool Pop(unsigned pIndex, std::size_t* pItem);
+
+    std::vector<std::unique_ptr<Queue>> mQueues;
+    std::vector<std::thread> mThreads;
+    const std::function<void(std::size_t)>* mBody = nullptr;
+    std::atomic<std::size_t> mPending{ 0 };
+
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+    uint64_t mBatch = 0;
+    bool mStop = false;
+};
+
+} // namespace mirage
+
+#endif
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "parallel.hpp"
+
+TEST(Parallel, ParallelForCoversEveryIndexOnce)
+{
+    using namespace mirage;
+
+    const std::size_t counts[] = { 0, 1, 7, 1000, 100003 };
+    for (std::size_t count : counts)
+    {
+        std::vector<std::atomic<int>> visits(count);
+        std::atomic<int> ranges(0);
+        ParallelFor(count, 1000, [&](std::size_t pBegin, std::size_t pEnd)
+        {
+            EXPECT_LT(pBegin, pEnd);
+            ranges++;
+            for (std::size_t i = pBegin; i < pEnd; ++i)
+                visits[i]++;
+        });
+
+        for (std::size_t i = 0; i < count; ++i)
+            EXPECT_EQ(visits[i].load(), 1);
+        // Never more ranges than the grain allows.
+        EXPECT_LE(static_cast<std::size_t>(ranges.load()), (count + 999) / 1000);
+    }
+}
+
+TEST(Parallel, WorkStealingPoolRunsEveryItemOnce)
+{
+    using namespace mirage;
+
+    for (unsigned threads : { 1u, 2u, 5u })
+    {
+        WorkStealingPool pool(threads);
+        EXPECT_EQ(pool.GetThreadCount(), threads);
+        // Several batches on the same threads, some with fewer items than
+        // threads, and uneven items that leave queues to steal from.
+        const std::size_t counts[] = { 0, 1, 3, 1000, 17 };
+        for (std::size_t count : counts)
+        {
+            std::vector<std::atomic<int>> visits(count);
+            pool.Run(count, [&](std::size_t pItem)
+            {
+                if (pItem % 7 == 0)
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                visits[pItem]++;
+            });
+            for (std::size_t i = 0; i < count; ++i)
+                EXPECT_EQ(visits[i].load(), 1);
+        }
+    }
+}
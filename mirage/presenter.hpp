@@ -0,0 +1,24 @@
+#ifndef MIRAGE_PRESENTER_HPP
+#define MIRAGE_PRESENTER_HPP
+#include "vecmath.hpp"
+
+namespace mirage
+{
+
+// Receives the rasterized color buffer once per frame. TextureRenderer shows
+// it in a GLFW window, HeadlessPresenter keeps it in memory and does not need
+// a display or a GL context.
+class Presenter
+{
+public:
+
+    virtual ~Presenter() {}
+
+    virtual void Update(const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY) = 0;
+    virtual void Render() = 0;
+    virtual bool ShouldWindowClose() const = 0;
+};
+
+} // namespace mirage
+
+#endif
@@ -0,0 +1,214 @@
+#include "profiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "image_io.hpp"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define MIRAGE_PROFILER_RDTSC
+#endif
+
+namespace mirage
+{
+
+namespace detail
+{
+
+struct ProfilerThreadBuffer
+{
+    std::unique_ptr<ProfileEvent[]> events;
+    // Written only by the owning thread.
+    std::atomic<uint64_t> count;
+    unsigned thread_id;
+    std::string thread_name;
+};
+
+struct ProfilerRegistry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ProfilerThreadBuffer>> buffers;
+    std::atomic<bool> enabled{ false };
+    // Tick and steady_clock values taken together, to convert ticks to time.
+    uint64_t base_ticks = 0;
+    std::chrono::steady_clock::time_point base_time;
+    bool calibrated = false;
+};
+
+// Buffers outlive the threads that filled them, and threads may still record
+// during static destruction, so the registry is never destroyed.
+static ProfilerRegistry& GetProfilerRegistry()
+{
+    static ProfilerRegistry* registry = new ProfilerRegistry();
+    return *registry;
+}
+
+static ProfilerThreadBuffer* GetProfilerThreadBuffer()
+{
+    thread_local ProfilerThreadBuffer* buffer = nullptr;
+    if (!buffer)
+    {
+        ProfilerRegistry& registry = GetProfilerRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        auto new_buffer = std::make_unique<ProfilerThreadBuffer>();
+        new_buffer->events.reset(new ProfileEvent[Profiler::RingSize]);
+        new_buffer->count.store(0, std::memory_order_relaxed);
+        new_buffer->thread_id = static_cast<unsigned>(registry.buffers.size());
+        buffer = new_buffer.get();
+        registry.buffers.push_back(std::move(new_buffer));
+    }
+    return buffer;
+}
+
+static void AppendJsonString(std::string* pOut, const char* pString)
+{
+    pOut->push_back('"');
+    for (const char* c = pString; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+            pOut->push_back('\\');
+        pOut->push_back(*c);
+    }
+    pOut->push_back('"');
+}
+
+} // namespace detail
+
+void Profiler::SetEnabled(bool pEnabled)
+{
+    detail::ProfilerRegistry& registry = detail::GetProfilerRegistry();
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (pEnabled && !registry.calibrated)
+        {
+            registry.base_time = std::chrono::steady_clock::now();
+            registry.base_ticks = Now();
+            registry.calibrated = true;
+        }
+    }
+    registry.enabled.store(pEnabled, std::memory_order_relaxed);
+}
+
+bool Profiler::IsEnabled()
+{
+    return detail::GetProfilerRegistry().enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t Profiler::Now()
+{
+#ifdef MIRAGE_PROFILER_RDTSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void Profiler::Record(const char* pName, uint64_t pBeginTicks, uint64_t pEndTicks)
+{
+    detail::ProfilerThreadBuffer* buffer = detail::GetProfilerThreadBuffer();
+    const uint64_t index = buffer->count.load(std::memory_order_relaxed);
+    ProfileEvent& event = buffer->events[index & (RingSize - 1)];
+    event.name = pName;
+    event.begin_ticks = pBeginTicks;
+    event.end_ticks = pEndTicks;
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::SetThreadName(const char* pName)
+{
+    detail::ProfilerThreadBuffer* buffer = detail::GetProfilerThreadBuffer();
+    std::lock_guard<std::mutex> lock(detail::GetProfilerRegistry().mutex);
+    buffer->thread_name = pName;
+}
+
+void Profiler::ExportChromeTrace(std::string* pOut)
+{
+    detail::ProfilerRegistry& registry = detail::GetProfilerRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    // Ticks per microsecond, measured over the whole profiling session.
+    double ticks_per_us = 1000.0;
+#ifdef MIRAGE_PROFILER_RDTSC
+    if (registry.calibrated)
+    {
+        const double elapsed_us = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - registry.base_time).count();
+        const uint64_t elapsed_ticks = Now() - registry.base_ticks;
+        if (elapsed_us > 0.0 && elapsed_ticks > 0)
+            ticks_per_us = elapsed_ticks / elapsed_us;
+    }
+#endif
+
+    pOut->clear();
+    pOut->append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    bool first = true;
+    char buf[160];
+    for (const auto& buffer : registry.buffers)
+    {
+        if (!buffer->thread_name.empty())
+        {
+            if (!first)
+                pOut->push_back(',');
+            first = false;
+            snprintf(buf, sizeof(buf), "{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":", buffer->thread_id);
+            pOut->append(buf);
+            detail::AppendJsonString(pOut, buffer->thread_name.c_str());
+            pOut->append("}}");
+        }
+
+        const uint64_t count = buffer->count.load(std::memory_order_acquire);
+        const uint64_t oldest = count > RingSize ? count - RingSize : 0;
+        for (uint64_t i = oldest; i < count; ++i)
+        {
+            const ProfileEvent& event = buffer->events[i & (RingSize - 1)];
+            const double ts = static_cast<double>(static_cast<int64_t>(event.begin_ticks - registry.base_ticks)) / ticks_per_us;
+            const double dur = static_cast<double>(event.end_ticks - event.begin_ticks) / ticks_per_us;
+
+            if (!first)
+                pOut->push_back(',');
+            first = false;
+            pOut->append("{\"ph\":\"X\",\"cat\":\"mirage\",\"name\":");
+            detail::AppendJsonString(pOut, event.name);
+            snprintf(buf, sizeof(buf), ",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", buffer->thread_id, ts, dur);
+            pOut->append(buf);
+        }
+    }
+    pOut->append("]}\n");
+}
+
+bool Profiler::WriteChromeTrace(const std::string& pPath)
+{
+    std::string trace;
+    ExportChromeTrace(&trace);
+    return WriteBytesToFile(pPath, reinterpret_cast<const uint8_t*>(trace.data()), trace.size());
+}
+
+uint64_t Profiler::GetRecordedEventCount()
+{
+    detail::ProfilerRegistry& registry = detail::GetProfilerRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    uint64_t count = 0;
+    for (const auto& buffer : registry.buffers)
+        count += buffer->count.load(std::memory_order_acquire);
+    return count;
+}
+
+void Profiler::Reset()
+{
+    detail::ProfilerRegistry& registry = detail::GetProfilerRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto& buffer : registry.buffers)
+        buffer->count.store(0, std::memory_order_relaxed);
+}
+
+} // namespace mirage
@@ -0,0 +1,86 @@
+#ifndef MIRAGE_PROFILER_HPP
+#define MIRAGE_PROFILER_HPP
+#include <cstdint>
+#include <string>
+
+namespace mirage
+{
+
+struct ProfileEvent
+{
+    // Zone names are not copied and must outlive the profiler, e.g. string literals.
+    const char* name;
+    uint64_t begin_ticks;
+    uint64_t end_ticks;
+};
+
+// Collects timed zones from every thread. Each thread records into its own
+// fixed-size ring, so recording never takes a lock and the oldest events are
+// overwritten once a ring is full. Recording is off until SetEnabled(true).
+class Profiler
+{
+public:
+
+    // Events recorded per thread before the ring wraps.
+    static constexpr unsigned RingSize = 1u << 16;
+
+    static void SetEnabled(bool pEnabled);
+    static bool IsEnabled();
+
+    // Timestamp counter (rdtsc where available, steady_clock otherwise).
+    static uint64_t Now();
+
+    static void Record(const char* pName, uint64_t pBeginTicks, uint64_t pEndTicks);
+
+    // Name shown for the calling thread in the trace viewer.
+    static void SetThreadName(const char* pName);
+
+    // Serializes all recorded events in the Chrome trace_event JSON format,
+    // viewable in chrome://tracing or ui.perfetto.dev. Call while the
+    // instrumented threads are idle, e.g. between frames.
+    static void ExportChromeTrace(std::string* pOut);
+    static bool WriteChromeTrace(const std::string& pPath);
+
+    // Total number of events recorded since the last Reset(), including
+    // events that were overwritten.
+    static uint64_t GetRecordedEventCount();
+
+    // Drops all recorded events. Same restrictions as ExportChromeTrace().
+    static void Reset();
+};
+
+// Records the lifetime of the enclosing scope.
+class ProfileZone
+{
+public:
+
+    explicit ProfileZone(const char* pName)
+        : mName(Profiler::IsEnabled() ? pName : nullptr)
+        , mBeginTicks(mName ? Profiler::Now() : 0)
+    {}
+
+    ~ProfileZone()
+    {
+        if (mName)
+            Profiler::Record(mName, mBeginTicks, Profiler::Now());
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+
+    const char* mName;
+    uint64_t mBeginTicks;
+};
+
+} // namespace mirage
+
+#define MIRAGE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define MIRAGE_PROFILE_CONCAT(a, b) MIRAGE_PROFILE_CONCAT_IMPL(a, b)
+
+// MIRAGE_PROFILE_ZONE("Name") times the rest of the enclosing scope.
+#define MIRAGE_PROFILE_ZONE(name) \
+    ::mirage::ProfileZone MIRAGE_PROFILE_CONCAT(mirage_profile_zone_, __LINE__)(name)
+
+#endif
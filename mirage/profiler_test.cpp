@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+#include "profiler.hpp"
+
+static unsigned CountOccurrences(const std::string& pText, const std::string& pPattern)
+{
+    unsigned count = 0;
+    for (std::size_t pos = pText.find(pPattern); pos != std::string::npos; pos = pText.find(pPattern, pos + 1))
+        count++;
+    return count;
+}
+
+TEST(Profiler, ChromeTraceExport)
+{
+    using namespace mirage;
+
+    Profiler::Reset();
+    {
+        MIRAGE_PROFILE_ZONE("Disabled");
+    }
+    EXPECT_EQ(Profiler::GetRecordedEventCount(), 0u);
+
+    Profiler::SetEnabled(true);
+    {
+        MIRAGE_PROFILE_ZONE("Outer");
+        MIRAGE_PROFILE_ZONE("Inner");
+    }
+    std::thread worker([]() {
+        Profiler::SetThreadName("Worker");
+        MIRAGE_PROFILE_ZONE("WorkerZone");
+    });
+    worker.join();
+    Profiler::SetEnabled(false);
+
+    EXPECT_EQ(Profiler::GetRecordedEventCount(), 3u);
+
+    std::string trace;
+    Profiler::ExportChromeTrace(&trace);
+    EXPECT_EQ(trace.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["), 0u);
+    EXPECT_EQ(CountOccurrences(trace, "\"ph\":\"X\""), 3u);
+    EXPECT_EQ(CountOccurrences(trace, "\"name\":\"Outer\""), 1u);
+    EXPECT_EQ(CountOccurrences(trace, "\"name\":\"Inner\""), 1u);
+    EXPECT_EQ(CountOccurrences(trace, "\"name\":\"WorkerZone\""), 1u);
+    EXPECT_EQ(CountOccurrences(trace, "\"args\":{\"name\":\"Worker\"}"), 1u);
+    EXPECT_NE(trace.find("]}"), std::string::npos);
+
+    Profiler::Reset();
+    EXPECT_EQ(Profiler::GetRecordedEventCount(), 0u);
+}
+
+TEST(Profiler, RingOverwritesOldestEvents)
+{
+    using namespace mirage;
+
+    Profiler::Reset();
+    for (unsigned i = 0; i < Profiler::RingSize + 10; ++i)
+        Profiler::Record("Event", i, i + 1);
+
+    std::string trace;
+    Profiler::ExportChromeTrace(&trace);
+    EXPECT_EQ(CountOccurrences(trace, "\"ph\":\"X\""), Profiler::RingSize);
+    Profiler::Reset();
+}
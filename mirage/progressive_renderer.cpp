@@ -0,0 +1,217 @@
+#include "progressive_renderer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "check.hpp"
+#include "profiler.hpp"
+#include "ray_tracer.hpp"
+
+namespace mirage
+{
+
+namespace detail
+{
+
+// Integer hash with good avalanche (lowbias32 by Chris Wellons).
+inline uint32_t HashUint32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Random numbers of one sample of one pixel. They depend on nothing else,
+// so the image does not depend on which thread renders which tile.
+class SampleRandom
+{
+public:
+    SampleRandom(uint32_t pX, uint32_t pY, uint32_t pSample)
+        : mState(HashUint32(pX ^ HashUint32(pY ^ HashUint32(pSample))))
+    {}
+
+    // Uniform in [0, 1).
+    float Next()
+    {
+        mState = HashUint32(mState + 0x9e3779b9u);
+        return (mState >> 8) * (1.f / 16777216.f);
+    }
+
+private:
+    uint32_t mState;
+};
+
+// Direction in the hemisphere around the unit vector pNormal, with density
+// proportional to the cosine to pNormal. The tangent frame is the one of
+// Duff et al., "Building an Orthonormal Basis, Revisited".
+inline Vector3<float> SampleCosineHemisphere(const Vector3<float>& pNormal, float pU1, float pU2)
+{
+    const float sign = pNormal.z >= 0.f ? 1.f : -1.f;
+    const float a = -1.f / (sign + pNormal.z);
+    const float b = pNormal.x * pNormal.y * a;
+    const Vector3<float> tangent(1.f + sign * pNormal.x * pNormal.x * a, sign * b, -sign * pNormal.x);
+    const Vector3<float> bitangent(b, sign + pNormal.y * pNormal.y * a, -pNormal.y);
+
+    constexpr float two_pi = 6.28318530718f;
+    const float r = std::sqrt(pU1);
+    const float phi = two_pi * pU2;
+    return tangent * (r * std::cos(phi)) + bitangent * (r * std::sin(phi)) + pNormal * std::sqrt(std::max(0.f, 1.f - pU1));
+}
+
+inline float Luminance(const Vector4<float>& pColor)
+{
+    return 0.2126f * pColor.x + 0.7152f * pColor.y + 0.0722f * pColor.z;
+}
+
+} // namespace detail
+
+ProgressiveRenderer::ProgressiveRenderer(unsigned pResolutionX, unsigned pResolutionY, const ProgressiveSettings& pSettings,
+    Execution pExecution)
+    : mResolutionX(pResolutionX)
+    , mResolutionY(pResolutionY)
+    , mTileCountX((pResolutionX + TileSize - 1) / TileSize)
+    , mTileCountY((pResolutionY + TileSize - 1) / TileSize)
+    , mSettings(pSettings)
+    , mPool(pExecution == Execution::PARALLEL ? GetHardwareThreadCount() : 1)
+{
+    mSum.resize(static_cast<std::size_t>(mResolutionX) * mResolutionY);
+    mLuminanceSquares.resize(mSum.size());
+    mTileSamples.resize(static_cast<std::size_t>(mTileCountX) * mTileCountY);
+    mTileError.resize(mTileSamples.size());
+    mSchedule.reserve(mTileSamples.size());
+    Reset();
+}
+
+void ProgressiveRenderer::Reset()
+{
+    std::fill(mSum.begin(), mSum.end(), Vector4<float>(0.f));
+    std::fill(mLuminanceSquares.begin(), mLuminanceSquares.end(), 0.f);
+    std::fill(mTileSamples.begin(), mTileSamples.end(), 0u);
+    std::fill(mTileError.begin(), mTileError.end(), 0.f);
+}
+
+std::size_t ProgressiveRenderer::RenderFrame(const Bvh& pBvh, const Matrix44<float>& pViewProjection)
+{
+    MIRAGE_PROFILE_ZONE("ProgressiveRenderer::RenderFrame");
+    mSchedule.clear();
+    for (uint32_t tile = 0; tile < mTileSamples.size(); ++tile)
+    {
+        const uint32_t samples = mTileSamples[tile];
+        if (samples < mSettings.max_samples && (samples < MinSamples || mTileError[tile] >= mSettings.converged_error))
+            mSchedule.push_back(tile);
+    }
+
+    // Tiles without a trusted error first, fewest samples first, then the
+    // largest error first.
+    const auto before = [this](uint32_t a, uint32_t b)
+    {
+        const uint32_t samples_a = mTileSamples[a];
+        const uint32_t samples_b = mTileSamples[b];
+        if (samples_a < MinSamples || samples_b < MinSamples)
+            return samples_a != samples_b ? samples_a < samples_b : a < b;
+        return mTileError[a] != mTileError[b] ? mTileError[a] > mTileError[b] : a < b;
+    };
+    const std::size_t count = std::min<std::size_t>(mSettings.tiles_per_frame, mSchedule.size());
+    std::partial_sort(mSchedule.begin(), mSchedule.begin() + count, mSchedule.end(), before);
+
+    // The pool starts the tiles in this order, so the most important ones
+    // are done first even when a frame has more tiles than threads.
+    const Matrix44<float> inverse = InverseMatrix(pViewProjection);
+    mPool.Run(count, [&](std::size_t pIndex)
+    {
+        RenderTile(pBvh, inverse, mSchedule[pIndex]);
+    });
+    return count;
+}
+
+void ProgressiveRenderer::RenderTile(const Bvh& pBvh, const Matrix44<float>& pInverseViewProjection, uint32_t pTile)
+{
+    const unsigned x_begin = (pTile % mTileCountX) * TileSize;
+    const unsigned y_begin = (pTile / mTileCountX) * TileSize;
+    const unsigned x_end = std::min(x_begin + TileSize, mResolutionX);
+    const unsigned y_end = std::min(y_begin + TileSize, mResolutionY);
+    const uint32_t sample = mTileSamples[pTile];
+    const float samples = static_cast<float>(sample + 1);
+    const float dx = 2.f / mResolutionX;
+    const float dy = 2.f / mResolutionY;
+
+    float error = 0.f;
+    for (unsigned y = y_begin; y < y_end; ++y)
+    {
+        for (unsigned x = x_begin; x < x_end; ++x)
+        {
+            detail::SampleRandom random(x, y, sample);
+            const float ndc_x = (x + random.Next()) * dx - 1.f;
+            const float ndc_y = (y + random.Next()) * dy - 1.f;
+            const Ray ray = GenerateCameraRay(pInverseViewProjection, ndc_x, ndc_y);
+
+            Vector4<float> color(0.f);
+            RayHit hit;
+            if (pBvh.Intersect(ray, &hit))
+            {
+                // Two-sided, with the normal towards the camera.
+                const Triangle& triangle = pBvh.GetTriangles()[hit.triangle];
+                Vector3<float> normal = Normalize(Cross(triangle.v1 - triangle.v0, triangle.v2 - triangle.v0));
+                float facing = Dot(normal, ray.direction);
+                if (facing > 0.f)
+                    normal = normal * -1.f;
+                facing = Abs(facing);
+
+                // Offset the occlusion ray so that it does not hit its own
+                // triangle, by a margin that grows with the coordinates.
+                const Vector3<float> point = ray.origin + ray.direction * hit.t;
+                const float margin = 1e-4f * (1.f + std::max(std::max(Abs(point.x), Abs(point.y)), Abs(point.z)));
+                Ray occlusion_ray;
+                occlusion_ray.origin = point + normal * margin;
+                const float u1 = random.Next();
+                const float u2 = random.Next();
+                occlusion_ray.direction = detail::SampleCosineHemisphere(normal, u1, u2);
+                RayHit occluder;
+                occluder.t = mSettings.occlusion_radius;
+                const float shade = pBvh.Intersect(occlusion_ray, &occluder) ? 0.f : 0.15f + 0.85f * facing;
+                color = Vector4<float>(shade, shade, shade, 1.f);
+            }
+
+            const std::size_t pixel = static_cast<std::size_t>(y) * mResolutionX + x;
+            const float luminance = detail::Luminance(color);
+            mSum[pixel] += color;
+            mLuminanceSquares[pixel] += luminance * luminance;
+
+            const float mean = detail::Luminance(mSum[pixel]) / samples;
+            const float variance = std::max(0.f, mLuminanceSquares[pixel] / samples - mean * mean);
+            error += std::sqrt(variance / samples);
+        }
+    }
+
+    mTileSamples[pTile] = sample + 1;
+    mTileError[pTile] = error / ((x_end - x_begin) * (y_end - y_begin));
+}
+
+void ProgressiveRenderer::Resolve(Vector4<uint8_t>* pColorBuffer) const
+{
+    MIRAGE_PROFILE_ZONE("ProgressiveRenderer::Resolve");
+    const auto to_byte = [](float v)
+    {
+        return static_cast<uint8_t>(std::min(std::max(v, 0.f), 1.f) * 255.f + 0.5f);
+    };
+    for (unsigned y = 0; y < mResolutionY; ++y)
+    {
+        for (unsigned x = 0; x < mResolutionX; ++x)
+        {
+            const std::size_t pixel = static_cast<std::size_t>(y) * mResolutionX + x;
+            const uint32_t samples = mTileSamples[(y / TileSize) * mTileCountX + x / TileSize];
+            if (samples == 0)
+            {
+                pColorBuffer[pixel] = Vector4<uint8_t>(0, 0, 0, 0);
+                continue;
+            }
+            const Vector4<float> mean = mSum[pixel] * (1.f / samples);
+            pColorBuffer[pixel] = Vector4<uint8_t>(to_byte(mean.x), to_byte(mean.y), to_byte(mean.z), to_byte(mean.w));
+        }
+    }
+}
+
+} // namespace mirage
@@ -0,0 +1,86 @@
+#ifndef MIRAGE_PROGRESSIVE_RENDERER_HPP
+#define MIRAGE_PROGRESSIVE_RENDERER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bvh.hpp"
+#include "parallel.hpp"
+#include "vecmath.hpp"
+
+namespace mirage
+{
+
+struct ProgressiveSettings
+{
+    // Tiles rendered per RenderFrame(), one sample per pixel each. Bounds
+    // the work of a frame.
+    unsigned tiles_per_frame = 64;
+    // Samples per pixel after which a tile is not rendered again.
+    unsigned max_samples = 1024;
+    // A tile is also done once the standard error of its mean luminance
+    // falls below this, half a step of 8-bit output by default.
+    float converged_error = 0.5f / 255.f;
+    // Geometry closer than this occludes the ambient light of a point.
+    float occlusion_radius = 1.f;
+};
+
+// Renders a Bvh over many frames: every frame adds one sample per pixel to
+// a bounded number of tiles, accumulated in a float buffer, and Resolve()
+// turns the running mean into 8-bit pixels. Samples jitter the pixel
+// position and cast one ambient occlusion ray, so the image converges to
+// an antialiased, ambient-occluded rendering. Tiles are rendered on a
+// WorkStealingPool, those with the largest remaining error first.
+class ProgressiveRenderer
+{
+public:
+    static constexpr unsigned TileSize = 16;
+    // Tiles are rendered this many times before their error is trusted.
+    static constexpr unsigned MinSamples = 4;
+
+    ProgressiveRenderer(unsigned pResolutionX, unsigned pResolutionY, const ProgressiveSettings& pSettings = ProgressiveSettings(),
+        Execution pExecution = Execution::PARALLEL);
+
+    // Discards the accumulated samples. Call after the scene or the camera
+    // changed.
+    void Reset();
+
+    // Adds a sample to the pixels of up to tiles_per_frame tiles. Returns the
+    // number of tiles rendered, 0 once the whole image converged.
+    std::size_t RenderFrame(const Bvh& pBvh, const Matrix44<float>& pViewProjection);
+
+    // Writes the mean of the samples of each pixel, clamped to [0, 1], as
+    // 8-bit color. Pixels without samples are transparent black. Pixels map
+    // to device coordinates as in RayTrace().
+    void Resolve(Vector4<uint8_t>* pColorBuffer) const;
+
+    unsigned GetTileCountX() const { return mTileCountX; }
+    unsigned GetTileCountY() const { return mTileCountY; }
+    unsigned GetTileSamples(unsigned pTileX, unsigned pTileY) const { return mTileSamples[pTileY * mTileCountX + pTileX]; }
+    // Standard error of the mean luminance of the tile, averaged over its
+    // pixels.
+    float GetTileError(unsigned pTileX, unsigned pTileY) const { return mTileError[pTileY * mTileCountX + pTileX]; }
+
+private:
+    void RenderTile(const Bvh& pBvh, const Matrix44<float>& pInverseViewProjection, uint32_t pTile);
+
+    unsigned mResolutionX;
+    unsigned mResolutionY;
+    unsigned mTileCountX;
+    unsigned mTileCountY;
+    ProgressiveSettings mSettings;
+    WorkStealingPool mPool;
+
+    // Per pixel: the sums of the samples, rgb and coverage, and of their
+    // squared luminance.
+    std::vector<Vector4<float>> mSum;
+    std::vector<float> mLuminanceSquares;
+    // Per tile: every pixel of a tile has the same number of samples.
+    std::vector<uint32_t> mTileSamples;
+    std::vector<float> mTileError;
+    std::vector<uint32_t> mSchedule;
+};
+
+} // namespace mirage
+
+#endif
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "progressive_renderer.hpp"
+#include "ray_tracer.hpp"
+
+// A unit sphere resting on a floor, seen from 5 units away: the floor
+// near the sphere is partly occluded and needs many samples, the sky above
+// needs none.
+static mirage::Bvh MakeScene()
+{
+    using namespace mirage;
+    std::vector<Triangle> triangles;
+    AppendSphereMesh(&triangles, Vector3<float>(0.f), 1.f, 24);
+    const Vector3<float> a(-10.f, -1.f, -10.f), b(10.f, -1.f, -10.f), c(10.f, -1.f, 10.f), d(-10.f, -1.f, 10.f);
+    triangles.push_back(Triangle{ a, b, c });
+    triangles.push_back(Triangle{ a, c, d });
+    return Bvh(triangles);
+}
+
+static mirage::Matrix44<float> MakeViewProjection()
+{
+    using namespace mirage;
+    const Matrix44<float> projection = PerspectiveMatrix(1.5707964f, 1.f, 0.5f, 100.f);
+    const Matrix44<float> view = LookAtMatrix(Vector3<float>(0.f, 0.f, 5.f), Vector3<float>(0.f), Vector3<float>(0.f, 1.f, 0.f));
+    return projection * view;
+}
+
+TEST(ProgressiveRenderer, SerialMatchesParallel)
+{
+    using namespace mirage;
+
+    const Bvh bvh = MakeScene();
+    ProgressiveSettings settings;
+    settings.tiles_per_frame = 7;
+    const unsigned res_x = 70, res_y = 50;
+    ProgressiveRenderer serial(res_x, res_y, settings, Execution::SERIAL);
+    ProgressiveRenderer parallel(res_x, res_y, settings, Execution::PARALLEL);
+    EXPECT_EQ(serial.GetTileCountX(), 5u);
+    EXPECT_EQ(serial.GetTileCountY(), 4u);
+
+    for (int frame = 0; frame < 12; ++frame)
+    {
+        EXPECT_EQ(serial.RenderFrame(bvh, MakeViewProjection()), 7u);
+        EXPECT_EQ(parallel.RenderFrame(bvh, MakeViewProjection()), 7u);
+    }
+    std::vector<Vector4<uint8_t>> expected(res_x * res_y), actual(res_x * res_y);
+    serial.Resolve(expected.data());
+    parallel.Resolve(actual.data());
+    EXPECT_EQ(expected, actual);
+}
+
+TEST(ProgressiveRenderer, ConvergesWhereTheImageIsNoisy)
+{
+    using namespace mirage;
+
+    const Bvh bvh = MakeScene();
+    ProgressiveSettings settings;
+    settings.max_samples = 64;
+    const unsigned res = 64;
+    ProgressiveRenderer renderer(res, res, settings);
+
+    std::vector<Vector4<uint8_t>> color_buffer(res * res, Vector4<uint8_t>(1, 2, 3, 4));
+    renderer.Resolve(color_buffer.data());
+    EXPECT_EQ(color_buffer[res / 2 * res + res / 2], Vector4<uint8_t>(0, 0, 0, 0));
+
+    int frames = 0;
+    while (renderer.RenderFrame(bvh, MakeViewProjection()) != 0)
+        ASSERT_LT(++frames, 1000);
+
+    for (unsigned ty = 0; ty < renderer.GetTileCountY(); ++ty)
+    {
+        for (unsigned tx = 0; tx < renderer.GetTileCountX(); ++tx)
+        {
+            const unsigned samples = renderer.GetTileSamples(tx, ty);
+            EXPECT_GE(samples, ProgressiveRenderer::MinSamples);
+            EXPECT_LE(samples, settings.max_samples);
+            if (samples < settings.max_samples)
+            {
+                EXPECT_LT(renderer.GetTileError(tx, ty), settings.converged_error);
+            }
+        }
+    }
+    // Empty sky is done after the minimum, the edge of the sphere and its
+    // contact shadow are not.
+    EXPECT_EQ(renderer.GetTileSamples(0, 3), ProgressiveRenderer::MinSamples);
+    EXPECT_GT(renderer.GetTileSamples(1, 1), ProgressiveRenderer::MinSamples);
+
+    renderer.Resolve(color_buffer.data());
+    EXPECT_EQ(color_buffer[res * res - 1], Vector4<uint8_t>(0, 0, 0, 0));
+    const Vector4<uint8_t> center = color_buffer[res / 2 * res + res / 2];
+    EXPECT_EQ(center.w, 255);
+    EXPECT_GT(center.x, 240);
+
+    renderer.Reset();
+    EXPECT_EQ(renderer.GetTileSamples(1, 1), 0u);
+}
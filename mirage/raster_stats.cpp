@@ -0,0 +1,154 @@
+#include "raster_stats.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "stringprintf.hpp"
+
+namespace mirage
+{
+
+namespace detail
+{
+
+struct RasterStatsRegistry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<RasterStats>> threads;
+    std::atomic<RasterDebugMode> debug_mode{ RasterDebugMode::NONE };
+};
+
+// Never destroyed, threads may outlive static destruction.
+static RasterStatsRegistry& GetRasterStatsRegistry()
+{
+    static RasterStatsRegistry* registry = new RasterStatsRegistry();
+    return *registry;
+}
+
+} // namespace detail
+
+const char* CullReasonName(CullReason pReason)
+{
+    switch (pReason)
+    {
+    case CullReason::OFFSCREEN: return "offscreen";
+    default: return "unknown";
+    }
+}
+
+RasterStats::RasterStats()
+    : triangles_submitted(0)
+    , triangles_culled{}
+    , triangles_rasterized(0)
+    , triangles_degenerate(0)
+    , lines_drawn(0)
+    , pixels_tested(0)
+    , pixels_written(0)
+{}
+
+void RasterStats::Merge(const RasterStats& pOther)
+{
+    triangles_submitted += pOther.triangles_submitted;
+    for (int i = 0; i < static_cast<int>(CullReason::COUNT); ++i)
+        triangles_culled[i] += pOther.triangles_culled[i];
+    triangles_rasterized += pOther.triangles_rasterized;
+    triangles_degenerate += pOther.triangles_degenerate;
+    lines_drawn += pOther.lines_drawn;
+    pixels_tested += pOther.pixels_tested;
+    pixels_written += pOther.pixels_written;
+}
+
+uint64_t RasterStats::GetTrianglesCulled() const
+{
+    uint64_t culled = 0;
+    for (int i = 0; i < static_cast<int>(CullReason::COUNT); ++i)
+        culled += triangles_culled[i];
+    return culled;
+}
+
+std::string RasterStats::ToString() const
+{
+    std::string culled;
+    for (int i = 0; i < static_cast<int>(CullReason::COUNT); ++i)
+    {
+        culled += StringPrintf(MIRAGE_FMT(" %s=%llu"), CullReasonName(static_cast<CullReason>(i)), triangles_culled[i]);
+    }
+    return StringPrintf(MIRAGE_FMT("triangles: submitted=%llu rasterized=%llu degenerate=%llu culled=%llu (%s ), lines=%llu, pixels: tested=%llu written=%llu"),
+        triangles_submitted, triangles_rasterized, triangles_degenerate, GetTrianglesCulled(), culled.c_str(),
+        lines_drawn, pixels_tested, pixels_written);
+}
+
+RasterStats& GetThreadRasterStats()
+{
+    thread_local RasterStats* stats = nullptr;
+    if (!stats)
+    {
+        detail::RasterStatsRegistry& registry = detail::GetRasterStatsRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.threads.push_back(std::make_unique<RasterStats>());
+        stats = registry.threads.back().get();
+    }
+    return *stats;
+}
+
+RasterStats CollectRasterStats()
+{
+    detail::RasterStatsRegistry& registry = detail::GetRasterStatsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    RasterStats total;
+    for (const auto& stats : registry.threads)
+    {
+        total.Merge(*stats);
+        *stats = RasterStats();
+    }
+    return total;
+}
+
+void SetRasterDebugMode(RasterDebugMode pMode)
+{
+    detail::GetRasterStatsRegistry().debug_mode.store(pMode, std::memory_order_relaxed);
+}
+
+RasterDebugMode GetRasterDebugMode()
+{
+    return detail::GetRasterStatsRegistry().debug_mode.load(std::memory_order_relaxed);
+}
+
+void ResolveOverdrawHeatmap(Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY, unsigned pMaxOverdraw)
+{
+    const Vector3<float> stops[] =
+    {
+        { 0.f, 0.f, 255.f }, { 0.f, 255.f, 0.f }, { 255.f, 255.f, 0.f }, { 255.f, 0.f, 0.f }
+    };
+    constexpr int Segments = 3;
+
+    // One color per overdraw level, index 0 stays black.
+    const unsigned levels = pMaxOverdraw < 1 ? 1 : pMaxOverdraw;
+    std::vector<Vector4<uint8_t>> palette(levels + 1);
+    palette[0] = Vector4<uint8_t>(0, 0, 0, 255);
+    for (unsigned i = 1; i <= levels; ++i)
+    {
+        const float t = levels == 1 ? 1.f : static_cast<float>(i - 1) / (levels - 1);
+        const int segment = std::min(static_cast<int>(t * Segments), Segments - 1);
+        const float a = t * Segments - segment;
+        const Vector3<float>& c0 = stops[segment];
+        const Vector3<float>& c1 = stops[segment + 1];
+        palette[i] = Vector4<uint8_t>(
+            static_cast<uint8_t>(Lerp(c0.x, c1.x, a)),
+            static_cast<uint8_t>(Lerp(c0.y, c1.y, a)),
+            static_cast<uint8_t>(Lerp(c0.z, c1.z, a)),
+            255);
+    }
+
+    const std::size_t n = static_cast<std::size_t>(pDimensionX) * pDimensionY;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const unsigned count = pColorBuffer[i].x;
+        pColorBuffer[i] = palette[count < levels ? count : levels];
+    }
+}
+
+} // namespace mirage
@@ -0,0 +1,67 @@
+#ifndef MIRAGE_RASTER_STATS_HPP
+#define MIRAGE_RASTER_STATS_HPP
+#include <cstdint>
+#include <string>
+
+#include "vecmath.hpp"
+
+namespace mirage
+{
+
+enum class CullReason
+{
+    OFFSCREEN = 0,  // All vertices outside the same edge of the viewport.
+    COUNT
+};
+
+const char* CullReasonName(CullReason pReason);
+
+// Rasterizer work done in a frame.
+struct RasterStats
+{
+    RasterStats();
+
+    void Merge(const RasterStats& pOther);
+    std::string ToString() const;
+
+    uint64_t GetTrianglesCulled() const;
+
+    uint64_t triangles_submitted;
+    uint64_t triangles_culled[static_cast<int>(CullReason::COUNT)];
+    uint64_t triangles_rasterized;
+    // Rasterized triangles of zero area. They are still drawn, as lines.
+    uint64_t triangles_degenerate;
+    uint64_t lines_drawn;
+    // Pixels the rasterizer stepped over, and the ones that passed the
+    // viewport test and were written.
+    uint64_t pixels_tested;
+    uint64_t pixels_written;
+};
+
+// Counters of the calling thread. The rasterizer adds to these without
+// synchronization.
+RasterStats& GetThreadRasterStats();
+
+// Sums the counters of all threads and clears them. Call at frame end, while
+// no thread is rasterizing.
+RasterStats CollectRasterStats();
+
+enum class RasterDebugMode
+{
+    NONE = 0,
+    // Each written pixel increments a counter in its red channel instead of
+    // receiving a color. ResolveOverdrawHeatmap() turns the counters into colors.
+    OVERDRAW
+};
+
+void SetRasterDebugMode(RasterDebugMode pMode);
+RasterDebugMode GetRasterDebugMode();
+
+// Replaces the overdraw counters of a frame rendered in OVERDRAW mode with a
+// heatmap: black where nothing was drawn, then blue, green, yellow and red up
+// to pMaxOverdraw writes per pixel.
+void ResolveOverdrawHeatmap(Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY, unsigned pMaxOverdraw = 4);
+
+} // namespace mirage
+
+#endif
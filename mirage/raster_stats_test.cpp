@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "raster_stats.hpp"
+#include "triangle_p0.hpp"
+
+TEST(RasterStats, CountsAndCulling)
+{
+    using namespace mirage;
+
+    constexpr unsigned Res = 64;
+    std::vector<Vector4<uint8_t>> buffer(Res * Res, Vector4<uint8_t>(0, 0, 0, 0));
+    const Vector3<uint8_t> c(255, 255, 255);
+
+    CollectRasterStats();
+    FormTriangle(buffer.data(), Res, Res, Point2<float>(-0.5f, -0.5f), Point2<float>(0.5f, -0.5f), Point2<float>(0.f, 0.5f), c, c, c);
+    // Entirely right of the viewport.
+    FormTriangle(buffer.data(), Res, Res, Point2<float>(1.5f, -0.5f), Point2<float>(2.5f, -0.5f), Point2<float>(2.f, 0.5f), c, c, c);
+    // Collinear vertices, counted but still drawn.
+    FormTriangle(buffer.data(), Res, Res, Point2<float>(-0.5f, 0.f), Point2<float>(0.f, 0.f), Point2<float>(0.5f, 0.f), c, c, c);
+    // Partially visible, pixels past the right edge are tested but not written.
+    FormTriangle(buffer.data(), Res, Res, Point2<float>(0.5f, -0.5f), Point2<float>(1.5f, -0.5f), Point2<float>(1.f, 0.5f), c, c, c);
+
+    RasterStats stats = CollectRasterStats();
+    EXPECT_EQ(stats.triangles_submitted, 4u);
+    EXPECT_EQ(stats.triangles_culled[static_cast<int>(CullReason::OFFSCREEN)], 1u);
+    EXPECT_EQ(stats.GetTrianglesCulled(), 1u);
+    EXPECT_EQ(stats.triangles_rasterized, 3u);
+    EXPECT_EQ(stats.triangles_degenerate, 1u);
+    EXPECT_EQ(stats.lines_drawn, 9u);
+    EXPECT_GT(stats.pixels_written, 0u);
+    EXPECT_LT(stats.pixels_written, stats.pixels_tested);
+
+    // Collecting clears the counters.
+    stats = CollectRasterStats();
+    EXPECT_EQ(stats.triangles_submitted, 0u);
+    EXPECT_EQ(stats.pixels_tested, 0u);
+}
+
+TEST(RasterStats, DegenerateTrianglesAreDrawn)
+{
+    using namespace mirage;
+
+    constexpr unsigned Res = 64;
+    std::vector<Vector4<uint8_t>> buffer(Res * Res, Vector4<uint8_t>(0, 0, 0, 0));
+    const Vector3<uint8_t> c(255, 255, 255);
+
+    CollectRasterStats();
+    FormTriangle(buffer.data(), Res, Res, Point2<float>(-0.5f, 0.f), Point2<float>(0.f, 0.f), Point2<float>(0.5f, 0.f), c, c, c);
+    const RasterStats stats = CollectRasterStats();
+    EXPECT_EQ(stats.triangles_degenerate, 1u);
+    EXPECT_GT(stats.pixels_written, 0u);
+
+    unsigned lit = 0;
+    for (const auto& pixel : buffer)
+        lit += pixel.x != 0;
+    EXPECT_GE(lit, Res / 2);
+}
+
+TEST(RasterStats, OverdrawHeatmap)
+{
+    using namespace mirage;
+
+    constexpr unsigned Res = 64;
+    std::vector<Vector4<uint8_t>> buffer(Res * Res, Vector4<uint8_t>(0, 0, 0, 0));
+    const Vector3<uint8_t> c(255, 255, 255);
+
+    SetRasterDebugMode(RasterDebugMode::OVERDRAW);
+    for (int i = 0; i < 3; ++i)
+        FormTriangle(buffer.data(), Res, Res, Point2<float>(-0.5f, -0.5f), Point2<float>(0.5f, -0.5f), Point2<float>(0.f, 0.5f), c, c, c);
+    SetRasterDebugMode(RasterDebugMode::NONE);
+    RasterStats stats = CollectRasterStats();
+
+    uint64_t covered = 0;
+    uint64_t total = 0;
+    for (const auto& pixel : buffer)
+    {
+        covered += pixel.x != 0;
+        total += pixel.x;
+        EXPECT_LE(pixel.x, 6);
+    }
+    EXPECT_EQ(total, stats.pixels_written);
+
+    ResolveOverdrawHeatmap(buffer.data(), Res, Res, 4);
+    uint64_t black = 0;
+    for (const auto& pixel : buffer)
+    {
+        EXPECT_EQ(pixel.w, 255);
+        black += pixel.x == 0 && pixel.y == 0 && pixel.z == 0;
+    }
+    EXPECT_EQ(black, Res * Res - covered);
+}
@@ -0,0 +1,129 @@
+#include "ray_tracer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "bvh_wide.hpp"
+#include "check.hpp"
+#include "profiler.hpp"
+
+namespace mirage
+{
+
+namespace detail
+{
+
+// Rows per thread. A row of a 1024 pixel wide frame takes tens of
+// microseconds, more on heavy scenes.
+constexpr std::size_t RayTraceRowGrain = 16;
+
+inline Vector3<float> Unproject(const Matrix44<float>& pInverseViewProjection, float pX, float pY, float pZ)
+{
+    const Vector4<float> p = pInverseViewProjection * Vector4<float>(pX, pY, pZ, 1.f);
+    const float inverse_w = 1.f / p.w;
+    return Vector3<float>(p.x * inverse_w, p.y * inverse_w, p.z * inverse_w);
+}
+
+inline Vector4<uint8_t> ShadeHit(const Triangle& pTriangle, const Ray& pRay)
+{
+    // Two-sided: the mesh winding is not known.
+    const Vector3<float> normal = Normalize(Cross(pTriangle.v1 - pTriangle.v0, pTriangle.v2 - pTriangle.v0));
+    const float facing = Abs(Dot(normal, pRay.direction));
+    const uint8_t c = static_cast<uint8_t>(255.f * (0.15f + 0.85f * facing));
+    return Vector4<uint8_t>(c, c, c, 255);
+}
+
+} // namespace detail
+
+Ray GenerateCameraRay(const Matrix44<float>& pInverseViewProjection, float pNdcX, float pNdcY)
+{
+    const Vector3<float> near_point = detail::Unproject(pInverseViewProjection, pNdcX, pNdcY, -1.f);
+    const Vector3<float> far_point = detail::Unproject(pInverseViewProjection, pNdcX, pNdcY, 1.f);
+    Ray ray;
+    ray.origin = near_point;
+    ray.direction = Normalize(far_point - near_point);
+    return ray;
+}
+
+void RayTrace(const Bvh& pBvh, const Matrix44<float>& pViewProjection,
+    Vector4<uint8_t>* pColorBuffer, unsigned pResolutionX, unsigned pResolutionY,
+    Execution pExecution)
+{
+    MIRAGE_PROFILE_ZONE("RayTrace");
+    const Matrix44<float> inverse = InverseMatrix(pViewProjection);
+    const float dx = 2.f / pResolutionX;
+    const float dy = 2.f / pResolutionY;
+
+    // Packets of 4x2 pixels. Lanes past the edge of the frame repeat the
+    // last pixel of the row or column and are not written.
+    const auto trace_row_pairs = [&](std::size_t pBegin, std::size_t pEnd)
+    {
+        for (std::size_t pair = pBegin; pair < pEnd; ++pair)
+        {
+            for (unsigned x = 0; x < pResolutionX; x += 4)
+            {
+                Ray rays[Float8::Width];
+                Vector3<float> origins[Float8::Width], directions[Float8::Width];
+                for (int j = 0; j < Float8::Width; ++j)
+                {
+                    const unsigned px = std::min(x + (j & 3), pResolutionX - 1);
+                    const unsigned py = std::min(static_cast<unsigned>(2 * pair) + (j >> 2), pResolutionY - 1);
+                    rays[j] = GenerateCameraRay(inverse, (px + 0.5f) * dx - 1.f, (py + 0.5f) * dy - 1.f);
+                    origins[j] = rays[j].origin;
+                    directions[j] = rays[j].direction;
+                }
+                const RayPacket8 packet{ Vector3x8<float>::Load(origins), Vector3x8<float>::Load(directions) };
+                RayHit8 hit;
+                const int mask = IntersectPacket(pBvh, packet, &hit);
+
+                for (int j = 0; j < Float8::Width; ++j)
+                {
+                    const unsigned px = x + (j & 3);
+                    const std::size_t py = 2 * pair + (j >> 2);
+                    if (px >= pResolutionX || py >= pResolutionY)
+                        continue;
+                    pColorBuffer[py * pResolutionX + px] = (mask & (1 << j))
+                        ? detail::ShadeHit(pBvh.GetTriangles()[hit.triangle[j]], rays[j])
+                        : Vector4<uint8_t>(0, 0, 0, 0);
+                }
+            }
+        }
+    };
+
+    const std::size_t row_pairs = (pResolutionY + 1) / 2;
+    if (pExecution == Execution::PARALLEL)
+        ParallelFor(row_pairs, detail::RayTraceRowGrain / 2, trace_row_pairs);
+    else
+        trace_row_pairs(0, row_pairs);
+}
+
+void AppendSphereMesh(std::vector<Triangle>* pTriangles, const Vector3<float>& pCenter, float pRadius, unsigned pSegments)
+{
+    DCHECK_GE(pSegments, 2u);
+    constexpr float pi = 3.14159265358979f;
+    const auto vertex = [&](unsigned pRing, unsigned pSlice)
+    {
+        const float theta = pi * pRing / pSegments;
+        const float phi = 2.f * pi * pSlice / pSegments;
+        return pCenter + pRadius * Vector3<float>(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+    };
+
+    pTriangles->reserve(pTriangles->size() + 2 * pSegments * (pSegments - 1));
+    for (unsigned ring = 0; ring < pSegments; ++ring)
+    {
+        for (unsigned slice = 0; slice < pSegments; ++slice)
+        {
+            const Vector3<float> a = vertex(ring, slice);
+            const Vector3<float> b = vertex(ring + 1, slice);
+            const Vector3<float> c = vertex(ring + 1, slice + 1);
+            const Vector3<float> d = vertex(ring, slice + 1);
+            // The first and last rings meet at the poles, one triangle per quad.
+            if (ring != 0)
+                pTriangles->push_back(Triangle{ a, b, d });
+            if (ring != pSegments - 1)
+                pTriangles->push_back(Triangle{ b, c, d });
+        }
+    }
+}
+
+} // namespace mirage
@@ -0,0 +1,34 @@
+#ifndef MIRAGE_RAY_TRACER_HPP
+#define MIRAGE_RAY_TRACER_HPP
+#include <cstdint>
+#include <vector>
+
+#include "bvh.hpp"
+#include "parallel.hpp"
+#include "vecmath.hpp"
+
+namespace mirage
+{
+
+// Ray through the point (pNdcX, pNdcY) in normalized device coordinates,
+// from the near plane towards the far plane, with a unit direction. The
+// near plane is at depth -1 as in ClipDepth::MINUS_ONE_TO_ONE.
+Ray GenerateCameraRay(const Matrix44<float>& pInverseViewProjection, float pNdcX, float pNdcY);
+
+// Renders pBvh as seen through pViewProjection into the color buffer, one
+// primary ray through each pixel center, traced in packets of 4x2 pixels
+// with IntersectPacket(). Pixels map to device coordinates as in
+// FormTriangle, with row 0 at y = -1, so both render modes can share a
+// color buffer and presenter. Hits are shaded by how directly the surface
+// faces the camera, misses are cleared to transparent black.
+void RayTrace(const Bvh& pBvh, const Matrix44<float>& pViewProjection,
+    Vector4<uint8_t>* pColorBuffer, unsigned pResolutionX, unsigned pResolutionY,
+    Execution pExecution = Execution::PARALLEL);
+
+// Appends a closed UV sphere of 2 * pSegments * (pSegments - 1) triangles,
+// test geometry for the ray-traced mode.
+void AppendSphereMesh(std::vector<Triangle>* pTriangles, const Vector3<float>& pCenter, float pRadius, unsigned pSegments);
+
+} // namespace mirage
+
+#endif
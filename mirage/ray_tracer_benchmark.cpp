@@ -0,0 +1,116 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+#include "tmp_runtests_macro.hpp"
+
+#ifdef MIRAGE_RUN_BENCHMARKS
+
+#include "bvh_wide.hpp"
+#include "ray_tracer.hpp"
+
+// An 8x8 grid of spheres of about pTriangles triangles in total, filling
+// most of a 90 degree view.
+static std::vector<mirage::Triangle> MakeSpheresScene(int64_t pTriangles)
+{
+    using namespace mirage;
+    const unsigned segments = static_cast<unsigned>(std::sqrt(pTriangles / 128.0)) + 1;
+    std::vector<Triangle> triangles;
+    for (int y = 0; y < 8; ++y)
+    {
+        for (int x = 0; x < 8; ++x)
+            AppendSphereMesh(&triangles, Vector3<float>(x - 3.5f, y - 3.5f, 0.f), 0.45f, segments);
+    }
+    return triangles;
+}
+
+static mirage::Matrix44<float> MakeSceneViewProjection()
+{
+    using namespace mirage;
+    return PerspectiveMatrix(1.5707964f, 1.f, 0.5f, 100.f) *
+        LookAtMatrix(Vector3<float>(0.f, 0.f, 5.f), Vector3<float>(0.f), Vector3<float>(0.f, 1.f, 0.f));
+}
+
+// state.range(1) is the Execution.
+static void BM_BvhBuild(benchmark::State& state)
+{
+    using namespace mirage;
+    const std::vector<Triangle> triangles = MakeSpheresScene(state.range(0));
+    for (auto _ : state)
+    {
+        Bvh bvh(triangles, static_cast<Execution>(state.range(1)));
+        benchmark::DoNotOptimize(bvh.GetNodes().data());
+    }
+    state.SetItemsProcessed(state.iterations() * triangles.size());
+}
+BENCHMARK(BM_BvhBuild)->Args({ 1 << 14, 0 })->Args({ 1 << 17, 0 })->Args({ 1 << 20, 0 })->Args({ 1 << 20, 1 })
+    ->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// One 256x256 frame. The frame time grows with the logarithm of the
+// triangle count.
+static void BM_RayTrace(benchmark::State& state)
+{
+    using namespace mirage;
+    const Bvh bvh(MakeSpheresScene(state.range(0)));
+    const unsigned res = 256;
+    std::vector<Vector4<uint8_t>> color_buffer(res * res);
+    for (auto _ : state)
+    {
+        RayTrace(bvh, MakeSceneViewProjection(), color_buffer.data(), res, res, Execution::SERIAL);
+        benchmark::DoNotOptimize(color_buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations() * res * res);
+}
+BENCHMARK(BM_RayTrace)->Arg(1 << 14)->Arg(1 << 17)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+
+// The closest hits of the primary rays of a 256x256 frame, without
+// shading. state.range(0) picks the kernel: single rays on the binary tree,
+// single rays on the 8-wide tree, or 8-ray packets of neighboring pixels on
+// the binary tree. state.range(1) is the triangle count.
+static void BM_PrimaryRays(benchmark::State& state)
+{
+    using namespace mirage;
+    const Bvh bvh(MakeSpheresScene(state.range(1)));
+    const Bvh8 bvh8(bvh);
+    const unsigned res = 256;
+    const Matrix44<float> inverse = InverseMatrix(MakeSceneViewProjection());
+    std::vector<Ray> rays;
+    for (unsigned y = 0; y < res; ++y)
+    {
+        for (unsigned x = 0; x < res; ++x)
+            rays.push_back(GenerateCameraRay(inverse, (x + 0.5f) * 2.f / res - 1.f, (y + 0.5f) * 2.f / res - 1.f));
+    }
+
+    const int kernel = static_cast<int>(state.range(0));
+    for (auto _ : state)
+    {
+        int hits = 0;
+        for (std::size_t i = 0; i < rays.size(); i += Float8::Width)
+        {
+            if (kernel == 2)
+            {
+                Vector3<float> origins[Float8::Width], directions[Float8::Width];
+                for (int j = 0; j < Float8::Width; ++j)
+                {
+                    origins[j] = rays[i + j].origin;
+                    directions[j] = rays[i + j].direction;
+                }
+                const RayPacket8 packet{ Vector3x8<float>::Load(origins), Vector3x8<float>::Load(directions) };
+                RayHit8 hit;
+                hits += IntersectPacket(bvh, packet, &hit) != 0;
+                continue;
+            }
+            for (int j = 0; j < Float8::Width; ++j)
+            {
+                RayHit hit;
+                hits += kernel == 0 ? bvh.Intersect(rays[i + j], &hit) : bvh8.Intersect(rays[i + j], &hit);
+            }
+        }
+        benchmark::DoNotOptimize(hits);
+    }
+    state.SetItemsProcessed(state.iterations() * rays.size());
+}
+BENCHMARK(BM_PrimaryRays)->ArgsProduct({ { 0, 1, 2 }, { 1 << 14, 1 << 20 } })->Unit(benchmark::kMillisecond);
+
+#endif
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "ray_tracer.hpp"
+
+static mirage::Matrix44<float> MakeViewProjection()
+{
+    using namespace mirage;
+    const Matrix44<float> projection = PerspectiveMatrix(1.5707964f, 1.f, 0.5f, 100.f);
+    const Matrix44<float> view = LookAtMatrix(Vector3<float>(0.f, 0.f, 5.f), Vector3<float>(0.f), Vector3<float>(0.f, 1.f, 0.f));
+    return projection * view;
+}
+
+TEST(RayTracer, CameraRaysStartOnTheNearPlane)
+{
+    using namespace mirage;
+
+    const Matrix44<float> inverse = InverseMatrix(MakeViewProjection());
+    const Ray center = GenerateCameraRay(inverse, 0.f, 0.f);
+    EXPECT_NEAR(center.origin.x, 0.f, 1e-5f);
+    EXPECT_NEAR(center.origin.y, 0.f, 1e-5f);
+    EXPECT_NEAR(center.origin.z, 4.5f, 1e-4f);
+    EXPECT_NEAR(center.direction.z, -1.f, 1e-6f);
+
+    // 90 degree field of view: the corners are at 45 degrees on each axis.
+    const Ray corner = GenerateCameraRay(inverse, 1.f, -1.f);
+    EXPECT_NEAR(corner.origin.x, 0.5f, 1e-4f);
+    EXPECT_NEAR(corner.origin.y, -0.5f, 1e-4f);
+    EXPECT_NEAR(corner.direction.x, -corner.direction.z, 1e-5f);
+    EXPECT_NEAR(corner.direction.y, corner.direction.z, 1e-5f);
+}
+
+TEST(RayTracer, RendersSphere)
+{
+    using namespace mirage;
+
+    // A unit sphere 5 units away covers the center of the frame but not the
+    // corners.
+    std::vector<Triangle> triangles;
+    AppendSphereMesh(&triangles, Vector3<float>(0.f), 1.f, 32);
+    EXPECT_EQ(triangles.size(), 2u * 32 * 31);
+    const Bvh bvh(triangles);
+
+    const unsigned res = 64;
+    for (Execution execution : { Execution::SERIAL, Execution::PARALLEL })
+    {
+        std::vector<Vector4<uint8_t>> color_buffer(res * res, Vector4<uint8_t>(1, 2, 3, 4));
+        RayTrace(bvh, MakeViewProjection(), color_buffer.data(), res, res, execution);
+
+        const Vector4<uint8_t> center = color_buffer[res / 2 * res + res / 2];
+        EXPECT_EQ(center.w, 255);
+        EXPECT_GT(center.x, 240);
+        EXPECT_EQ(color_buffer[0], Vector4<uint8_t>(0, 0, 0, 0));
+        EXPECT_EQ(color_buffer[res * res - 1], Vector4<uint8_t>(0, 0, 0, 0));
+
+        // The sphere spans about tan(asin(1/5)) = 0.2 of the half frame.
+        int covered = 0;
+        for (const Vector4<uint8_t>& c : color_buffer)
+            covered += c.w != 0;
+        const float expected = 3.14159f * 0.2041f * 0.2041f * res * res / 4.f;
+        EXPECT_NEAR(covered, expected, 0.1f * expected);
+    }
+}
+
+TEST(RayTracer, PacketsMatchSingleRays)
+{
+    using namespace mirage;
+
+    std::vector<Triangle> triangles;
+    AppendSphereMesh(&triangles, Vector3<float>(0.5f, 0.f, 0.f), 2.f, 24);
+    AppendSphereMesh(&triangles, Vector3<float>(-1.5f, 1.f, 1.f), 1.f, 24);
+    const Bvh bvh(triangles);
+
+    // Neither size is a multiple of the 4x2 packets.
+    const unsigned res_x = 63, res_y = 41;
+    std::vector<Vector4<uint8_t>> color_buffer(res_x * res_y);
+    RayTrace(bvh, MakeViewProjection(), color_buffer.data(), res_x, res_y, Execution::SERIAL);
+
+    const Matrix44<float> inverse = InverseMatrix(MakeViewProjection());
+    for (unsigned y = 0; y < res_y; ++y)
+    {
+        for (unsigned x = 0; x < res_x; ++x)
+        {
+            const Ray ray = GenerateCameraRay(inverse, (x + 0.5f) * 2.f / res_x - 1.f, (y + 0.5f) * 2.f / res_y - 1.f);
+            RayHit hit;
+            const bool expected = bvh.Intersect(ray, &hit);
+            const Vector4<uint8_t> c = color_buffer[y * res_x + x];
+            ASSERT_EQ(c.w, expected ? 255 : 0) << x << ", " << y;
+        }
+    }
+}
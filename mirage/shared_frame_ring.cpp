@@ -0,0 +1,352 @@
+#include "shared_frame_ring.hpp"
+
+#include <cstring>
+#include <new>
+
+#include "check.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mirage
+{
+
+namespace detail
+{
+
+constexpr uint32_t SharedFrameRingMagic = 0x4d52474d; // "MGRM"
+constexpr uint32_t SharedFrameRingVersion = 1;
+constexpr std::size_t PageSize = 4096;
+
+static std::size_t AlignUp(std::size_t v, std::size_t alignment)
+{
+    return (v + alignment - 1) / alignment * alignment;
+}
+
+static std::size_t GetSlotTableOffset()
+{
+    return AlignUp(sizeof(SharedFrameRingHeader), 64);
+}
+
+static SharedFrameSlot* GetSlot(SharedFrameRingHeader* pHeader, uint64_t pIndex)
+{
+    uint8_t* base = reinterpret_cast<uint8_t*>(pHeader) + GetSlotTableOffset();
+    return reinterpret_cast<SharedFrameSlot*>(base) + pIndex;
+}
+
+static const SharedFrameSlot* GetSlot(const SharedFrameRingHeader* pHeader, uint64_t pIndex)
+{
+    return GetSlot(const_cast<SharedFrameRingHeader*>(pHeader), pIndex);
+}
+
+#ifdef _WIN32
+static std::string GetMappingName(const std::string& pName)
+{
+    return "Local\\" + pName;
+}
+#else
+static std::string GetMappingName(const std::string& pName)
+{
+    return "/" + pName;
+}
+#endif
+
+static bool CreateMapping(const std::string& pName, std::size_t pSize, SharedMemoryMapping* pMapping)
+{
+#ifdef _WIN32
+    HANDLE handle = CreateFileMappingA(
+        INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+        static_cast<DWORD>(static_cast<uint64_t>(pSize) >> 32), static_cast<DWORD>(pSize),
+        GetMappingName(pName).c_str());
+    if (!handle)
+        return false;
+    // Unlike on POSIX, a mapping another process still holds, e.g. a viewer
+    // of a previous run, cannot be replaced, and its layout may differ.
+    if (GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        CloseHandle(handle);
+        return false;
+    }
+
+    void* address = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, pSize);
+    if (!address)
+    {
+        CloseHandle(handle);
+        return false;
+    }
+    pMapping->handle = handle;
+#else
+    const std::string name = GetMappingName(pName);
+    // Drop a ring left behind by a previous run, its layout may differ.
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+        return false;
+
+    if (ftruncate(fd, pSize) != 0)
+    {
+        close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    void* address = mmap(nullptr, pSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED)
+    {
+        close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    pMapping->fd = fd;
+#endif
+    pMapping->address = address;
+    pMapping->size = pSize;
+    return true;
+}
+
+static bool OpenMapping(const std::string& pName, SharedMemoryMapping* pMapping)
+{
+#ifdef _WIN32
+    HANDLE handle = OpenFileMappingA(FILE_MAP_READ, FALSE, GetMappingName(pName).c_str());
+    if (!handle)
+        return false;
+
+    void* address = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+    if (!address)
+    {
+        CloseHandle(handle);
+        return false;
+    }
+    // The view spans the whole mapping, take its size from the system rather
+    // than from the header.
+    MEMORY_BASIC_INFORMATION info;
+    if (VirtualQuery(address, &info, sizeof(info)) == 0 || info.RegionSize < sizeof(SharedFrameRingHeader))
+    {
+        UnmapViewOfFile(address);
+        CloseHandle(handle);
+        return false;
+    }
+    pMapping->handle = handle;
+    pMapping->size = info.RegionSize;
+#else
+    int fd = shm_open(GetMappingName(pName).c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(SharedFrameRingHeader)))
+    {
+        close(fd);
+        return false;
+    }
+
+    void* address = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+    pMapping->fd = fd;
+    pMapping->size = info.st_size;
+#endif
+    pMapping->address = address;
+    return true;
+}
+
+// The layout comes from another process, so check that every slot of the
+// largest frame lies within the mapping before trusting it.
+static bool IsValidLayout(const SharedFrameRingHeader* pHeader, std::size_t pMappingSize)
+{
+    if (pMappingSize < GetSlotTableOffset() || pHeader->slot_count == 0 ||
+        pHeader->slot_count > (pMappingSize - GetSlotTableOffset()) / sizeof(SharedFrameSlot))
+        return false;
+
+    const uint64_t frame_pixels = static_cast<uint64_t>(pHeader->max_width) * pHeader->max_height;
+    for (uint32_t i = 0; i < pHeader->slot_count; ++i)
+    {
+        const uint64_t offset = GetSlot(pHeader, i)->pixel_offset;
+        if (offset > pMappingSize || frame_pixels > (pMappingSize - offset) / sizeof(Vector4<uint8_t>))
+            return false;
+    }
+    return true;
+}
+
+static void CloseMapping(SharedMemoryMapping* pMapping)
+{
+    if (!pMapping->address)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(pMapping->address);
+    CloseHandle(pMapping->handle);
+#else
+    munmap(pMapping->address, pMapping->size);
+    close(pMapping->fd);
+#endif
+    *pMapping = SharedMemoryMapping();
+}
+
+} // namespace detail
+
+SharedFrameRingPublisher::SharedFrameRingPublisher(
+    const std::string& pName, unsigned pMaxDimensionX, unsigned pMaxDimensionY, unsigned pSlotCount)
+    : mName(pName)
+    , mHeader(nullptr)
+    , mWriteSlot(nullptr)
+{
+    using namespace detail;
+
+    if (pSlotCount < 2)
+        pSlotCount = 2;
+
+    const std::size_t slot_table_end = GetSlotTableOffset() + sizeof(SharedFrameSlot) * pSlotCount;
+    const std::size_t pixel_offset = AlignUp(slot_table_end, PageSize);
+    const std::size_t slot_size = AlignUp(static_cast<std::size_t>(pMaxDimensionX) * pMaxDimensionY * sizeof(Vector4<uint8_t>), PageSize);
+    const std::size_t size = pixel_offset + slot_size * pSlotCount;
+
+    if (!CreateMapping(pName, size, &mMapping))
+    {
+        printf("Error. Could not create shared frame ring %s\n", pName.c_str());
+        return;
+    }
+
+    mHeader = static_cast<SharedFrameRingHeader*>(mMapping.address);
+    mHeader->version = SharedFrameRingVersion;
+    mHeader->slot_count = pSlotCount;
+    mHeader->max_width = pMaxDimensionX;
+    mHeader->max_height = pMaxDimensionY;
+    mHeader->reserved = 0;
+    mHeader->mapping_size = size;
+    new (&mHeader->published_frames) std::atomic<uint64_t>(0);
+
+    for (unsigned i = 0; i < pSlotCount; ++i)
+    {
+        SharedFrameSlot* slot = GetSlot(mHeader, i);
+        new (&slot->sequence) std::atomic<uint64_t>(0);
+        slot->width = 0;
+        slot->height = 0;
+        slot->frame_index = 0;
+        slot->pixel_offset = pixel_offset + slot_size * i;
+    }
+
+    // Readers refuse the mapping until the magic is in place.
+    std::atomic_thread_fence(std::memory_order_release);
+    mHeader->magic = SharedFrameRingMagic;
+}
+
+SharedFrameRingPublisher::~SharedFrameRingPublisher()
+{
+    detail::CloseMapping(&mMapping);
+#ifndef _WIN32
+    if (mHeader)
+        shm_unlink(detail::GetMappingName(mName).c_str());
+#endif
+}
+
+void SharedFrameRingPublisher::Consume(const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY)
+{
+    Vector4<uint8_t>* dst = BeginFrame(pDimensionX, pDimensionY);
+    if (!dst)
+        return;
+    std::memcpy(dst, pColorBuffer, static_cast<std::size_t>(pDimensionX) * pDimensionY * sizeof(Vector4<uint8_t>));
+    EndFrame();
+}
+
+Vector4<uint8_t>* SharedFrameRingPublisher::BeginFrame(unsigned pDimensionX, unsigned pDimensionY)
+{
+    DCHECK(mWriteSlot == nullptr);
+    if (!mHeader || pDimensionX > mHeader->max_width || pDimensionY > mHeader->max_height)
+        return nullptr;
+
+    const uint64_t frame = mHeader->published_frames.load(std::memory_order_relaxed);
+    mWriteSlot = detail::GetSlot(mHeader, frame % mHeader->slot_count);
+
+    // Seqlock write: odd sequence while the pixels change.
+    const uint64_t sequence = mWriteSlot->sequence.load(std::memory_order_relaxed);
+    mWriteSlot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    mWriteSlot->width = pDimensionX;
+    mWriteSlot->height = pDimensionY;
+    mWriteSlot->frame_index = frame;
+    return reinterpret_cast<Vector4<uint8_t>*>(static_cast<uint8_t*>(mMapping.address) + mWriteSlot->pixel_offset);
+}
+
+void SharedFrameRingPublisher::EndFrame()
+{
+    DCHECK(mWriteSlot != nullptr);
+    const uint64_t sequence = mWriteSlot->sequence.load(std::memory_order_relaxed);
+    mWriteSlot->sequence.store(sequence + 1, std::memory_order_release);
+    mHeader->published_frames.store(mWriteSlot->frame_index + 1, std::memory_order_release);
+    mWriteSlot = nullptr;
+}
+
+SharedFrameRingReader::SharedFrameRingReader(const std::string& pName)
+    : mHeader(nullptr)
+{
+    if (!detail::OpenMapping(pName, &mMapping))
+        return;
+
+    const auto* header = static_cast<const detail::SharedFrameRingHeader*>(mMapping.address);
+    if (header->magic != detail::SharedFrameRingMagic || header->version != detail::SharedFrameRingVersion)
+    {
+        detail::CloseMapping(&mMapping);
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!detail::IsValidLayout(header, mMapping.size))
+    {
+        detail::CloseMapping(&mMapping);
+        return;
+    }
+    mHeader = header;
+}
+
+SharedFrameRingReader::~SharedFrameRingReader()
+{
+    detail::CloseMapping(&mMapping);
+}
+
+uint64_t SharedFrameRingReader::GetPublishedFrames() const
+{
+    return mHeader ? mHeader->published_frames.load(std::memory_order_acquire) : 0;
+}
+
+bool SharedFrameRingReader::AcquireLatest(Frame* pFrame) const
+{
+    const uint64_t published = GetPublishedFrames();
+    if (published == 0)
+        return false;
+
+    const uint64_t frame = published - 1;
+    const detail::SharedFrameSlot* slot = detail::GetSlot(mHeader, frame % mHeader->slot_count);
+    const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+    // The publisher already lapped the ring and is rewriting this slot.
+    if (sequence & 1)
+        return false;
+    if (slot->width > mHeader->max_width || slot->height > mHeader->max_height)
+        return false;
+
+    pFrame->pixels = reinterpret_cast<const Vector4<uint8_t>*>(static_cast<const uint8_t*>(mMapping.address) + slot->pixel_offset);
+    pFrame->width = slot->width;
+    pFrame->height = slot->height;
+    pFrame->frame_index = slot->frame_index;
+    pFrame->sequence = sequence;
+    return pFrame->frame_index == frame;
+}
+
+bool SharedFrameRingReader::IsStillValid(const Frame& pFrame) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const detail::SharedFrameSlot* slot = detail::GetSlot(mHeader, pFrame.frame_index % mHeader->slot_count);
+    return slot->sequence.load(std::memory_order_relaxed) == pFrame.sequence;
+}
+
+} // namespace mirage
@@ -0,0 +1,127 @@
+#ifndef MIRAGE_SHARED_FRAME_RING_HPP
+#define MIRAGE_SHARED_FRAME_RING_HPP
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "frame_sink.hpp"
+
+namespace mirage
+{
+
+namespace detail
+{
+
+struct SharedFrameSlot
+{
+    // Seqlock counter. Odd while the publisher writes the slot.
+    std::atomic<uint64_t> sequence;
+    uint32_t width;
+    uint32_t height;
+    uint64_t frame_index;
+    uint64_t pixel_offset;
+};
+
+// Lives at the start of the shared-memory object, followed by slot_count
+// SharedFrameSlot entries and the page-aligned pixel storage of every slot.
+struct SharedFrameRingHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t max_width;
+    uint32_t max_height;
+    uint32_t reserved;
+    uint64_t mapping_size;
+    // Number of frames published so far. Frame n lives in slot n % slot_count.
+    std::atomic<uint64_t> published_frames;
+};
+
+struct SharedMemoryMapping
+{
+    SharedMemoryMapping() : address(nullptr), size(0), handle(nullptr), fd(-1) {}
+
+    void* address;
+    std::size_t size;
+    void* handle;   // Windows file mapping handle.
+    int fd;         // POSIX shared memory descriptor.
+};
+
+} // namespace detail
+
+// Publishes completed color buffers into a named shared-memory ring, so that
+// a viewer process can display the latest frame while the renderer runs at
+// full speed. The publisher never waits for the viewer.
+class SharedFrameRingPublisher : public FrameSink
+{
+public:
+
+    // pName is a plain identifier, e.g. "mirage". On POSIX, a ring left behind
+    // under that name is replaced. On Windows the name stays taken while any
+    // process maps the old ring, and creating the publisher fails; IsOpen()
+    // reports the failure.
+    SharedFrameRingPublisher(const std::string& pName, unsigned pMaxDimensionX, unsigned pMaxDimensionY, unsigned pSlotCount = 3);
+    ~SharedFrameRingPublisher();
+
+    SharedFrameRingPublisher(const SharedFrameRingPublisher&) = delete;
+    SharedFrameRingPublisher& operator=(const SharedFrameRingPublisher&) = delete;
+
+    // Copies the frame into the next slot.
+    void Consume(const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY) override;
+
+    // Renders directly into shared memory instead of copying with Consume().
+    // The returned buffer is only valid until EndFrame().
+    Vector4<uint8_t>* BeginFrame(unsigned pDimensionX, unsigned pDimensionY);
+    void EndFrame();
+
+    bool IsOpen() const override { return mHeader != nullptr; }
+
+private:
+
+    std::string mName;
+    detail::SharedMemoryMapping mMapping;
+    detail::SharedFrameRingHeader* mHeader;
+    detail::SharedFrameSlot* mWriteSlot;
+};
+
+// Maps a ring created by SharedFrameRingPublisher, typically in another process.
+class SharedFrameRingReader
+{
+public:
+
+    explicit SharedFrameRingReader(const std::string& pName);
+    ~SharedFrameRingReader();
+
+    SharedFrameRingReader(const SharedFrameRingReader&) = delete;
+    SharedFrameRingReader& operator=(const SharedFrameRingReader&) = delete;
+
+    struct Frame
+    {
+        const Vector4<uint8_t>* pixels;
+        unsigned width;
+        unsigned height;
+        uint64_t frame_index;
+        uint64_t sequence;
+    };
+
+    // Points pFrame at the most recently completed frame. The pixels stay in
+    // shared memory, no copy is made. Returns false if nothing was published
+    // yet. Once done reading, IsStillValid() tells whether the publisher has
+    // started overwriting the slot in the meantime.
+    bool AcquireLatest(Frame* pFrame) const;
+    bool IsStillValid(const Frame& pFrame) const;
+
+    uint64_t GetPublishedFrames() const;
+    unsigned GetMaxDimensionX() const { return mHeader ? mHeader->max_width : 0; }
+    unsigned GetMaxDimensionY() const { return mHeader ? mHeader->max_height : 0; }
+    bool IsOpen() const { return mHeader != nullptr; }
+
+private:
+
+    detail::SharedMemoryMapping mMapping;
+    const detail::SharedFrameRingHeader* mHeader;
+};
+
+} // namespace mirage
+
+#endif
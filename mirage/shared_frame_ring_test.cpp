@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "shared_frame_ring.hpp"
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Unique per process, so concurrent test runs do not share a ring.
+static std::string GetRingName()
+{
+    return "mirage_test_" + std::to_string(getpid());
+}
+
+static void Publish(mirage::SharedFrameRingPublisher* pPublisher, uint8_t pValue, unsigned pDimensionX, unsigned pDimensionY)
+{
+    using namespace mirage;
+    std::vector<Vector4<uint8_t>> frame(pDimensionX * pDimensionY, Vector4<uint8_t>(pValue, 0, 0, 255));
+    pPublisher->Consume(frame.data(), pDimensionX, pDimensionY);
+}
+
+TEST(SharedFrameRing, ReaderGetsLatestFrame)
+{
+    using namespace mirage;
+
+    SharedFrameRingPublisher publisher(GetRingName(), 8, 8, 3);
+    ASSERT_TRUE(publisher.IsOpen());
+    SharedFrameRingReader reader(GetRingName());
+    ASSERT_TRUE(reader.IsOpen());
+    EXPECT_EQ(reader.GetMaxDimensionX(), 8u);
+    EXPECT_EQ(reader.GetMaxDimensionY(), 8u);
+
+    SharedFrameRingReader::Frame frame;
+    EXPECT_FALSE(reader.AcquireLatest(&frame));
+
+    Publish(&publisher, 10, 8, 8);
+    Publish(&publisher, 11, 4, 2);
+    EXPECT_EQ(reader.GetPublishedFrames(), 2u);
+    ASSERT_TRUE(reader.AcquireLatest(&frame));
+    EXPECT_EQ(frame.frame_index, 1u);
+    EXPECT_EQ(frame.width, 4u);
+    EXPECT_EQ(frame.height, 2u);
+    EXPECT_EQ(frame.pixels[0], Vector4<uint8_t>(11, 0, 0, 255));
+    EXPECT_EQ(frame.pixels[7], Vector4<uint8_t>(11, 0, 0, 255));
+    EXPECT_TRUE(reader.IsStillValid(frame));
+
+    // Frames larger than the ring are not published.
+    Publish(&publisher, 12, 9, 8);
+    EXPECT_EQ(reader.GetPublishedFrames(), 2u);
+}
+
+TEST(SharedFrameRing, ReaderDetectsOverwrittenSlot)
+{
+    using namespace mirage;
+
+    SharedFrameRingPublisher publisher(GetRingName(), 4, 4, 2);
+    ASSERT_TRUE(publisher.IsOpen());
+    SharedFrameRingReader reader(GetRingName());
+    ASSERT_TRUE(reader.IsOpen());
+
+    Publish(&publisher, 1, 4, 4);
+    Publish(&publisher, 2, 4, 4);
+    SharedFrameRingReader::Frame frame;
+    ASSERT_TRUE(reader.AcquireLatest(&frame));
+    EXPECT_EQ(frame.frame_index, 1u);
+
+    // While the reader looks at frame 1, the publisher laps the ring and
+    // starts rewriting its slot: the read is torn.
+    Publish(&publisher, 3, 4, 4);
+    Vector4<uint8_t>* pixels = publisher.BeginFrame(4, 4);
+    ASSERT_NE(pixels, nullptr);
+    pixels[0] = Vector4<uint8_t>(4, 0, 0, 255);
+    EXPECT_FALSE(reader.IsStillValid(frame));
+
+    // Retrying gets the newest completed frame, which stays valid.
+    ASSERT_TRUE(reader.AcquireLatest(&frame));
+    EXPECT_EQ(frame.frame_index, 2u);
+    EXPECT_EQ(frame.pixels[0].x, 3);
+    EXPECT_TRUE(reader.IsStillValid(frame));
+
+    // Once frame 3 is done, it is the latest and frame 2 is still intact.
+    publisher.EndFrame();
+    EXPECT_TRUE(reader.IsStillValid(frame));
+    ASSERT_TRUE(reader.AcquireLatest(&frame));
+    EXPECT_EQ(frame.frame_index, 3u);
+    EXPECT_EQ(frame.pixels[0].x, 4);
+}
+
+#ifndef _WIN32
+
+// Edits the ring through a writable mapping of its own, as a misbehaving or
+// mismatched publisher would.
+TEST(SharedFrameRing, ReaderRejectsInvalidLayout)
+{
+    using namespace mirage;
+
+    SharedFrameRingPublisher publisher(GetRingName(), 8, 8, 2);
+    ASSERT_TRUE(publisher.IsOpen());
+    const int fd = shm_open(("/" + GetRingName()).c_str(), O_RDWR, 0);
+    ASSERT_GE(fd, 0);
+    void* address = mmap(nullptr, sizeof(detail::SharedFrameRingHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(address, MAP_FAILED);
+    auto* header = static_cast<detail::SharedFrameRingHeader*>(address);
+
+    header->slot_count = 0;
+    EXPECT_FALSE(SharedFrameRingReader(GetRingName()).IsOpen());
+    header->slot_count = 1 << 30;
+    EXPECT_FALSE(SharedFrameRingReader(GetRingName()).IsOpen());
+    header->slot_count = 2;
+    header->max_height = 1 << 20;
+    EXPECT_FALSE(SharedFrameRingReader(GetRingName()).IsOpen());
+    header->max_height = 8;
+    EXPECT_TRUE(SharedFrameRingReader(GetRingName()).IsOpen());
+
+    munmap(address, sizeof(detail::SharedFrameRingHeader));
+}
+
+#endif
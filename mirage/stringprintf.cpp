@@ -62,79 +62,42 @@ std::string DoubleToStringWithPrecision(double v, int precision)
     return std::string(buf, length);
 }
 
-void ResolveFmtString(std::string* str, const char** fmt_p)
+FmtSpecifier NextFmtSpecifier(std::string* str, const char** fmt_p)
 {
     const char* fmt = *fmt_p;
     while (*fmt != '\0')
     {
-        if (*fmt == '%')
+        const char* literal = fmt;
+        while (*fmt != '\0' && *fmt != '%')
+            fmt++;
+        str->append(literal, fmt);
+        if (*fmt == '\0')
+            break;
+
+        if (*(fmt + 1) == '%')
         {
-            if (*(fmt + 1) == '%')
-            {
-                *str += *fmt;
-                fmt++;
-                fmt++;
-                continue;
-            }
+            *str += '%';
+            fmt += 2;
+            continue;
         }
-        *str += *fmt;
-        fmt++;
+        const FmtSpecifier f = ParseFmtSpecifier(fmt + 1);
+        *fmt_p = fmt + 1 + f.length;
+        return f;
     }
     *fmt_p = fmt;
+    return FmtSpecifier();
 }
 
-
-FmtStruct GetFmtSpecifier(const char* f)
+void ResolveFmtString(std::string* str, const char** fmt_p)
 {
-    FmtStruct fmt{};
-
-    if (*f == 'l')
-    {
-        fmt.specifier += 'l';
-        fmt.specifier_length++;
-        f++;
-    }
-    if (*f == 'l')
-    {
-        fmt.specifier += 'l';
-        fmt.specifier_length++;
-        f++;
-    }
-
-    if (*f == '.')
-    {
-        // Precision specifier for floats.
-        f++;
-        fmt.specifier_length++;
-
-        int precision = 0;
-        int i = 0;
-        while (true)
-        {
-            if (*f >= '0' && *f <= '9')
-            {
-                precision *= 10;
-                precision += *f - '0';
-                f++;
-                fmt.specifier_length++;
-            } else
-            {
-                fmt.precision = (i == 0) ? -1 : precision;
-                break;
-            }
-            ++i;
-        }
-    }
-
-    if (*f == 'd' || *f == 'i' || *f == 'o' || *f == 'u' ||
-        *f == 'x' || *f == 'X' || *f == 'd' || *f == 'f' ||
-        *f == 's')
+    while (**fmt_p != '\0')
     {
-        fmt.specifier += *f;
-        fmt.specifier_length++;
+        // Only reached for conversions without an argument and unsupported
+        // conversions, which are dropped.
+        const FmtSpecifier f = NextFmtSpecifier(str, fmt_p);
+        DCHECK(f.conversion == '\0');
+        (void)f;
     }
-
-    return fmt;
 }
 
 } // namespace detail
@@ -2,165 +2,336 @@
 #define MIRAGE_STRING_PRINTF_HPP
 #include <intrin.h>
 #include <stdio.h>
+#include <charconv>
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <type_traits>
+#include <utility>
 
 #include <double-conversion.h>
 
+#include "check.hpp"
 #include "util.hpp"
 
+// Format string for StringPrintf() that is parsed and checked against the
+// arguments at compile time:
+//
+//     StringPrintf(MIRAGE_FMT("frame %d took %.3f ms"), frame, ms);
+//
+// A wrong number of arguments, an argument of the wrong kind for its
+// conversion or an unsupported conversion is a compile error, and the
+// formatting only copies the precomputed literal text and the arguments.
+#define MIRAGE_FMT(s) \
+    [] { \
+        struct FmtLiteral : mirage::detail::FmtLiteralBase \
+        { \
+            static constexpr std::string_view Get() { return s; } \
+        }; \
+        return FmtLiteral{}; \
+    }()
+
 namespace mirage
 {
 
 namespace detail
 {
 
-struct FmtStruct
+// A conversion such as "%.3f" or "%llu". The length modifiers are accepted
+// but ignored: integers are printed at the width of their actual type.
+struct FmtSpecifier
 {
-    FmtStruct()
-        : specifier("")
-        , specifier_length(0)
-        , precision(-1)
-    {}
-
-    std::string specifier;
-    int specifier_length;
-    // A value of -1 indicates that the precision specifier was not 
+    // One of d, i, o, u, x, X, f and s, or '\0' if the conversion is not
+    // supported.
+    char conversion = '\0';
+    // Characters after the '%'.
+    int length = 0;
+    // A value of -1 indicates that the precision specifier was not
     // provided. Therefore, don't parse with the precision functions.
-    int precision;
+    int precision = -1;
 };
 
-template<typename T>
-struct is_static_string_literal : public std::false_type {};
+// Parses the conversion following a '%'. Used at compile time for
+// MIRAGE_FMT strings and at run time for all others.
+constexpr FmtSpecifier ParseFmtSpecifier(const char* f)
+{
+    FmtSpecifier fmt;
+    const char* begin = f;
 
-template<std::size_t N>
-struct is_static_string_literal<const char(&)[N]> : public std::true_type {};
+    if (*f == 'l')
+        f++;
+    if (*f == 'l')
+        f++;
 
-template<typename T>
-struct is_string_literal : public std::false_type {};
+    if (*f == '.')
+    {
+        // Precision specifier for floats.
+        f++;
+        if (*f >= '0' && *f <= '9')
+            fmt.precision = 0;
+        while (*f >= '0' && *f <= '9')
+        {
+            fmt.precision = fmt.precision * 10 + (*f - '0');
+            f++;
+        }
+    }
+
+    switch (*f)
+    {
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'f': case 's':
+        fmt.conversion = *f;
+        fmt.length = static_cast<int>(f + 1 - begin);
+        return fmt;
+    default:
+        return FmtSpecifier();
+    }
+}
 
-template<>
-struct is_string_literal<const char*> : public std::true_type {};
+enum class FmtArgType
+{
+    INTEGER,
+    FLOAT,
+    STRING,
+    UNSUPPORTED
+};
 
-template<>
-struct is_string_literal<std::string> : public std::true_type {};
+template<typename T>
+constexpr FmtArgType GetFmtArgType()
+{
+    using U = std::remove_cv_t<std::remove_reference_t<T>>;
+    if constexpr (std::is_integral_v<U>)
+        return FmtArgType::INTEGER;
+    else if constexpr (std::is_same_v<U, float> || std::is_same_v<U, double>)
+        return FmtArgType::FLOAT;
+    else if constexpr (std::is_convertible_v<const U&, std::string_view>)
+        return FmtArgType::STRING;
+    else
+        return FmtArgType::UNSUPPORTED;
+}
+
+constexpr bool FmtAccepts(char pConversion, FmtArgType pType)
+{
+    switch (pConversion)
+    {
+    case '\0':
+        return false;
+    case 's':
+        return pType == FmtArgType::STRING;
+    case 'f':
+        return pType == FmtArgType::FLOAT;
+    default:
+        return pType == FmtArgType::INTEGER;
+    }
+}
 
 std::string FloatToString(float v);
 std::string DoubleToString(double v);
 std::string FloatToStringWithPrecision(float v, int precision);
 std::string DoubleToStringWithPrecision(double v, int precision);
 
-FmtStruct GetFmtSpecifier(const char* f);
-
-void ResolveFmtString(std::string* str, const char** fmt_p);
-
 template<typename T>
-void ResolveFmtString(std::string* str, const char** fmt_p, T&& t)
+void AppendFmtArg(std::string* str, const FmtSpecifier& f, const T& t)
 {
-    const char* fmt = *fmt_p;
+    constexpr FmtArgType type = GetFmtArgType<T>();
+    static_assert(type != FmtArgType::UNSUPPORTED, "StringPrintf() takes integers, floats, doubles and strings.");
 
-    while (*fmt != '\0')
+    if constexpr (type == FmtArgType::INTEGER)
     {
-        if (*fmt == '%')
+        // Promoted like a printf() argument, so bool and char print as
+        // numbers and %x of a negative int is 8 digits.
+        const auto v = +t;
+        char buf[24];
+        std::to_chars_result result;
+        if (f.conversion == 'o' || f.conversion == 'x' || f.conversion == 'X')
         {
-            if (*(fmt + 1) == '%')
+            const auto u = static_cast<std::make_unsigned_t<decltype(v)>>(v);
+            result = std::to_chars(buf, buf + sizeof(buf), u, f.conversion == 'o' ? 8 : 16);
+            if (f.conversion == 'X')
             {
-                *str += *fmt;
-                fmt++;
-                fmt++;
-                continue;
-            }
-            FmtStruct f = GetFmtSpecifier(fmt+1);
-            if (f.specifier == "s")
-            {
-                if constexpr (is_string_literal<std::remove_reference_t<T>>::value ||
-                              is_static_string_literal<T>::value)
+                for (char* c = buf; c != result.ptr; ++c)
                 {
-                    *str += t;
-                    fmt++;
-                    fmt += f.specifier_length;
-                    break;
+                    if (*c >= 'a')
+                        *c += 'A' - 'a';
                 }
-                else assert(false, "Expected %s here!");
-            }
-            if (f.specifier == "d" || f.specifier == "i" || f.specifier == "o" || 
-                f.specifier == "u" || f.specifier == "x" || f.specifier == "X" || 
-                f.specifier == "llu")
-            {
-                if constexpr (std::is_integral_v<std::remove_reference_t<T>>)
-                {
-                    *str += std::to_string(t);
-                    fmt++;
-                    fmt += f.specifier_length;
-                    break;
-                }
-                else 
-                    assert(false, "Expected integer specifier here!");
-            }
-            if (f.specifier == "f")
-            {
-                if constexpr (std::is_same_v<float, std::remove_reference_t<T>>)
-                {
-                    if (f.precision == -1)
-                        *str += FloatToString(t);
-                    else
-                    {
-                        int digits = CountDigits((int)t);
-                        *str += FloatToStringWithPrecision(t, digits + f.precision);
-                    }
-                    fmt += f.specifier_length;
-                    break;
-                }
-                else if constexpr (std::is_same_v<double, std::remove_reference_t<T>>)
-                {
-                    if (f.precision == -1)
-                        *str += DoubleToString(t);
-                    else
-                    {
-                        int digits = CountDigits((int)t);
-                        *str += DoubleToStringWithPrecision(t, digits + f.precision);
-                    }
-                    fmt += f.specifier_length;
-                    break;
-                }
-                else 
-                    assert(false, "Expected %f here!");
             }
         }
         else
         {
-            *str += *fmt;
+            result = std::to_chars(buf, buf + sizeof(buf), v);
+        }
+        str->append(buf, result.ptr);
+    }
+    else if constexpr (type == FmtArgType::FLOAT)
+    {
+        constexpr bool is_float = std::is_same_v<std::remove_cv_t<T>, float>;
+        if (f.precision == -1)
+            *str += is_float ? FloatToString(t) : DoubleToString(t);
+        else
+        {
+            int digits = CountDigits((int)t);
+            *str += is_float ? FloatToStringWithPrecision(t, digits + f.precision) :
+                DoubleToStringWithPrecision(t, digits + f.precision);
         }
-        fmt++;
     }
+    else
+    {
+        *str += t;
+    }
+}
+
+// Format string parsed by ParseFmt(): the literal text with "%%" unescaped,
+// split into one literal before each argument and one after the last, and
+// the conversion of each argument.
+template<std::size_t Size, std::size_t ArgCount>
+struct ParsedFmt
+{
+    enum class Error
+    {
+        NONE,
+        UNSUPPORTED_CONVERSION,
+        TOO_FEW_ARGUMENTS,
+        TOO_MANY_ARGUMENTS,
+        ARGUMENT_MISMATCH
+    };
+
+    struct Literal
+    {
+        std::size_t begin = 0;
+        std::size_t length = 0;
+    };
+
+    char text[Size] = {};
+    std::size_t text_length = 0;
+    Literal literals[ArgCount + 1] = {};
+    FmtSpecifier specifiers[ArgCount + 1] = {};
+    Error error = Error::NONE;
+};
+
+// Parses pFmt, of at most Size - 1 characters, for arguments of the types
+// Args, and reports the first problem in ParsedFmt::error.
+template<std::size_t Size, typename... Args>
+constexpr ParsedFmt<Size, sizeof...(Args)> ParseFmt(std::string_view pFmt)
+{
+    using Parsed = ParsedFmt<Size, sizeof...(Args)>;
+    constexpr FmtArgType types[] = { GetFmtArgType<Args>()..., FmtArgType::UNSUPPORTED };
+
+    Parsed parsed;
+    std::size_t arg = 0;
+    std::size_t literal_begin = 0;
+    for (std::size_t i = 0; i < pFmt.size(); ++i)
+    {
+        if (pFmt[i] != '%')
+        {
+            parsed.text[parsed.text_length++] = pFmt[i];
+            continue;
+        }
+        if (i + 1 < pFmt.size() && pFmt[i + 1] == '%')
+        {
+            parsed.text[parsed.text_length++] = '%';
+            ++i;
+            continue;
+        }
+
+        // The literal is null-terminated, so the specifier cannot read past
+        // its end.
+        const FmtSpecifier f = ParseFmtSpecifier(pFmt.data() + i + 1);
+        if (f.conversion == '\0')
+        {
+            parsed.error = Parsed::Error::UNSUPPORTED_CONVERSION;
+            return parsed;
+        }
+        if (arg == sizeof...(Args))
+        {
+            parsed.error = Parsed::Error::TOO_FEW_ARGUMENTS;
+            return parsed;
+        }
+        if (!FmtAccepts(f.conversion, types[arg]))
+        {
+            parsed.error = Parsed::Error::ARGUMENT_MISMATCH;
+            return parsed;
+        }
+        parsed.literals[arg].begin = literal_begin;
+        parsed.literals[arg].length = parsed.text_length - literal_begin;
+        parsed.specifiers[arg] = f;
+        literal_begin = parsed.text_length;
+        ++arg;
+        i += f.length;
+    }
+    if (arg != sizeof...(Args))
+    {
+        parsed.error = Parsed::Error::TOO_MANY_ARGUMENTS;
+        return parsed;
+    }
+    parsed.literals[arg].begin = literal_begin;
+    parsed.literals[arg].length = parsed.text_length - literal_begin;
+    return parsed;
+}
 
-    *fmt_p = fmt;
+template<std::size_t Size, std::size_t ArgCount>
+void AppendFmtLiteral(std::string* str, const ParsedFmt<Size, ArgCount>& pFmt, std::size_t pIndex)
+{
+    str->append(pFmt.text + pFmt.literals[pIndex].begin, pFmt.literals[pIndex].length);
 }
 
-template<typename T>
-void StringPrintfRecursively(std::string* str, const char* fmt, T&& t)
+template<std::size_t Size, std::size_t ArgCount, std::size_t... I, typename... Args>
+void FormatParsed(std::string* str, const ParsedFmt<Size, ArgCount>& pFmt, std::index_sequence<I...>, const Args&... args)
 {
-    ResolveFmtString(str, &fmt, std::forward<T>(t));
-    ResolveFmtString(str, &fmt);
+    ((AppendFmtLiteral(str, pFmt, I), AppendFmtArg(str, pFmt.specifiers[I], args)), ...);
+    AppendFmtLiteral(str, pFmt, ArgCount);
 }
 
-template<typename T, typename... Args>
-void StringPrintfRecursively(std::string* str, const char* fmt, T&& t, Args&&... args)
+// Base of the format string types made by MIRAGE_FMT.
+struct FmtLiteralBase {};
+
+// Copies the literal text up to the next conversion, unescaping "%%", and
+// advances *fmt_p past that conversion. Returns its specifier, with
+// conversion '\0' at the end of the string or for unsupported conversions.
+FmtSpecifier NextFmtSpecifier(std::string* str, const char** fmt_p);
+
+// Copies the rest of the format string.
+void ResolveFmtString(std::string* str, const char** fmt_p);
+
+template<typename T>
+void ResolveFmtString(std::string* str, const char** fmt_p, const T& t)
 {
-    ResolveFmtString(str, &fmt, std::forward<T>(t));
-    StringPrintfRecursively(str, fmt, std::forward<Args>(args)...);
+    const FmtSpecifier f = NextFmtSpecifier(str, fmt_p);
+    DCHECK(FmtAccepts(f.conversion, GetFmtArgType<T>()));
+    if (f.conversion != '\0')
+        AppendFmtArg(str, f, t);
 }
-    
+
 } // namespace detail
 
+// printf-style formatting of integers (%d, %i, %u, %o, %x, %X, optionally
+// with l or ll), floats and doubles (%f, %.Nf) and strings (%s). Prefer a
+// MIRAGE_FMT format string, which is checked at compile time; a plain
+// format string is parsed on every call and checked with DCHECKs.
 template<typename... Args>
-std::string StringPrintf(const char* fmt, Args&&... args)
+std::string StringPrintf(const char* fmt, const Args&... args)
+{
+    std::string res;
+    (detail::ResolveFmtString(&res, &fmt, args), ...);
+    detail::ResolveFmtString(&res, &fmt);
+    return res;
+}
+
+template<typename Fmt, typename... Args, typename = std::enable_if_t<std::is_base_of_v<detail::FmtLiteralBase, Fmt>>>
+std::string StringPrintf(Fmt, const Args&... args)
 {
+    using Parsed = detail::ParsedFmt<Fmt::Get().size() + 1, sizeof...(Args)>;
+    static constexpr Parsed parsed = detail::ParseFmt<Fmt::Get().size() + 1, std::decay_t<Args>...>(Fmt::Get());
+    static_assert(parsed.error != Parsed::Error::UNSUPPORTED_CONVERSION, "StringPrintf(): unsupported conversion.");
+    static_assert(parsed.error != Parsed::Error::TOO_FEW_ARGUMENTS, "StringPrintf(): more conversions than arguments.");
+    static_assert(parsed.error != Parsed::Error::TOO_MANY_ARGUMENTS, "StringPrintf(): more arguments than conversions.");
+    static_assert(parsed.error != Parsed::Error::ARGUMENT_MISMATCH,
+        "StringPrintf(): argument of the wrong type for its conversion.");
+
     std::string res;
-    detail::StringPrintfRecursively(&res, fmt, std::forward<Args>(args)...);
+    res.reserve(parsed.text_length + 16 * sizeof...(Args));
+    detail::FormatParsed(&res, parsed, std::index_sequence_for<Args...>(), args...);
     return res;
 }
 
 } // namespace mirage
 
-#endif MIRAGE_STRING_PRINTF_HPP
\ No newline at end of file
+#endif MIRAGE_STRING_PRINTF_HPP
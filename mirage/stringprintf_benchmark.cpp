@@ -0,0 +1,49 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+
+#include "tmp_runtests_macro.hpp"
+
+#ifdef MIRAGE_RUN_BENCHMARKS
+
+#include "stringprintf.hpp"
+
+static void BM_StringPrintf(benchmark::State& state)
+{
+    int frame = 42;
+    float ms = 16.6667f;
+    for (auto _ : state)
+    {
+        std::string s = mirage::StringPrintf("frame %d took %.3f ms in %s", frame, ms, "FormTriangle");
+        benchmark::DoNotOptimize(s);
+    }
+}
+BENCHMARK(BM_StringPrintf);
+
+static void BM_StringPrintfCompiled(benchmark::State& state)
+{
+    int frame = 42;
+    float ms = 16.6667f;
+    for (auto _ : state)
+    {
+        std::string s = mirage::StringPrintf(MIRAGE_FMT("frame %d took %.3f ms in %s"), frame, ms, "FormTriangle");
+        benchmark::DoNotOptimize(s);
+    }
+}
+BENCHMARK(BM_StringPrintfCompiled);
+
+static void BM_Snprintf(benchmark::State& state)
+{
+    int frame = 42;
+    float ms = 16.6667f;
+    for (auto _ : state)
+    {
+        char buf[128];
+        int n = std::snprintf(buf, sizeof(buf), "frame %d took %.3f ms in %s", frame, ms, "FormTriangle");
+        std::string s(buf, n);
+        benchmark::DoNotOptimize(s);
+    }
+}
+BENCHMARK(BM_Snprintf);
+
+#endif
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+
+#include "stringprintf.hpp"
+
+TEST(StringPrintf, ParsesSpecifiersAtCompileTime)
+{
+    using namespace mirage::detail;
+
+    constexpr FmtSpecifier precision = ParseFmtSpecifier(".3f ms");
+    static_assert(precision.conversion == 'f' && precision.precision == 3 && precision.length == 3, "");
+    constexpr FmtSpecifier integer = ParseFmtSpecifier("llu");
+    static_assert(integer.conversion == 'u' && integer.precision == -1 && integer.length == 3, "");
+    static_assert(ParseFmtSpecifier("q").conversion == '\0', "");
+    static_assert(ParseFmtSpecifier("").conversion == '\0', "");
+
+    constexpr auto parsed = ParseFmt<14, int, const char*>("a %d%% b %s c");
+    static_assert(parsed.error == decltype(parsed)::Error::NONE, "");
+    EXPECT_EQ(std::string(parsed.text, parsed.text_length), "a % b  c");
+    EXPECT_EQ(parsed.literals[0].length, 2u);
+    EXPECT_EQ(parsed.literals[1].begin, 2u);
+    EXPECT_EQ(parsed.literals[1].length, 4u);
+    EXPECT_EQ(parsed.literals[2].length, 2u);
+    EXPECT_EQ(parsed.specifiers[1].conversion, 's');
+
+    static_assert(ParseFmt<3, float>("%d").error == ParsedFmt<3, 1>::Error::ARGUMENT_MISMATCH, "");
+    static_assert(ParseFmt<3>("%d").error == ParsedFmt<3, 0>::Error::TOO_FEW_ARGUMENTS, "");
+    static_assert(ParseFmt<2, int>("x").error == ParsedFmt<2, 1>::Error::TOO_MANY_ARGUMENTS, "");
+    static_assert(ParseFmt<3, char>("%c").error == ParsedFmt<3, 1>::Error::UNSUPPORTED_CONVERSION, "");
+}
+
+TEST(StringPrintf, CompileTimeMatchesRuntimeFormat)
+{
+    using mirage::StringPrintf;
+
+    const std::string name = "FormTriangle";
+    const uint64_t pixels = 1048576;
+    EXPECT_EQ(StringPrintf(MIRAGE_FMT("frame %d took %.3f ms in %s"), 42, 16.6667f, "FormTriangle"),
+        "frame 42 took 16.667 ms in FormTriangle");
+    EXPECT_EQ(StringPrintf("frame %d took %.3f ms in %s", 42, 16.6667f, "FormTriangle"),
+        "frame 42 took 16.667 ms in FormTriangle");
+    EXPECT_EQ(StringPrintf(MIRAGE_FMT("%s: %llu px, 100%%"), name, pixels), "FormTriangle: 1048576 px, 100%");
+    EXPECT_EQ(StringPrintf("%s: %llu px, 100%%", name, pixels), "FormTriangle: 1048576 px, 100%");
+    EXPECT_EQ(StringPrintf(MIRAGE_FMT("%x %X %o %d %u"), 255, 0xABCu, 8, -7, true), "ff ABC 10 -7 1");
+    EXPECT_EQ(StringPrintf("%x %X %o %d %u", 255, 0xABCu, 8, -7, true), "ff ABC 10 -7 1");
+    EXPECT_EQ(StringPrintf(MIRAGE_FMT("%x"), -1), "ffffffff");
+    EXPECT_EQ(StringPrintf(MIRAGE_FMT("%f|%f"), 0.5f, 0.25), "0.5|0.25");
+    EXPECT_EQ(StringPrintf(MIRAGE_FMT("no arguments%%")), "no arguments%");
+    EXPECT_EQ(StringPrintf("no arguments%%"), "no arguments%");
+}
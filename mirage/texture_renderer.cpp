@@ -1,6 +1,7 @@
 #include "texture_renderer.hpp"
 
 #include "check.hpp"
+#include "profiler.hpp"
 #include <shaderdirect.hpp>
 
 namespace mirage
@@ -67,31 +68,23 @@ TextureRenderer::~TextureRenderer()
     delete mRenderingObjects;
 }
 
-void TextureRenderer::Update(Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY)
+void TextureRenderer::Update(const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY)
 {
+    MIRAGE_PROFILE_ZONE("TextureRenderer::Update");
     glBindTexture(GL_TEXTURE_2D, mRenderingObjects->tex);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, pDimensionX, pDimensionY, 0, GL_RGBA, GL_UNSIGNED_BYTE, pColorBuffer);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_NEAREST);
 }
 
-void TextureRenderer::WriteToFile(Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY)
+void TextureRenderer::WriteToFile(const std::string& pPath, const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY)
 {
-    std::ofstream outs("C:/users/flora/dev/mirage/mirage/ref.ppm");
-    outs << "P3\n" << pDimensionX << ' ' << pDimensionY << "\n255\n";
-    for (int y = 0; y < pDimensionY; ++y)
-    {
-        for (int x = 0; x < pDimensionX; ++x)
-        {
-            int idx = x + y * pDimensionX;
-            Vector4<uint8_t> c = pColorBuffer[idx];
-            outs << (int)c.x << ' ' << (int)c.y << ' ' << (int)c.z << '\n';
-        }
-    }
+    mImageWriter.Write(pPath, pColorBuffer, pDimensionX, pDimensionY);
 }
 
 void TextureRenderer::Render()
 {
+    MIRAGE_PROFILE_ZONE("TextureRenderer::Render");
     if (glfwWindowShouldClose(mWindow.mWindowPtr))
     {
         mWindowShouldClose = true;
@@ -1,28 +1,36 @@
 #ifndef MIRAGE_TEXTURE_RENDERER_HPP
 #define MIRAGE_TEXTURE_RENDERER_HPP
+#include <string>
+
+#include "image_io.hpp"
+#include "presenter.hpp"
 #include "vecmath.hpp"
 #include "window.hpp"
 
 namespace mirage
 {
 
-class TextureRenderer
+class TextureRenderer : public Presenter
 {
 public:
     
     TextureRenderer(WindowMode pWindowMode, unsigned pResX, unsigned pResY);
     ~TextureRenderer();
-    void Update(Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY);
-    void WriteToFile(Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY);
-    void Render();
+    void Update(const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY) override;
+    // Queues the color buffer to be written to pPath. The format follows the
+    // file extension (.ppm, .pam, .qoi, .png). Encoding runs on a background
+    // thread that owns a copy of the frame, so this returns immediately.
+    void WriteToFile(const std::string& pPath, const Vector4<uint8_t>* pColorBuffer, unsigned pDimensionX, unsigned pDimensionY);
+    void Render() override;
 
-    bool ShouldWinodwClose() const { return mWindowShouldClose; }
+    bool ShouldWindowClose() const override { return mWindowShouldClose; }
 
 private:
     
     struct RenderingObjects;
     RenderingObjects* mRenderingObjects;
     Window mWindow;
+    AsyncImageWriter mImageWriter;
     bool mWindowShouldClose;
 };
 
@@ -1,5 +1,6 @@
 #pragma once
 
 //#define MIRAGE_RUN_TESTS
+//#define MIRAGE_RUN_BENCHMARKS
 
 // This is a temporary hack until I compile the code into a DLL.
\ No newline at end of file
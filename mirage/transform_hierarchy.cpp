@@ -0,0 +1,141 @@
+#include "transform_hierarchy.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+#include "check.hpp"
+
+namespace mirage
+{
+
+TransformHierarchy::TransformHierarchy()
+    : mFirstDirty(0)
+    , mRootOrderValid(true)
+{}
+
+void TransformHierarchy::Reserve(std::size_t pCount)
+{
+    mLocal.reserve(pCount);
+    mWorld.reserve(pCount);
+    mParent.reserve(pCount);
+    mDirty.reserve(pCount);
+    mRoot.reserve(pCount);
+}
+
+uint32_t TransformHierarchy::Add(const Matrix44<float>& pLocal, uint32_t pParent)
+{
+    DCHECK(pParent == NoParent || pParent < mLocal.size());
+
+    const uint32_t node = static_cast<uint32_t>(mLocal.size());
+    mLocal.push_back(pLocal);
+    mWorld.push_back(pLocal);
+    mParent.push_back(pParent);
+    mDirty.push_back(1);
+    mRoot.push_back(pParent == NoParent ? node : mRoot[pParent]);
+    mFirstDirty = std::min<std::size_t>(mFirstDirty, node);
+    mRootOrderValid = false;
+    return node;
+}
+
+void TransformHierarchy::SetLocal(uint32_t pNode, const Matrix44<float>& pLocal)
+{
+    DCHECK_LT(pNode, mLocal.size());
+
+    mLocal[pNode] = pLocal;
+    mDirty[pNode] = 1;
+    mFirstDirty = std::min<std::size_t>(mFirstDirty, pNode);
+}
+
+namespace detail
+{
+
+// Updates the nodes pIndex(pBegin) to pIndex(pEnd - 1), parents first.
+template<typename Index>
+std::size_t UpdateWorldMatrices(const Matrix44<float>* pLocal, Matrix44<float>* pWorld, const uint32_t* pParent,
+    uint8_t* pDirty, std::size_t pBegin, std::size_t pEnd, const Index& pIndex)
+{
+    std::size_t updated = 0;
+    for (std::size_t k = pBegin; k < pEnd; ++k)
+    {
+        const uint32_t i = pIndex(k);
+        const uint32_t parent = pParent[i];
+        // The parent comes first, so its flag already includes its ancestors.
+        if (parent != TransformHierarchy::NoParent)
+            pDirty[i] |= pDirty[parent];
+        if (!pDirty[i])
+            continue;
+        pWorld[i] = parent == TransformHierarchy::NoParent ? pLocal[i] : pWorld[parent] * pLocal[i];
+        updated++;
+    }
+    return updated;
+}
+
+} // namespace detail
+
+void TransformHierarchy::BuildRootOrder()
+{
+    // Counting sort by root. Stable, so parents stay ahead of their children.
+    const std::size_t n = mLocal.size();
+    std::vector<uint32_t> slot(n, 0);
+    mRootBegin.clear();
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (mParent[i] == NoParent)
+        {
+            slot[i] = static_cast<uint32_t>(mRootBegin.size());
+            mRootBegin.push_back(0);
+        }
+        mRootBegin[slot[mRoot[i]]]++;
+    }
+
+    std::size_t begin = 0;
+    for (std::size_t& b : mRootBegin)
+    {
+        const std::size_t count = b;
+        b = begin;
+        begin += count;
+    }
+    mRootBegin.push_back(n);
+
+    std::vector<std::size_t> next(mRootBegin.begin(), mRootBegin.end() - 1);
+    mRootOrder.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+        mRootOrder[next[slot[mRoot[i]]]++] = static_cast<uint32_t>(i);
+    mRootOrderValid = true;
+}
+
+std::size_t TransformHierarchy::UpdateWorld(Execution pExecution)
+{
+    const std::size_t n = mLocal.size();
+    if (mFirstDirty >= n)
+        return 0;
+
+    std::size_t updated = 0;
+    if (pExecution == Execution::PARALLEL && n >= ParallelThreshold)
+    {
+        if (!mRootOrderValid)
+            BuildRootOrder();
+
+        // Each range of roots owns a contiguous range of mRootOrder, and
+        // no node outside of it reads or writes its nodes.
+        std::atomic<std::size_t> total(0);
+        ParallelFor(mRootBegin.size() - 1, 1, [&](std::size_t pBegin, std::size_t pEnd)
+        {
+            const uint32_t* order = mRootOrder.data();
+            total += detail::UpdateWorldMatrices(mLocal.data(), mWorld.data(), mParent.data(), mDirty.data(),
+                mRootBegin[pBegin], mRootBegin[pEnd], [order](std::size_t k) { return order[k]; });
+        });
+        updated = total;
+    }
+    else
+    {
+        updated = detail::UpdateWorldMatrices(mLocal.data(), mWorld.data(), mParent.data(), mDirty.data(),
+            mFirstDirty, n, [](std::size_t k) { return static_cast<uint32_t>(k); });
+    }
+
+    std::fill(mDirty.begin() + mFirstDirty, mDirty.end(), 0);
+    mFirstDirty = n;
+    return updated;
+}
+
+} // namespace mirage
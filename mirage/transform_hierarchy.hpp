@@ -0,0 +1,79 @@
+#ifndef MIRAGE_TRANSFORM_HIERARCHY_HPP
+#define MIRAGE_TRANSFORM_HIERARCHY_HPP
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "parallel.hpp"
+#include "vecmath.hpp"
+
+namespace mirage
+{
+
+// Scene graph transforms in flat arrays. A node is added after its parent,
+// so parents always have lower indices than their children and one pass in
+// index order sees every parent before its children. Changing a local
+// transform only marks the node dirty. UpdateWorld() then recomputes the
+// world matrices of dirty nodes and their descendants, and nothing else.
+//
+//   const uint32_t car = hierarchy.Add(car_local);
+//   const uint32_t wheel = hierarchy.Add(wheel_local, car);
+//   hierarchy.SetLocal(car, moved);
+//   hierarchy.UpdateWorld();
+//   Draw(hierarchy.GetWorld(wheel));
+class TransformHierarchy
+{
+public:
+
+    static constexpr uint32_t NoParent = ~0u;
+
+    // Below this many nodes, Execution::PARALLEL updates on the calling thread.
+    static constexpr std::size_t ParallelThreshold = 1 << 14;
+
+    TransformHierarchy();
+
+    void Reserve(std::size_t pCount);
+
+    // Returns the index of the new node. pParent must be an existing node or
+    // NoParent for a root. The node starts dirty.
+    uint32_t Add(const Matrix44<float>& pLocal, uint32_t pParent = NoParent);
+
+    void SetLocal(uint32_t pNode, const Matrix44<float>& pLocal);
+    const Matrix44<float>& GetLocal(uint32_t pNode) const { return mLocal[pNode]; }
+
+    // Parent world * local, as of the last UpdateWorld().
+    const Matrix44<float>& GetWorld(uint32_t pNode) const { return mWorld[pNode]; }
+
+    uint32_t GetParent(uint32_t pNode) const { return mParent[pNode]; }
+    std::size_t GetNodeCount() const { return mLocal.size(); }
+
+    // Recomputes the world matrices of dirty subtrees and returns how many
+    // were recomputed. With Execution::PARALLEL, trees under different roots
+    // are updated on different threads.
+    std::size_t UpdateWorld(Execution pExecution = Execution::SERIAL);
+
+private:
+
+    // Groups the nodes by root for the parallel update.
+    void BuildRootOrder();
+
+    std::vector<Matrix44<float>> mLocal;
+    std::vector<Matrix44<float>> mWorld;
+    std::vector<uint32_t> mParent;
+    // Nonzero for nodes whose local transform changed. The update also sets
+    // it on their descendants while it runs, and clears it.
+    std::vector<uint8_t> mDirty;
+    // No node below this index is dirty.
+    std::size_t mFirstDirty;
+
+    // Every root followed by its descendants, in index order, and where the
+    // nodes of each root begin in it. Rebuilt after nodes were added.
+    std::vector<uint32_t> mRoot;
+    std::vector<uint32_t> mRootOrder;
+    std::vector<std::size_t> mRootBegin;
+    bool mRootOrderValid;
+};
+
+} // namespace mirage
+
+#endif
@@ -0,0 +1,60 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "tmp_runtests_macro.hpp"
+
+#ifdef MIRAGE_RUN_BENCHMARKS
+
+#include "transform_hierarchy.hpp"
+
+// 1000 objects of 16 nodes each: a root and a chain of children.
+static mirage::TransformHierarchy MakeTestHierarchy()
+{
+    mirage::TransformHierarchy h;
+    mirage::Matrix44<float> local(1.f);
+    local.d[3] = 0.5f;
+    for (int object = 0; object < 1000; ++object)
+    {
+        uint32_t parent = h.Add(local);
+        for (int i = 1; i < 16; ++i)
+            parent = h.Add(local, parent);
+    }
+    h.UpdateWorld();
+    return h;
+}
+
+// Every world matrix recomputed, as without dirty tracking.
+static void BM_TransformHierarchyFullUpdate(benchmark::State& state)
+{
+    using namespace mirage;
+    TransformHierarchy h = MakeTestHierarchy();
+    for (auto _ : state)
+    {
+        for (uint32_t i = 0; i < h.GetNodeCount(); i += 16)
+            h.SetLocal(i, h.GetLocal(i));
+        benchmark::DoNotOptimize(h.UpdateWorld());
+    }
+    state.SetItemsProcessed(state.iterations() * h.GetNodeCount());
+}
+BENCHMARK(BM_TransformHierarchyFullUpdate);
+
+// One object in state.range(0) moves each frame.
+static void BM_TransformHierarchyDirtyUpdate(benchmark::State& state)
+{
+    using namespace mirage;
+    TransformHierarchy h = MakeTestHierarchy();
+    const uint32_t step = static_cast<uint32_t>(16 * state.range(0));
+    uint32_t first = 0;
+    for (auto _ : state)
+    {
+        for (uint32_t i = first; i < h.GetNodeCount(); i += step)
+            h.SetLocal(i, h.GetLocal(i));
+        first = (first + 16) % step;
+        benchmark::DoNotOptimize(h.UpdateWorld());
+    }
+    state.SetItemsProcessed(state.iterations() * h.GetNodeCount());
+}
+BENCHMARK(BM_TransformHierarchyDirtyUpdate)->Arg(10)->Arg(100);
+
+#endif
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "transform_hierarchy.hpp"
+
+static mirage::Matrix44<float> MakeLocal(int i)
+{
+    const float t = 0.1f * i;
+    return mirage::Matrix44<float>(
+        std::cos(t), -std::sin(t), 0.f, 1.f + t,
+        std::sin(t), std::cos(t), 0.f, -0.5f * t,
+        0.f, 0.f, 1.f, 0.25f,
+        0.f, 0.f, 0.f, 1.f);
+}
+
+static mirage::Matrix44<float> ComputeWorld(const mirage::TransformHierarchy& h, uint32_t pNode)
+{
+    const uint32_t parent = h.GetParent(pNode);
+    if (parent == mirage::TransformHierarchy::NoParent)
+        return h.GetLocal(pNode);
+    return ComputeWorld(h, parent) * h.GetLocal(pNode);
+}
+
+static void ExpectWorldMatchesLocals(const mirage::TransformHierarchy& h)
+{
+    for (uint32_t i = 0; i < h.GetNodeCount(); ++i)
+    {
+        const mirage::Matrix44<float> expected = ComputeWorld(h, i);
+        for (int k = 0; k < 16; ++k)
+            ASSERT_EQ(h.GetWorld(i).d[k], expected.d[k]) << i;
+    }
+}
+
+// Several roots, each with a chain and a fan of children, interleaved.
+static mirage::TransformHierarchy MakeHierarchy(int pRoots, int pDepth)
+{
+    mirage::TransformHierarchy h;
+    std::vector<uint32_t> tips;
+    int n = 0;
+    for (int r = 0; r < pRoots; ++r)
+        tips.push_back(h.Add(MakeLocal(n++)));
+    for (int d = 0; d < pDepth; ++d)
+    {
+        for (uint32_t& tip : tips)
+        {
+            h.Add(MakeLocal(n++), tip);
+            tip = h.Add(MakeLocal(n++), tip);
+        }
+    }
+    return h;
+}
+
+TEST(TransformHierarchy, UpdatesOnlyDirtySubtrees)
+{
+    using namespace mirage;
+
+    TransformHierarchy h = MakeHierarchy(3, 4);
+    EXPECT_EQ(h.UpdateWorld(), h.GetNodeCount());
+    ExpectWorldMatchesLocals(h);
+    EXPECT_EQ(h.UpdateWorld(), 0u);
+
+    // A leaf updates alone.
+    const uint32_t leaf = static_cast<uint32_t>(h.GetNodeCount() - 1);
+    h.SetLocal(leaf, MakeLocal(100));
+    EXPECT_EQ(h.UpdateWorld(), 1u);
+    ExpectWorldMatchesLocals(h);
+
+    // A root updates its own tree: itself and two children per level.
+    h.SetLocal(1, MakeLocal(101));
+    EXPECT_EQ(h.UpdateWorld(), 1u + 2u * 4u);
+    ExpectWorldMatchesLocals(h);
+
+    // Nodes added later start dirty.
+    const uint32_t child = h.Add(MakeLocal(102), 2);
+    EXPECT_EQ(h.UpdateWorld(), 1u);
+    EXPECT_EQ(h.GetParent(child), 2u);
+    ExpectWorldMatchesLocals(h);
+}
+
+TEST(TransformHierarchy, ParallelMatchesSerial)
+{
+    using namespace mirage;
+
+    const int roots = 64;
+    const int depth = static_cast<int>(TransformHierarchy::ParallelThreshold / (2 * roots)) + 1;
+    TransformHierarchy serial = MakeHierarchy(roots, depth);
+    TransformHierarchy parallel = MakeHierarchy(roots, depth);
+    ASSERT_GE(parallel.GetNodeCount(), TransformHierarchy::ParallelThreshold);
+
+    EXPECT_EQ(parallel.UpdateWorld(Execution::PARALLEL), serial.UpdateWorld(Execution::SERIAL));
+    for (uint32_t node : { 5u, 700u, 9000u })
+    {
+        serial.SetLocal(node, MakeLocal(node + 1));
+        parallel.SetLocal(node, MakeLocal(node + 1));
+    }
+    EXPECT_EQ(parallel.UpdateWorld(Execution::PARALLEL), serial.UpdateWorld(Execution::SERIAL));
+    ExpectWorldMatchesLocals(parallel);
+    for (uint32_t i = 0; i < serial.GetNodeCount(); ++i)
+    {
+        for (int k = 0; k < 16; ++k)
+            ASSERT_EQ(parallel.GetWorld(i).d[k], serial.GetWorld(i).d[k]);
+    }
+}
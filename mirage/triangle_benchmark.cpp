@@ -0,0 +1,46 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "tmp_runtests_macro.hpp"
+
+#ifdef MIRAGE_RUN_BENCHMARKS
+
+#include "triangle_p0.hpp"
+
+// Number of pixels FormLine visits for an edge, one per step along the major axis.
+static int64_t EdgePixels(mirage::Point2<float> v0, mirage::Point2<float> v1, unsigned pResX, unsigned pResY)
+{
+    const float cx = std::abs(v1.x() - v0.x()) * 0.5f * pResX;
+    const float cy = std::abs(v1.y() - v0.y()) * 0.5f * pResY;
+    return static_cast<int64_t>(std::max(cx, cy));
+}
+
+// Argument: edge length of the triangle in pixels.
+static void BM_FormTriangle(benchmark::State& state)
+{
+    using namespace mirage;
+    constexpr unsigned Res = 1024;
+    std::vector<Vector4<uint8_t>> color_buffer(Res * Res, Vector4<uint8_t>(0, 0, 0, 0));
+
+    const float size = 2.f * state.range(0) / Res;
+    const Point2<float> v0(-size * 0.5f, -size * 0.5f);
+    const Point2<float> v1(size * 0.5f, -size * 0.5f);
+    const Point2<float> v2(0.f, size * 0.5f);
+    const Vector3<uint8_t> c0(255, 0, 0), c1(0, 255, 0), c2(0, 0, 255);
+    const int64_t pixels = EdgePixels(v0, v1, Res, Res) + EdgePixels(v1, v2, Res, Res) + EdgePixels(v2, v0, Res, Res);
+
+    for (auto _ : state)
+    {
+        FormTriangle(color_buffer.data(), Res, Res, v0, v1, v2, c0, c1, c2);
+        benchmark::ClobberMemory();
+    }
+
+    state.counters["triangles/s"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+    state.counters["pixels/s"] = benchmark::Counter(static_cast<double>(state.iterations() * pixels), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_FormTriangle)->Arg(4)->Arg(16)->Arg(64)->Arg(256)->Arg(1000);
+
+#endif
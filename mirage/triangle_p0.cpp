@@ -1,4 +1,6 @@
 #include "triangle_p0.hpp"
+#include "profiler.hpp"
+#include "raster_stats.hpp"
 #include "util.hpp"
 
 namespace mirage
@@ -17,6 +19,23 @@ void FormTriangle(
     Point2<float> v0, Point2<float> v1, Point2<float> v2,
     Vector3<uint8_t> pColor0, Vector3<uint8_t> pColor1, Vector3<uint8_t> pColor2)
 {
+    MIRAGE_PROFILE_ZONE("FormTriangle");
+    RasterStats& stats = GetThreadRasterStats();
+    stats.triangles_submitted++;
+
+    const bool offscreen =
+        (v0.x() < -1.f && v1.x() < -1.f && v2.x() < -1.f) || (v0.x() > 1.f && v1.x() > 1.f && v2.x() > 1.f) ||
+        (v0.y() < -1.f && v1.y() < -1.f && v2.y() < -1.f) || (v0.y() > 1.f && v1.y() > 1.f && v2.y() > 1.f);
+    if (offscreen)
+    {
+        stats.triangles_culled[static_cast<int>(CullReason::OFFSCREEN)]++;
+        return;
+    }
+    stats.triangles_rasterized++;
+    const float area = (v1.x() - v0.x()) * (v2.y() - v0.y()) - (v2.x() - v0.x()) * (v1.y() - v0.y());
+    if (area == 0.f)
+        stats.triangles_degenerate++;
+
     FormLine(pColorBuffer, pResolutionX, pResolutionY, v0, v1, pColor0, pColor1);
     FormLine(pColorBuffer, pResolutionX, pResolutionY, v1, v2, pColor1, pColor2);
     FormLine(pColorBuffer, pResolutionX, pResolutionY, v2, v0, pColor2, pColor0);
@@ -33,6 +52,7 @@ static void FormLine(
     Point2<float> v0, Point2<float> v1,
     Vector3<uint8_t> pColor0, Vector3<uint8_t> pColor1)
 {
+    MIRAGE_PROFILE_ZONE("FormLine");
     const float dx = 1.f / pResolutionX;
     const float dy = 1.f / pResolutionY;
     Point2<float> nv0(v0.x() * 0.5f + 0.5f, v0.y() * 0.5f + 0.5f);
@@ -53,16 +73,31 @@ static void FormLine(
         std::max(cx, cy) == cy ? Sign(sdist.y())*dy : sdist.y() / cx
     );
 
+    RasterStats& stats = GetThreadRasterStats();
+    stats.lines_drawn++;
+    stats.pixels_tested += std::max(LoopIterations, 0);
+    const bool overdraw = GetRasterDebugMode() == RasterDebugMode::OVERDRAW;
+
     for (int i = 0; i < LoopIterations; ++i)
     {
         float IdxX = S.x() + i * StepSize.x();
         IdxX *= pResolutionX;
         float IdxY = S.y() + i * StepSize.y();
         IdxY *= pResolutionY;
+
+        // Lines of partially visible triangles leave the viewport.
+        if (IdxX < 0.f || IdxX >= pResolutionX || IdxY < 0.f || IdxY >= pResolutionY)
+            continue;
         int Idx = IdxX + static_cast<int>(IdxY) * pResolutionX;
+        stats.pixels_written++;
 
-        if (Idx > pResolutionX * pResolutionY || Idx < 0)
-            assert(false, "False idx");
+        if (overdraw)
+        {
+            uint8_t& count = pColorBuffer[Idx].x;
+            if (count < 255)
+                count++;
+            continue;
+        }
 
         float a = static_cast<float>(i) / LoopIterations;
         uint8_t colorx = Lerp(pColor0.x, pColor1.x, a);
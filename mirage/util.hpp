@@ -1,7 +1,9 @@
 #ifndef MIRAGE_UTIL_HPP
 #define MIRAGE_UTIL_HPP
 #include <stdio.h>
+#include <cstddef>
 #include <type_traits>
+#include <utility>
 
 namespace mirage
 {
@@ -13,46 +15,87 @@ std::size_t ARRAYSIZE(T(&t)[N])
 }
 
 template<typename T>
-inline typename std::enable_if_t<std::is_integral_v<T>, bool>
-IsZero(T v)
+constexpr typename std::enable_if_t<std::is_integral_v<T>, bool>
+IsZero(T v) noexcept
 {
     return v == 0;
 }
 
 template<typename T>
-inline typename std::enable_if_t<std::is_floating_point_v<T>, bool>
-IsZero(T v)
+constexpr typename std::enable_if_t<std::is_floating_point_v<T>, bool>
+IsZero(T v) noexcept
 {
     constexpr float e = 1e-4;
     return v <= e && v >= -e;
 }
 
 template<typename T>
-inline typename std::enable_if_t<!std::is_floating_point_v<T>, bool>
-IsEqual(T x, T c)
+constexpr typename std::enable_if_t<!std::is_floating_point_v<T>, bool>
+IsEqual(T x, T c) noexcept
 {
     return x == c;
 }
 
 template<typename T>
-inline typename std::enable_if_t<std::is_floating_point_v<T>, bool>
-IsEqual(T x, T c)
+constexpr typename std::enable_if_t<std::is_floating_point_v<T>, bool>
+IsEqual(T x, T c) noexcept
 {
     constexpr float e = 1e-4;
     return x >= c - e && x <= c + e;
 }
 
 template<typename T>
-T Abs(T&& v)
+constexpr T Abs(T v) noexcept
 {
     return v < 0.0 ? -v : v;
 }
 
-inline float Lerp(float low, float high, float val)
+constexpr float Lerp(float low, float high, float val) noexcept
 {
     return low * (1.f - val) + high * val;
 }
 
+// Non-owning view of contiguous elements, a stand-in for C++20 std::span.
+// Converts implicitly from arrays, std::vector and anything else with
+// data() and size(), and from Span<T> to Span<const T>.
+template<typename T>
+class Span
+{
+public:
+
+    Span() : mData(nullptr), mSize(0) {}
+    Span(T* pData, std::size_t pSize) : mData(pData), mSize(pSize) {}
+
+    template<std::size_t N>
+    Span(T(&pArray)[N]) : mData(pArray), mSize(N) {}
+
+    template<typename C, typename = std::enable_if_t<
+        std::is_convertible_v<decltype(std::declval<C&>().data()), T*>>>
+    Span(C&& pContainer) : mData(pContainer.data()), mSize(pContainer.size()) {}
+
+    T* data() const { return mData; }
+    std::size_t size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+
+    T* begin() const { return mData; }
+    T* end() const { return mData + mSize; }
+
+    T& operator[](std::size_t i) const
+    {
+        return mData[i];
+    }
+
+    Span Subspan(std::size_t pOffset, std::size_t pCount) const
+    {
+        return Span(mData + pOffset, pCount);
+    }
+
+private:
+
+    T* mData;
+    std::size_t mSize;
+};
+
 #pragma warning ( push )
 #pragma warning ( disable : 4996 )
 
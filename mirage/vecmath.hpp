@@ -2,87 +2,166 @@
 #define MIRAGE_VECMATH_HPP
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <memory>
+#include <type_traits>
 #include "check.hpp"
 #include "util.hpp"
 
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MIRAGE_VECMATH_SSE
+#endif
+
 namespace mirage
 {
 
-template<typename T>
-struct Vector2
+// Accuracy of Length(), Normalize(), ReciprocalSqrt() and Reciprocal() on
+// float. Other scalar types are always EXACT. Recent x86 cores pipeline sqrt
+// and division well enough that FAST is rarely faster than EXACT, while
+// FASTEST saves about a third of a normalize. Measure before switching.
+enum class Precision
 {
-    Vector2() {}
-    Vector2(T v) : x(v), y(v) {}
-    Vector2(T x, T y) : x(x), y(y) {}
-    Vector2(const Vector2<T>& v) : x(v.x), y(v.y) {}
-    Vector2(Vector2<T>&& v) : x(v.x), y(v.y) {}
-    
-    Vector2& operator=(const Vector2<T>& v)
+    // Correctly rounded sqrt and division.
+    EXACT = 0,
+    // Hardware estimate refined by one Newton-Raphson step. Relative error
+    // below 1e-6 with SSE and 5e-6 without.
+    FAST,
+    // The estimate alone. Relative error below 4e-4 with SSE and 2e-3 without.
+    FASTEST
+};
+
+namespace detail
+{
+
+template<Precision P, typename T>
+constexpr bool UsesEstimate = P != Precision::EXACT && std::is_same_v<T, float>;
+
+inline float ReciprocalSqrtEstimate(float x) noexcept
+{
+#ifdef MIRAGE_VECMATH_SSE
+    return _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+#else
+    // Guess from the exponent bits, refined once to match the precision of
+    // the SSE estimate roughly.
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    bits = 0x5f375a86u - (bits >> 1);
+    float y;
+    std::memcpy(&y, &bits, sizeof(y));
+    return y * (1.5f - 0.5f * x * y * y);
+#endif
+}
+
+inline float ReciprocalEstimate(float x) noexcept
+{
+#ifdef MIRAGE_VECMATH_SSE
+    return _mm_cvtss_f32(_mm_rcp_ss(_mm_set_ss(x)));
+#else
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    bits = 0x7ef311c3u - bits;
+    float y;
+    std::memcpy(&y, &bits, sizeof(y));
+    y = y * (2.f - x * y);
+    return y * (2.f - x * y);
+#endif
+}
+
+} // namespace detail
+
+template<Precision P = Precision::EXACT, typename T>
+T ReciprocalSqrt(T x) noexcept
+{
+    if constexpr (detail::UsesEstimate<P, T>)
+    {
+        const float y = detail::ReciprocalSqrtEstimate(x);
+        if constexpr (P == Precision::FASTEST)
+            return y;
+        else
+            return y * (1.5f - 0.5f * x * y * y);
+    }
+    else
     {
-        x = v.x;
-        y = v.y;
-        return *this;
+        return T(1) / std::sqrt(x);
     }
+}
 
-    Vector2& operator=(Vector2<T>&& v)
+template<Precision P = Precision::EXACT, typename T>
+T Reciprocal(T x) noexcept
+{
+    if constexpr (detail::UsesEstimate<P, T>)
     {
-        x = v.x;
-        y = v.y;
-        return *this;
+        const float y = detail::ReciprocalEstimate(x);
+        if constexpr (P == Precision::FASTEST)
+            return y;
+        else
+            return y * (2.f - x * y);
     }
+    else
+    {
+        return T(1) / x;
+    }
+}
+
+template<typename T>
+struct Vector2
+{
+    Vector2() = default;
+    constexpr Vector2(T v) noexcept : x(v), y(v) {}
+    constexpr Vector2(T x, T y) noexcept : x(x), y(y) {}
 
-    bool operator==(const Vector2<T> V) const
+    constexpr bool operator==(const Vector2<T>& V) const noexcept
     {
-        return  IsEqual(x, V.x) && IsEqual(y, V.y);
+        return IsEqual(x, V.x) && IsEqual(y, V.y);
     }
 
-    bool operator!=(const Vector2<T>& V) const
+    constexpr bool operator!=(const Vector2<T>& V) const noexcept
     {
         return !this->operator==(V);
     }
 
-    T operator[](int i) const
+    constexpr T operator[](int i) const noexcept
     {
         DCHECK_LE(i, 1);
         DCHECK_GE(i, 0);
 
-        if (i == 0) return x;
-        if (i == 1) return y;
+        return i == 0 ? x : y;
     }
 
-    T& operator[](int i)
+    constexpr T& operator[](int i) noexcept
     {
         DCHECK_LE(i, 1);
         DCHECK_GE(i, 0);
 
-        if (i == 0) return x;
-        if (i == 1) return y;
+        return i == 0 ? x : y;
     }
 
     T x, y;
 };
 
 template<typename T>
-Vector2<T> operator+(const Vector2<T> s, const Vector2<T> t)
+constexpr Vector2<T> operator+(const Vector2<T> s, const Vector2<T> t) noexcept
 {
     return Vector2<T>(s.x + t.x, s.y + t.y);
 }
 
 template<typename T>
-Vector2<T> operator-(const Vector2<T> s, const Vector2<T> t)
+constexpr Vector2<T> operator-(const Vector2<T> s, const Vector2<T> t) noexcept
 {
     return Vector2<T>(s.x - t.x, s.y - t.y);
 }
 
 template<typename T>
-Vector2<T> operator*(const Vector2<T> s, const Vector2<T> t)
+constexpr Vector2<T> operator*(const Vector2<T> s, const Vector2<T> t) noexcept
 {
     return Vector2<T>(s.x * t.x, s.y * t.y);
 }
 
 template<typename T>
-Vector2<T>& operator+=(Vector2<T>& s, const Vector2<T>& t)
+constexpr Vector2<T>& operator+=(Vector2<T>& s, const Vector2<T>& t) noexcept
 {
     s.x += t.x;
     s.y += t.y;
@@ -90,7 +169,7 @@ Vector2<T>& operator+=(Vector2<T>& s, const Vector2<T>& t)
 }
 
 template<typename T>
-Vector2<T>& operator-=(Vector2<T>& s, const Vector2<T>& t)
+constexpr Vector2<T>& operator-=(Vector2<T>& s, const Vector2<T>& t) noexcept
 {
     s.x -= t.x;
     s.y -= t.y;
@@ -98,27 +177,27 @@ Vector2<T>& operator-=(Vector2<T>& s, const Vector2<T>& t)
 }
 
 template<typename T>
-Vector2<T>& operator*=(Vector2<T>& s, const Vector2<T>& t)
+constexpr Vector2<T>& operator*=(Vector2<T>& s, const Vector2<T>& t) noexcept
 {
     s.x *= t.x;
     s.y *= t.y;
     return s;
 }
 
-template<typename T, typename S>
-Vector2<T> operator*(Vector2<T> s, const S scalar)
+template<typename T, typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>>
+constexpr Vector2<T> operator*(Vector2<T> s, const S scalar) noexcept
 {
     return Vector2<T>(s.x * scalar, s.y * scalar);
 }
 
-template<typename T, typename S>
-Vector2<T> operator*(const S scalar, const Vector2<T> s)
+template<typename T, typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>>
+constexpr Vector2<T> operator*(const S scalar, const Vector2<T> s) noexcept
 {
     return Vector2<T>(s.x * scalar, s.y * scalar);
 }
 
-template<typename T, typename S>
-Vector2<T>& operator*=(Vector2<T>& s, const S scalar)
+template<typename T, typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>>
+constexpr Vector2<T>& operator*=(Vector2<T>& s, const S scalar) noexcept
 {
     s.x *= scalar;
     s.y *= scalar;
@@ -126,31 +205,42 @@ Vector2<T>& operator*=(Vector2<T>& s, const S scalar)
 }
 
 template<typename T>
-bool IsZero(const Vector2<T>& S)
+constexpr bool IsZero(const Vector2<T>& S) noexcept
 {
     return IsZero(S.x) && IsZero(S.y);
 }
 
-template<typename T>
-T Length(const Vector2<T> s)
+template<Precision P = Precision::EXACT, typename T>
+T Length(const Vector2<T> s) noexcept
 {
-    return std::sqrt(s.x * s.x + s.y * s.y);
+    if constexpr (detail::UsesEstimate<P, T>)
+    {
+        const float d = Dot(s, s);
+        return d > 0.f ? d * ReciprocalSqrt<P>(d) : 0.f;
+    }
+    else
+    {
+        return std::sqrt(s.x * s.x + s.y * s.y);
+    }
 }
 
-template<typename T>
-Vector2<T> Normalize(const Vector2<T> s)
+template<Precision P = Precision::EXACT, typename T>
+Vector2<T> Normalize(const Vector2<T> s) noexcept
 {
-    return s * (1.f / Length(s));
+    if constexpr (detail::UsesEstimate<P, T>)
+        return s * ReciprocalSqrt<P>(Dot(s, s));
+    else
+        return s * (1.f / Length(s));
 }
 
 template<typename T>
-T Dot(const Vector2<T> s, const Vector2<T> t)
+constexpr T Dot(const Vector2<T> s, const Vector2<T> t) noexcept
 {
     return s.x * t.x + s.y * t.y;
 }
 
 template<typename T>
-Vector2<T> Reflect(const Vector2<T> D, const Vector2<T> N)
+constexpr Vector2<T> Reflect(const Vector2<T> D, const Vector2<T> N) noexcept
 {
     // Reflects incident vector v around normal vecotr n.
     // n is expected to be normalized
@@ -160,81 +250,59 @@ Vector2<T> Reflect(const Vector2<T> D, const Vector2<T> N)
 template<typename T>
 struct Vector3
 {
-    Vector3() {}
-    Vector3(T v) : x(v), y(v), z(v) {}
-    Vector3(T x, T y, T z) : x(x), y(y), z(z) {}
-    Vector3(const Vector3<T>& v) : x(v.x), y(v.y), z(v.z) {}
-    Vector3(Vector3<T>&& v) : x(v.x), y(v.y), z(v.z) {}
-
-    Vector3& operator=(const Vector3<T>& v)
-    {
-        x = v.x;
-        y = v.y;
-        z = v.z;
-        return *this;
-    }
+    Vector3() = default;
+    constexpr Vector3(T v) noexcept : x(v), y(v), z(v) {}
+    constexpr Vector3(T x, T y, T z) noexcept : x(x), y(y), z(z) {}
 
-    Vector3& operator=(Vector3<T>&& v)
+    constexpr bool operator==(const Vector3<T>& V) const noexcept
     {
-        x = v.x;
-        y = v.y;
-        z = v.z;
-        return *this;
+        return IsEqual(x, V.x) && IsEqual(y, V.y) && IsEqual(z, V.z);
     }
 
-    bool operator==(const Vector3<T> V) const
-    {
-        return  IsEqual(x, x) && IsEqual(y, V.y) && IsEqual(z, V.z);
-    }
-
-    bool operator!=(const Vector3<T>& V) const
+    constexpr bool operator!=(const Vector3<T>& V) const noexcept
     {
         return !this->operator==(V);
     }
 
-    T operator[](int i) const
+    constexpr T operator[](int i) const noexcept
     {
         DCHECK_LE(i, 2);
         DCHECK_GE(i, 0);
 
-        if (i == 0) return x;
-        else if (i == 1) return y;
-        else if (i == 2) return z;
+        return i == 0 ? x : i == 1 ? y : z;
     }
 
-    T& operator[](int i)
+    constexpr T& operator[](int i) noexcept
     {
         DCHECK_LE(i, 2);
         DCHECK_GE(i, 0);
 
-        if (i == 0) return x;
-        else if (i == 1) return y;
-        else if (i == 2) return z;
+        return i == 0 ? x : i == 1 ? y : z;
     }
 
     T x, y, z;
 };
 
 template<typename T>
-Vector3<T> operator+(const Vector3<T> s, const Vector3<T> t)
+constexpr Vector3<T> operator+(const Vector3<T> s, const Vector3<T> t) noexcept
 {
     return Vector3<T>(s.x + t.x, s.y + t.y, s.z + t.z);
 }
 
 template<typename T>
-Vector3<T> operator-(const Vector3<T> s, const Vector3<T> t)
+constexpr Vector3<T> operator-(const Vector3<T> s, const Vector3<T> t) noexcept
 {
     return Vector3<T>(s.x - t.x, s.y - t.y, s.z - t.z);
 }
 
 template<typename T>
-Vector3<T> operator*(const Vector3<T> s, const Vector3<T> t)
+constexpr Vector3<T> operator*(const Vector3<T> s, const Vector3<T> t) noexcept
 {
     return Vector3<T>(s.x * t.x, s.y * t.y, s.z * t.z);
 }
 
 template<typename T>
-Vector3<T>& operator+=(Vector3<T>& s, const Vector3<T>& t)
+constexpr Vector3<T>& operator+=(Vector3<T>& s, const Vector3<T>& t) noexcept
 {
     s.x += t.x;
     s.y += t.y;
@@ -243,7 +311,7 @@ Vector3<T>& operator+=(Vector3<T>& s, const Vector3<T>& t)
 }
 
 template<typename T>
-Vector3<T>& operator-=(Vector3<T>& s, const Vector3<T>& t)
+constexpr Vector3<T>& operator-=(Vector3<T>& s, const Vector3<T>& t) noexcept
 {
     s.x -= t.x;
     s.y -= t.y;
@@ -252,7 +320,7 @@ Vector3<T>& operator-=(Vector3<T>& s, const Vector3<T>& t)
 }
 
 template<typename T>
-Vector3<T>& operator*=(Vector3<T>& s, const Vector3<T>& t)
+constexpr Vector3<T>& operator*=(Vector3<T>& s, const Vector3<T>& t) noexcept
 {
     s.x *= t.x;
     s.y *= t.y;
@@ -260,20 +328,20 @@ Vector3<T>& operator*=(Vector3<T>& s, const Vector3<T>& t)
     return s;
 }
 
-template<typename T, typename S>
-Vector3<T> operator*(Vector3<T> s, const S scalar)
+template<typename T, typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>>
+constexpr Vector3<T> operator*(Vector3<T> s, const S scalar) noexcept
 {
     return Vector3<T>(s.x * scalar, s.y * scalar, s.z * scalar);
 }
 
-template<typename T, typename S>
-Vector3<T> operator*(const S scalar, const Vector3<T> s)
+template<typename T, typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>>
+constexpr Vector3<T> operator*(const S scalar, const Vector3<T> s) noexcept
 {
     return Vector3<T>(s.x * scalar, s.y * scalar, s.z * scalar);
 }
 
-template<typename T, typename S>
-Vector3<T>& operator*=(Vector3<T>& s, const S scalar)
+template<typename T, typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>>
+constexpr Vector3<T>& operator*=(Vector3<T>& s, const S scalar) noexcept
 {
     s.x *= scalar;
     s.y *= scalar;
@@ -282,31 +350,42 @@ Vector3<T>& operator*=(Vector3<T>& s, const S scalar)
 }
 
 template<typename T>
-bool IsZero(const Vector3<T> S)
+constexpr bool IsZero(const Vector3<T> S) noexcept
 {
     return IsZero(S.x) && IsZero(S.y) && IsZero(S.z);
 }
 
-template<typename T>
-T Length(const Vector3<T> s)
+template<Precision P = Precision::EXACT, typename T>
+T Length(const Vector3<T> s) noexcept
 {
-    return std::sqrt(s.x * s.x + s.y * s.y + s.z * s.z);
+    if constexpr (detail::UsesEstimate<P, T>)
+    {
+        const float d = Dot(s, s);
+        return d > 0.f ? d * ReciprocalSqrt<P>(d) : 0.f;
+    }
+    else
+    {
+        return std::sqrt(s.x * s.x + s.y * s.y + s.z * s.z);
+    }
 }
 
-template<typename T>
-Vector3<T> Normalize(const Vector3<T> s)
+template<Precision P = Precision::EXACT, typename T>
+Vector3<T> Normalize(const Vector3<T> s) noexcept
 {
-    return s * (1.f / Length(s));
+    if constexpr (detail::UsesEstimate<P, T>)
+        return s * ReciprocalSqrt<P>(Dot(s, s));
+    else
+        return s * (1.f / Length(s));
 }
 
 template<typename T>
-T Dot(const Vector3<T> s, const Vector3<T> t)
+constexpr T Dot(const Vector3<T> s, const Vector3<T> t) noexcept
 {
     return s.x * t.x + s.y * t.y + s.z * t.z;
 }
 
 template<typename T>
-Vector3<T> Cross(const Vector3<T> s, const Vector3<T> t)
+constexpr Vector3<T> Cross(const Vector3<T> s, const Vector3<T> t) noexcept
 {
     return Vector3<T>(
         s.y * t.z - s.z * t.y, 
@@ -316,7 +395,7 @@ Vector3<T> Cross(const Vector3<T> s, const Vector3<T> t)
 }
 
 template<typename T>
-Vector3<T> Reflect(const Vector3<T> D, const Vector3<T> N)
+constexpr Vector3<T> Reflect(const Vector3<T> D, const Vector3<T> N) noexcept
 {
     // Reflects incident vector v around normal vecotr n.
     // n is expected to be normalized
@@ -326,85 +405,59 @@ Vector3<T> Reflect(const Vector3<T> D, const Vector3<T> N)
 template<typename T>
 struct Vector4
 {
-    Vector4() {}
-    Vector4(T v) : x(v), y(v), z(v), w(v) {}
-    Vector4(T x, T y, T z, T w) : x(x), y(y), z(z), w(w) {}
-    Vector4(const Vector4<T>& v) : x(v.x), y(v.y), z(v.z), w(v.w) {}
-    Vector4(Vector4<T>&& v) : x(v.x), y(v.y), z(v.z), w(v.w) {}
-
-    Vector4& operator=(const Vector4<T>& v)
-    {
-        x = v.x;
-        y = v.y;
-        z = v.z;
-        w = v.w;
-        return *this;
-    }
-
-    Vector4& operator=(Vector4<T>&& v)
-    {
-        x = v.x;
-        y = v.y;
-        z = v.z;
-        w = v.w;
-        return *this;
-    }
+    Vector4() = default;
+    constexpr Vector4(T v) noexcept : x(v), y(v), z(v), w(v) {}
+    constexpr Vector4(T x, T y, T z, T w) noexcept : x(x), y(y), z(z), w(w) {}
 
-    bool operator==(const Vector4<T> V) const
+    constexpr bool operator==(const Vector4<T>& V) const noexcept
     {
-        return  IsEqual(x, x) && IsEqual(y, V.y) && IsEqual(z, V.z) && IsEqual(w, V.w);
+        return IsEqual(x, V.x) && IsEqual(y, V.y) && IsEqual(z, V.z) && IsEqual(w, V.w);
     }
 
-    bool operator!=(const Vector4<T>& V) const
+    constexpr bool operator!=(const Vector4<T>& V) const noexcept
     {
         return !this->operator==(V);
     }
 
-    T operator[](int i) const
+    constexpr T operator[](int i) const noexcept
     {
         DCHECK_LE(i, 3);
         DCHECK_GE(i, 0);
 
-        if (i == 0) return x;
-        else if (i == 1) return y;
-        else if (i == 2) return z;
-        else if (i == 3) return w;
+        return i == 0 ? x : i == 1 ? y : i == 2 ? z : w;
     }
 
-    T& operator[](int i)
+    constexpr T& operator[](int i) noexcept
     {
         DCHECK_LE(i, 3);
         DCHECK_GE(i, 0);
 
-        if (i == 0) return x;
-        else if (i == 1) return y;
-        else if (i == 2) return z;
-        else if (i == 3) return w;
+        return i == 0 ? x : i == 1 ? y : i == 2 ? z : w;
     }
 
     T x, y, z, w;
 };
 
 template<typename T>
-Vector4<T> operator+(const Vector4<T> s, const Vector4<T> t)
+constexpr Vector4<T> operator+(const Vector4<T> s, const Vector4<T> t) noexcept
 {
     return Vector4<T>(s.x + t.x, s.y + t.y, s.z + t.z, s.w + t.w);
 }
 
 template<typename T>
-Vector4<T> operator-(const Vector4<T> s, const Vector4<T> t)
+constexpr Vector4<T> operator-(const Vector4<T> s, const Vector4<T> t) noexcept
 {
     return Vector4<T>(s.x - t.x, s.y - t.y, s.z - t.z, s.w - t.w);
 }
 
 template<typename T>
-Vector4<T> operator*(const Vector4<T> s, const Vector4<T> t)
+constexpr Vector4<T> operator*(const Vector4<T> s, const Vector4<T> t) noexcept
 {
     return Vector4<T>(s.x * t.x, s.y * t.y, s.z * t.z, s.w * t.w);
 }
 
 template<typename T>
-Vector4<T>& operator+=(Vector4<T>& s, const Vector4<T>& t)
+constexpr Vector4<T>& operator+=(Vector4<T>& s, const Vector4<T>& t) noexcept
 {
     s.x += t.x;
     s.y += t.y;
@@ -414,7 +467,7 @@ Vector4<T>& operator+=(Vector4<T>& s, const Vector4<T>& t)
 }
 
 template<typename T>
-Vector4<T>& operator-=(Vector4<T>& s, const Vector4<T>& t)
+constexpr Vector4<T>& operator-=(Vector4<T>& s, const Vector4<T>& t) noexcept
 {
     s.x -= t.x;
     s.y -= t.y;
@@ -424,7 +477,7 @@ Vector4<T>& operator-=(Vector4<T>& s, const Vector4<T>& t)
 }
 
 template<typename T>
-Vector4<T>& operator*=(Vector4<T>& s, const Vector4<T>& t)
+constexpr Vector4<T>& operator*=(Vector4<T>& s, const Vector4<T>& t) noexcept
 {
     s.x *= t.x;
     s.y *= t.y;
@@ -433,20 +486,20 @@ Vector4<T>& operator*=(Vector4<T>& s, const Vector4<T>& t)
     return s;
 }
 
-template<typename T, typename S>
-Vector4<T> operator*(Vector4<T> s, const S scalar)
+template<typename T, typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>>
+constexpr Vector4<T> operator*(Vector4<T> s, const S scalar) noexcept
 {
     return Vector4<T>(s.x * scalar, s.y * scalar, s.z * scalar, s.w * scalar);
 }
 
-template<typename T, typename S>
-Vector4<T> operator*(const S scalar, const Vector4<T> s)
+template<typename T, typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>>
+constexpr Vector4<T> operator*(const S scalar, const Vector4<T> s) noexcept
 {
     return Vector4<T>(s.x * scalar, s.y * scalar, s.z * scalar, s.w * scalar);
 }
 
-template<typename T, typename S>
-Vector4<T>& operator*=(Vector4<T>& s, const S scalar)
+template<typename T, typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>>
+constexpr Vector4<T>& operator*=(Vector4<T>& s, const S scalar) noexcept
 {
     s.x *= scalar;
     s.y *= scalar;
@@ -456,77 +509,172 @@ Vector4<T>& operator*=(Vector4<T>& s, const S scalar)
 }
 
 template<typename T>
-bool IsZero(const Vector4<T> S)
+constexpr bool IsZero(const Vector4<T> S) noexcept
 {
     return IsZero(S.x) && IsZero(S.y) && IsZero(S.z) && IsZero(S.w);
 }
 
-template<typename T>
-T Length(const Vector4<T> S)
+template<Precision P = Precision::EXACT, typename T>
+T Length(const Vector4<T> S) noexcept
 {
-    return std::sqrt(S.x * S.x + S.y * S.y + S.z * S.z + S.w * S.w);
+    if constexpr (detail::UsesEstimate<P, T>)
+    {
+        const float d = Dot(S, S);
+        return d > 0.f ? d * ReciprocalSqrt<P>(d) : 0.f;
+    }
+    else
+    {
+        return std::sqrt(S.x * S.x + S.y * S.y + S.z * S.z + S.w * S.w);
+    }
 }
 
-template<typename T>
-Vector4<T> Normalize(const Vector4<T> S)
+template<Precision P = Precision::EXACT, typename T>
+Vector4<T> Normalize(const Vector4<T> S) noexcept
 {
-    return S * (1.f / Length(S));
+    if constexpr (detail::UsesEstimate<P, T>)
+        return S * ReciprocalSqrt<P>(Dot(S, S));
+    else
+        return S * (1.f / Length(S));
 }
 
 template<typename T>
-T Dot(const Vector4<T> S, const Vector4<T> U)
+constexpr T Dot(const Vector4<T> S, const Vector4<T> U) noexcept
 {
     return S.x * U.x + S.y * U.y + S.z * U.z + S.w * U.w;
 }
 
-template<typename T>
-struct Matrix33
+#ifdef MIRAGE_VECMATH_SSE
+
+// Vector4<float> fills one SSE register. The storage is 16-byte aligned so
+// that every operation is a single aligned load and store.
+template<>
+struct alignas(16) Vector4<float>
 {
-    Matrix33() {}
-    
-    // Sets the diagonal matrix..
-    Matrix33(T v)
-    {
-        d[0] = v; d[1] = 0; d[2] = 0;
-        d[3] = 0; d[4] = v; d[5] = 0;
-        d[6] = 0; d[7] = 0; d[8] = v;
-    }
+    Vector4() = default;
+    constexpr Vector4(float v) noexcept : x(v), y(v), z(v), w(v) {}
+    constexpr Vector4(float x, float y, float z, float w) noexcept : x(x), y(y), z(z), w(w) {}
+    explicit Vector4(__m128 v) noexcept { Store(v); }
 
-    Matrix33(T aa, T bb, T cc, T dd, T ee, T ff, T gg, T hh, T ii)
+    constexpr bool operator==(const Vector4<float>& V) const noexcept
     {
-        d[0] = aa; d[1] = bb; d[2] = cc;
-        d[3] = dd; d[4] = ee; d[5] = ff;
-        d[6] = gg; d[7] = hh; d[8] = ii;
+        return IsEqual(x, V.x) && IsEqual(y, V.y) && IsEqual(z, V.z) && IsEqual(w, V.w);
     }
 
-    Matrix33(const Matrix33<T>& v)
+    constexpr bool operator!=(const Vector4<float>& V) const noexcept
     {
-        std::memcpy(d, v.d, sizeof(T) * 9);
+        return !this->operator==(V);
     }
 
-    Matrix33(Matrix33<T>&& v)
+    constexpr float operator[](int i) const noexcept
     {
-        std::memcpy(d, v.d, sizeof(T) * 9);
-    }
+        DCHECK_LE(i, 3);
+        DCHECK_GE(i, 0);
 
-    Matrix33<T>& operator=(const Matrix33<T>& v)
-    {
-        std::memcpy(d, v.d, sizeof(T) * 9);
-        return *this;
+        return i == 0 ? x : i == 1 ? y : i == 2 ? z : w;
     }
 
-    Matrix33<T>& operator=(Matrix33<T>&& v)
+    constexpr float& operator[](int i) noexcept
     {
-        std::memcpy(d, v.d, sizeof(T) * 9);
-        return *this;
+        DCHECK_LE(i, 3);
+        DCHECK_GE(i, 0);
+
+        return i == 0 ? x : i == 1 ? y : i == 2 ? z : w;
     }
 
-    void SetEmpty()
+    __m128 Load() const noexcept { return _mm_load_ps(&x); }
+    void Store(__m128 v) noexcept { _mm_store_ps(&x, v); }
+
+    float x, y, z, w;
+};
+
+inline Vector4<float> operator+(const Vector4<float>& s, const Vector4<float>& t) noexcept
+{
+    return Vector4<float>(_mm_add_ps(s.Load(), t.Load()));
+}
+
+inline Vector4<float> operator-(const Vector4<float>& s, const Vector4<float>& t) noexcept
+{
+    return Vector4<float>(_mm_sub_ps(s.Load(), t.Load()));
+}
+
+inline Vector4<float> operator*(const Vector4<float>& s, const Vector4<float>& t) noexcept
+{
+    return Vector4<float>(_mm_mul_ps(s.Load(), t.Load()));
+}
+
+inline Vector4<float>& operator+=(Vector4<float>& s, const Vector4<float>& t) noexcept
+{
+    s.Store(_mm_add_ps(s.Load(), t.Load()));
+    return s;
+}
+
+inline Vector4<float>& operator-=(Vector4<float>& s, const Vector4<float>& t) noexcept
+{
+    s.Store(_mm_sub_ps(s.Load(), t.Load()));
+    return s;
+}
+
+inline Vector4<float>& operator*=(Vector4<float>& s, const Vector4<float>& t) noexcept
+{
+    s.Store(_mm_mul_ps(s.Load(), t.Load()));
+    return s;
+}
+
+inline Vector4<float> operator*(const Vector4<float>& s, const float scalar) noexcept
+{
+    return Vector4<float>(_mm_mul_ps(s.Load(), _mm_set1_ps(scalar)));
+}
+
+inline Vector4<float> operator*(const float scalar, const Vector4<float>& s) noexcept
+{
+    return Vector4<float>(_mm_mul_ps(s.Load(), _mm_set1_ps(scalar)));
+}
+
+inline Vector4<float>& operator*=(Vector4<float>& s, const float scalar) noexcept
+{
+    s.Store(_mm_mul_ps(s.Load(), _mm_set1_ps(scalar)));
+    return s;
+}
+
+inline float Dot(const Vector4<float>& S, const Vector4<float>& U) noexcept
+{
+    const __m128 p = _mm_mul_ps(S.Load(), U.Load());
+    // (p0 + p2) + (p1 + p3)
+    const __m128 s = _mm_add_ps(p, _mm_movehl_ps(p, p));
+    return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1))));
+}
+
+inline float Length(const Vector4<float>& S) noexcept
+{
+    return std::sqrt(Dot(S, S));
+}
+
+#endif
+
+template<typename T>
+struct Matrix33
+{
+    Matrix33() = default;
+
+    // Sets the diagonal matrix..
+    constexpr Matrix33(T v) noexcept
+        : d{ v, 0, 0,
+             0, v, 0,
+             0, 0, v }
+    {}
+
+    constexpr Matrix33(T aa, T bb, T cc, T dd, T ee, T ff, T gg, T hh, T ii) noexcept
+        : d{ aa, bb, cc,
+             dd, ee, ff,
+             gg, hh, ii }
+    {}
+
+    constexpr void SetEmpty() noexcept
     {
         for (int i = 0; i < 9; ++i) d[i] = 0;
     }
 
-    void TransposeInplace()
+    void TransposeInplace() noexcept
     {
         T tmp;
         tmp = d[1]; d[1] = d[3]; d[3] = tmp;
@@ -534,16 +682,16 @@ struct Matrix33
         tmp = d[5]; d[5] = d[7]; d[7] = tmp;
     }
 
-    bool IsZero() const
+    constexpr bool IsZero() const noexcept
     {
         for (int i = 0; i < 9; ++i)
         {
-            if (!IsZero(d[i])) return false;
+            if (!mirage::IsZero(d[i])) return false;
         }
         return true;
     }
 
-    Vector3<T> Col(int i) const
+    constexpr Vector3<T> Col(int i) const noexcept
     {
         DCHECK_LE(i, 2);
         DCHECK_GE(i, 0);
@@ -551,7 +699,7 @@ struct Matrix33
         return Vector3<T>(d[i], d[i + 3], d[i + 6]);
     }
 
-    Vector3<T> Row(int i) const
+    constexpr Vector3<T> Row(int i) const noexcept
     {
         DCHECK_LE(i, 2);
         DCHECK_GE(i, 0);
@@ -559,7 +707,7 @@ struct Matrix33
         return Vector3<T>(d[i * 3], d[i * 3 + 1], d[i * 3 + 2]);
     }
 
-    T Trace() const
+    constexpr T Trace() const noexcept
     {
         return d[0] + d[4] + d[8];
     }
@@ -569,7 +717,7 @@ struct Matrix33
 };
 
 template<typename T>
-Matrix33<T> operator+(const Matrix33<T>& A, const Matrix33<T>& B)
+Matrix33<T> operator+(const Matrix33<T>& A, const Matrix33<T>& B) noexcept
 {
     Matrix33<T> C;
     for (int i = 0; i < 9; ++i)
@@ -578,7 +726,7 @@ Matrix33<T> operator+(const Matrix33<T>& A, const Matrix33<T>& B)
 }
 
 template<typename T>
-Matrix33<T> operator-(const Matrix33<T>& A, const Matrix33<T>& B)
+Matrix33<T> operator-(const Matrix33<T>& A, const Matrix33<T>& B) noexcept
 {
     Matrix33<T> C;
     for (int i = 0; i < 9; ++i)
@@ -587,7 +735,7 @@ Matrix33<T> operator-(const Matrix33<T>& A, const Matrix33<T>& B)
 }
 
 template<typename T>
-Matrix33<T> operator*(const Matrix33<T>& A, const Matrix33<T>& B)
+Matrix33<T> operator*(const Matrix33<T>& A, const Matrix33<T>& B) noexcept
 {
     Matrix33<T> C;
     C.d[0] = A.d[0] * B.d[0] + A.d[1] * B.d[3] + A.d[2] * B.d[6];
@@ -603,7 +751,17 @@ Matrix33<T> operator*(const Matrix33<T>& A, const Matrix33<T>& B)
 }
 
 template<typename T>
-Matrix33<T> operator*(const Matrix33<T>& A, const T s)
+constexpr Vector3<T> operator*(const Matrix33<T>& A, const Vector3<T>& v) noexcept
+{
+    return Vector3<T>(
+        A.d[0] * v.x + A.d[1] * v.y + A.d[2] * v.z,
+        A.d[3] * v.x + A.d[4] * v.y + A.d[5] * v.z,
+        A.d[6] * v.x + A.d[7] * v.y + A.d[8] * v.z
+    );
+}
+
+template<typename T>
+Matrix33<T> operator*(const Matrix33<T>& A, const T s) noexcept
 {
     Matrix33<T> C;
     for (int i = 0; i < 9; ++i)
@@ -612,7 +770,7 @@ Matrix33<T> operator*(const Matrix33<T>& A, const T s)
 }
 
 template<typename T>
-Matrix33<T>& operator*=(Matrix33<T>& A, const T s)
+Matrix33<T>& operator*=(Matrix33<T>& A, const T s) noexcept
 {
     for (int i = 0; i < 9; ++i)
         A.d[i] = A.d[i] * s;
@@ -620,14 +778,14 @@ Matrix33<T>& operator*=(Matrix33<T>& A, const T s)
 }
 
 template<typename T>
-bool IsDiagonalMatrix(const Matrix33<T>& A)
+bool IsDiagonalMatrix(const Matrix33<T>& A) noexcept
 {
     return IsZero(A.d[1]) && IsZero(A.d[2]) && IsZero(A.d[3]) &&
            IsZero(A.d[5]) && IsZero(A.d[6]) && IsZero(A.d[7]);
 }
 
 template<typename T>
-bool IsIdentityMatrix(const Matrix33<T>& A)
+bool IsIdentityMatrix(const Matrix33<T>& A) noexcept
 {
     constexpr T One = 1;
     bool DiagonalIsOne = IsEqual(A.d[0], One) && IsEqual(A.d[4], One) && IsEqual(A.d[8], One);
@@ -636,7 +794,7 @@ bool IsIdentityMatrix(const Matrix33<T>& A)
 }
 
 template<typename T>
-T Det(const Matrix33<T>& A)
+T Det(const Matrix33<T>& A) noexcept
 {
     return
         (A.d[0] * A.d[4] * A.d[8]) +
@@ -648,7 +806,7 @@ T Det(const Matrix33<T>& A)
 }
 
 template<typename T>
-T DetExcludeRowCol(const Matrix33<T>& A, const int row, const int col)
+T DetExcludeRowCol(const Matrix33<T>& A, const int row, const int col) noexcept
 {
     if (row < 0 || row > 2)
         assert(false, "Row index out of bounds!");
@@ -669,7 +827,7 @@ T DetExcludeRowCol(const Matrix33<T>& A, const int row, const int col)
 }
 
 template<typename T>
-Matrix33<T> Transpose(const Matrix33<T>& A)
+Matrix33<T> Transpose(const Matrix33<T>& A) noexcept
 {
     Matrix33<T> R;
     R.d[0] = A.d[0]; R.d[1] = A.d[3]; R.d[2] = A.d[6];
@@ -679,7 +837,7 @@ Matrix33<T> Transpose(const Matrix33<T>& A)
 }
 
 template<typename T>
-Matrix33<T> Inverse(const Matrix33<T>& S)
+Matrix33<T> Inverse(const Matrix33<T>& S) noexcept
 {
     T d = Det(S);
     if (IsZero(d))
@@ -707,52 +865,28 @@ Matrix33<T> Inverse(const Matrix33<T>& S)
 template<typename T>
 struct Matrix44
 {
-    Matrix44() {}
+    Matrix44() = default;
     // Make diagonal matrix.
-    Matrix44(T v)
-    {
-        constexpr T Null = T();
-        d[0] = v;       d[1] = Null;    d[2] = Null;    d[3] = Null;
-        d[4] = Null;    d[5] = v;       d[6] = Null;    d[7] = Null;
-        d[8] = Null;    d[9] = Null;    d[10] = v;      d[11] = Null;
-        d[12] = Null;   d[13] = Null;   d[14] = Null;   d[15] = v;
-    }
-    Matrix44(T v0, T v1, T v2, T v3, T v4, T v5, T v6, T v7, T v8,
-        T v9, T v10, T v11, T v12, T v13, T v14, T v15)
-    {
-        d[0] = v0; d[1] = v1; d[2] = v2; d[3] = v3;
-        d[4] = v4; d[5] = v5; d[6] = v6; d[7] = v7;
-        d[8] = v8; d[9] = v9; d[10] = v10; d[11] = v11;
-        d[12] = v12; d[13] = v13; d[14] = v14; d[15] = v15;
-    }
-    Matrix44(const Matrix44& v)
-    {
-        std::memcpy(d, v.d, sizeof(T) * 16);
-    }
-
-    Matrix44(Matrix44&& v)
-    {
-        std::memcpy(d, v.d, sizeof(T) * 16);
-    }
-
-    Matrix44& operator=(const Matrix44& v)
-    {
-        std::memcpy(d, v.d, sizeof(T) * 16);
-        return *this;
-    }
-
-    Matrix44& operator=(Matrix44&& v)
-    {
-        std::memcpy(d, v.d, sizeof(T) * 16);
-        return *this;
-    }
-
-    void SetEmpty()
+    constexpr Matrix44(T v) noexcept
+        : d{ v,   T(), T(), T(),
+             T(), v,   T(), T(),
+             T(), T(), v,   T(),
+             T(), T(), T(), v }
+    {}
+    constexpr Matrix44(T v0, T v1, T v2, T v3, T v4, T v5, T v6, T v7, T v8,
+        T v9, T v10, T v11, T v12, T v13, T v14, T v15) noexcept
+        : d{ v0,  v1,  v2,  v3,
+             v4,  v5,  v6,  v7,
+             v8,  v9,  v10, v11,
+             v12, v13, v14, v15 }
+    {}
+
+    constexpr void SetEmpty() noexcept
     {
         for (int i = 0; i < 16; ++i) d[i] = 0;
     }
 
-    void TransposeInplace()
+    void TransposeInplace() noexcept
     {
         T tmp;
         tmp = d[1];  d[1]  = d[4];  d[4]  = tmp;
@@ -763,7 +897,7 @@ struct Matrix44
         tmp = d[11]; d[11] = d[14]; d[14] = tmp;
     }
 
-    Vector4<T> Col(int i) const
+    constexpr Vector4<T> Col(int i) const noexcept
     {
         DCHECK_LE(i, 3);
         DCHECK_GE(i, 0);
@@ -771,7 +905,7 @@ struct Matrix44
         return Vector4<T>(d[i], d[i + 4], d[i + 8], d[i + 12]);
     }
 
-    Vector4<T> Row(int i) const
+    constexpr Vector4<T> Row(int i) const noexcept
     {
         DCHECK_LE(i, 3);
         DCHECK_GE(i, 0);
@@ -779,7 +913,7 @@ struct Matrix44
         return Vector4<T>(d[i * 4], d[i * 4 + 1], d[i * 4 + 2], d[i * 4 + 3]);
     }
 
-    T Trace() const
+    constexpr T Trace() const noexcept
     {
         return d[0] + d[5] + d[10] + d[15];
     }
@@ -788,7 +922,7 @@ struct Matrix44
 };
 
 template<typename T>
-Matrix44<T> operator+(const Matrix44<T>& A, const Matrix44<T>& B)
+Matrix44<T> operator+(const Matrix44<T>& A, const Matrix44<T>& B) noexcept
 {
     Matrix44<T> C;
     for (int i = 0; i < 16; ++i)
@@ -797,7 +931,7 @@ Matrix44<T> operator+(const Matrix44<T>& A, const Matrix44<T>& B)
 }
 
 template<typename T>
-Matrix44<T> operator-(const Matrix44<T>& A, const Matrix44<T>& B)
+Matrix44<T> operator-(const Matrix44<T>& A, const Matrix44<T>& B) noexcept
 {
     Matrix44<T> C;
     for (int i = 0; i < 16; ++i)
@@ -806,7 +940,7 @@ Matrix44<T> operator-(const Matrix44<T>& A, const Matrix44<T>& B)
 }
 
 template<typename T>
-Matrix44<T> operator*(const Matrix44<T>& A, const Matrix44<T>& B)
+Matrix44<T> operator*(const Matrix44<T>& A, const Matrix44<T>& B) noexcept
 {
     Matrix44<T> C;
     C.d[0]  = A.d[0]  * B.d[0] + A.d[1]  * B.d[4] + A.d[2]  * B.d[8]  + A.d[3]  * B.d[12];
@@ -829,7 +963,18 @@ Matrix44<T> operator*(const Matrix44<T>& A, const Matrix44<T>& B)
 }
 
 template<typename T>
-bool IsZero(const Matrix44<T>& A)
+constexpr Vector4<T> operator*(const Matrix44<T>& A, const Vector4<T>& v) noexcept
+{
+    return Vector4<T>(
+        A.d[0]  * v.x + A.d[1]  * v.y + A.d[2]  * v.z + A.d[3]  * v.w,
+        A.d[4]  * v.x + A.d[5]  * v.y + A.d[6]  * v.z + A.d[7]  * v.w,
+        A.d[8]  * v.x + A.d[9]  * v.y + A.d[10] * v.z + A.d[11] * v.w,
+        A.d[12] * v.x + A.d[13] * v.y + A.d[14] * v.z + A.d[15] * v.w
+    );
+}
+
+template<typename T>
+bool IsZero(const Matrix44<T>& A) noexcept
 {
     for (int i = 0; i < 16; ++i)
     {
@@ -839,7 +984,7 @@ bool IsZero(const Matrix44<T>& A)
 }
 
 template<typename T>
-bool IsDiagonalMatrix(const Matrix44<T>& A)
+bool IsDiagonalMatrix(const Matrix44<T>& A) noexcept
 {
     return
         IsZero(A.d[1]) && IsZero(A.d[2]) && IsZero(A.d[3]) &&
@@ -849,7 +994,7 @@ bool IsDiagonalMatrix(const Matrix44<T>& A)
 }
 
 template<typename T>
-bool IsIdentityMatrix(const Matrix44<T>& A)
+bool IsIdentityMatrix(const Matrix44<T>& A) noexcept
 {
     constexpr T One = 1;
     bool DiagonalIsOne = IsEqual(A.d[0], One) && IsEqual(A.d[5], One) 
@@ -859,7 +1004,7 @@ bool IsIdentityMatrix(const Matrix44<T>& A)
 }
 
 template<typename T>
-T Det(const Matrix44<T>& A)
+T Det(const Matrix44<T>& A) noexcept
 {
     T D0 = (A.d[5] * A.d[10] * A.d[15]) +
         (A.d[6] * A.d[11] * A.d[13]) +
@@ -893,7 +1038,7 @@ T Det(const Matrix44<T>& A)
 }
 
 template<typename T>
-T DetExcludeRowCol(const Matrix44<T>& A, const int row, const int col)
+T DetExcludeRowCol(const Matrix44<T>& A, const int row, const int col) noexcept
 {
     DCHECK_LE(row, 3);
     DCHECK_GE(row, 0);
@@ -917,7 +1062,7 @@ T DetExcludeRowCol(const Matrix44<T>& A, const int row, const int col)
 }
 
 template<typename T>
-Matrix44<T> Transpose(const Matrix44<T>& A)
+Matrix44<T> Transpose(const Matrix44<T>& A) noexcept
 {
     Matrix44<T> R;
     R.d[0] = A.d[0];  R.d[1] = A.d[4];  R.d[2] = A.d[8];   R.d[3] = A.d[12];
@@ -927,8 +1072,13 @@ Matrix44<T> Transpose(const Matrix44<T>& A)
     return R;
 }
 
+namespace detail
+{
+
+// Writes the inverse of A to pR and returns the determinant of A. A singular
+// A still gets a result, with infinities.
 template<typename T>
-Matrix44<T> InverseMatrix(const Matrix44<T>& A)
+T InvertMatrix(const Matrix44<T>& A, Matrix44<T>* pR) noexcept
 {
     T inv[16];
 
@@ -1044,20 +1194,488 @@ Matrix44<T> InverseMatrix(const Matrix44<T>& A)
         A.d[8] * A.d[1] * A.d[6] -
         A.d[8] * A.d[2] * A.d[5];
 
-    T det = A.d[0] * inv[0] + A.d[1] * inv[4] + A.d[2] * inv[8] + A.d[3] * inv[12];
+    const T det = A.d[0] * inv[0] + A.d[1] * inv[4] + A.d[2] * inv[8] + A.d[3] * inv[12];
+    const T inv_det = 1.0 / det;
+
+    for (int i = 0; i < 16; i++)
+        pR->d[i] = inv[i] * inv_det;
+
+    return det;
+}
+
+// Same for affine A, whose last row is 0, 0, 0, 1: the inverse of the upper
+// 3x3 block, and the translation mapped back through it. About 40
+// multiplies instead of 200.
+template<typename T>
+T InvertAffine(const Matrix44<T>& A, Matrix44<T>* pR) noexcept
+{
+    // Rows of the inverse block are the cross products of the columns of A.
+    const T c0 = A.d[5] * A.d[10] - A.d[6] * A.d[9];
+    const T c4 = A.d[6] * A.d[8] - A.d[4] * A.d[10];
+    const T c8 = A.d[4] * A.d[9] - A.d[5] * A.d[8];
+    const T det = A.d[0] * c0 + A.d[1] * c4 + A.d[2] * c8;
+    const T s = T(1) / det;
+
+    Matrix44<T> R;
+    R.d[0] = c0 * s;
+    R.d[1] = (A.d[2] * A.d[9] - A.d[1] * A.d[10]) * s;
+    R.d[2] = (A.d[1] * A.d[6] - A.d[2] * A.d[5]) * s;
+    R.d[4] = c4 * s;
+    R.d[5] = (A.d[0] * A.d[10] - A.d[2] * A.d[8]) * s;
+    R.d[6] = (A.d[2] * A.d[4] - A.d[0] * A.d[6]) * s;
+    R.d[8] = c8 * s;
+    R.d[9] = (A.d[1] * A.d[8] - A.d[0] * A.d[9]) * s;
+    R.d[10] = (A.d[0] * A.d[5] - A.d[1] * A.d[4]) * s;
+    R.d[3] = -(R.d[0] * A.d[3] + R.d[1] * A.d[7] + R.d[2] * A.d[11]);
+    R.d[7] = -(R.d[4] * A.d[3] + R.d[5] * A.d[7] + R.d[6] * A.d[11]);
+    R.d[11] = -(R.d[8] * A.d[3] + R.d[9] * A.d[7] + R.d[10] * A.d[11]);
+    R.d[12] = 0; R.d[13] = 0; R.d[14] = 0; R.d[15] = 1;
+    *pR = R;
+    return det;
+}
+
+} // namespace detail
 
-    if (det == 0)
+template<typename T>
+Matrix44<T> InverseMatrix(const Matrix44<T>& A) noexcept
+{
+    Matrix44<T> R;
+    if (detail::InvertMatrix(A, &R) == 0)
         assert(false, "Determinant is zero!");
+    return R;
+}
 
-    det = 1.0 / det;
+// Inverse of an affine transform (rotation, scale, shear and translation).
+// The last row of A must be 0, 0, 0, 1.
+template<typename T>
+Matrix44<T> InverseAffine(const Matrix44<T>& A) noexcept
+{
+    Matrix44<T> R;
+    if (detail::InvertAffine(A, &R) == 0)
+        assert(false, "Determinant is zero!");
+    return R;
+}
 
+// Inverse of a rigid transform (rotation and translation only): the
+// transposed rotation and the translation rotated back and negated.
+template<typename T>
+Matrix44<T> InverseRigid(const Matrix44<T>& A) noexcept
+{
     Matrix44<T> R;
-    for (int i = 0; i < 16; i++)
-        R.d[i] = inv[i] * det;
+    R.d[0] = A.d[0]; R.d[1] = A.d[4]; R.d[2] = A.d[8];
+    R.d[4] = A.d[1]; R.d[5] = A.d[5]; R.d[6] = A.d[9];
+    R.d[8] = A.d[2]; R.d[9] = A.d[6]; R.d[10] = A.d[10];
+    R.d[3] = -(R.d[0] * A.d[3] + R.d[1] * A.d[7] + R.d[2] * A.d[11]);
+    R.d[7] = -(R.d[4] * A.d[3] + R.d[5] * A.d[7] + R.d[6] * A.d[11]);
+    R.d[11] = -(R.d[8] * A.d[3] + R.d[9] * A.d[7] + R.d[10] * A.d[11]);
+    R.d[12] = 0; R.d[13] = 0; R.d[14] = 0; R.d[15] = 1;
+    return R;
+}
+
+#ifdef MIRAGE_VECMATH_SSE
+
+// Each row of Matrix44<float> is one aligned SSE register. The operations
+// below produce the same results as the generic templates, bit for bit:
+// every element is computed with the same sequence of operations, just four
+// elements at a time.
+template<>
+struct alignas(16) Matrix44<float>
+{
+    Matrix44() = default;
+    // Make diagonal matrix.
+    constexpr Matrix44(float v) noexcept
+        : d{ v, 0, 0, 0,
+             0, v, 0, 0,
+             0, 0, v, 0,
+             0, 0, 0, v }
+    {}
+    constexpr Matrix44(float v0, float v1, float v2, float v3, float v4, float v5, float v6, float v7, float v8,
+        float v9, float v10, float v11, float v12, float v13, float v14, float v15) noexcept
+        : d{ v0,  v1,  v2,  v3,
+             v4,  v5,  v6,  v7,
+             v8,  v9,  v10, v11,
+             v12, v13, v14, v15 }
+    {}
+
+    void SetEmpty() noexcept
+    {
+        for (int i = 0; i < 4; ++i) StoreRow(i, _mm_setzero_ps());
+    }
+
+    void TransposeInplace() noexcept
+    {
+        __m128 r0 = LoadRow(0), r1 = LoadRow(1), r2 = LoadRow(2), r3 = LoadRow(3);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        StoreRow(0, r0); StoreRow(1, r1); StoreRow(2, r2); StoreRow(3, r3);
+    }
+
+    constexpr Vector4<float> Col(int i) const noexcept
+    {
+        DCHECK_LE(i, 3);
+        DCHECK_GE(i, 0);
 
+        return Vector4<float>(d[i], d[i + 4], d[i + 8], d[i + 12]);
+    }
+
+    Vector4<float> Row(int i) const noexcept
+    {
+        DCHECK_LE(i, 3);
+        DCHECK_GE(i, 0);
+
+        return Vector4<float>(LoadRow(i));
+    }
+
+    constexpr float Trace() const noexcept
+    {
+        return d[0] + d[5] + d[10] + d[15];
+    }
+
+    __m128 LoadRow(int i) const noexcept { return _mm_load_ps(d + i * 4); }
+    void StoreRow(int i, __m128 v) noexcept { _mm_store_ps(d + i * 4, v); }
+
+    float d[16];
+};
+
+inline Matrix44<float> operator+(const Matrix44<float>& A, const Matrix44<float>& B) noexcept
+{
+    Matrix44<float> C;
+    for (int i = 0; i < 4; ++i)
+        C.StoreRow(i, _mm_add_ps(A.LoadRow(i), B.LoadRow(i)));
+    return C;
+}
+
+inline Matrix44<float> operator-(const Matrix44<float>& A, const Matrix44<float>& B) noexcept
+{
+    Matrix44<float> C;
+    for (int i = 0; i < 4; ++i)
+        C.StoreRow(i, _mm_sub_ps(A.LoadRow(i), B.LoadRow(i)));
+    return C;
+}
+
+inline Matrix44<float> operator*(const Matrix44<float>& A, const Matrix44<float>& B) noexcept
+{
+    const __m128 b0 = B.LoadRow(0);
+    const __m128 b1 = B.LoadRow(1);
+    const __m128 b2 = B.LoadRow(2);
+    const __m128 b3 = B.LoadRow(3);
+
+    // Row i of C is the rows of B weighted by row i of A.
+    Matrix44<float> C;
+    for (int i = 0; i < 4; ++i)
+    {
+        const float* a = A.d + i * 4;
+        __m128 r = _mm_mul_ps(_mm_set1_ps(a[0]), b0);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a[1]), b1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a[2]), b2));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a[3]), b3));
+        C.StoreRow(i, r);
+    }
+    return C;
+}
+
+inline Vector4<float> operator*(const Matrix44<float>& A, const Vector4<float>& v) noexcept
+{
+    __m128 c0 = A.LoadRow(0), c1 = A.LoadRow(1), c2 = A.LoadRow(2), c3 = A.LoadRow(3);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    __m128 r = _mm_mul_ps(c0, _mm_set1_ps(v.x));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(v.y)));
+    r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(v.z)));
+    r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_set1_ps(v.w)));
+    return Vector4<float>(r);
+}
+
+inline Matrix44<float> Transpose(const Matrix44<float>& A) noexcept
+{
+    Matrix44<float> R(A);
+    R.TransposeInplace();
     return R;
 }
 
+namespace detail
+{
+
+// One column of the adjugate, built from the three rows that do not hold the
+// column's index. Lane k evaluates the same six products, in the same order,
+// as the generic InverseMatrix does for element 4 * k + column. Lanes whose
+// expression starts with a negative product are flipped by the caller, which
+// is exact because rounding is symmetric.
+inline __m128 AdjugateColumn(__m128 ra, __m128 rb, __m128 rc) noexcept
+{
+    constexpr int L0 = _MM_SHUFFLE(0, 0, 0, 1);
+    constexpr int L1 = _MM_SHUFFLE(1, 1, 2, 2);
+    constexpr int L2 = _MM_SHUFFLE(2, 3, 3, 3);
+
+    const __m128 a0 = _mm_shuffle_ps(ra, ra, L0), a1 = _mm_shuffle_ps(ra, ra, L1), a2 = _mm_shuffle_ps(ra, ra, L2);
+    const __m128 b0 = _mm_shuffle_ps(rb, rb, L0), b1 = _mm_shuffle_ps(rb, rb, L1), b2 = _mm_shuffle_ps(rb, rb, L2);
+    const __m128 c0 = _mm_shuffle_ps(rc, rc, L0), c1 = _mm_shuffle_ps(rc, rc, L1), c2 = _mm_shuffle_ps(rc, rc, L2);
+
+    __m128 r = _mm_mul_ps(_mm_mul_ps(a0, b1), c2);
+    r = _mm_sub_ps(r, _mm_mul_ps(_mm_mul_ps(a0, b2), c1));
+    r = _mm_sub_ps(r, _mm_mul_ps(_mm_mul_ps(b0, a1), c2));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(b0, a2), c1));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(c0, a1), b2));
+    r = _mm_sub_ps(r, _mm_mul_ps(_mm_mul_ps(c0, a2), b1));
+    return r;
+}
+
+inline float InvertMatrix(const Matrix44<float>& A, Matrix44<float>* pR) noexcept
+{
+    const __m128 r0 = A.LoadRow(0);
+    const __m128 r1 = A.LoadRow(1);
+    const __m128 r2 = A.LoadRow(2);
+    const __m128 r3 = A.LoadRow(3);
+
+    const __m128 odd = _mm_castsi128_ps(_mm_setr_epi32(0, 0x80000000, 0, 0x80000000));
+    const __m128 even = _mm_castsi128_ps(_mm_setr_epi32(0x80000000, 0, 0x80000000, 0));
+
+    // Columns of the adjugate: inv[0], inv[4], inv[8], inv[12] and so on.
+    __m128 c0 = _mm_xor_ps(detail::AdjugateColumn(r1, r2, r3), odd);
+    __m128 c1 = _mm_xor_ps(detail::AdjugateColumn(r0, r2, r3), even);
+    __m128 c2 = _mm_xor_ps(detail::AdjugateColumn(r0, r1, r3), odd);
+    __m128 c3 = _mm_xor_ps(detail::AdjugateColumn(r0, r1, r2), even);
+
+    // Summed left to right like the generic version.
+    alignas(16) float p[4];
+    _mm_store_ps(p, _mm_mul_ps(r0, c0));
+    float det = p[0] + p[1] + p[2] + p[3];
+
+    const __m128 inv_det = _mm_set1_ps(static_cast<float>(1.0 / det));
+
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    pR->StoreRow(0, _mm_mul_ps(c0, inv_det));
+    pR->StoreRow(1, _mm_mul_ps(c1, inv_det));
+    pR->StoreRow(2, _mm_mul_ps(c2, inv_det));
+    pR->StoreRow(3, _mm_mul_ps(c3, inv_det));
+    return det;
+}
+
+} // namespace detail
+
+inline Matrix44<float> InverseMatrix(const Matrix44<float>& A) noexcept
+{
+    Matrix44<float> R;
+    if (detail::InvertMatrix(A, &R) == 0)
+        assert(false, "Determinant is zero!");
+    return R;
+}
+
+#endif
+
+// Axis-aligned bounding box. Empty() holds nothing, so extending it by a
+// point gives the box of just that point.
+template<typename T>
+struct AABB
+{
+    AABB() = default;
+    constexpr AABB(const Vector3<T>& pLower, const Vector3<T>& pUpper) noexcept
+        : lower(pLower)
+        , upper(pUpper)
+    {}
+
+    static constexpr AABB Empty() noexcept
+    {
+        constexpr T big = std::numeric_limits<T>::max();
+        return AABB(Vector3<T>(big, big, big), Vector3<T>(-big, -big, -big));
+    }
+
+    constexpr bool IsEmpty() const noexcept
+    {
+        return lower.x > upper.x || lower.y > upper.y || lower.z > upper.z;
+    }
+
+    constexpr void Extend(const Vector3<T>& p) noexcept
+    {
+        lower = Vector3<T>(p.x < lower.x ? p.x : lower.x, p.y < lower.y ? p.y : lower.y, p.z < lower.z ? p.z : lower.z);
+        upper = Vector3<T>(p.x > upper.x ? p.x : upper.x, p.y > upper.y ? p.y : upper.y, p.z > upper.z ? p.z : upper.z);
+    }
+
+    // An empty b leaves the box unchanged.
+    constexpr void Extend(const AABB& b) noexcept
+    {
+        lower = Vector3<T>(b.lower.x < lower.x ? b.lower.x : lower.x, b.lower.y < lower.y ? b.lower.y : lower.y,
+            b.lower.z < lower.z ? b.lower.z : lower.z);
+        upper = Vector3<T>(b.upper.x > upper.x ? b.upper.x : upper.x, b.upper.y > upper.y ? b.upper.y : upper.y,
+            b.upper.z > upper.z ? b.upper.z : upper.z);
+    }
+
+    constexpr Vector3<T> Center() const noexcept { return (lower + upper) * T(0.5); }
+    constexpr Vector3<T> HalfExtents() const noexcept { return (upper - lower) * T(0.5); }
+
+    constexpr T SurfaceArea() const noexcept
+    {
+        const Vector3<T> e = upper - lower;
+        return T(2) * (e.x * e.y + e.y * e.z + e.z * e.x);
+    }
+
+    constexpr bool Contains(const Vector3<T>& p) const noexcept
+    {
+        return p.x >= lower.x && p.x <= upper.x && p.y >= lower.y && p.y <= upper.y && p.z >= lower.z && p.z <= upper.z;
+    }
+
+    constexpr bool Overlaps(const AABB& b) const noexcept
+    {
+        return lower.x <= b.upper.x && upper.x >= b.lower.x && lower.y <= b.upper.y && upper.y >= b.lower.y &&
+            lower.z <= b.upper.z && upper.z >= b.lower.z;
+    }
+
+    constexpr bool operator==(const AABB& b) const noexcept { return lower == b.lower && upper == b.upper; }
+
+    Vector3<T> lower;
+    Vector3<T> upper;
+};
+
+// Box around B transformed by the affine M: the center moves with M, the
+// half extents through the absolute values of its 3x3 block.
+template<typename T>
+AABB<T> Transform(const Matrix44<T>& M, const AABB<T>& B) noexcept
+{
+    const Vector3<T> c = B.Center();
+    const Vector3<T> e = B.HalfExtents();
+    const Vector3<T> center(
+        M.d[0] * c.x + M.d[1] * c.y + M.d[2] * c.z + M.d[3],
+        M.d[4] * c.x + M.d[5] * c.y + M.d[6] * c.z + M.d[7],
+        M.d[8] * c.x + M.d[9] * c.y + M.d[10] * c.z + M.d[11]);
+    const Vector3<T> extent(
+        Abs(M.d[0]) * e.x + Abs(M.d[1]) * e.y + Abs(M.d[2]) * e.z,
+        Abs(M.d[4]) * e.x + Abs(M.d[5]) * e.y + Abs(M.d[6]) * e.z,
+        Abs(M.d[8]) * e.x + Abs(M.d[9]) * e.y + Abs(M.d[10]) * e.z);
+    return AABB<T>(center - extent, center + extent);
+}
+
+// Points p with Dot(normal, p) + d >= 0 are on the inner side.
+template<typename T>
+struct Plane
+{
+    constexpr T Distance(const Vector3<T>& p) const noexcept { return Dot(normal, p) + d; }
+
+    Vector3<T> normal;
+    T d;
+};
+
+// Depth range of clip space: OpenGL maps the near plane to z = -w, D3D and
+// Vulkan to z = 0.
+enum class ClipDepth
+{
+    MINUS_ONE_TO_ONE = 0,
+    ZERO_TO_ONE
+};
+
+enum class FrustumPlane
+{
+    LEFT = 0,
+    RIGHT,
+    BOTTOM,
+    TOP,
+    // Not NEAR and FAR, which windows.h defines as macros.
+    ZNEAR,
+    ZFAR,
+    COUNT
+};
+
+// The six planes of a view frustum, normals pointing inside and of unit
+// length, so Distance() is in world units.
+template<typename T>
+struct Frustum
+{
+    const Plane<T>& operator[](FrustumPlane pPlane) const noexcept { return planes[static_cast<int>(pPlane)]; }
+
+    // Conservative tests: may accept objects near a frustum corner that are
+    // outside, never rejects visible ones.
+    bool IsSphereVisible(const Vector3<T>& pCenter, T pRadius) const noexcept
+    {
+        bool visible = true;
+        for (const Plane<T>& p : planes)
+            visible &= p.Distance(pCenter) + pRadius >= 0;
+        return visible;
+    }
+
+    // The box projected on a plane normal reaches Dot(|normal|, half extents)
+    // from the center.
+    bool IsBoxVisible(const Vector3<T>& pCenter, const Vector3<T>& pHalfExtents) const noexcept
+    {
+        bool visible = true;
+        for (const Plane<T>& p : planes)
+        {
+            const T r = Abs(p.normal.x) * pHalfExtents.x + Abs(p.normal.y) * pHalfExtents.y + Abs(p.normal.z) * pHalfExtents.z;
+            visible &= p.Distance(pCenter) + r >= 0;
+        }
+        return visible;
+    }
+
+    bool IsVisible(const AABB<T>& pBox) const noexcept
+    {
+        return IsBoxVisible(pBox.Center(), pBox.HalfExtents());
+    }
+
+    Plane<T> planes[static_cast<int>(FrustumPlane::COUNT)];
+};
+
+// Planes of the frustum of a view-projection matrix (Gribb and Hartmann):
+// sums and differences of the w row with the x, y and z rows of clip space.
+// With a projection matrix alone the planes are in view space, with
+// projection * view in world space.
+template<typename T>
+Frustum<T> ExtractFrustum(const Matrix44<T>& pViewProjection, ClipDepth pDepth = ClipDepth::MINUS_ONE_TO_ONE) noexcept
+{
+    // Rows of clip space.
+    const T* x = &pViewProjection.d[0];
+    const T* y = &pViewProjection.d[4];
+    const T* z = &pViewProjection.d[8];
+    const T* w = &pViewProjection.d[12];
+
+    const auto normalized = [](T a, T b, T c, T d)
+    {
+        Plane<T> p;
+        p.normal = Vector3<T>(a, b, c);
+        const T scale = T(1) / Length(p.normal);
+        p.normal = p.normal * scale;
+        p.d = d * scale;
+        return p;
+    };
+
+    Frustum<T> f;
+    f.planes[static_cast<int>(FrustumPlane::LEFT)] = normalized(w[0] + x[0], w[1] + x[1], w[2] + x[2], w[3] + x[3]);
+    f.planes[static_cast<int>(FrustumPlane::RIGHT)] = normalized(w[0] - x[0], w[1] - x[1], w[2] - x[2], w[3] - x[3]);
+    f.planes[static_cast<int>(FrustumPlane::BOTTOM)] = normalized(w[0] + y[0], w[1] + y[1], w[2] + y[2], w[3] + y[3]);
+    f.planes[static_cast<int>(FrustumPlane::TOP)] = normalized(w[0] - y[0], w[1] - y[1], w[2] - y[2], w[3] - y[3]);
+    f.planes[static_cast<int>(FrustumPlane::ZNEAR)] = pDepth == ClipDepth::ZERO_TO_ONE
+        ? normalized(z[0], z[1], z[2], z[3])
+        : normalized(w[0] + z[0], w[1] + z[1], w[2] + z[2], w[3] + z[3]);
+    f.planes[static_cast<int>(FrustumPlane::ZFAR)] = normalized(w[0] - z[0], w[1] - z[1], w[2] - z[2], w[3] - z[3]);
+    return f;
+}
+
+// Right-handed perspective projection looking down -z, with the vertical
+// field of view in radians.
+template<typename T>
+Matrix44<T> PerspectiveMatrix(T pFovY, T pAspect, T pNear, T pFar, ClipDepth pDepth = ClipDepth::MINUS_ONE_TO_ONE) noexcept
+{
+    const T f = T(1) / std::tan(pFovY * T(0.5));
+    const T a = pDepth == ClipDepth::ZERO_TO_ONE ? pFar / (pNear - pFar) : (pFar + pNear) / (pNear - pFar);
+    const T b = pDepth == ClipDepth::ZERO_TO_ONE ? pNear * pFar / (pNear - pFar) : T(2) * pFar * pNear / (pNear - pFar);
+    return Matrix44<T>(
+        f / pAspect, T(), T(), T(),
+        T(), f, T(), T(),
+        T(), T(), a, b,
+        T(), T(), T(-1), T());
+}
+
+// View matrix of a camera at pEye looking at pTarget: the camera looks
+// down -z, with y as close to pUp as possible.
+template<typename T>
+Matrix44<T> LookAtMatrix(const Vector3<T>& pEye, const Vector3<T>& pTarget, const Vector3<T>& pUp) noexcept
+{
+    const Vector3<T> z = Normalize(pEye - pTarget);
+    const Vector3<T> x = Normalize(Cross(pUp, z));
+    const Vector3<T> y = Cross(z, x);
+    return Matrix44<T>(
+        x.x, x.y, x.z, -Dot(x, pEye),
+        y.x, y.y, y.z, -Dot(y, pEye),
+        z.x, z.y, z.z, -Dot(z, pEye),
+        T(), T(), T(), T(1));
+}
+
 } // namespace mirage
 
 #endif MIRAGE_VECMATH_HPP
\ No newline at end of file
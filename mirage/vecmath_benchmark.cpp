@@ -0,0 +1,466 @@
+#include <benchmark/benchmark.h>
+
+#include "tmp_runtests_macro.hpp"
+
+#ifdef MIRAGE_RUN_BENCHMARKS
+
+#include <memory>
+#include <vector>
+
+#include "compact_types.hpp"
+#include "vecmath.hpp"
+#include "vecmath_bulk.hpp"
+#include "vecmath_expr.hpp"
+#include "vecmath_wide.hpp"
+
+static mirage::Matrix44<float> MakeTestMatrix()
+{
+    return mirage::Matrix44<float>(7, 1, 9, 7, 2, 5, 1, 6, 9, 6, 1, 2, 6, 3, 5, 5);
+}
+
+static void BM_Matrix44Multiply(benchmark::State& state)
+{
+    using namespace mirage;
+    Matrix44<float> A = MakeTestMatrix();
+    Matrix44<float> B = Transpose(A);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(A);
+        benchmark::DoNotOptimize(B);
+        Matrix44<float> C = A * B;
+        benchmark::DoNotOptimize(C);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Matrix44Multiply);
+
+static void BM_Matrix44Inverse(benchmark::State& state)
+{
+    using namespace mirage;
+    Matrix44<float> A = MakeTestMatrix();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(A);
+        Matrix44<float> R = InverseMatrix(A);
+        benchmark::DoNotOptimize(R);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Matrix44Inverse);
+
+// Rotation about (1, 2, 2) / 3 by 60 degrees, then a translation.
+static mirage::Matrix44<float> MakeTestRigidMatrix()
+{
+    return mirage::Matrix44<float>(
+        0.5555556f, -0.4662392f, 0.6884614f, 3.f,
+        0.6884614f, 0.7222222f, -0.0664529f, -2.f,
+        -0.4662392f, 0.5108974f, 0.7222222f, 5.f,
+        0.f, 0.f, 0.f, 1.f);
+}
+
+static void BM_Matrix44InverseAffine(benchmark::State& state)
+{
+    using namespace mirage;
+    Matrix44<float> A = MakeTestRigidMatrix();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(A);
+        Matrix44<float> R = InverseAffine(A);
+        benchmark::DoNotOptimize(R);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Matrix44InverseAffine);
+
+static void BM_Matrix44InverseRigid(benchmark::State& state)
+{
+    using namespace mirage;
+    Matrix44<float> A = MakeTestRigidMatrix();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(A);
+        Matrix44<float> R = InverseRigid(A);
+        benchmark::DoNotOptimize(R);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Matrix44InverseRigid);
+
+static void BM_Matrix44Det(benchmark::State& state)
+{
+    using namespace mirage;
+    Matrix44<float> A = MakeTestMatrix();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(A);
+        float d = Det(A);
+        benchmark::DoNotOptimize(d);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Matrix44Det);
+
+static void BM_Matrix33Det(benchmark::State& state)
+{
+    using namespace mirage;
+    Matrix33<float> A(1, 9, 5, 9, 9, 4, 6, 2, 7);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(A);
+        float d = Det(A);
+        benchmark::DoNotOptimize(d);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Matrix33Det);
+
+static void BM_Vector3Normalize(benchmark::State& state)
+{
+    using namespace mirage;
+    Vector3<float> v(1.f, 2.f, 3.f);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(v);
+        Vector3<float> n = Normalize(v);
+        benchmark::DoNotOptimize(n);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Vector3Normalize);
+
+static void BM_Vector4Normalize(benchmark::State& state)
+{
+    using namespace mirage;
+    Vector4<float> v(1.f, 2.f, 3.f, 4.f);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(v);
+        Vector4<float> n = Normalize(v);
+        benchmark::DoNotOptimize(n);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Vector4Normalize);
+
+static void BM_Vector3Cross(benchmark::State& state)
+{
+    using namespace mirage;
+    Vector3<float> a(1.f, 2.f, 3.f);
+    Vector3<float> b(-4.f, 5.f, 0.5f);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(a);
+        benchmark::DoNotOptimize(b);
+        Vector3<float> c = Cross(a, b);
+        benchmark::DoNotOptimize(c);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Vector3Cross);
+
+// Normalizes an array of vectors, one at a time or in packets of eight.
+static void BM_Vector3Combine(benchmark::State& state)
+{
+    using namespace mirage;
+    Vector3<float> a(1.f, 2.f, 3.f), b(-1.f, 0.5f, 2.f), c(0.25f, 4.f, -2.f);
+    float s = 0.5f, t = 1.5f;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(a);
+        benchmark::DoNotOptimize(b);
+        Vector3<float> r = a * s + b * t - c;
+        benchmark::DoNotOptimize(r);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Vector3Combine);
+
+static void BM_Vector3CombineLazy(benchmark::State& state)
+{
+    using namespace mirage;
+    Vector3<float> a(1.f, 2.f, 3.f), b(-1.f, 0.5f, 2.f), c(0.25f, 4.f, -2.f);
+    float s = 0.5f, t = 1.5f;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(a);
+        benchmark::DoNotOptimize(b);
+        Vector3<float> r = Lazy(a) * s + Lazy(b) * t - c;
+        benchmark::DoNotOptimize(r);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Vector3CombineLazy);
+
+static void BM_MatrixChainTimesVector(benchmark::State& state)
+{
+    using namespace mirage;
+    Matrix44<float> P = MakeTestMatrix(), V = Transpose(P), M = P;
+    Vector4<float> v(1.f, 2.f, 3.f, 1.f);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(v);
+        Vector4<float> r = P * V * M * v;
+        benchmark::DoNotOptimize(r);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MatrixChainTimesVector);
+
+static void BM_MatrixChainTimesVectorLazy(benchmark::State& state)
+{
+    using namespace mirage;
+    Matrix44<float> P = MakeTestMatrix(), V = Transpose(P), M = P;
+    Vector4<float> v(1.f, 2.f, 3.f, 1.f);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(v);
+        Vector4<float> r = Lazy(P) * V * M * v;
+        benchmark::DoNotOptimize(r);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MatrixChainTimesVectorLazy);
+
+static std::vector<mirage::Vector3<float>> MakeTestVectors(std::size_t pCount)
+{
+    std::vector<mirage::Vector3<float>> v(pCount);
+    for (std::size_t i = 0; i < pCount; ++i)
+        v[i] = mirage::Vector3<float>(1.f + i % 7, 2.f - i % 5, 0.5f + i % 3);
+    return v;
+}
+
+static std::vector<mirage::Vector3<float>> NormalizeTestVectors(std::vector<mirage::Vector3<float>> pVectors)
+{
+    for (auto& v : pVectors)
+        v = mirage::Normalize(v);
+    return pVectors;
+}
+
+static void BM_Vector3NormalizeArray(benchmark::State& state)
+{
+    using namespace mirage;
+    std::vector<Vector3<float>> v = MakeTestVectors(4096);
+    for (auto _ : state)
+    {
+        for (auto& e : v)
+            e = Normalize(e);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * v.size());
+}
+BENCHMARK(BM_Vector3NormalizeArray);
+
+template<mirage::Precision P>
+static void BM_Vector3NormalizeArrayPrecision(benchmark::State& state)
+{
+    using namespace mirage;
+    std::vector<Vector3<float>> v = MakeTestVectors(4096);
+    for (auto _ : state)
+    {
+        for (auto& e : v)
+            e = Normalize<P>(e);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * v.size());
+}
+BENCHMARK_TEMPLATE(BM_Vector3NormalizeArrayPrecision, mirage::Precision::FAST);
+BENCHMARK_TEMPLATE(BM_Vector3NormalizeArrayPrecision, mirage::Precision::FASTEST);
+
+static void BM_Vector3x8NormalizeArray(benchmark::State& state)
+{
+    using namespace mirage;
+    std::vector<Vector3<float>> v = MakeTestVectors(4096);
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < v.size(); i += 8)
+            Normalize(Vector3x8<float>::Load(&v[i])).Store(&v[i]);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * v.size());
+}
+BENCHMARK(BM_Vector3x8NormalizeArray);
+
+template<mirage::Precision P>
+static void BM_Vector3x8NormalizeArrayPrecision(benchmark::State& state)
+{
+    using namespace mirage;
+    std::vector<Vector3<float>> v = MakeTestVectors(4096);
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < v.size(); i += 8)
+            Normalize<P>(Vector3x8<float>::Load(&v[i])).Store(&v[i]);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * v.size());
+}
+BENCHMARK_TEMPLATE(BM_Vector3x8NormalizeArrayPrecision, mirage::Precision::FAST);
+BENCHMARK_TEMPLATE(BM_Vector3x8NormalizeArrayPrecision, mirage::Precision::FASTEST);
+
+static void BM_TransformPointsLoop(benchmark::State& state)
+{
+    using namespace mirage;
+    const Matrix44<float> M = MakeTestMatrix();
+    const std::vector<Vector3<float>> in = MakeTestVectors(state.range(0));
+    std::vector<Vector3<float>> out(in.size());
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < in.size(); ++i)
+        {
+            const Vector4<float> p = M * Vector4<float>(in[i].x, in[i].y, in[i].z, 1.f);
+            out[i] = Vector3<float>(p.x, p.y, p.z);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * in.size());
+}
+BENCHMARK(BM_TransformPointsLoop)->Arg(4096)->Arg(1 << 20);
+
+static void BM_TransformPoints(benchmark::State& state)
+{
+    using namespace mirage;
+    const Matrix44<float> M = MakeTestMatrix();
+    const std::vector<Vector3<float>> in = MakeTestVectors(state.range(0));
+    std::vector<Vector3<float>> out(in.size());
+    const Execution execution = state.range(1) ? Execution::PARALLEL : Execution::SERIAL;
+    for (auto _ : state)
+    {
+        TransformPoints(M, in, out, execution);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * in.size());
+}
+BENCHMARK(BM_TransformPoints)->Args({ 4096, 0 })->Args({ 1 << 20, 0 })->Args({ 1 << 20, 1 })->UseRealTime();
+
+static std::vector<float> MakeTestFloats(std::size_t pCount)
+{
+    std::vector<float> f(pCount);
+    for (std::size_t i = 0; i < pCount; ++i)
+        f[i] = 0.001f * (i % 2000) - 1.f;
+    return f;
+}
+
+static void BM_PackHalfLoop(benchmark::State& state)
+{
+    using namespace mirage;
+    const std::vector<float> in = MakeTestFloats(1 << 16);
+    std::vector<Half> out(in.size());
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < in.size(); ++i)
+            out[i] = Half(in[i]);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * in.size());
+}
+BENCHMARK(BM_PackHalfLoop);
+
+static void BM_PackHalf(benchmark::State& state)
+{
+    using namespace mirage;
+    const std::vector<float> in = MakeTestFloats(1 << 16);
+    std::vector<Half> out(in.size());
+    for (auto _ : state)
+    {
+        Pack(in, out);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * in.size());
+}
+BENCHMARK(BM_PackHalf);
+
+static void BM_UnpackHalfLoop(benchmark::State& state)
+{
+    using namespace mirage;
+    std::vector<Half> in(1 << 16);
+    Pack(MakeTestFloats(in.size()), in);
+    std::vector<float> out(in.size());
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < in.size(); ++i)
+            out[i] = in[i];
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * in.size());
+}
+BENCHMARK(BM_UnpackHalfLoop);
+
+static void BM_UnpackHalf(benchmark::State& state)
+{
+    using namespace mirage;
+    std::vector<Half> in(1 << 16);
+    Pack(MakeTestFloats(in.size()), in);
+    std::vector<float> out(in.size());
+    for (auto _ : state)
+    {
+        Unpack(in, out);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * in.size());
+}
+BENCHMARK(BM_UnpackHalf);
+
+static void BM_UnpackSnorm16(benchmark::State& state)
+{
+    using namespace mirage;
+    std::vector<Snorm16> in(1 << 16);
+    Pack(MakeTestFloats(in.size()), in);
+    std::vector<float> out(in.size());
+    for (auto _ : state)
+    {
+        Unpack(in, out);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * in.size());
+}
+BENCHMARK(BM_UnpackSnorm16);
+
+static void BM_UnpackOctNormalsLoop(benchmark::State& state)
+{
+    using namespace mirage;
+    std::vector<OctNormal16> in(4096);
+    Pack(NormalizeTestVectors(MakeTestVectors(in.size())), in);
+    std::vector<Vector3<float>> out(in.size());
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < in.size(); ++i)
+            out[i] = in[i].Decode();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * in.size());
+}
+BENCHMARK(BM_UnpackOctNormalsLoop);
+
+static void BM_UnpackOctNormals(benchmark::State& state)
+{
+    using namespace mirage;
+    std::vector<OctNormal16> in(4096);
+    Pack(NormalizeTestVectors(MakeTestVectors(in.size())), in);
+    std::vector<Vector3<float>> out(in.size());
+    for (auto _ : state)
+    {
+        Unpack(in, out);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * in.size());
+}
+BENCHMARK(BM_UnpackOctNormals);
+
+static void BM_InverseMatrixArray(benchmark::State& state)
+{
+    using namespace mirage;
+    const std::vector<Matrix44<float>> in(4096, MakeTestRigidMatrix());
+    std::vector<Matrix44<float>> out(in.size());
+    std::unique_ptr<bool[]> invertible(new bool[in.size()]);
+    for (auto _ : state)
+    {
+        if (state.range(0))
+            InverseAffine(in, out, Span<bool>(invertible.get(), in.size()));
+        else
+            InverseMatrix(in, out, Span<bool>(invertible.get(), in.size()));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * in.size());
+}
+BENCHMARK(BM_InverseMatrixArray)->Arg(0)->Arg(1);
+
+#endif
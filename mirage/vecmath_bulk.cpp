@@ -0,0 +1,239 @@
+#include "vecmath_bulk.hpp"
+
+#include "check.hpp"
+#include "vecmath_wide.hpp"
+
+namespace mirage
+{
+
+namespace detail
+{
+
+// Each thread gets at least this many elements, about 50 us of work for the
+// cheapest kernels, so that starting it pays off.
+constexpr std::size_t BulkParallelGrain = 1 << 15;
+
+// Calls pKernel(begin, end) over [0, pCount), split across threads when
+// requested and worthwhile.
+template<typename Kernel>
+void RunBulk(std::size_t pCount, Execution pExecution, const Kernel& pKernel)
+{
+    if (pExecution == Execution::PARALLEL && pCount >= BulkParallelThreshold)
+        ParallelFor(pCount, BulkParallelGrain, pKernel);
+    else
+        pKernel(0, pCount);
+}
+
+// Rows 0 to 2 of a 4x4 matrix broadcast for Vector3x8. Entries 3, 7 and 11
+// are the translation.
+struct Matrix34x8
+{
+    Matrix34x8(const Matrix44<float>& pMatrix)
+    {
+        for (int i = 0; i < 12; ++i) d[i] = Float8(pMatrix.d[i]);
+    }
+
+    Float8 d[12];
+};
+
+// Same sums, in the same order, as the scalar Matrix * Vector operators.
+inline Vector3x8<float> TransformPoint(const Matrix34x8& M, const Vector3x8<float>& p)
+{
+    return Vector3x8<float>(
+        M.d[0] * p.x + M.d[1] * p.y + M.d[2]  * p.z + M.d[3],
+        M.d[4] * p.x + M.d[5] * p.y + M.d[6]  * p.z + M.d[7],
+        M.d[8] * p.x + M.d[9] * p.y + M.d[10] * p.z + M.d[11]
+    );
+}
+
+inline Vector3x8<float> TransformVector(const Matrix34x8& M, const Vector3x8<float>& v)
+{
+    return Vector3x8<float>(
+        M.d[0] * v.x + M.d[1] * v.y + M.d[2]  * v.z,
+        M.d[4] * v.x + M.d[5] * v.y + M.d[6]  * v.z,
+        M.d[8] * v.x + M.d[9] * v.y + M.d[10] * v.z
+    );
+}
+
+inline Vector3<float> TransformPoint(const Matrix44<float>& M, const Vector3<float>& p)
+{
+    return Vector3<float>(
+        M.d[0] * p.x + M.d[1] * p.y + M.d[2]  * p.z + M.d[3],
+        M.d[4] * p.x + M.d[5] * p.y + M.d[6]  * p.z + M.d[7],
+        M.d[8] * p.x + M.d[9] * p.y + M.d[10] * p.z + M.d[11]
+    );
+}
+
+inline Vector3<float> TransformVector(const Matrix44<float>& M, const Vector3<float>& v)
+{
+    return Vector3<float>(
+        M.d[0] * v.x + M.d[1] * v.y + M.d[2]  * v.z,
+        M.d[4] * v.x + M.d[5] * v.y + M.d[6]  * v.z,
+        M.d[8] * v.x + M.d[9] * v.y + M.d[10] * v.z
+    );
+}
+
+} // namespace detail
+
+void TransformPoints(const Matrix44<float>& pMatrix, Span<const Vector3<float>> pIn, Span<Vector3<float>> pOut,
+    Execution pExecution)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+
+    const detail::Matrix34x8 M(pMatrix);
+    detail::RunBulk(pIn.size(), pExecution, [&](std::size_t pBegin, std::size_t pEnd)
+    {
+        std::size_t i = pBegin;
+        for (; i + Float8::Width <= pEnd; i += Float8::Width)
+            detail::TransformPoint(M, Vector3x8<float>::Load(&pIn[i])).Store(&pOut[i]);
+        for (; i < pEnd; ++i)
+            pOut[i] = detail::TransformPoint(pMatrix, pIn[i]);
+    });
+}
+
+void TransformVectors(const Matrix44<float>& pMatrix, Span<const Vector3<float>> pIn, Span<Vector3<float>> pOut,
+    Execution pExecution)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+
+    const detail::Matrix34x8 M(pMatrix);
+    detail::RunBulk(pIn.size(), pExecution, [&](std::size_t pBegin, std::size_t pEnd)
+    {
+        std::size_t i = pBegin;
+        for (; i + Float8::Width <= pEnd; i += Float8::Width)
+            detail::TransformVector(M, Vector3x8<float>::Load(&pIn[i])).Store(&pOut[i]);
+        for (; i < pEnd; ++i)
+            pOut[i] = detail::TransformVector(pMatrix, pIn[i]);
+    });
+}
+
+void TransformVectors(const Matrix33<float>& pMatrix, Span<const Vector3<float>> pIn, Span<Vector3<float>> pOut,
+    Execution pExecution)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+
+    Float8 m[9];
+    for (int k = 0; k < 9; ++k) m[k] = Float8(pMatrix.d[k]);
+
+    detail::RunBulk(pIn.size(), pExecution, [&](std::size_t pBegin, std::size_t pEnd)
+    {
+        std::size_t i = pBegin;
+        for (; i + Float8::Width <= pEnd; i += Float8::Width)
+        {
+            const Vector3x8<float> v = Vector3x8<float>::Load(&pIn[i]);
+            Vector3x8<float>(
+                m[0] * v.x + m[1] * v.y + m[2] * v.z,
+                m[3] * v.x + m[4] * v.y + m[5] * v.z,
+                m[6] * v.x + m[7] * v.y + m[8] * v.z
+            ).Store(&pOut[i]);
+        }
+        for (; i < pEnd; ++i)
+            pOut[i] = pMatrix * pIn[i];
+    });
+}
+
+void NormalizeVectors(Span<const Vector3<float>> pIn, Span<Vector3<float>> pOut, Execution pExecution)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+
+    detail::RunBulk(pIn.size(), pExecution, [&](std::size_t pBegin, std::size_t pEnd)
+    {
+        std::size_t i = pBegin;
+        for (; i + Float8::Width <= pEnd; i += Float8::Width)
+            Normalize(Vector3x8<float>::Load(&pIn[i])).Store(&pOut[i]);
+        for (; i < pEnd; ++i)
+            pOut[i] = Normalize(pIn[i]);
+    });
+}
+
+void DotProducts(Span<const Vector3<float>> pA, Span<const Vector3<float>> pB, Span<float> pOut, Execution pExecution)
+{
+    DCHECK_EQ(pA.size(), pB.size());
+    DCHECK_EQ(pA.size(), pOut.size());
+
+    detail::RunBulk(pA.size(), pExecution, [&](std::size_t pBegin, std::size_t pEnd)
+    {
+        std::size_t i = pBegin;
+        for (; i + Float8::Width <= pEnd; i += Float8::Width)
+            Dot(Vector3x8<float>::Load(&pA[i]), Vector3x8<float>::Load(&pB[i])).Store(&pOut[i]);
+        for (; i < pEnd; ++i)
+            pOut[i] = Dot(pA[i], pB[i]);
+    });
+}
+
+void AosToSoa(Span<const Vector3<float>> pIn, Span<float> pX, Span<float> pY, Span<float> pZ, Execution pExecution)
+{
+    DCHECK_EQ(pIn.size(), pX.size());
+    DCHECK_EQ(pIn.size(), pY.size());
+    DCHECK_EQ(pIn.size(), pZ.size());
+
+    detail::RunBulk(pIn.size(), pExecution, [&](std::size_t pBegin, std::size_t pEnd)
+    {
+        std::size_t i = pBegin;
+        for (; i + Float8::Width <= pEnd; i += Float8::Width)
+        {
+            const Vector3x8<float> v = Vector3x8<float>::Load(&pIn[i]);
+            v.x.Store(&pX[i]);
+            v.y.Store(&pY[i]);
+            v.z.Store(&pZ[i]);
+        }
+        for (; i < pEnd; ++i)
+        {
+            pX[i] = pIn[i].x;
+            pY[i] = pIn[i].y;
+            pZ[i] = pIn[i].z;
+        }
+    });
+}
+
+void SoaToAos(Span<const float> pX, Span<const float> pY, Span<const float> pZ, Span<Vector3<float>> pOut, Execution pExecution)
+{
+    DCHECK_EQ(pOut.size(), pX.size());
+    DCHECK_EQ(pOut.size(), pY.size());
+    DCHECK_EQ(pOut.size(), pZ.size());
+
+    detail::RunBulk(pOut.size(), pExecution, [&](std::size_t pBegin, std::size_t pEnd)
+    {
+        std::size_t i = pBegin;
+        for (; i + Float8::Width <= pEnd; i += Float8::Width)
+            Vector3x8<float>(Float8::Load(&pX[i]), Float8::Load(&pY[i]), Float8::Load(&pZ[i])).Store(&pOut[i]);
+        for (; i < pEnd; ++i)
+            pOut[i] = Vector3<float>(pX[i], pY[i], pZ[i]);
+    });
+}
+
+void InverseMatrix(Span<const Matrix44<float>> pIn, Span<Matrix44<float>> pOut, Span<bool> pInvertible,
+    Execution pExecution)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+    DCHECK_EQ(pIn.size(), pInvertible.size());
+
+    detail::RunBulk(pIn.size(), pExecution, [&](std::size_t pBegin, std::size_t pEnd)
+    {
+        for (std::size_t i = pBegin; i < pEnd; ++i)
+        {
+            pInvertible[i] = detail::InvertMatrix(pIn[i], &pOut[i]) != 0;
+            if (!pInvertible[i])
+                pOut[i].SetEmpty();
+        }
+    });
+}
+
+void InverseAffine(Span<const Matrix44<float>> pIn, Span<Matrix44<float>> pOut, Span<bool> pInvertible,
+    Execution pExecution)
+{
+    DCHECK_EQ(pIn.size(), pOut.size());
+    DCHECK_EQ(pIn.size(), pInvertible.size());
+
+    detail::RunBulk(pIn.size(), pExecution, [&](std::size_t pBegin, std::size_t pEnd)
+    {
+        for (std::size_t i = pBegin; i < pEnd; ++i)
+        {
+            pInvertible[i] = detail::InvertAffine(pIn[i], &pOut[i]) != 0;
+            if (!pInvertible[i])
+                pOut[i].SetEmpty();
+        }
+    });
+}
+
+} // namespace mirage
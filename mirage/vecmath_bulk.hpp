@@ -0,0 +1,57 @@
+#ifndef MIRAGE_VECMATH_BULK_HPP
+#define MIRAGE_VECMATH_BULK_HPP
+#include "parallel.hpp"
+#include "util.hpp"
+#include "vecmath.hpp"
+
+namespace mirage
+{
+
+// Array versions of the vecmath operations, for preprocessing whole meshes.
+// They run eight elements at a time with Float8 and, with Execution::PARALLEL,
+// split inputs of BulkParallelThreshold or more elements across threads.
+// Each element goes through the same operations, in the same order, as with
+// the scalar operators, so results do not depend on the thread count. They
+// match the scalar operators exactly unless the compiler contracts either
+// side into FMAs (e.g. -mfma without -ffp-contract=off), which may change
+// the last bits.
+// Outputs must have the size of the inputs and may alias them exactly.
+
+constexpr std::size_t BulkParallelThreshold = 1 << 16;
+
+// xyz of pMatrix * (p, 1), without perspective divide.
+void TransformPoints(const Matrix44<float>& pMatrix, Span<const Vector3<float>> pIn, Span<Vector3<float>> pOut,
+    Execution pExecution = Execution::SERIAL);
+
+// xyz of pMatrix * (v, 0), the translation is ignored.
+void TransformVectors(const Matrix44<float>& pMatrix, Span<const Vector3<float>> pIn, Span<Vector3<float>> pOut,
+    Execution pExecution = Execution::SERIAL);
+
+void TransformVectors(const Matrix33<float>& pMatrix, Span<const Vector3<float>> pIn, Span<Vector3<float>> pOut,
+    Execution pExecution = Execution::SERIAL);
+
+void NormalizeVectors(Span<const Vector3<float>> pIn, Span<Vector3<float>> pOut,
+    Execution pExecution = Execution::SERIAL);
+
+// pOut[i] = Dot(pA[i], pB[i]).
+void DotProducts(Span<const Vector3<float>> pA, Span<const Vector3<float>> pB, Span<float> pOut,
+    Execution pExecution = Execution::SERIAL);
+
+// Conversion between an array of Vector3 and one array per component.
+void AosToSoa(Span<const Vector3<float>> pIn, Span<float> pX, Span<float> pY, Span<float> pZ,
+    Execution pExecution = Execution::SERIAL);
+void SoaToAos(Span<const float> pX, Span<const float> pY, Span<const float> pZ, Span<Vector3<float>> pOut,
+    Execution pExecution = Execution::SERIAL);
+
+// pOut[i] = InverseMatrix(pIn[i]), or InverseAffine(pIn[i]) for affine
+// matrices, without asserting on singular ones: pInvertible[i] is false for
+// those and pOut[i] is the zero matrix. These go one matrix at a time, eight
+// lanes gained little over transposing the matrices in and out.
+void InverseMatrix(Span<const Matrix44<float>> pIn, Span<Matrix44<float>> pOut, Span<bool> pInvertible,
+    Execution pExecution = Execution::SERIAL);
+void InverseAffine(Span<const Matrix44<float>> pIn, Span<Matrix44<float>> pOut, Span<bool> pInvertible,
+    Execution pExecution = Execution::SERIAL);
+
+} // namespace mirage
+
+#endif
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "vecmath_bulk.hpp"
+
+static std::vector<mirage::Vector3<float>> MakeVectors(std::size_t n, float seed)
+{
+    std::vector<mirage::Vector3<float>> vectors(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const float t = seed + 0.37f * i;
+        vectors[i] = mirage::Vector3<float>(std::sin(t) * 3.f, std::cos(1.3f * t) + 2.f, t * 0.01f - 1.f);
+    }
+    return vectors;
+}
+
+static void ExpectEqual(const mirage::Vector3<float>& a, const mirage::Vector3<float>& b)
+{
+    EXPECT_EQ(a.x, b.x);
+    EXPECT_EQ(a.y, b.y);
+    EXPECT_EQ(a.z, b.z);
+}
+
+// The scalar operators and the kernels may be contracted into FMAs
+// differently, e.g. with -mfma, which changes the last bits.
+static void ExpectNear(float a, float b)
+{
+    EXPECT_NEAR(a, b, 1e-6f * (1.f + std::abs(b)));
+}
+
+static void ExpectNear(const mirage::Vector3<float>& a, const mirage::Vector3<float>& b)
+{
+    ExpectNear(a.x, b.x);
+    ExpectNear(a.y, b.y);
+    ExpectNear(a.z, b.z);
+}
+
+static void ExpectEqual(const mirage::Matrix44<float>& a, const mirage::Matrix44<float>& b)
+{
+    for (int i = 0; i < 16; ++i)
+        EXPECT_EQ(a.d[i], b.d[i]);
+}
+
+TEST(VecmathBulk, TransformsMatchScalar)
+{
+    using namespace mirage;
+
+    const Matrix44<float> M(0.5f, 1.f, -2.f, 3.f, 0.25f, 2.f, 1.5f, -1.f, 1.f, -0.75f, 0.5f, 4.f, 0.f, 0.f, 0.f, 1.f);
+    const Matrix33<float> R(0.f, -1.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 2.f);
+
+    // Not a multiple of the packet width, so the scalar tail runs too.
+    const std::vector<Vector3<float>> in = MakeVectors(1003, 0.5f);
+    std::vector<Vector3<float>> points(in.size()), vectors(in.size()), rotated(in.size());
+    TransformPoints(M, in, points);
+    TransformVectors(M, in, vectors);
+    TransformVectors(R, in, rotated);
+
+    for (std::size_t i = 0; i < in.size(); ++i)
+    {
+        const Vector4<float> p = M * Vector4<float>(in[i].x, in[i].y, in[i].z, 1.f);
+        const Vector4<float> v = M * Vector4<float>(in[i].x, in[i].y, in[i].z, 0.f);
+        ExpectNear(points[i], Vector3<float>(p.x, p.y, p.z));
+        ExpectNear(vectors[i], Vector3<float>(v.x, v.y, v.z));
+        ExpectNear(rotated[i], R * in[i]);
+    }
+}
+
+TEST(VecmathBulk, NormalizeAndDotMatchScalar)
+{
+    using namespace mirage;
+
+    const std::vector<Vector3<float>> a = MakeVectors(61, 1.f);
+    const std::vector<Vector3<float>> b = MakeVectors(61, 7.f);
+    std::vector<Vector3<float>> normalized(a);
+    std::vector<float> dots(a.size());
+
+    // In place.
+    NormalizeVectors(normalized, normalized);
+    DotProducts(a, b, dots);
+
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        ExpectNear(normalized[i], Normalize(a[i]));
+        ExpectNear(dots[i], Dot(a[i], b[i]));
+    }
+}
+
+TEST(VecmathBulk, SoaRoundTrip)
+{
+    using namespace mirage;
+
+    const std::vector<Vector3<float>> in = MakeVectors(29, 2.f);
+    std::vector<float> x(in.size()), y(in.size()), z(in.size());
+    AosToSoa(in, x, y, z);
+    for (std::size_t i = 0; i < in.size(); ++i)
+    {
+        EXPECT_EQ(x[i], in[i].x);
+        EXPECT_EQ(y[i], in[i].y);
+        EXPECT_EQ(z[i], in[i].z);
+    }
+
+    std::vector<Vector3<float>> out(in.size());
+    SoaToAos(x, y, z, out);
+    for (std::size_t i = 0; i < in.size(); ++i)
+        ExpectEqual(out[i], in[i]);
+}
+
+TEST(VecmathBulk, ParallelMatchesSerial)
+{
+    using namespace mirage;
+
+    const Matrix44<float> M(0.5f, 1.f, -2.f, 3.f, 0.25f, 2.f, 1.5f, -1.f, 1.f, -0.75f, 0.5f, 4.f, 0.f, 0.f, 0.f, 1.f);
+    const std::vector<Vector3<float>> in = MakeVectors(BulkParallelThreshold * 3 + 5, 3.f);
+    std::vector<Vector3<float>> serial(in.size()), parallel(in.size());
+    TransformPoints(M, in, serial, Execution::SERIAL);
+    TransformPoints(M, in, parallel, Execution::PARALLEL);
+
+    for (std::size_t i = 0; i < in.size(); ++i)
+        ExpectEqual(parallel[i], serial[i]);
+}
+
+TEST(VecmathBulk, InverseFlagsSingularMatrices)
+{
+    using namespace mirage;
+
+    std::vector<Matrix44<float>> in;
+    for (int i = 0; i < 21; ++i)
+    {
+        const float t = 0.3f * i;
+        in.push_back(Matrix44<float>(std::cos(t), -std::sin(t), 0.f, t, std::sin(t), std::cos(t), 0.f, 1.f,
+            0.f, 0.f, 1.f + i, -t, 0.f, 0.f, 0.f, 1.f));
+    }
+    in[3] = Matrix44<float>(0.f);
+    in[3].d[15] = 1.f;
+    in[10].d[10] = 0.f;
+
+    std::vector<Matrix44<float>> general(in.size()), affine(in.size());
+    std::unique_ptr<bool[]> general_invertible(new bool[in.size()]);
+    std::unique_ptr<bool[]> affine_invertible(new bool[in.size()]);
+    InverseMatrix(in, general, Span<bool>(general_invertible.get(), in.size()));
+    InverseAffine(in, affine, Span<bool>(affine_invertible.get(), in.size()));
+
+    for (std::size_t i = 0; i < in.size(); ++i)
+    {
+        const bool singular = i == 3 || i == 10;
+        EXPECT_EQ(general_invertible[i], !singular);
+        EXPECT_EQ(affine_invertible[i], !singular);
+        if (singular)
+        {
+            EXPECT_TRUE(IsZero(general[i]));
+            EXPECT_TRUE(IsZero(affine[i]));
+            continue;
+        }
+        ExpectEqual(general[i], InverseMatrix(in[i]));
+        ExpectEqual(affine[i], InverseAffine(in[i]));
+        for (int k = 0; k < 16; ++k)
+            EXPECT_NEAR(affine[i].d[k], general[i].d[k], 1e-5f);
+    }
+}
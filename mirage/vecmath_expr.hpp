@@ -0,0 +1,355 @@
+#ifndef MIRAGE_VECMATH_EXPR_HPP
+#define MIRAGE_VECMATH_EXPR_HPP
+#include <type_traits>
+
+#include "vecmath.hpp"
+
+namespace mirage
+{
+
+// Opt-in expression templates for Vector3/Vector4 and Matrix33/Matrix44.
+//
+// An operator with a Lazy() operand builds a tree instead of a vector, and so
+// does every operator applied to that tree. It is evaluated when assigned to
+// a vector, one component at a time and without intermediate vectors:
+//
+//   Vector3<float> p = Lazy(a) * s + Lazy(b) * t - c;
+//
+// Operators between two plain vectors, like b * t above without Lazy(), are
+// still the eager ones from vecmath.hpp.
+//
+// Matrix products stay unevaluated until they meet a vector, which is then
+// pushed through them right to left, so P * V * M * v costs three
+// matrix-vector products instead of two matrix-matrix products and one
+// matrix-vector product:
+//
+//   Vector4<float> clip = Lazy(P) * V * M * v;
+//
+// With optimizations, the fused vector expressions compile to the same code
+// as the eager operators, which the compiler already keeps in registers.
+// Unoptimized builds run them slower, as every node is a call. The
+// reassociated matrix chains are faster in every build.
+//
+// The tree refers to its plain vector and matrix operands, so it must be
+// evaluated within the full expression that created it. Do not keep one in
+// an auto variable.
+
+template<typename E>
+struct VectorExpr;
+
+template<typename E>
+struct MatrixExpr;
+
+namespace detail
+{
+
+template<typename V>
+struct VectorTraits
+{
+    static constexpr bool IsVector = false;
+};
+
+template<typename T>
+struct VectorTraits<Vector3<T>>
+{
+    static constexpr bool IsVector = true;
+    static constexpr int Size = 3;
+    using Scalar = T;
+};
+
+template<typename T>
+struct VectorTraits<Vector4<T>>
+{
+    static constexpr bool IsVector = true;
+    static constexpr int Size = 4;
+    using Scalar = T;
+};
+
+template<typename M>
+struct MatrixTraits
+{
+    static constexpr bool IsMatrix = false;
+};
+
+template<typename T>
+struct MatrixTraits<Matrix33<T>>
+{
+    static constexpr bool IsMatrix = true;
+    using Vector = Vector3<T>;
+};
+
+template<typename T>
+struct MatrixTraits<Matrix44<T>>
+{
+    static constexpr bool IsMatrix = true;
+    using Vector = Vector4<T>;
+};
+
+template<typename E>
+constexpr bool IsVectorExpr = std::is_base_of_v<VectorExpr<E>, E>;
+
+template<typename E>
+constexpr bool IsMatrixExpr = std::is_base_of_v<MatrixExpr<E>, E>;
+
+template<typename V>
+constexpr bool IsVector = VectorTraits<V>::IsVector;
+
+template<typename M>
+constexpr bool IsMatrix = MatrixTraits<M>::IsMatrix;
+
+// A vector operand: an expression, or a plain vector in an expression.
+template<typename L, typename R>
+constexpr bool IsVectorOperation =
+    (IsVectorExpr<L> && (IsVectorExpr<R> || IsVector<R>)) ||
+    (IsVector<L> && IsVectorExpr<R>);
+
+template<typename L, typename R>
+constexpr bool IsMatrixOperation =
+    (IsMatrixExpr<L> && (IsMatrixExpr<R> || IsMatrix<R>)) ||
+    (IsMatrix<L> && IsMatrixExpr<R>);
+
+template<int I, typename T>
+constexpr T Component(const Vector3<T>& v) noexcept
+{
+    if constexpr (I == 0) return v.x;
+    else if constexpr (I == 1) return v.y;
+    else return v.z;
+}
+
+template<int I, typename T>
+constexpr T Component(const Vector4<T>& v) noexcept
+{
+    if constexpr (I == 0) return v.x;
+    else if constexpr (I == 1) return v.y;
+    else if constexpr (I == 2) return v.z;
+    else return v.w;
+}
+
+struct AddOp { template<typename T> static constexpr T Apply(T a, T b) noexcept { return a + b; } };
+struct SubOp { template<typename T> static constexpr T Apply(T a, T b) noexcept { return a - b; } };
+struct MulOp { template<typename T> static constexpr T Apply(T a, T b) noexcept { return a * b; } };
+
+} // namespace detail
+
+template<typename V>
+struct VectorLeaf;
+
+template<typename M>
+struct MatrixLeaf;
+
+namespace detail
+{
+
+template<typename E>
+constexpr const E& AsVectorExpr(const E& e, std::enable_if_t<IsVectorExpr<E>, int> = 0) noexcept { return e; }
+
+template<typename V>
+constexpr VectorLeaf<V> AsVectorExpr(const V& v, std::enable_if_t<IsVector<V>, int> = 0) noexcept { return VectorLeaf<V>(v); }
+
+template<typename E>
+constexpr const E& AsMatrixExpr(const E& e, std::enable_if_t<IsMatrixExpr<E>, int> = 0) noexcept { return e; }
+
+template<typename M>
+constexpr MatrixLeaf<M> AsMatrixExpr(const M& m, std::enable_if_t<IsMatrix<M>, int> = 0) noexcept { return MatrixLeaf<M>(m); }
+
+template<typename E>
+using VectorExprOf = std::decay_t<decltype(AsVectorExpr(std::declval<const E&>()))>;
+
+template<typename E>
+using MatrixExprOf = std::decay_t<decltype(AsMatrixExpr(std::declval<const E&>()))>;
+
+} // namespace detail
+
+// Evaluates a vector expression, one component at a time.
+template<typename E>
+constexpr typename E::Vector Evaluate(const VectorExpr<E>& pExpr) noexcept
+{
+    const E& e = static_cast<const E&>(pExpr);
+    if constexpr (detail::VectorTraits<typename E::Vector>::Size == 3)
+        return typename E::Vector(e.template Get<0>(), e.template Get<1>(), e.template Get<2>());
+    else
+        return typename E::Vector(e.template Get<0>(), e.template Get<1>(), e.template Get<2>(), e.template Get<3>());
+}
+
+// Evaluates a matrix expression with matrix-matrix products.
+template<typename E>
+constexpr typename E::Matrix Evaluate(const MatrixExpr<E>& pExpr) noexcept
+{
+    return static_cast<const E&>(pExpr).Evaluate();
+}
+
+template<typename E>
+struct VectorExpr
+{
+    template<typename V, typename D = E, typename = std::enable_if_t<std::is_same_v<V, typename D::Vector>>>
+    constexpr operator V() const noexcept
+    {
+        return mirage::Evaluate(*this);
+    }
+};
+
+template<typename E>
+struct MatrixExpr
+{
+    template<typename M, typename D = E, typename = std::enable_if_t<std::is_same_v<M, typename D::Matrix>>>
+    constexpr operator M() const noexcept
+    {
+        return mirage::Evaluate(*this);
+    }
+};
+
+template<typename V>
+struct VectorLeaf : VectorExpr<VectorLeaf<V>>
+{
+    using Vector = V;
+
+    explicit constexpr VectorLeaf(const V& v) noexcept : v(v) {}
+
+    template<int I>
+    constexpr typename detail::VectorTraits<V>::Scalar Get() const noexcept { return detail::Component<I>(v); }
+
+    const V& v;
+};
+
+template<typename L, typename R, typename Op>
+struct VectorBinary : VectorExpr<VectorBinary<L, R, Op>>
+{
+    using Vector = typename L::Vector;
+    static_assert(std::is_same_v<Vector, typename R::Vector>, "Operands must have the same vector type.");
+
+    constexpr VectorBinary(const L& l, const R& r) noexcept : l(l), r(r) {}
+
+    template<int I>
+    constexpr auto Get() const noexcept { return Op::Apply(l.template Get<I>(), r.template Get<I>()); }
+
+    L l;
+    R r;
+};
+
+template<typename E>
+struct VectorScale : VectorExpr<VectorScale<E>>
+{
+    using Vector = typename E::Vector;
+    using Scalar = typename detail::VectorTraits<Vector>::Scalar;
+
+    constexpr VectorScale(const E& e, Scalar s) noexcept : e(e), s(s) {}
+
+    template<int I>
+    constexpr Scalar Get() const noexcept { return e.template Get<I>() * s; }
+
+    E e;
+    Scalar s;
+};
+
+template<typename M>
+struct MatrixLeaf : MatrixExpr<MatrixLeaf<M>>
+{
+    using Matrix = M;
+
+    explicit constexpr MatrixLeaf(const M& m) noexcept : m(m) {}
+
+    template<typename V>
+    constexpr V Apply(const V& v) const noexcept { return m * v; }
+
+    constexpr M Evaluate() const noexcept { return m; }
+
+    const M& m;
+};
+
+template<typename L, typename R>
+struct MatrixProduct : MatrixExpr<MatrixProduct<L, R>>
+{
+    using Matrix = typename L::Matrix;
+    static_assert(std::is_same_v<Matrix, typename R::Matrix>, "Operands must have the same matrix type.");
+
+    constexpr MatrixProduct(const L& l, const R& r) noexcept : l(l), r(r) {}
+
+    // (L * R) * v = L * (R * v).
+    template<typename V>
+    constexpr V Apply(const V& v) const noexcept { return l.Apply(r.Apply(v)); }
+
+    constexpr Matrix Evaluate() const noexcept { return l.Evaluate() * r.Evaluate(); }
+
+    L l;
+    R r;
+};
+
+template<typename V, typename = std::enable_if_t<detail::IsVector<V>>>
+constexpr VectorLeaf<V> Lazy(const V& v) noexcept
+{
+    return VectorLeaf<V>(v);
+}
+
+template<typename M, typename = std::enable_if_t<detail::IsMatrix<M>>, typename = void>
+constexpr MatrixLeaf<M> Lazy(const M& m) noexcept
+{
+    return MatrixLeaf<M>(m);
+}
+
+template<typename L, typename R, typename = std::enable_if_t<detail::IsVectorOperation<L, R>>>
+constexpr VectorBinary<detail::VectorExprOf<L>, detail::VectorExprOf<R>, detail::AddOp>
+operator+(const L& l, const R& r) noexcept
+{
+    return { detail::AsVectorExpr(l), detail::AsVectorExpr(r) };
+}
+
+template<typename L, typename R, typename = std::enable_if_t<detail::IsVectorOperation<L, R>>>
+constexpr VectorBinary<detail::VectorExprOf<L>, detail::VectorExprOf<R>, detail::SubOp>
+operator-(const L& l, const R& r) noexcept
+{
+    return { detail::AsVectorExpr(l), detail::AsVectorExpr(r) };
+}
+
+// Component-wise, like Vector3 * Vector3.
+template<typename L, typename R, typename = std::enable_if_t<detail::IsVectorOperation<L, R>>>
+constexpr VectorBinary<detail::VectorExprOf<L>, detail::VectorExprOf<R>, detail::MulOp>
+operator*(const L& l, const R& r) noexcept
+{
+    return { detail::AsVectorExpr(l), detail::AsVectorExpr(r) };
+}
+
+template<typename E, typename = std::enable_if_t<detail::IsVectorExpr<E>>>
+constexpr VectorScale<E> operator*(const VectorExpr<E>& e, typename VectorScale<E>::Scalar s) noexcept
+{
+    return { static_cast<const E&>(e), s };
+}
+
+template<typename E, typename = std::enable_if_t<detail::IsVectorExpr<E>>>
+constexpr VectorScale<E> operator*(typename VectorScale<E>::Scalar s, const VectorExpr<E>& e) noexcept
+{
+    return { static_cast<const E&>(e), s };
+}
+
+template<typename L, typename R, typename = std::enable_if_t<detail::IsVectorOperation<L, R>>>
+constexpr auto Dot(const L& l, const R& r) noexcept
+{
+    const detail::VectorExprOf<L> a = detail::AsVectorExpr(l);
+    const detail::VectorExprOf<R> b = detail::AsVectorExpr(r);
+    auto sum = a.template Get<0>() * b.template Get<0>() + a.template Get<1>() * b.template Get<1>() + a.template Get<2>() * b.template Get<2>();
+    if constexpr (detail::VectorTraits<typename detail::VectorExprOf<L>::Vector>::Size == 4)
+        sum += a.template Get<3>() * b.template Get<3>();
+    return sum;
+}
+
+template<typename L, typename R, typename = std::enable_if_t<detail::IsMatrixOperation<L, R>>>
+constexpr MatrixProduct<detail::MatrixExprOf<L>, detail::MatrixExprOf<R>>
+operator*(const L& l, const R& r) noexcept
+{
+    return { detail::AsMatrixExpr(l), detail::AsMatrixExpr(r) };
+}
+
+// A matrix expression times a vector is evaluated right away, as a chain of
+// matrix-vector products.
+template<typename E, typename V, typename = std::enable_if_t<
+    detail::IsMatrixExpr<E> && (detail::IsVector<V> || detail::IsVectorExpr<V>)>>
+constexpr typename detail::MatrixTraits<typename E::Matrix>::Vector
+operator*(const MatrixExpr<E>& m, const V& v) noexcept
+{
+    using Vector = typename detail::MatrixTraits<typename E::Matrix>::Vector;
+    const Vector x = v;
+    return static_cast<const E&>(m).Apply(x);
+}
+
+} // namespace mirage
+
+#endif
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include "vecmath_expr.hpp"
+
+TEST(VecmathExpr, VectorExpressionsMatchOperators)
+{
+    using namespace mirage;
+
+    const Vector3<float> a(1.f, -2.f, 0.5f);
+    const Vector3<float> b(3.f, 0.25f, -4.f);
+    const Vector3<float> c(-1.f, 8.f, 2.f);
+    const float s = 1.5f;
+    const float t = -0.75f;
+
+    const Vector3<float> fused = Lazy(a) * s + Lazy(b) * t - c;
+    const Vector3<float> plain = a * s + b * t - c;
+    EXPECT_EQ(fused.x, plain.x);
+    EXPECT_EQ(fused.y, plain.y);
+    EXPECT_EQ(fused.z, plain.z);
+
+    Vector3<float> r(0.f);
+    r = 2.f * (Lazy(a) + b) * c;
+    const Vector3<float> expected = 2.f * (a + b) * c;
+    EXPECT_EQ(r.x, expected.x);
+    EXPECT_EQ(r.y, expected.y);
+    EXPECT_EQ(r.z, expected.z);
+
+    EXPECT_EQ(Dot(Lazy(a) - b, c), Dot(a - b, c));
+
+    const Vector4<int> u(1, 2, 3, 4);
+    const Vector4<int> v(-5, 6, 0, 2);
+    const Vector4<int> w = Lazy(u) * 3 - v;
+    EXPECT_TRUE(w == Vector4<int>(8, 0, 9, 10));
+    EXPECT_EQ(Dot(Lazy(u), v), 15);
+
+    static_assert(Evaluate(Lazy(Vector3<int>(1, 2, 3)) + Vector3<int>(1, 1, 1)) == Vector3<int>(2, 3, 4), "");
+}
+
+TEST(VecmathExpr, MatrixChainsAreReassociated)
+{
+    using namespace mirage;
+
+    const Matrix44<double> P(1, 0, 0, 0, 0, 2, 0, 0, 0, 0, -1, -2, 0, 0, -1, 0);
+    const Matrix44<double> V(1, 0, 0, 3, 0, 1, 0, -1, 0, 0, 1, 5, 0, 0, 0, 1);
+    const Matrix44<double> M(0, -1, 0, 0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+    const Vector4<double> v(1, 2, 3, 1);
+
+    const Vector4<double> fused = Lazy(P) * V * M * v;
+    const Vector4<double> plain = P * V * M * v;
+    // Small integers, so both association orders are exact.
+    EXPECT_EQ(fused.x, plain.x);
+    EXPECT_EQ(fused.y, plain.y);
+    EXPECT_EQ(fused.z, plain.z);
+    EXPECT_EQ(fused.w, plain.w);
+
+    const Matrix44<double> PVM = Lazy(P) * V * M;
+    const Matrix44<double> expected = P * V * M;
+    for (int i = 0; i < 16; ++i)
+        EXPECT_EQ(PVM.d[i], expected.d[i]);
+
+    // A vector expression on the right is evaluated first.
+    const Matrix33<float> R(0.f, -1.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f);
+    const Vector3<float> rotated = Lazy(R) * R * (Lazy(Vector3<float>(1.f, 0.f, 0.f)) + Vector3<float>(0.f, 0.f, 2.f));
+    EXPECT_TRUE(rotated == Vector3<float>(-1.f, 0.f, 2.f));
+}
@@ -1,5 +1,11 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+#include "point.hpp"
 #include "vecmath.hpp"
 
 TEST(Vector2, Arithmetic)
@@ -236,6 +242,16 @@ TEST(Vector3, AccessAndMisc)
     EXPECT_EQ(a == b, true);
 }
 
+TEST(Vector3, EqualityComparesEveryComponent)
+{
+    using namespace mirage;
+    // Differ in x only.
+    EXPECT_FALSE(Vector3<float>(1.f, 2.f, 3.f) == Vector3<float>(5.f, 2.f, 3.f));
+    EXPECT_FALSE(Vector4<float>(1.f, 2.f, 3.f, 4.f) == Vector4<float>(5.f, 2.f, 3.f, 4.f));
+    EXPECT_FALSE(Vector4<int>(1, 2, 3, 4) == Vector4<int>(5, 2, 3, 4));
+    EXPECT_TRUE(Vector4<int>(1, 2, 3, 4) != Vector4<int>(5, 2, 3, 4));
+}
+
 //-----------------------------------------------------------------------------------------
 //-----------------------------------------------------------------------------------------
 //-----------------------------------------------------------------------------------------
@@ -828,4 +844,146 @@ TEST(Matrix44, AlgebraicOperations)
     Matrix44<float> ComputedInvOfA = InverseMatrix(A);
     for (int i = 0; i < 16; ++i)
         EXPECT_EQ(ComputedInvOfA.d[i], InvA.d[i]);
-}
\ No newline at end of file
+}
+
+TEST(Matrix44, AffineInverse)
+{
+    using namespace mirage;
+
+    // Rotation about (1, 2, 2) / 3 by 60 degrees, then a translation.
+    const Matrix44<double> Rigid(
+        0.5555555555555557, -0.4662391580785147, 0.6884613803007368, 3,
+        0.6884613803007368, 0.7222222222222223, -0.0664529123725907, -2,
+        -0.4662391580785147, 0.5108973568170350, 0.7222222222222223, 5,
+        0, 0, 0, 1);
+    // Scale and shear on top.
+    const Matrix44<double> Affine = Rigid * Matrix44<double>(2, 0.5, 0, 0, 0, 3, 0, 0, 0, 0, 0.25, 0, 0, 0, 0, 1);
+
+    const Matrix44<double> General = InverseMatrix(Affine);
+    const Matrix44<double> InvAffine = InverseAffine(Affine);
+    const Matrix44<double> InvRigid = InverseRigid(Rigid);
+    const Matrix44<double> InvRigidGeneral = InverseMatrix(Rigid);
+    for (int i = 0; i < 16; ++i)
+    {
+        EXPECT_NEAR(InvAffine.d[i], General.d[i], 1e-12);
+        EXPECT_NEAR(InvRigid.d[i], InvRigidGeneral.d[i], 1e-9);
+    }
+    EXPECT_TRUE(IsIdentityMatrix(InverseAffine(Matrix44<double>(1.0))));
+}
+//-----------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------
+//-----------------------------------------------------------------------------------------
+
+static_assert(std::is_trivially_copyable_v<mirage::Vector2<float>>, "Vector2 must be trivially copyable.");
+static_assert(std::is_trivially_copyable_v<mirage::Vector3<float>>, "Vector3 must be trivially copyable.");
+static_assert(std::is_trivially_copyable_v<mirage::Vector4<float>>, "Vector4 must be trivially copyable.");
+static_assert(std::is_trivially_copyable_v<mirage::Vector4<uint8_t>>, "Vector4 must be trivially copyable.");
+static_assert(std::is_trivially_copyable_v<mirage::Matrix33<float>>, "Matrix33 must be trivially copyable.");
+static_assert(std::is_trivially_copyable_v<mirage::Matrix44<float>>, "Matrix44 must be trivially copyable.");
+static_assert(std::is_trivially_copyable_v<mirage::Matrix44<double>>, "Matrix44 must be trivially copyable.");
+static_assert(std::is_trivially_copyable_v<mirage::Point2<float>>, "Point2 must be trivially copyable.");
+
+TEST(Vecmath, Constexpr)
+{
+    using namespace mirage;
+
+    constexpr Vector3<int> a(1, 2, 3);
+    constexpr Vector3<int> b(4, 5, 6);
+    static_assert(Dot(a, b) == 32, "");
+    static_assert(Cross(a, b) == Vector3<int>(-3, 6, -3), "");
+    static_assert((a + b)[2] == 9, "");
+    static_assert(2 * a - b == Vector3<int>(-2, -1, 0), "");
+
+    constexpr Matrix33<int> R(0, -1, 0, 1, 0, 0, 0, 0, 1);
+    static_assert(R * Vector3<int>(1, 0, 0) == Vector3<int>(0, 1, 0), "");
+    static_assert(Matrix44<double>(2.0).Trace() == 8.0, "");
+    constexpr Matrix44<float> I(1.f);
+    static_assert(I.Col(3)[3] == 1.f, "");
+
+    constexpr Point2<float> p0(1.f, 2.f);
+    constexpr Point2<float> p1(4.f, -2.f);
+    static_assert(AbsDistBetweenPoints(p0, p1).y() == 4.f, "");
+    static_assert(IsPointsNotEqual(p0, p1), "");
+
+    // Value-initialization zeroes, default-initialization leaves them as is.
+    constexpr Vector4<float> zero{};
+    EXPECT_TRUE(IsZero(zero));
+
+    Matrix44<float> copies[2];
+    std::memcpy(&copies[0], &I, sizeof(I));
+    copies[1] = copies[0];
+    EXPECT_TRUE(IsIdentityMatrix(copies[1]));
+}
+
+TEST(Vecmath, ApproximatePrecision)
+{
+    using namespace mirage;
+
+#ifdef MIRAGE_VECMATH_SSE
+    const float fast_tolerance = 1e-6f;
+    const float fastest_tolerance = 4e-4f;
+#else
+    const float fast_tolerance = 5e-6f;
+    const float fastest_tolerance = 2e-3f;
+#endif
+
+    float fast_error = 0.f;
+    float fastest_error = 0.f;
+    auto Track = [](float* error, double approx, double exact)
+    {
+        *error = std::max(*error, static_cast<float>(std::abs(approx - exact) / exact));
+    };
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        // Log-uniform over 1e-6 to 1e6.
+        const float x = std::pow(10.f, -6.f + 12.f * i / 20000.f);
+        const double rsqrt = 1.0 / std::sqrt(static_cast<double>(x));
+        Track(&fast_error, ReciprocalSqrt<Precision::FAST>(x), rsqrt);
+        Track(&fastest_error, ReciprocalSqrt<Precision::FASTEST>(x), rsqrt);
+        Track(&fast_error, Reciprocal<Precision::FAST>(x), 1.0 / x);
+        Track(&fastest_error, Reciprocal<Precision::FASTEST>(x), 1.0 / x);
+
+        const Vector3<float> v(x, 0.5f * x, -0.25f * x);
+        const double length = std::sqrt(1.3125 * static_cast<double>(x) * x);
+        Track(&fast_error, Length<Precision::FAST>(v), length);
+        Track(&fastest_error, Length<Precision::FASTEST>(v), length);
+        Track(&fast_error, Normalize<Precision::FAST>(v).x, x / length);
+        Track(&fastest_error, Normalize<Precision::FASTEST>(v).x, x / length);
+    }
+    EXPECT_LT(fast_error, fast_tolerance);
+    EXPECT_LT(fastest_error, fastest_tolerance);
+
+    EXPECT_EQ(Length<Precision::FAST>(Vector3<float>(0.f)), 0.f);
+    EXPECT_EQ(Length<Precision::FASTEST>(Vector2<float>(3.f, 4.f)), Length<Precision::FASTEST>(Vector2<float>(4.f, 3.f)));
+    EXPECT_NEAR(Length<Precision::FAST>(Vector4<float>(1.f, 2.f, 2.f, 4.f)), 5.f, 5.f * fast_tolerance);
+    EXPECT_NEAR(Normalize<Precision::FAST>(Vector4<float>(0.f, 0.f, 3.f, 0.f)).z, 1.f, fast_tolerance);
+
+    // EXACT is the default, and other scalar types ignore the policy.
+    const Vector3<float> v(1.f, 2.f, 3.f);
+    EXPECT_EQ(Length<Precision::EXACT>(v), Length(v));
+    EXPECT_EQ(Length<Precision::FASTEST>(Vector3<double>(1.0, 2.0, 2.0)), 3.0);
+}
+
+TEST(AABB, ExtendAndQueries)
+{
+    using namespace mirage;
+
+    AABB<float> box = AABB<float>::Empty();
+    EXPECT_TRUE(box.IsEmpty());
+    box.Extend(Vector3<float>(1.f, -2.f, 3.f));
+    EXPECT_FALSE(box.IsEmpty());
+    EXPECT_EQ(box, AABB<float>(Vector3<float>(1.f, -2.f, 3.f), Vector3<float>(1.f, -2.f, 3.f)));
+    box.Extend(AABB<float>(Vector3<float>(-1.f, 0.f, 0.f), Vector3<float>(0.f, 2.f, 1.f)));
+    EXPECT_EQ(box, AABB<float>(Vector3<float>(-1.f, -2.f, 0.f), Vector3<float>(1.f, 2.f, 3.f)));
+    EXPECT_EQ(box.Center(), Vector3<float>(0.f, 0.f, 1.5f));
+    EXPECT_EQ(box.HalfExtents(), Vector3<float>(1.f, 2.f, 1.5f));
+    EXPECT_TRUE(box.Contains(Vector3<float>(1.f, 2.f, 3.f)));
+    EXPECT_FALSE(box.Contains(Vector3<float>(1.f, 2.f, 3.5f)));
+    EXPECT_TRUE(box.Overlaps(AABB<float>(Vector3<float>(1.f, 2.f, 3.f), Vector3<float>(4.f, 4.f, 4.f))));
+    EXPECT_FALSE(box.Overlaps(AABB<float>(Vector3<float>(1.5f, 0.f, 0.f), Vector3<float>(4.f, 4.f, 4.f))));
+
+    // A quarter turn about z and a translation.
+    const Matrix44<float> M(0.f, -1.f, 0.f, 10.f, 1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f);
+    EXPECT_EQ(Transform(M, box), AABB<float>(Vector3<float>(8.f, -1.f, 0.f), Vector3<float>(12.f, 1.f, 3.f)));
+}
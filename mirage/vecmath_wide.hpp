@@ -0,0 +1,619 @@
+#ifndef MIRAGE_VECMATH_WIDE_HPP
+#define MIRAGE_VECMATH_WIDE_HPP
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "check.hpp"
+#include "vecmath.hpp"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MIRAGE_WIDE_AVX
+#elif defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MIRAGE_WIDE_SSE
+#endif
+
+namespace mirage
+{
+
+// Eight floats processed together: one AVX register, a pair of SSE registers,
+// or a plain array, depending on the target. Every operation is the IEEE
+// operation per lane, so the results match the scalar code lane by lane.
+// Comparisons return masks with all bits set in lanes where they hold.
+struct alignas(32) Float8
+{
+    static constexpr int Width = 8;
+
+    Float8() {}
+    Float8(float v)
+    {
+#if defined(MIRAGE_WIDE_AVX)
+        v8 = _mm256_set1_ps(v);
+#elif defined(MIRAGE_WIDE_SSE)
+        lo = _mm_set1_ps(v);
+        hi = lo;
+#else
+        for (int i = 0; i < Width; ++i) f[i] = v;
+#endif
+    }
+
+    Float8(float a0, float a1, float a2, float a3, float a4, float a5, float a6, float a7)
+    {
+#if defined(MIRAGE_WIDE_AVX)
+        v8 = _mm256_setr_ps(a0, a1, a2, a3, a4, a5, a6, a7);
+#elif defined(MIRAGE_WIDE_SSE)
+        lo = _mm_setr_ps(a0, a1, a2, a3);
+        hi = _mm_setr_ps(a4, a5, a6, a7);
+#else
+        f[0] = a0; f[1] = a1; f[2] = a2; f[3] = a3;
+        f[4] = a4; f[5] = a5; f[6] = a6; f[7] = a7;
+#endif
+    }
+
+    static Float8 Load(const float* p)
+    {
+        Float8 r;
+#if defined(MIRAGE_WIDE_AVX)
+        r.v8 = _mm256_loadu_ps(p);
+#elif defined(MIRAGE_WIDE_SSE)
+        r.lo = _mm_loadu_ps(p);
+        r.hi = _mm_loadu_ps(p + 4);
+#else
+        for (int i = 0; i < Width; ++i) r.f[i] = p[i];
+#endif
+        return r;
+    }
+
+    void Store(float* p) const
+    {
+#if defined(MIRAGE_WIDE_AVX)
+        _mm256_storeu_ps(p, v8);
+#elif defined(MIRAGE_WIDE_SSE)
+        _mm_storeu_ps(p, lo);
+        _mm_storeu_ps(p + 4, hi);
+#else
+        for (int i = 0; i < Width; ++i) p[i] = f[i];
+#endif
+    }
+
+    float operator[](int i) const
+    {
+        DCHECK_GE(i, 0);
+        DCHECK_LT(i, Width);
+
+        alignas(32) float lanes[Width];
+        Store(lanes);
+        return lanes[i];
+    }
+
+#if defined(MIRAGE_WIDE_AVX)
+    __m256 v8;
+#elif defined(MIRAGE_WIDE_SSE)
+    __m128 lo, hi;
+#else
+    float f[Width];
+#endif
+};
+
+#if defined(MIRAGE_WIDE_AVX)
+#define MIRAGE_FLOAT8_BINARY(name, avx, sse, expr) \
+    inline Float8 name(const Float8& a, const Float8& b) \
+    { \
+        Float8 r; \
+        r.v8 = avx(a.v8, b.v8); \
+        return r; \
+    }
+#elif defined(MIRAGE_WIDE_SSE)
+#define MIRAGE_FLOAT8_BINARY(name, avx, sse, expr) \
+    inline Float8 name(const Float8& a, const Float8& b) \
+    { \
+        Float8 r; \
+        r.lo = sse(a.lo, b.lo); \
+        r.hi = sse(a.hi, b.hi); \
+        return r; \
+    }
+#else
+#define MIRAGE_FLOAT8_BINARY(name, avx, sse, expr) \
+    inline Float8 name(const Float8& a, const Float8& b) \
+    { \
+        Float8 r; \
+        for (int i = 0; i < Float8::Width; ++i) \
+        { \
+            const float x = a.f[i]; \
+            const float y = b.f[i]; \
+            r.f[i] = (expr); \
+        } \
+        return r; \
+    }
+#endif
+
+namespace detail
+{
+
+inline float MaskBits(bool v)
+{
+    const uint32_t bits = v ? 0xffffffffu : 0u;
+    float r;
+    std::memcpy(&r, &bits, sizeof(r));
+    return r;
+}
+
+inline bool MaskIsSet(float v)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits != 0;
+}
+
+#if defined(MIRAGE_WIDE_AVX) || defined(MIRAGE_WIDE_SSE)
+
+// Four packed Vector3<float> are three registers (x0 y0 z0 x1) (y1 z1 x2 y2)
+// (z2 x3 y3 z3). These transpose them to and from (x0..x3) (y0..y3) (z0..z3)
+// with shuffles, without a round trip through memory.
+inline void LoadXyz4(const float* p, __m128& x, __m128& y, __m128& z)
+{
+    const __m128 a = _mm_loadu_ps(p);
+    const __m128 b = _mm_loadu_ps(p + 4);
+    const __m128 c = _mm_loadu_ps(p + 8);
+
+    const __m128 y1x2 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 0, 2, 0));
+    x = _mm_shuffle_ps(a, y1x2, _MM_SHUFFLE(3, 1, 3, 0));
+    const __m128 y0y1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+    const __m128 y2y3 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+    y = _mm_shuffle_ps(y0y1, y2y3, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 z0z1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+    const __m128 z2z3 = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+    z = _mm_shuffle_ps(z0z1, z2z3, _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+inline void StoreXyz4(float* p, __m128 x, __m128 y, __m128 z)
+{
+    const __m128 x0y0 = _mm_unpacklo_ps(x, y);
+    const __m128 z0x1 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+    _mm_storeu_ps(p, _mm_shuffle_ps(x0y0, z0x1, _MM_SHUFFLE(2, 0, 1, 0)));
+    const __m128 y1z1 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+    const __m128 x2y2 = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2));
+    _mm_storeu_ps(p + 4, _mm_shuffle_ps(y1z1, x2y2, _MM_SHUFFLE(2, 0, 2, 0)));
+    const __m128 z2x3 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));
+    const __m128 y3z3 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));
+    _mm_storeu_ps(p + 8, _mm_shuffle_ps(z2x3, y3z3, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+#endif
+
+#if defined(MIRAGE_WIDE_AVX)
+inline __m256 CmpLt(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline __m256 CmpLe(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+inline __m256 CmpGt(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline __m256 CmpGe(__m256 a, __m256 b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+#endif
+
+} // namespace detail
+
+MIRAGE_FLOAT8_BINARY(operator+, _mm256_add_ps, _mm_add_ps, x + y)
+MIRAGE_FLOAT8_BINARY(operator-, _mm256_sub_ps, _mm_sub_ps, x - y)
+MIRAGE_FLOAT8_BINARY(operator*, _mm256_mul_ps, _mm_mul_ps, x * y)
+MIRAGE_FLOAT8_BINARY(operator/, _mm256_div_ps, _mm_div_ps, x / y)
+MIRAGE_FLOAT8_BINARY(Min, _mm256_min_ps, _mm_min_ps, x < y ? x : y)
+MIRAGE_FLOAT8_BINARY(Max, _mm256_max_ps, _mm_max_ps, x > y ? x : y)
+MIRAGE_FLOAT8_BINARY(operator<, detail::CmpLt, _mm_cmplt_ps, detail::MaskBits(x < y))
+MIRAGE_FLOAT8_BINARY(operator<=, detail::CmpLe, _mm_cmple_ps, detail::MaskBits(x <= y))
+MIRAGE_FLOAT8_BINARY(operator>, detail::CmpGt, _mm_cmpgt_ps, detail::MaskBits(x > y))
+MIRAGE_FLOAT8_BINARY(operator>=, detail::CmpGe, _mm_cmpge_ps, detail::MaskBits(x >= y))
+MIRAGE_FLOAT8_BINARY(operator&, _mm256_and_ps, _mm_and_ps, detail::MaskBits(detail::MaskIsSet(x) && detail::MaskIsSet(y)))
+MIRAGE_FLOAT8_BINARY(operator|, _mm256_or_ps, _mm_or_ps, detail::MaskBits(detail::MaskIsSet(x) || detail::MaskIsSet(y)))
+
+#undef MIRAGE_FLOAT8_BINARY
+
+inline Float8 operator-(const Float8& a)
+{
+    return Float8(0.f) - a;
+}
+
+inline Float8& operator+=(Float8& a, const Float8& b) { a = a + b; return a; }
+inline Float8& operator-=(Float8& a, const Float8& b) { a = a - b; return a; }
+inline Float8& operator*=(Float8& a, const Float8& b) { a = a * b; return a; }
+
+inline Float8 Sqrt(const Float8& a)
+{
+    Float8 r;
+#if defined(MIRAGE_WIDE_AVX)
+    r.v8 = _mm256_sqrt_ps(a.v8);
+#elif defined(MIRAGE_WIDE_SSE)
+    r.lo = _mm_sqrt_ps(a.lo);
+    r.hi = _mm_sqrt_ps(a.hi);
+#else
+    for (int i = 0; i < Float8::Width; ++i) r.f[i] = std::sqrt(a.f[i]);
+#endif
+    return r;
+}
+
+// See Precision in vecmath.hpp. The packet estimates have the error bounds of
+// the scalar ones.
+template<Precision P = Precision::EXACT>
+inline Float8 ReciprocalSqrt(const Float8& x)
+{
+    if constexpr (P == Precision::EXACT)
+    {
+        return Float8(1.f) / Sqrt(x);
+    }
+    else
+    {
+        Float8 y;
+#if defined(MIRAGE_WIDE_AVX)
+        y.v8 = _mm256_rsqrt_ps(x.v8);
+#elif defined(MIRAGE_WIDE_SSE)
+        y.lo = _mm_rsqrt_ps(x.lo);
+        y.hi = _mm_rsqrt_ps(x.hi);
+#else
+        for (int i = 0; i < Float8::Width; ++i) y.f[i] = detail::ReciprocalSqrtEstimate(x.f[i]);
+#endif
+        if constexpr (P == Precision::FASTEST)
+            return y;
+        else
+            return y * (Float8(1.5f) - Float8(0.5f) * x * y * y);
+    }
+}
+
+template<Precision P = Precision::EXACT>
+inline Float8 Reciprocal(const Float8& x)
+{
+    if constexpr (P == Precision::EXACT)
+    {
+        return Float8(1.f) / x;
+    }
+    else
+    {
+        Float8 y;
+#if defined(MIRAGE_WIDE_AVX)
+        y.v8 = _mm256_rcp_ps(x.v8);
+#elif defined(MIRAGE_WIDE_SSE)
+        y.lo = _mm_rcp_ps(x.lo);
+        y.hi = _mm_rcp_ps(x.hi);
+#else
+        for (int i = 0; i < Float8::Width; ++i) y.f[i] = detail::ReciprocalEstimate(x.f[i]);
+#endif
+        if constexpr (P == Precision::FASTEST)
+            return y;
+        else
+            return y * (Float8(2.f) - x * y);
+    }
+}
+
+// Lanes of a where the mask is set, lanes of b elsewhere.
+inline Float8 Select(const Float8& pMask, const Float8& a, const Float8& b)
+{
+    Float8 r;
+#if defined(MIRAGE_WIDE_AVX)
+    r.v8 = _mm256_blendv_ps(b.v8, a.v8, pMask.v8);
+#elif defined(MIRAGE_WIDE_SSE)
+    r.lo = _mm_or_ps(_mm_and_ps(pMask.lo, a.lo), _mm_andnot_ps(pMask.lo, b.lo));
+    r.hi = _mm_or_ps(_mm_and_ps(pMask.hi, a.hi), _mm_andnot_ps(pMask.hi, b.hi));
+#else
+    for (int i = 0; i < Float8::Width; ++i) r.f[i] = detail::MaskIsSet(pMask.f[i]) ? a.f[i] : b.f[i];
+#endif
+    return r;
+}
+
+// Bit i is set if lane i of the mask is set.
+inline int MoveMask(const Float8& pMask)
+{
+#if defined(MIRAGE_WIDE_AVX)
+    return _mm256_movemask_ps(pMask.v8);
+#elif defined(MIRAGE_WIDE_SSE)
+    return _mm_movemask_ps(pMask.lo) | (_mm_movemask_ps(pMask.hi) << 4);
+#else
+    int bits = 0;
+    for (int i = 0; i < Float8::Width; ++i) bits |= detail::MaskIsSet(pMask.f[i]) ? (1 << i) : 0;
+    return bits;
+#endif
+}
+
+// Structure-of-arrays packets of eight vectors. Lane i of every component
+// belongs to vector i. The free functions mirror the ones of Vector3 and
+// Vector4 in vecmath.hpp and return Float8 where those return a scalar.
+template<typename T>
+struct Vector3x8;
+
+template<typename T>
+struct Vector4x8;
+
+// Load() and Store() read and write arrays of Vector3<float> as packed floats.
+static_assert(sizeof(Vector3<float>) == 3 * sizeof(float), "Vector3<float> must be packed.");
+
+template<>
+struct Vector3x8<float>
+{
+    Vector3x8() {}
+    Vector3x8(const Float8& x, const Float8& y, const Float8& z) : x(x), y(y), z(z) {}
+    // The same vector in every lane.
+    Vector3x8(const Vector3<float>& v) : x(v.x), y(v.y), z(v.z) {}
+
+    // Transposes eight consecutive array-of-structs vectors.
+    static Vector3x8 Load(const Vector3<float>* p)
+    {
+#if defined(MIRAGE_WIDE_AVX)
+        __m128 x0, y0, z0, x1, y1, z1;
+        detail::LoadXyz4(&p[0].x, x0, y0, z0);
+        detail::LoadXyz4(&p[4].x, x1, y1, z1);
+        Vector3x8 r;
+        r.x.v8 = _mm256_insertf128_ps(_mm256_castps128_ps256(x0), x1, 1);
+        r.y.v8 = _mm256_insertf128_ps(_mm256_castps128_ps256(y0), y1, 1);
+        r.z.v8 = _mm256_insertf128_ps(_mm256_castps128_ps256(z0), z1, 1);
+        return r;
+#elif defined(MIRAGE_WIDE_SSE)
+        Vector3x8 r;
+        detail::LoadXyz4(&p[0].x, r.x.lo, r.y.lo, r.z.lo);
+        detail::LoadXyz4(&p[4].x, r.x.hi, r.y.hi, r.z.hi);
+        return r;
+#else
+        return Vector3x8(
+            Float8(p[0].x, p[1].x, p[2].x, p[3].x, p[4].x, p[5].x, p[6].x, p[7].x),
+            Float8(p[0].y, p[1].y, p[2].y, p[3].y, p[4].y, p[5].y, p[6].y, p[7].y),
+            Float8(p[0].z, p[1].z, p[2].z, p[3].z, p[4].z, p[5].z, p[6].z, p[7].z)
+        );
+#endif
+    }
+
+    void Store(Vector3<float>* p) const
+    {
+#if defined(MIRAGE_WIDE_AVX)
+        detail::StoreXyz4(&p[0].x, _mm256_castps256_ps128(x.v8), _mm256_castps256_ps128(y.v8), _mm256_castps256_ps128(z.v8));
+        detail::StoreXyz4(&p[4].x, _mm256_extractf128_ps(x.v8, 1), _mm256_extractf128_ps(y.v8, 1), _mm256_extractf128_ps(z.v8, 1));
+#elif defined(MIRAGE_WIDE_SSE)
+        detail::StoreXyz4(&p[0].x, x.lo, y.lo, z.lo);
+        detail::StoreXyz4(&p[4].x, x.hi, y.hi, z.hi);
+#else
+        for (int i = 0; i < Float8::Width; ++i)
+            p[i] = Vector3<float>(x.f[i], y.f[i], z.f[i]);
+#endif
+    }
+
+    Vector3<float> Get(int i) const
+    {
+        return Vector3<float>(x[i], y[i], z[i]);
+    }
+
+    Float8 x, y, z;
+};
+
+inline Vector3x8<float> operator+(const Vector3x8<float>& s, const Vector3x8<float>& t)
+{
+    return Vector3x8<float>(s.x + t.x, s.y + t.y, s.z + t.z);
+}
+
+inline Vector3x8<float> operator-(const Vector3x8<float>& s, const Vector3x8<float>& t)
+{
+    return Vector3x8<float>(s.x - t.x, s.y - t.y, s.z - t.z);
+}
+
+inline Vector3x8<float> operator*(const Vector3x8<float>& s, const Vector3x8<float>& t)
+{
+    return Vector3x8<float>(s.x * t.x, s.y * t.y, s.z * t.z);
+}
+
+inline Vector3x8<float> operator*(const Vector3x8<float>& s, const Float8& scalar)
+{
+    return Vector3x8<float>(s.x * scalar, s.y * scalar, s.z * scalar);
+}
+
+inline Vector3x8<float> operator*(const Float8& scalar, const Vector3x8<float>& s)
+{
+    return Vector3x8<float>(s.x * scalar, s.y * scalar, s.z * scalar);
+}
+
+inline Vector3x8<float>& operator+=(Vector3x8<float>& s, const Vector3x8<float>& t)
+{
+    s = s + t;
+    return s;
+}
+
+inline Vector3x8<float>& operator-=(Vector3x8<float>& s, const Vector3x8<float>& t)
+{
+    s = s - t;
+    return s;
+}
+
+inline Vector3x8<float>& operator*=(Vector3x8<float>& s, const Float8& scalar)
+{
+    s = s * scalar;
+    return s;
+}
+
+inline Float8 Dot(const Vector3x8<float>& s, const Vector3x8<float>& t)
+{
+    return s.x * t.x + s.y * t.y + s.z * t.z;
+}
+
+template<Precision P = Precision::EXACT>
+inline Float8 Length(const Vector3x8<float>& s)
+{
+    if constexpr (P == Precision::EXACT)
+    {
+        return Sqrt(Dot(s, s));
+    }
+    else
+    {
+        const Float8 d = Dot(s, s);
+        return Select(d > Float8(0.f), d * ReciprocalSqrt<P>(d), Float8(0.f));
+    }
+}
+
+template<Precision P = Precision::EXACT>
+inline Vector3x8<float> Normalize(const Vector3x8<float>& s)
+{
+    if constexpr (P == Precision::EXACT)
+        return s * (Float8(1.f) / Length(s));
+    else
+        return s * ReciprocalSqrt<P>(Dot(s, s));
+}
+
+inline Vector3x8<float> Cross(const Vector3x8<float>& s, const Vector3x8<float>& t)
+{
+    return Vector3x8<float>(
+        s.y * t.z - s.z * t.y,
+        s.z * t.x - s.x * t.z,
+        s.x * t.y - s.y * t.x
+    );
+}
+
+inline Vector3x8<float> Reflect(const Vector3x8<float>& D, const Vector3x8<float>& N)
+{
+    // Reflects incident vector v around normal vecotr n.
+    // n is expected to be normalized
+    return (Float8(2.f) * (Dot(D, N) * N)) - D;
+}
+
+static_assert(sizeof(Vector4<float>) == 4 * sizeof(float), "Vector4<float> must be packed.");
+
+template<>
+struct Vector4x8<float>
+{
+    Vector4x8() {}
+    Vector4x8(const Float8& x, const Float8& y, const Float8& z, const Float8& w) : x(x), y(y), z(z), w(w) {}
+    // The same vector in every lane.
+    Vector4x8(const Vector4<float>& v) : x(v.x), y(v.y), z(v.z), w(v.w) {}
+
+    // Transposes eight consecutive array-of-structs vectors.
+    static Vector4x8 Load(const Vector4<float>* p)
+    {
+#if defined(MIRAGE_WIDE_AVX)
+        // Rows (p[i], p[i + 4]), transposed as two 4x4 blocks, one per
+        // 128-bit half.
+        const float* f = &p[0].x;
+        const __m256 r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f + 0)), _mm_loadu_ps(f + 16), 1);
+        const __m256 r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f + 4)), _mm_loadu_ps(f + 20), 1);
+        const __m256 r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f + 8)), _mm_loadu_ps(f + 24), 1);
+        const __m256 r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f + 12)), _mm_loadu_ps(f + 28), 1);
+        const __m256 x0x1y0y1 = _mm256_unpacklo_ps(r0, r1);
+        const __m256 z0z1w0w1 = _mm256_unpackhi_ps(r0, r1);
+        const __m256 x2x3y2y3 = _mm256_unpacklo_ps(r2, r3);
+        const __m256 z2z3w2w3 = _mm256_unpackhi_ps(r2, r3);
+        Vector4x8 r;
+        r.x.v8 = _mm256_shuffle_ps(x0x1y0y1, x2x3y2y3, _MM_SHUFFLE(1, 0, 1, 0));
+        r.y.v8 = _mm256_shuffle_ps(x0x1y0y1, x2x3y2y3, _MM_SHUFFLE(3, 2, 3, 2));
+        r.z.v8 = _mm256_shuffle_ps(z0z1w0w1, z2z3w2w3, _MM_SHUFFLE(1, 0, 1, 0));
+        r.w.v8 = _mm256_shuffle_ps(z0z1w0w1, z2z3w2w3, _MM_SHUFFLE(3, 2, 3, 2));
+        return r;
+#else
+        return Vector4x8(
+            Float8(p[0].x, p[1].x, p[2].x, p[3].x, p[4].x, p[5].x, p[6].x, p[7].x),
+            Float8(p[0].y, p[1].y, p[2].y, p[3].y, p[4].y, p[5].y, p[6].y, p[7].y),
+            Float8(p[0].z, p[1].z, p[2].z, p[3].z, p[4].z, p[5].z, p[6].z, p[7].z),
+            Float8(p[0].w, p[1].w, p[2].w, p[3].w, p[4].w, p[5].w, p[6].w, p[7].w)
+        );
+#endif
+    }
+
+    void Store(Vector4<float>* p) const
+    {
+#if defined(MIRAGE_WIDE_AVX)
+        // The transpose of Load(), back to rows (p[i], p[i + 4]).
+        const __m256 x0y0x1y1 = _mm256_unpacklo_ps(x.v8, y.v8);
+        const __m256 x2y2x3y3 = _mm256_unpackhi_ps(x.v8, y.v8);
+        const __m256 z0w0z1w1 = _mm256_unpacklo_ps(z.v8, w.v8);
+        const __m256 z2w2z3w3 = _mm256_unpackhi_ps(z.v8, w.v8);
+        const __m256 r0 = _mm256_shuffle_ps(x0y0x1y1, z0w0z1w1, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 r1 = _mm256_shuffle_ps(x0y0x1y1, z0w0z1w1, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 r2 = _mm256_shuffle_ps(x2y2x3y3, z2w2z3w3, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 r3 = _mm256_shuffle_ps(x2y2x3y3, z2w2z3w3, _MM_SHUFFLE(3, 2, 3, 2));
+        float* f = &p[0].x;
+        _mm256_storeu_ps(f + 0, _mm256_permute2f128_ps(r0, r1, 0x20));
+        _mm256_storeu_ps(f + 8, _mm256_permute2f128_ps(r2, r3, 0x20));
+        _mm256_storeu_ps(f + 16, _mm256_permute2f128_ps(r0, r1, 0x31));
+        _mm256_storeu_ps(f + 24, _mm256_permute2f128_ps(r2, r3, 0x31));
+#else
+        alignas(32) float lanes[4][Float8::Width];
+        x.Store(lanes[0]);
+        y.Store(lanes[1]);
+        z.Store(lanes[2]);
+        w.Store(lanes[3]);
+        for (int i = 0; i < Float8::Width; ++i)
+            p[i] = Vector4<float>(lanes[0][i], lanes[1][i], lanes[2][i], lanes[3][i]);
+#endif
+    }
+
+    Vector4<float> Get(int i) const
+    {
+        return Vector4<float>(x[i], y[i], z[i], w[i]);
+    }
+
+    Float8 x, y, z, w;
+};
+
+inline Vector4x8<float> operator+(const Vector4x8<float>& s, const Vector4x8<float>& t)
+{
+    return Vector4x8<float>(s.x + t.x, s.y + t.y, s.z + t.z, s.w + t.w);
+}
+
+inline Vector4x8<float> operator-(const Vector4x8<float>& s, const Vector4x8<float>& t)
+{
+    return Vector4x8<float>(s.x - t.x, s.y - t.y, s.z - t.z, s.w - t.w);
+}
+
+inline Vector4x8<float> operator*(const Vector4x8<float>& s, const Vector4x8<float>& t)
+{
+    return Vector4x8<float>(s.x * t.x, s.y * t.y, s.z * t.z, s.w * t.w);
+}
+
+inline Vector4x8<float> operator*(const Vector4x8<float>& s, const Float8& scalar)
+{
+    return Vector4x8<float>(s.x * scalar, s.y * scalar, s.z * scalar, s.w * scalar);
+}
+
+inline Vector4x8<float> operator*(const Float8& scalar, const Vector4x8<float>& s)
+{
+    return Vector4x8<float>(s.x * scalar, s.y * scalar, s.z * scalar, s.w * scalar);
+}
+
+inline Vector4x8<float>& operator+=(Vector4x8<float>& s, const Vector4x8<float>& t)
+{
+    s = s + t;
+    return s;
+}
+
+inline Vector4x8<float>& operator-=(Vector4x8<float>& s, const Vector4x8<float>& t)
+{
+    s = s - t;
+    return s;
+}
+
+inline Vector4x8<float>& operator*=(Vector4x8<float>& s, const Float8& scalar)
+{
+    s = s * scalar;
+    return s;
+}
+
+inline Float8 Dot(const Vector4x8<float>& s, const Vector4x8<float>& t)
+{
+    return s.x * t.x + s.y * t.y + s.z * t.z + s.w * t.w;
+}
+
+template<Precision P = Precision::EXACT>
+inline Float8 Length(const Vector4x8<float>& s)
+{
+    if constexpr (P == Precision::EXACT)
+    {
+        return Sqrt(Dot(s, s));
+    }
+    else
+    {
+        const Float8 d = Dot(s, s);
+        return Select(d > Float8(0.f), d * ReciprocalSqrt<P>(d), Float8(0.f));
+    }
+}
+
+template<Precision P = Precision::EXACT>
+inline Vector4x8<float> Normalize(const Vector4x8<float>& s)
+{
+    if constexpr (P == Precision::EXACT)
+        return s * (Float8(1.f) / Length(s));
+    else
+        return s * ReciprocalSqrt<P>(Dot(s, s));
+}
+
+} // namespace mirage
+
+#endif
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include "vecmath_wide.hpp"
+
+static mirage::Vector3<float> TestVector3(int i)
+{
+    return mirage::Vector3<float>(1.5f * i - 4.f, 0.25f * i * i + 1.f, 3.f - 0.75f * i);
+}
+
+static mirage::Vector4<float> TestVector4(int i)
+{
+    return mirage::Vector4<float>(1.5f * i - 4.f, 0.25f * i * i + 1.f, 3.f - 0.75f * i, 0.5f * i);
+}
+
+TEST(Float8, LanesAndMasks)
+{
+    using namespace mirage;
+
+    const float a_lanes[8] = { 1.f, -2.f, 3.f, -4.f, 5.f, -6.f, 7.f, -8.f };
+    const float b_lanes[8] = { 2.f, 2.f, 2.f, 2.f, -2.f, -2.f, -2.f, -2.f };
+    Float8 a = Float8::Load(a_lanes);
+    Float8 b = Float8::Load(b_lanes);
+
+    Float8 sum = a + b;
+    Float8 quotient = a / b;
+    Float8 lower = Min(a, b);
+    Float8 upper = Max(a, b);
+    for (int i = 0; i < 8; ++i)
+    {
+        EXPECT_EQ(sum[i], a_lanes[i] + b_lanes[i]);
+        EXPECT_EQ(quotient[i], a_lanes[i] / b_lanes[i]);
+        EXPECT_EQ(lower[i], std::min(a_lanes[i], b_lanes[i]));
+        EXPECT_EQ(upper[i], std::max(a_lanes[i], b_lanes[i]));
+    }
+
+    Float8 less = a < b;
+    EXPECT_EQ(MoveMask(less), 0b10101011);
+    EXPECT_EQ(MoveMask(less & (a > Float8(-5.f))), 0b00001011);
+    EXPECT_EQ(MoveMask(less | (a >= Float8(7.f))), 0b11101011);
+
+    Float8 selected = Select(less, a, b);
+    for (int i = 0; i < 8; ++i)
+        EXPECT_EQ(selected[i], a_lanes[i] < b_lanes[i] ? a_lanes[i] : b_lanes[i]);
+
+    EXPECT_EQ(Sqrt(Float8(16.f))[5], 4.f);
+}
+
+TEST(Vector3x8, MatchesScalar)
+{
+    using namespace mirage;
+
+    Vector3<float> s[8], t[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        s[i] = TestVector3(i);
+        t[i] = TestVector3(7 - i) * 0.5f;
+    }
+    Vector3x8<float> S = Vector3x8<float>::Load(s);
+    Vector3x8<float> T = Vector3x8<float>::Load(t);
+
+    Vector3x8<float> sum = S + T;
+    Vector3x8<float> difference = S - T;
+    Vector3x8<float> product = S * T;
+    Vector3x8<float> scaled = S * Float8(3.f);
+    Float8 dot = Dot(S, T);
+    Float8 length = Length(S);
+    Vector3x8<float> normalized = Normalize(S);
+    Vector3x8<float> cross = Cross(S, T);
+    Vector3x8<float> reflected = Reflect(S, Normalize(T));
+
+    Vector3<float> stored[8];
+    cross.Store(stored);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        EXPECT_EQ(sum.Get(i) == s[i] + t[i], true);
+        EXPECT_EQ(difference.Get(i) == s[i] - t[i], true);
+        EXPECT_EQ(product.Get(i) == s[i] * t[i], true);
+        EXPECT_EQ(scaled.Get(i) == s[i] * 3.f, true);
+        EXPECT_FLOAT_EQ(dot[i], Dot(s[i], t[i]));
+        EXPECT_FLOAT_EQ(length[i], Length(s[i]));
+        EXPECT_EQ(normalized.Get(i) == Normalize(s[i]), true);
+        EXPECT_EQ(cross.Get(i) == Cross(s[i], t[i]), true);
+        EXPECT_EQ(stored[i] == Cross(s[i], t[i]), true);
+        EXPECT_EQ(reflected.Get(i) == Reflect(s[i], Normalize(t[i])), true);
+    }
+
+    Vector3x8<float> broadcast(Vector3<float>(1.f, 2.f, 3.f));
+    EXPECT_EQ(broadcast.Get(6) == Vector3<float>(1.f, 2.f, 3.f), true);
+}
+
+TEST(Vector4x8, MatchesScalar)
+{
+    using namespace mirage;
+
+    Vector4<float> s[8], t[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        s[i] = TestVector4(i);
+        t[i] = TestVector4(7 - i) * 0.5f;
+    }
+    Vector4x8<float> S = Vector4x8<float>::Load(s);
+    Vector4x8<float> T = Vector4x8<float>::Load(t);
+
+    Vector4x8<float> sum = S + T;
+    Vector4x8<float> product = S * T;
+    Float8 dot = Dot(S, T);
+    Float8 length = Length(S);
+    Vector4x8<float> normalized = Normalize(S);
+
+    Vector4<float> stored[8];
+    sum.Store(stored);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        EXPECT_EQ(S.Get(i) == s[i], true);
+        EXPECT_EQ(sum.Get(i) == s[i] + t[i], true);
+        EXPECT_EQ(stored[i] == s[i] + t[i], true);
+        EXPECT_EQ(product.Get(i) == s[i] * t[i], true);
+        EXPECT_FLOAT_EQ(dot[i], Dot(s[i], t[i]));
+        EXPECT_FLOAT_EQ(length[i], Length(s[i]));
+        EXPECT_EQ(normalized.Get(i) == Normalize(s[i]), true);
+    }
+}
+
+TEST(Vector3x8, ApproximatePrecisionMatchesScalarBounds)
+{
+    using namespace mirage;
+
+    Vector3<float> vectors[8];
+    for (int i = 0; i < 8; ++i)
+        vectors[i] = TestVector3(i) * std::pow(10.f, static_cast<float>(i - 4));
+    const Vector3x8<float> packet = Vector3x8<float>::Load(vectors);
+
+    const Vector3x8<float> fast = Normalize<Precision::FAST>(packet);
+    const Vector3x8<float> fastest = Normalize<Precision::FASTEST>(packet);
+    const Float8 fast_length = Length<Precision::FAST>(packet);
+    for (int i = 0; i < 8; ++i)
+    {
+        const Vector3<float> exact = Normalize(vectors[i]);
+        EXPECT_NEAR(fast.x[i], exact.x, 5e-6f);
+        EXPECT_NEAR(fastest.y[i], exact.y, 2e-3f);
+        EXPECT_NEAR(fast_length[i] / Length(vectors[i]), 1.f, 5e-6f);
+    }
+
+    EXPECT_EQ(Length<Precision::FAST>(Vector3x8<float>(Vector3<float>(0.f)))[0], 0.f);
+    EXPECT_NEAR(Reciprocal<Precision::FAST>(Float8(4.f))[5], 0.25f, 0.25f * 5e-6f);
+}
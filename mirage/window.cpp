@@ -15,13 +15,20 @@ Window::Window(WindowMode pWindowMode, unsigned pResolutionX, unsigned pResoluti
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_CENTER_CURSOR, GLFW_TRUE);
 
+    // Only borderless and fullscreen windows need a monitor. Windowed mode also
+    // works on virtual displays that don't report one.
     mPrimaryMonitor = glfwGetPrimaryMonitor();
-    if (!mPrimaryMonitor)
-        assert(false, "Error. GLFW could not detect any monitor!");
-
-    mVideoMode = const_cast<GLFWvidmode*>(glfwGetVideoMode(mPrimaryMonitor));
-    if (!mVideoMode)
-        assert(false, "Error. GLFW coudln't retrieve video mode of current monitor!");
+    mVideoMode = NULL;
+    if (mPrimaryMonitor)
+        mVideoMode = const_cast<GLFWvidmode*>(glfwGetVideoMode(mPrimaryMonitor));
+
+    if (pWindowMode != WindowMode::WINDOWED)
+    {
+        if (!mPrimaryMonitor)
+            assert(false, "Error. GLFW could not detect any monitor!");
+        if (!mVideoMode)
+            assert(false, "Error. GLFW coudln't retrieve video mode of current monitor!");
+    }
 
     switch (pWindowMode) {
     case WindowMode::WINDOWED:
@@ -46,7 +53,7 @@ Window::Window(WindowMode pWindowMode, unsigned pResolutionX, unsigned pResoluti
         assert(false, "Error. GLFW could not create window!");
 
     mWindowSize = Point2<unsigned>(pResolutionX, pResolutionY);
-    mWindowMode = mWindowMode;
+    mWindowMode = pWindowMode;
 
     glfwMakeContextCurrent(mWindowPtr);
     if (glfwGetError(NULL))